@@ -0,0 +1,713 @@
+// micro_bench.cpp
+// Microbenchmarks of the renderer's building blocks: per-point rotation and
+// projection, the batch transform kernels, edge clipping, segment
+// rasterization, edge deduplication, the object builders and one whole
+// software frame. Each stage runs over meshes of configurable size with
+// warmup and repeated samples, and reports median, MAD, ns per element and
+// GB/s as a table and optionally as JSON for diffing between commits.
+#include "3d_renderer/3d_renderer.h"
+#include "3d_renderer/batch_transform.h"
+#include "3d_renderer/clipping.h"
+#include "3d_objects/objects_3d.h"
+#include "app_state/app_state.h"
+#include "framebuffer/framebuffer.h"
+#include "framebuffer/tile_rasterizer.h"
+#include "mesh_io/edge_set.h"
+#include "threading/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Same projection as the application (main.cpp) and a 1000x1000 target
+static constexpr float FOCAL_LENGTH = 100000.0f;
+static constexpr float VIEWER_DISTANCE = 500.0f;
+static constexpr int TARGET_SIZE = 1000;
+static constexpr float ANGLE_X = 20.0f, ANGLE_Y = 30.0f, ANGLE_Z = 40.0f;
+
+// Where the result table goes (stderr when the JSON is written to stdout)
+static std::FILE *tableFile = stdout;
+
+/**
+ * @brief Command-line settings.
+ */
+struct BenchOptions
+{
+    std::vector<std::size_t> vertexCounts{10000, 100000, 1000000}; ///< --vertices=N,N,... approximate mesh sizes
+    std::vector<unsigned> threadCounts;                             ///< --threads=N,N,... for the parallel transform; empty = 1, 2, 4, ... cores
+    int repetitions = 15;                                           ///< --reps=N timed samples per benchmark
+    int warmup = 3;                                                 ///< --warmup=N untimed samples first
+    double minSampleMs = 2.0;                                       ///< --min-time=MS; small inputs are looped until a sample takes this long
+    const char *jsonPath = nullptr;                                 ///< --json=PATH, or - for stdout
+    const char *filter = nullptr;                                   ///< --filter=TEXT runs only names containing TEXT
+};
+
+/**
+ * @brief Summary of one benchmark at one size.
+ */
+struct BenchResult
+{
+    std::string name;
+    const char *unit;          ///< What one element is (vertex, edge, segment, ...)
+    std::size_t elements;      ///< Elements processed per call
+    std::size_t bytesPerCall;  ///< Bytes read and written per call; 0 = not meaningful
+    std::size_t innerCalls;    ///< Calls per timed sample
+    int repetitions;           ///< Timed samples
+    double medianNs;           ///< Median time of one call
+    double madNs;              ///< Median absolute deviation of one call
+    double minNs;              ///< Fastest call
+};
+
+static double nowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const std::size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+static bool selected(const BenchOptions &options, const std::string &name)
+{
+    return !options.filter || name.find(options.filter) != std::string::npos;
+}
+
+// Time body: warmup samples, then repetitions samples of innerCalls calls,
+// innerCalls chosen so a sample lasts at least minSampleMs
+static BenchResult measure(const BenchOptions &options, const std::string &name, const char *unit, std::size_t elements,
+                           std::size_t bytesPerCall, const std::function<void()> &body)
+{
+    // Calibrate with doubling batches, so a slow first (cold) call does not decide alone
+    const double targetNs = options.minSampleMs * 1.0e6;
+    std::size_t batch = 1;
+    double batchNs = 0.0;
+    for (;;)
+    {
+        const double batchStart = nowNs();
+        for (std::size_t call = 0; call < batch; ++call)
+            body();
+        batchNs = std::max(nowNs() - batchStart, 1.0);
+        if (batchNs >= targetNs / 4.0 || batch >= (std::size_t(1) << 30))
+            break;
+        batch *= 2;
+    }
+    const std::size_t innerCalls = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(targetNs * static_cast<double>(batch) / batchNs)));
+
+    double start = 0.0;
+
+    std::vector<double> samples;
+    samples.reserve(static_cast<std::size_t>(options.repetitions));
+    for (int sample = 0; sample < options.warmup + options.repetitions; ++sample)
+    {
+        start = nowNs();
+        for (std::size_t call = 0; call < innerCalls; ++call)
+            body();
+        const double perCall = (nowNs() - start) / static_cast<double>(innerCalls);
+        if (sample >= options.warmup)
+            samples.push_back(perCall);
+    }
+
+    const double middle = median(samples);
+    std::vector<double> deviations(samples.size());
+    for (std::size_t i = 0; i < samples.size(); ++i)
+        deviations[i] = std::fabs(samples[i] - middle);
+
+    BenchResult result{name, unit, elements, bytesPerCall, innerCalls, options.repetitions, middle, median(deviations),
+                       *std::min_element(samples.begin(), samples.end())};
+    std::fprintf(tableFile, "%-34s %10zu %-8s %12.1f %10.1f %10.3f", result.name.c_str(), result.elements, result.unit,
+                result.medianNs / 1000.0, result.madNs / 1000.0, result.medianNs / static_cast<double>(result.elements));
+    if (bytesPerCall)
+        std::fprintf(tableFile, " %8.2f\n", static_cast<double>(bytesPerCall) / result.medianNs);
+    else
+        std::fprintf(tableFile, " %8s\n", "-");
+    std::fflush(tableFile);
+    return result;
+}
+
+// Keeps results observable so the optimizer cannot drop the benchmarked work
+static volatile float sink;
+
+/**
+ * @brief A generated torus with ~vertices vertices and its frame data.
+ */
+struct BenchMesh
+{
+    Objects3d factory;
+    RenderState state;
+    GeometryView geometry;
+    ProjectionMatrix matrix{};
+    ScreenBuffer projected;
+    std::vector<Point3d> points;           ///< The same vertices as Point3d, for the per-point reference
+    std::vector<ScreenSegment> segments;   ///< Visible edges of the frame, for the rasterizer
+    int resolution = 0;
+};
+
+static bool buildMesh(BenchMesh &mesh, std::size_t vertices)
+{
+    // The torus has 2 * res * res vertices, 4 * res * res edges and faces
+    mesh.resolution = std::max(3, static_cast<int>(std::lround(std::sqrt(static_cast<double>(vertices) / 2.0))));
+    mesh.state.screenWidth = TARGET_SIZE;
+    mesh.state.screenHeight = TARGET_SIZE;
+    mesh.state.focalLength = FOCAL_LENGTH;
+    mesh.state.viewerDistance = VIEWER_DISTANCE;
+    if (!mesh.factory.generate(mesh.state, GeneratorKind::Torus, mesh.resolution, 255, 0, 0))
+        return false;
+    mesh.geometry = mesh.state.externalGeometry;
+
+    const GeometryView &geometry = mesh.geometry;
+    mesh.matrix = buildProjectionMatrix(ANGLE_X, ANGLE_Y, ANGLE_Z, FOCAL_LENGTH, VIEWER_DISTANCE, TARGET_SIZE, TARGET_SIZE);
+    mesh.projected.x.resize(geometry.vertexCount);
+    mesh.projected.y.resize(geometry.vertexCount);
+    mesh.projected.depth.resize(geometry.vertexCount);
+    transformPositions(mesh.matrix, geometry.x, geometry.y, geometry.z, geometry.vertexCount, mesh.projected.x.data(),
+                       mesh.projected.y.data(), mesh.projected.depth.data());
+
+    mesh.points.resize(geometry.vertexCount);
+    for (std::size_t i = 0; i < geometry.vertexCount; ++i)
+        mesh.points[i] = {geometry.x[i], geometry.y[i], geometry.z[i], 255, 0, 0};
+
+    const ClipRegion region = makeClipRegion(TARGET_SIZE, TARGET_SIZE, mesh.state.nearPlane);
+    ClipStats stats;
+    for (std::size_t i = 0; i < geometry.edgeCount; ++i)
+    {
+        const std::uint32_t a = geometry.edgeIndices[2 * i], b = geometry.edgeIndices[2 * i + 1];
+        ClippedEdge clipped;
+        switch (clipEdge<false>(mesh.matrix, geometry, mesh.projected, a, b, region, clipped, stats))
+        {
+        case EdgeClip::Visible:
+            mesh.segments.push_back({toPixelCoordinate(mesh.projected.x[a]), toPixelCoordinate(mesh.projected.y[a]),
+                                     toPixelCoordinate(mesh.projected.x[b]), toPixelCoordinate(mesh.projected.y[b]),
+                                     geometry.uniformColor, 0.0f, 0.0f});
+            break;
+        case EdgeClip::Clipped:
+            mesh.segments.push_back({toPixelCoordinate(clipped.x0), toPixelCoordinate(clipped.y0), toPixelCoordinate(clipped.x1),
+                                     toPixelCoordinate(clipped.y1), geometry.uniformColor, 0.0f, 0.0f});
+            break;
+        case EdgeClip::Culled:
+            break;
+        }
+    }
+    return true;
+}
+
+static void benchPerPoint(const BenchOptions &options, BenchMesh &mesh, std::vector<BenchResult> &results)
+{
+    Renderer3d renderer;
+    const std::size_t count = mesh.points.size();
+    if (selected(options, "renderer3d_rotate_xyz"))
+    {
+        std::vector<Point3d> rotated(count);
+        results.push_back(measure(options, "renderer3d_rotate_xyz", "vertex", count, count * 2 * sizeof(Point3d), [&]
+                                  {
+                                      for (std::size_t i = 0; i < count; ++i)
+                                          rotated[i] = renderer.rotateZ(renderer.rotateY(renderer.rotateX(mesh.points[i], ANGLE_X), ANGLE_Y), ANGLE_Z);
+                                      sink = rotated[count / 2].x; }));
+    }
+    if (selected(options, "renderer3d_project_point"))
+    {
+        std::vector<Point2d> projected(count);
+        results.push_back(measure(options, "renderer3d_project_point", "vertex", count, count * (sizeof(Point3d) + sizeof(Point2d)), [&]
+                                  {
+                                      for (std::size_t i = 0; i < count; ++i)
+                                          projected[i] = renderer.projectPoint(mesh.points[i], FOCAL_LENGTH, VIEWER_DISTANCE, TARGET_SIZE, TARGET_SIZE);
+                                      sink = projected[count / 2].x; }));
+    }
+}
+
+static void benchTransform(const BenchOptions &options, BenchMesh &mesh, std::vector<BenchResult> &results)
+{
+    struct Variant
+    {
+        const char *name;
+        TransformKernel kernel;
+    };
+    const TransformKernel best = detectTransformKernel();
+    std::vector<Variant> kernels{{"scalar", TransformKernel::Scalar}};
+    if (best == TransformKernel::SSE || best == TransformKernel::AVX)
+        kernels.push_back({"sse", TransformKernel::SSE});
+    if (best == TransformKernel::AVX)
+        kernels.push_back({"avx", TransformKernel::AVX});
+
+    const GeometryView &geometry = mesh.geometry;
+    const std::size_t count = geometry.vertexCount;
+    ScreenBuffer out;
+    out.x.resize(count);
+    out.y.resize(count);
+    out.depth.resize(count);
+    // The view-axis shape needs a matrix that rotates about Z only
+    const ProjectionMatrix viewAxis = buildProjectionMatrix(0.0f, 0.0f, ANGLE_Z, FOCAL_LENGTH, VIEWER_DISTANCE, TARGET_SIZE, TARGET_SIZE);
+    for (const Variant &variant : kernels)
+    {
+        for (int shapeIndex = 0; shapeIndex < 2; ++shapeIndex)
+        {
+            const TransformShape shape = shapeIndex ? TransformShape::ViewAxisOnly : TransformShape::General;
+            const ProjectionMatrix &matrix = shapeIndex ? viewAxis : mesh.matrix;
+            const std::string name = std::string("transform_") + variant.name + (shapeIndex ? "_view_axis" : "_general");
+            if (!selected(options, name))
+                continue;
+            results.push_back(measure(options, name, "vertex", count, count * 6 * sizeof(float), [&]
+                                      {
+                                          transformPositions(matrix, geometry.x, geometry.y, geometry.z, count, out.x.data(), out.y.data(),
+                                                             out.depth.data(), variant.kernel, shape);
+                                          sink = out.x[count / 2]; }));
+        }
+    }
+}
+
+// The accuracy bound documented in batch_transform.h: every kernel, in both
+// shapes, against Renderer3d::rotateY/X/Z + projectPoint on random points
+// and angles; the kernels must also agree with each other bit for bit
+static bool checkTransformAccuracy()
+{
+    constexpr std::size_t POINTS = 4099; // Not a multiple of 8, so the kernels' tails run too
+    constexpr int ANGLE_SETS = 32;
+    std::uint64_t random = 0x5EEDu;
+    const auto uniform = [&random]()
+    {
+        std::uint64_t value = (random += 0x9E3779B97F4A7C15ULL);
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return static_cast<double>((value ^ (value >> 31)) >> 11) * (1.0 / 9007199254740992.0);
+    };
+
+    // Directions in the unit cube at scales from 1e-3 to 100 (in front of the viewer)
+    std::vector<Point3d> points(POINTS);
+    std::vector<float> x(POINTS), y(POINTS), z(POINTS);
+    for (std::size_t i = 0; i < POINTS; ++i)
+    {
+        const double scale = std::pow(10.0, -3.0 + 5.0 * uniform());
+        points[i] = {static_cast<float>((2.0 * uniform() - 1.0) * scale), static_cast<float>((2.0 * uniform() - 1.0) * scale),
+                     static_cast<float>((2.0 * uniform() - 1.0) * scale), 255, 255, 255};
+        x[i] = points[i].x;
+        y[i] = points[i].y;
+        z[i] = points[i].z;
+    }
+
+    const TransformKernel best = detectTransformKernel();
+    std::vector<TransformKernel> kernels{TransformKernel::Scalar};
+    if (best == TransformKernel::SSE || best == TransformKernel::AVX)
+        kernels.push_back(TransformKernel::SSE);
+    if (best == TransformKernel::AVX)
+        kernels.push_back(TransformKernel::AVX);
+
+    Renderer3d renderer;
+    ScreenBuffer reference, out;
+    for (ScreenBuffer *buffer : {&reference, &out})
+    {
+        buffer->x.resize(POINTS);
+        buffer->y.resize(POINTS);
+        buffer->depth.resize(POINTS);
+    }
+    double worstPixels = 0.0, worstRatio = 0.0;
+    bool identical = true;
+    for (int set = 0; set < 2 * ANGLE_SETS; ++set)
+    {
+        // The second half rotates about the view axis only, for the ViewAxisOnly shape
+        const bool viewAxis = set >= ANGLE_SETS;
+        const float angleX = viewAxis ? 0.0f : static_cast<float>(720.0 * uniform() - 360.0);
+        const float angleY = viewAxis ? 0.0f : static_cast<float>(720.0 * uniform() - 360.0);
+        const float angleZ = static_cast<float>(720.0 * uniform() - 360.0);
+        const ProjectionMatrix matrix = buildProjectionMatrix(angleX, angleY, angleZ, FOCAL_LENGTH, VIEWER_DISTANCE, TARGET_SIZE, TARGET_SIZE);
+        const TransformShape shape = viewAxis ? TransformShape::ViewAxisOnly : TransformShape::General;
+        for (const TransformKernel kernel : kernels)
+        {
+            ScreenBuffer &target = kernel == TransformKernel::Scalar ? reference : out;
+            transformPositions(matrix, x.data(), y.data(), z.data(), POINTS, target.x.data(), target.y.data(), target.depth.data(), kernel, shape);
+            if (kernel == TransformKernel::Scalar)
+                continue;
+            const std::size_t bytes = POINTS * sizeof(float);
+            identical = identical && std::memcmp(out.x.data(), reference.x.data(), bytes) == 0 &&
+                        std::memcmp(out.y.data(), reference.y.data(), bytes) == 0 && std::memcmp(out.depth.data(), reference.depth.data(), bytes) == 0;
+        }
+        for (std::size_t i = 0; i < POINTS; ++i)
+        {
+            const Point3d rotated = renderer.rotateZ(renderer.rotateX(renderer.rotateY(points[i], angleY), angleX), angleZ);
+            const Point2d projected = renderer.projectPoint(rotated, FOCAL_LENGTH, VIEWER_DISTANCE, TARGET_SIZE, TARGET_SIZE);
+            const double length = std::sqrt(static_cast<double>(points[i].x) * points[i].x + static_cast<double>(points[i].y) * points[i].y +
+                                            static_cast<double>(points[i].z) * points[i].z);
+            const double bound = 1e-3 + 1e-5 * FOCAL_LENGTH * length / (VIEWER_DISTANCE + static_cast<double>(rotated.z));
+            const double error = std::max(std::fabs(static_cast<double>(reference.x[i]) - projected.x),
+                                          std::fabs(static_cast<double>(reference.y[i]) - projected.y));
+            worstPixels = std::max(worstPixels, error);
+            worstRatio = std::max(worstRatio, error / bound);
+        }
+    }
+
+    std::fprintf(tableFile, "transform_accuracy kernels=%zu points=%zu angle_sets=%d max_error_px=%.3g max_error_over_bound=%.3f bit_identical=%d\n",
+                 kernels.size(), POINTS, 2 * ANGLE_SETS, worstPixels, worstRatio, identical ? 1 : 0);
+    if (worstRatio > 1.0 || !identical)
+    {
+        std::fprintf(stderr, "transform_accuracy: the batch transform breaks the bound in batch_transform.h\n");
+        return false;
+    }
+    return true;
+}
+
+// Scaling of the chunked transform over thread counts. Every run is checked
+// against the single-call output, which it must match bit for bit.
+static bool benchTransformParallel(const BenchOptions &options, BenchMesh &mesh, std::vector<BenchResult> &results)
+{
+    const GeometryView &geometry = mesh.geometry;
+    const std::size_t count = geometry.vertexCount;
+    ScreenBuffer serial, out;
+    for (ScreenBuffer *buffer : {&serial, &out})
+    {
+        buffer->x.resize(count);
+        buffer->y.resize(count);
+        buffer->depth.resize(count);
+    }
+    transformPositions(mesh.matrix, geometry.x, geometry.y, geometry.z, count, serial.x.data(), serial.y.data(), serial.depth.data());
+
+    std::vector<unsigned> threadCounts = options.threadCounts;
+    if (threadCounts.empty())
+    {
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned threads = 1; threads < cores; threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(cores);
+    }
+    for (const unsigned threads : threadCounts)
+    {
+        const std::string name = "transform_parallel_t" + std::to_string(threads);
+        if (!selected(options, name))
+            continue;
+        ThreadPool pool(threads);
+        results.push_back(measure(options, name, "vertex", count, count * 6 * sizeof(float), [&]
+                                  {
+                                      transformPositionsParallel(pool, mesh.matrix, geometry.x, geometry.y, geometry.z, count, out.x.data(),
+                                                                 out.y.data(), out.depth.data());
+                                      sink = out.x[count / 2]; }));
+        const std::size_t bytes = count * sizeof(float);
+        if (std::memcmp(out.x.data(), serial.x.data(), bytes) != 0 || std::memcmp(out.y.data(), serial.y.data(), bytes) != 0 ||
+            std::memcmp(out.depth.data(), serial.depth.data(), bytes) != 0)
+        {
+            std::fprintf(stderr, "%s: output differs from the serial transform\n", name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+template <bool InverseDepths>
+static void benchClip(const BenchOptions &options, BenchMesh &mesh, const char *name, std::vector<BenchResult> &results)
+{
+    if (!selected(options, name))
+        return;
+    const GeometryView &geometry = mesh.geometry;
+    const ClipRegion region = makeClipRegion(TARGET_SIZE, TARGET_SIZE, mesh.state.nearPlane);
+    // Per edge: two indices, then x, y and depth of both endpoints
+    const std::size_t bytes = geometry.edgeCount * (2 * sizeof(std::uint32_t) + 6 * sizeof(float));
+    results.push_back(measure(options, name, "edge", geometry.edgeCount, bytes, [&]
+                              {
+                                  ClipStats stats;
+                                  ClippedEdge clipped{};
+                                  std::size_t visible = 0;
+                                  for (std::size_t i = 0; i < geometry.edgeCount; ++i)
+                                      visible += clipEdge<InverseDepths>(mesh.matrix, geometry, mesh.projected, geometry.edgeIndices[2 * i],
+                                                                         geometry.edgeIndices[2 * i + 1], region, clipped, stats) != EdgeClip::Culled;
+                                  sink = static_cast<float>(visible) + clipped.x0; }));
+}
+
+static void benchRasterize(const BenchOptions &options, BenchMesh &mesh, std::vector<BenchResult> &results)
+{
+    if (!selected(options, "rasterize_segments"))
+        return;
+    Framebuffer framebuffer;
+    framebuffer.resize(TARGET_SIZE, TARGET_SIZE);
+    framebuffer.clear(packColor(0, 0, 0));
+    // GB/s counts the segment list only; the pixels written depend on the segment lengths
+    results.push_back(measure(options, "rasterize_segments", "segment", mesh.segments.size(), mesh.segments.size() * sizeof(ScreenSegment), [&]
+                              {
+                                  rasterizeSegments(framebuffer, mesh.segments);
+                                  sink = static_cast<float>(framebuffer.pixels[framebuffer.pixelCount() / 2]); }));
+}
+
+static void benchEdgeSet(const BenchOptions &options, BenchMesh &mesh, std::vector<BenchResult> &results)
+{
+    if (!selected(options, "edge_set_faces"))
+        return;
+    // Face boundaries as a loader sees them: every inner edge arrives twice
+    const GeometryView &geometry = mesh.geometry;
+    const std::size_t inserts = geometry.triangleCount * 3;
+    results.push_back(measure(options, "edge_set_faces", "insert", inserts, inserts * 2 * sizeof(std::uint32_t), [&]
+                              {
+                                  EdgeSet edges;
+                                  edges.reserve(inserts / 2);
+                                  for (std::size_t t = 0; t < geometry.triangleCount; ++t)
+                                  {
+                                      const std::uint32_t *face = geometry.triangleIndices + 3 * t;
+                                      edges.insert(face[0], face[1]);
+                                      edges.insert(face[1], face[2]);
+                                      edges.insert(face[2], face[0]);
+                                  }
+                                  sink = static_cast<float>(edges.edges().size()); }));
+}
+
+static void benchBuilders(const BenchOptions &options, BenchMesh &mesh, std::vector<BenchResult> &results)
+{
+    if (selected(options, "objects3d_generate_torus"))
+    {
+        Objects3d factory;
+        RenderState state;
+        const GeometryView &geometry = mesh.geometry;
+        const std::size_t bytes = geometry.vertexCount * 3 * sizeof(float) + geometry.edgeCount * 2 * sizeof(std::uint32_t) +
+                                  geometry.triangleCount * 3 * sizeof(std::uint32_t);
+        results.push_back(measure(options, "objects3d_generate_torus", "vertex", geometry.vertexCount, bytes, [&]
+                                  {
+                                      factory.generate(state, GeneratorKind::Torus, mesh.resolution, 255, 0, 0);
+                                      sink = static_cast<float>(state.externalGeometry.edgeCount); }));
+    }
+}
+
+static void benchPrimitives(const BenchOptions &options, std::vector<BenchResult> &results)
+{
+    Objects3d factory;
+    RenderState state;
+    if (selected(options, "objects3d_make_cube"))
+    {
+        results.push_back(measure(options, "objects3d_make_cube", "vertex", 8, 0, [&]
+                                  {
+                                      factory.makeCube(state, 0.5f, 255, 0, 0);
+                                      sink = state.basePoints3d[0].x; }));
+    }
+    if (selected(options, "objects3d_make_pyramid"))
+    {
+        results.push_back(measure(options, "objects3d_make_pyramid", "vertex", 5, 0, [&]
+                                  {
+                                      factory.makePyramid(state, 0.5f, 255, 0, 0);
+                                      sink = state.basePoints3d[0].x; }));
+    }
+}
+
+static void benchFrame(const BenchOptions &options, BenchMesh &mesh, std::vector<BenchResult> &results)
+{
+    if (!selected(options, "frame_software"))
+        return;
+    // The whole software frame: animation, culling, transform, the edge loop
+    // (clip and queue) and rasterization, on one thread
+    Framebuffer framebuffer;
+    framebuffer.resize(TARGET_SIZE, TARGET_SIZE);
+    RenderState &state = mesh.state;
+    state.backend = RenderBackend::Software;
+    state.framebuffer = &framebuffer;
+    state.angleX = ANGLE_X;
+    state.angleY = ANGLE_Y;
+    state.angleZ = ANGLE_Z;
+    state.fixedDeltaSeconds = 1.0f / 60.0f;
+    results.push_back(measure(options, "frame_software", "vertex", mesh.geometry.vertexCount, 0, [&]
+                              {
+                                  framebuffer.clear(packColor(0, 0, 0));
+                                  frame_callback(nullptr, nullptr, &state);
+                                  sink = static_cast<float>(framebuffer.pixels[framebuffer.pixelCount() / 2]); }));
+    state.framebuffer = nullptr;
+}
+
+static void writeJson(std::FILE *file, const BenchOptions &options, const std::vector<BenchResult> &results)
+{
+    static const char *const KERNEL_NAMES[] = {"auto", "scalar", "sse", "avx"};
+    std::fprintf(file, "{\n  \"transform_kernel\": \"%s\",\n  \"repetitions\": %d,\n  \"warmup\": %d,\n  \"min_sample_ms\": %.3f,\n  \"benchmarks\": [\n",
+                 KERNEL_NAMES[static_cast<int>(detectTransformKernel())], options.repetitions, options.warmup, options.minSampleMs);
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult &result = results[i];
+        std::fprintf(file,
+                     "    {\"name\": \"%s\", \"unit\": \"%s\", \"elements\": %zu, \"calls_per_sample\": %zu, \"repetitions\": %d, "
+                     "\"median_ns\": %.1f, \"mad_ns\": %.1f, \"min_ns\": %.1f, \"ns_per_element\": %.4f, ",
+                     result.name.c_str(), result.unit, result.elements, result.innerCalls, result.repetitions, result.medianNs, result.madNs,
+                     result.minNs, result.medianNs / static_cast<double>(result.elements));
+        if (result.bytesPerCall)
+            std::fprintf(file, "\"bytes\": %zu, \"gb_per_s\": %.4f}", result.bytesPerCall, static_cast<double>(result.bytesPerCall) / result.medianNs);
+        else
+            std::fprintf(file, "\"bytes\": null, \"gb_per_s\": null}");
+        std::fprintf(file, "%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+}
+
+static const char *optionValue(const char *arg, const char *name)
+{
+    const std::size_t length = std::strlen(name);
+    return std::strncmp(arg, name, length) == 0 && arg[length] == '=' ? arg + length + 1 : nullptr;
+}
+
+static bool parseCount(const char *text, long minimum, long maximum, long &out)
+{
+    char *end = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < minimum || value > maximum)
+        return false;
+    out = value;
+    return true;
+}
+
+// Comma-separated counts in [minimum, maximum]
+template <typename T>
+static bool parseCountList(const char *text, long minimum, long maximum, std::vector<T> &out)
+{
+    out.clear();
+    const std::string list(text);
+    std::size_t begin = 0;
+    while (begin <= list.size())
+    {
+        const std::size_t end = std::min(list.find(',', begin), list.size());
+        long number = 0;
+        if (!parseCount(list.substr(begin, end - begin).c_str(), minimum, maximum, number))
+            return false;
+        out.push_back(static_cast<T>(number));
+        begin = end + 1;
+    }
+    return true;
+}
+
+static void printUsage(const char *program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --vertices=N[,N...]  Approximate mesh sizes (default 10000,100000,1000000)\n"
+                "  --threads=N[,N...]   Thread counts of the parallel transform (default 1, 2, 4, ... cores)\n"
+                "  --reps=N             Timed samples per benchmark (default 15)\n"
+                "  --warmup=N           Untimed samples before them (default 3)\n"
+                "  --min-time=MS        Repeat small inputs until a sample takes MS (default 2)\n"
+                "  --filter=TEXT        Only run benchmarks whose name contains TEXT\n"
+                "  --json=PATH          Also write the results as JSON (- for stdout)\n"
+                "  --help               Show this message\n",
+                program);
+}
+
+static bool parseOptions(int argc, char **argv, BenchOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = nullptr;
+        long number = 0;
+        if ((value = optionValue(arg, "--vertices")))
+        {
+            if (!parseCountList(value, 1, 100000000L, options.vertexCounts))
+            {
+                std::fprintf(stderr, "Invalid vertex counts '%s'\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--threads")))
+        {
+            if (!parseCountList(value, 1, 1024L, options.threadCounts))
+            {
+                std::fprintf(stderr, "Invalid thread counts '%s'\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--reps")))
+        {
+            if (!parseCount(value, 1, 100000L, number))
+            {
+                std::fprintf(stderr, "Invalid repetition count '%s'\n", value);
+                return false;
+            }
+            options.repetitions = static_cast<int>(number);
+        }
+        else if ((value = optionValue(arg, "--warmup")))
+        {
+            if (!parseCount(value, 0, 100000L, number))
+            {
+                std::fprintf(stderr, "Invalid warmup count '%s'\n", value);
+                return false;
+            }
+            options.warmup = static_cast<int>(number);
+        }
+        else if ((value = optionValue(arg, "--min-time")))
+        {
+            char *end = nullptr;
+            options.minSampleMs = std::strtod(value, &end);
+            if (end == value || *end != '\0' || !(options.minSampleMs >= 0.0))
+            {
+                std::fprintf(stderr, "Invalid sample time '%s'\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--filter")))
+        {
+            options.filter = value;
+        }
+        else if ((value = optionValue(arg, "--json")))
+        {
+            options.jsonPath = value;
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown option '%s'\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--help") == 0)
+        {
+            printUsage(argv[0]);
+            return 0;
+        }
+    }
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    // With --json=- the table goes to stderr so stdout stays valid JSON
+    const bool jsonToStdout = options.jsonPath && std::strcmp(options.jsonPath, "-") == 0;
+    if (jsonToStdout)
+        tableFile = stderr;
+
+    std::fprintf(tableFile, "%-34s %10s %-8s %12s %10s %10s %8s\n", "benchmark", "elements", "unit", "median_us", "mad_us", "ns/elem", "GB/s");
+    if (!checkTransformAccuracy())
+        return 1;
+    std::vector<BenchResult> results;
+    benchPrimitives(options, results);
+    for (const std::size_t vertices : options.vertexCounts)
+    {
+        BenchMesh mesh;
+        if (!buildMesh(mesh, vertices))
+        {
+            std::fprintf(stderr, "Cannot generate a mesh with %zu vertices\n", vertices);
+            return 1;
+        }
+        benchPerPoint(options, mesh, results);
+        benchTransform(options, mesh, results);
+        if (!benchTransformParallel(options, mesh, results))
+            return 1;
+        benchClip<false>(options, mesh, "clip_edges", results);
+        benchClip<true>(options, mesh, "clip_edges_inverse_depth", results);
+        benchRasterize(options, mesh, results);
+        benchEdgeSet(options, mesh, results);
+        benchBuilders(options, mesh, results);
+        benchFrame(options, mesh, results);
+    }
+
+    if (options.jsonPath)
+    {
+        std::FILE *file = jsonToStdout ? stdout : std::fopen(options.jsonPath, "w");
+        if (!file)
+        {
+            std::fprintf(stderr, "Cannot write '%s'\n", options.jsonPath);
+            return 1;
+        }
+        writeJson(file, options, results);
+        if (file != stdout)
+            std::fclose(file);
+    }
+    return 0;
+}
@@ -7,11 +7,193 @@
 //  - SDL is initialized on entry and cleaned up on exit
 //  - SDL_Window and SDL_Renderer are created once and destroyed after the loop
 //  - The loop runs while the provided user state indicates 'running == true'
+//  - With the software backend, frames are rasterized into a Framebuffer owned
+//    here and uploaded through one streaming texture per frame
+//  - In pipelined mode a FramePipeline worker prepares the frames and this
+//    thread only forwards events, submits and presents
 //
 #define SDL_MAIN_HANDLED
 #include "../2d_renderer/2d_renderer.h"
+#include "../3d_renderer/3d_renderer.h" // replayDrawCommands
 #include "../app_state/app_state.h"
+#include "../app_state/dirty_tracking.h"
+#include "../diagnostics/allocation_counter.h"
+#include "../diagnostics/frame_profiler.h"
+#include "../diagnostics/latency_stats.h"
+#include "../diagnostics/profiler_overlay.h"
 #include "../input/input.h"
+#include "../framebuffer/framebuffer.h"
+#include "../frame_export/frame_exporter.h"
+#include "../frame_export/shm_frame_ring.h"
+#include "../mesh_io/background_loader.h"
+#include "../pipeline/frame_pipeline.h"
+#include "../replay/input_trace.h"
+#include "../threading/thread_pool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Longest time the idle loop blocks without an event before re-checking the
+// state (changes made from other threads have no event of their own)
+constexpr int IDLE_WAIT_MS = 250;
+
+// What the interactive loop needs to put frames on screen and measure them
+struct FramePresenter
+{
+    SDL_Renderer *renderer = nullptr;
+    SDL_Texture *texture = nullptr; ///< Streaming texture of the software backend
+    int textureWidth = 0;
+    int textureHeight = 0;
+    FrameProfiler profiler;    ///< Stage history shown by the overlay and exported as CSV
+    ProfilerOverlay overlay;   ///< Drawn while ProfilerControls::overlay is set
+    LatencyStats inputLatency; ///< Input to present
+};
+
+// Upload the software framebuffer and copy it to the backbuffer. The texture is
+// (re)created whenever the framebuffer size changes. Returns false on failure.
+static bool presentFramebuffer(FramePresenter &presenter, const Framebuffer &framebuffer)
+{
+    SDL_Renderer *renderer = presenter.renderer;
+    SDL_Texture *&texture = presenter.texture;
+    int &textureWidth = presenter.textureWidth;
+    int &textureHeight = presenter.textureHeight;
+    if (framebuffer.width <= 0 || framebuffer.height <= 0)
+        return true; // Minimized window, nothing to upload
+
+    if (!texture || textureWidth != framebuffer.width || textureHeight != framebuffer.height)
+    {
+        if (texture)
+            SDL_DestroyTexture(texture);
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, framebuffer.width, framebuffer.height);
+        if (!texture)
+        {
+            SDL_Log("SDL_CreateTexture failed: %s", SDL_GetError());
+            return false;
+        }
+        textureWidth = framebuffer.width;
+        textureHeight = framebuffer.height;
+    }
+
+    SDL_UpdateTexture(texture, nullptr, framebuffer.pixels, framebuffer.pitch());
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+    return true;
+}
+
+// handleEvent for live input: during --replay only quitting gets through, and
+// with --record every event that changed the state is logged
+static bool dispatchEvent(RenderState *state, const SDL_Event &event)
+{
+    if (state->inputReplay && !InputReplay::passesLiveEvent(event))
+        return false;
+    const bool handled = handleEvent(state, event);
+    if (handled && state->inputRecorder)
+        state->inputRecorder->recordEvent(event);
+    return handled;
+}
+
+// Write the profiler history for the D key / --profile=PATH
+static void dumpProfile(const FrameProfiler &profiler, const ProfilerControls &controls)
+{
+    const char *path = controls.csvPath ? controls.csvPath : "frame_profile.csv";
+    std::string error;
+    if (profiler.writeCsv(path, error))
+        SDL_Log("Wrote %zu profiled frames to %s", profiler.size(), path);
+    else
+        SDL_Log("Profile export failed: %s", error.c_str());
+}
+
+// Overlay, present, and the bookkeeping that follows every presented frame.
+// sample (null when not profiling) is committed to the history with its
+// frame time measured from frameStart.
+static void finishFrame(FramePresenter &presenter, const ProfilerControls &controls, FrameProfileSample *sample,
+                        Uint64 frameStart, Uint64 inputTimestamp)
+{
+    {
+        StageTimer timer(sample, ProfileStage::Present);
+        if (controls.overlay)
+            presenter.overlay.draw(presenter.renderer, presenter.profiler);
+        SDL_RenderPresent(presenter.renderer);
+    }
+
+    const Uint64 presentEnd = SDL_GetPerformanceCounter();
+    if (inputTimestamp != 0)
+        presenter.inputLatency.recordTicks(presentEnd - inputTimestamp, SDL_GetPerformanceFrequency());
+    if (sample)
+    {
+        sample->frameTicks = presentEnd - frameStart;
+        presenter.profiler.commit(*sample);
+        *sample = FrameProfileSample{};
+    }
+    if (controls.dumpRequested)
+        dumpProfile(presenter.profiler, controls);
+}
+
+// Pipelined main loop: forward events to the worker and present what it
+// prepared. Returns the number of frames presented.
+static std::uint64_t runPipelinedLoop(FramePresenter &presenter, RenderState &state, RendererFrameCallback on_frame)
+{
+    SDL_Renderer *renderer = presenter.renderer;
+    // The worker pushes this event after each published frame, ending the wait below
+    const Uint32 wakeEvent = SDL_RegisterEvents(1);
+    FramePipeline pipeline(state, on_frame, wakeEvent == static_cast<Uint32>(-1) ? 0 : wakeEvent);
+    pipeline.start();
+
+    std::uint64_t presented = 0;
+    Uint64 lastPresent = 0;
+    Uint64 eventTicks = 0; // Forwarding time, charged to the next presented frame
+    while (!pipeline.finished())
+    {
+        SDL_Event event;
+        if (SDL_WaitEventTimeout(&event, IDLE_WAIT_MS))
+        {
+            const Uint64 eventStart = SDL_GetPerformanceCounter();
+            do
+            {
+                if (event.type != wakeEvent)
+                    pipeline.postEvent(event, SDL_GetPerformanceCounter());
+            } while (SDL_PollEvent(&event));
+            eventTicks += SDL_GetPerformanceCounter() - eventStart;
+        }
+
+        if (!pipeline.acquireFrame())
+            continue;
+        PipelineFrame &frame = pipeline.frame();
+        FrameProfileSample *sample = frame.profiling ? &frame.profile : nullptr;
+        if (sample)
+            sample->stageTicks[static_cast<std::size_t>(ProfileStage::Events)] += eventTicks;
+        eventTicks = 0;
+
+        {
+            StageTimer timer(sample, ProfileStage::Present);
+            if (frame.backend == RenderBackend::Software)
+            {
+                if (!presentFramebuffer(presenter, frame.framebuffer))
+                {
+                    SDL_Log("renderer_run: falling back to the SDL_Renderer backend");
+                    pipeline.requestSdlRenderer();
+                }
+            }
+            else
+            {
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                SDL_RenderClear(renderer);
+                replayDrawCommands(renderer, frame.commands);
+            }
+        }
+
+        // Frame time runs from the later of the previous present and the start
+        // of this frame's preparation, so idle gaps are not counted
+        const Uint64 frameStart = std::max(lastPresent, frame.prepareStart);
+        finishFrame(presenter, frame.profilerControls, sample, frameStart, frame.inputTimestamp);
+        lastPresent = SDL_GetPerformanceCounter();
+        ++presented;
+    }
+
+    pipeline.stop();
+    return presented;
+}
 
 // Runs the SDL renderer
 int renderer_run(const char *title, int width, int height, RendererFrameCallback on_frame, void *userData)
@@ -67,30 +249,147 @@ int renderer_run(const char *title, int width, int height, RendererFrameCallback
         return 1;
     }
 
-    // Main loop
-    while (state->running)
+    // Software backend target; the frame callback draws into it through the state
+    Framebuffer framebuffer;
+    state->framebuffer = &framebuffer;
+
+    // Texture upload, profiler history / overlay and latency statistics
+    FramePresenter presenter;
+    presenter.renderer = renderer;
+
+    // Persistent workers for the tiled software rasterizer
+    ThreadPool threadPool(static_cast<unsigned>(state->rasterThreads > 0 ? state->rasterThreads : 0));
+    state->threadPool = &threadPool;
+
+    // A mesh finished in the background ends the idle wait, so it is shown right away
+    const Uint32 meshReadyEvent = state->meshLoader ? SDL_RegisterEvents(1) : static_cast<Uint32>(-1);
+    if (meshReadyEvent != static_cast<Uint32>(-1))
+        state->meshLoader->setWakeEvent(meshReadyEvent);
+
+    // Skipped frames are counted in display refreshes
+    SDL_DisplayMode displayMode;
+    const double refreshHz = (SDL_GetWindowDisplayMode(window, &displayMode) == 0 && displayMode.refresh_rate > 0) ? displayMode.refresh_rate : 60.0;
+    const double ticksToSeconds = 1.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+    // Time from receiving an input that changed the state to presenting the first frame showing it
+    Uint64 inputTimestamp = 0;
+    const Uint64 loopStart = SDL_GetPerformanceCounter();
+
+    if (state->pipelined)
+    {
+        state->pacing.framesDrawn += runPipelinedLoop(presenter, *state, on_frame);
+        state->pacing.framesSkipped = static_cast<std::uint64_t>(state->pacing.idleSeconds * refreshHz);
+    }
+
+    // Main loop (sequential mode)
+    FrameProfileSample profileSample;
+    while (state->running && !state->pipelined)
     {
+        const Uint64 frameStart = SDL_GetPerformanceCounter();
+        FrameProfileSample *sample = (state->profiler.enabled || state->profiler.overlay) ? &profileSample : nullptr;
+
         // Handle events (input.cpp translates events into state changes)
         SDL_Event event;
-        while (SDL_PollEvent(&event))
         {
-            handleEvent(state, event);
+            StageTimer timer(sample, ProfileStage::Events);
+            while (SDL_PollEvent(&event))
+            {
+                if (dispatchEvent(state, event) && inputTimestamp == 0)
+                    inputTimestamp = SDL_GetPerformanceCounter();
+            }
         }
 
-        // Set the render color to black
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+        if (state->inputReplay)
+        {
+            // The trace decides what changes, and every recorded frame was drawn
+            if (!state->inputReplay->applyNextFrame(*state))
+            {
+                state->running = false;
+                break;
+            }
+        }
+        else if (frameDirtyFlags(*state) == 0)
+        {
+            // Static image: sleep until an event arrives instead of redrawing the same frame
+            const Uint64 idleStart = SDL_GetPerformanceCounter();
+            if (SDL_WaitEventTimeout(&event, IDLE_WAIT_MS) && dispatchEvent(state, event) && inputTimestamp == 0)
+            {
+                inputTimestamp = SDL_GetPerformanceCounter();
+            }
+            state->pacing.idleSeconds += static_cast<double>(SDL_GetPerformanceCounter() - idleStart) * ticksToSeconds;
+            state->pacing.framesSkipped = static_cast<std::uint64_t>(state->pacing.idleSeconds * refreshHz);
 
-        // Clear the screen
-        SDL_RenderClear(renderer);
+            // Resume animation from now rather than jumping by the idle time
+            state->lastPerformanceCounter = 0;
+            profileSample = FrameProfileSample{};
+            continue;
+        }
 
-        // Render the frame (issue all draw calls through the callback)
-        if (on_frame)
+        state->profileSample = sample;
+        if (state->backend == RenderBackend::Software)
         {
-            on_frame(window, renderer, userData);
+            // Rasterize on the CPU, then upload the whole frame at once
+            {
+                StageTimer timer(sample, ProfileStage::Rasterize);
+                framebuffer.resize(state->screenWidth, state->screenHeight);
+                framebuffer.clear(packColor(0, 0, 0));
+            }
+
+            if (on_frame)
+            {
+                on_frame(window, renderer, userData);
+            }
+
+            StageTimer timer(sample, ProfileStage::Present);
+            if (!presentFramebuffer(presenter, framebuffer))
+            {
+                SDL_Log("renderer_run: falling back to the SDL_Renderer backend");
+                state->backend = RenderBackend::SdlRenderer;
+            }
         }
+        else
+        {
+            // Set the render color to black
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+
+            // Clear the screen
+            SDL_RenderClear(renderer);
+
+            // Render the frame (issue all draw calls through the callback)
+            if (on_frame)
+            {
+                on_frame(window, renderer, userData);
+            }
+        }
+
+        state->profileSample = nullptr;
 
         // Present the rendered frame
-        SDL_RenderPresent(renderer);
+        finishFrame(presenter, state->profiler, sample, frameStart, inputTimestamp);
+        inputTimestamp = 0;
+        state->profiler.dumpRequested = false;
+        markFramePresented(*state);
+        ++state->pacing.framesDrawn;
+        if (state->inputRecorder)
+            state->inputRecorder->endFrame(state->lastDeltaSeconds);
+    }
+
+    const double loopSeconds = static_cast<double>(SDL_GetPerformanceCounter() - loopStart) * ticksToSeconds;
+    SDL_Log("Frames drawn: %llu, skipped while idle: %llu (%.1f s idle)",
+            static_cast<unsigned long long>(state->pacing.framesDrawn),
+            static_cast<unsigned long long>(state->pacing.framesSkipped), state->pacing.idleSeconds);
+    SDL_Log("%s loop: %.1f frames/s while drawing, input to present mean %.2f ms p95 %.2f ms max %.2f ms (%zu inputs)",
+            state->pipelined ? "Pipelined" : "Sequential",
+            loopSeconds > state->pacing.idleSeconds ? static_cast<double>(state->pacing.framesDrawn) / (loopSeconds - state->pacing.idleSeconds) : 0.0,
+            presenter.inputLatency.mean(), presenter.inputLatency.percentile(0.95), presenter.inputLatency.max(), presenter.inputLatency.count());
+
+    state->framebuffer = nullptr;
+    state->threadPool = nullptr;
+    if (state->meshLoader)
+        state->meshLoader->setWakeEvent(0);
+    if (presenter.texture)
+    {
+        SDL_DestroyTexture(presenter.texture);
     }
 
     // Shutdown renderer
@@ -103,4 +402,380 @@ int renderer_run(const char *title, int width, int height, RendererFrameCallback
     SDL_Quit();
 
     return 0;
-}
\ No newline at end of file
+}
+
+// Headless benchmark
+// ------------------
+
+// FNV-1a over the visible pixels of each row (pitch padding excluded)
+static std::uint64_t hashPixels(const void *pixels, int width, int height, int pitch)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto *rowBytes = static_cast<const unsigned char *>(pixels);
+    for (int y = 0; y < height; ++y, rowBytes += pitch)
+    {
+        for (int i = 0; i < width * 4; ++i)
+        {
+            hash = (hash ^ rowBytes[i]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+// Headless runs inject an input every this many frames to measure input latency
+constexpr int INPUT_PROBE_INTERVAL = 8;
+
+// Nearest-rank percentile of an ascending sorted sample
+static double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    const size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+int renderer_run_headless(const HeadlessConfig &config, RendererFrameCallback on_frame, void *userData)
+{
+    RenderState *state = static_cast<RenderState *>(userData);
+    if (!state)
+    {
+        SDL_Log("renderer_run_headless: userData (RenderState*) is null");
+        return 1;
+    }
+
+    // No subsystems needed: the software renderer draws into a plain surface
+    if (SDL_Init(0) != 0)
+    {
+        SDL_Log("SDL_Init failed: %s", SDL_GetError());
+        return 1;
+    }
+
+    const int width = config.width > 0 ? config.width : 800;
+    const int height = config.height > 0 ? config.height : 600;
+    state->screenWidth = width;
+    state->screenHeight = height;
+
+    SDL_Surface *surface = nullptr;
+    SDL_Renderer *renderer = nullptr;
+    Framebuffer framebuffer;
+    ThreadPool threadPool(static_cast<unsigned>(state->rasterThreads > 0 ? state->rasterThreads : 0));
+    state->threadPool = &threadPool;
+    if (state->backend == RenderBackend::Software)
+    {
+        framebuffer.resize(width, height);
+        state->framebuffer = &framebuffer;
+    }
+    else
+    {
+        surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+        renderer = surface ? SDL_CreateSoftwareRenderer(surface) : nullptr;
+        if (!renderer)
+        {
+            SDL_Log("Offscreen software renderer failed: %s", SDL_GetError());
+            if (surface)
+                SDL_FreeSurface(surface);
+            state->threadPool = nullptr;
+            SDL_Quit();
+            return 1;
+        }
+    }
+
+    // --export: frames are copied here and written on the exporter's thread
+    FrameExporter exporter;
+    if (config.exportPath)
+    {
+        std::string error;
+        if (!exporter.open(config.exportPath, config.exportFormat, width, height, config.exportFramesPerSecond, config.exportQueueFrames, error))
+        {
+            SDL_Log("Export failed: %s", error.c_str());
+            if (renderer)
+                SDL_DestroyRenderer(renderer);
+            if (surface)
+                SDL_FreeSurface(surface);
+            state->framebuffer = nullptr;
+            state->threadPool = nullptr;
+            SDL_Quit();
+            return 1;
+        }
+    }
+    bool exportFailed = false;
+
+    // --shm: frames are published to a shared-memory ring for another process
+    ShmFrameRing shmRing;
+    if (config.shmName)
+    {
+        std::string error;
+        if (!shmRing.open(config.shmName, width, height, config.shmSlots, config.shmLossless, error))
+        {
+            SDL_Log("Shared-memory output failed: %s", error.c_str());
+            if (renderer)
+                SDL_DestroyRenderer(renderer);
+            if (surface)
+                SDL_FreeSurface(surface);
+            state->framebuffer = nullptr;
+            state->threadPool = nullptr;
+            SDL_Quit();
+            return 1;
+        }
+        // Lossless: hold the run until the consumer is there for frame 1
+        shmRing.waitForAttach();
+        if (shmRing.stats().attachTimedOut)
+            SDL_Log("Shared-memory output: no consumer attached to %s; frames published before one does are lost", config.shmName);
+    }
+
+    const double ticksToMs = 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+    std::vector<double> frameMs;
+    frameMs.reserve(static_cast<size_t>(std::max(config.frameCount, 0)));
+
+    // Heap allocations (debug builds). The first frame sizes the per-geometry
+    // buffers and scratch may still grow during the first half of the run;
+    // the second half is the steady state and must not allocate.
+    std::uint64_t firstFrameAllocations = 0, warmupAllocations = 0, steadyAllocations = 0;
+    int lastAllocatingFrame = -1;
+
+    // In pipelined mode the worker owns the state until pipeline.stop(). Every
+    // frame is rendered, as in the sequential loop, so a still image
+    // (--rotate=0,0,0) is benchmarked too instead of waiting for a change
+    FramePipeline pipeline(*state, on_frame, 0);
+    const bool pipelined = state->pipelined;
+    if (pipelined)
+    {
+        pipeline.prepareEveryFrame();
+        pipeline.start();
+    }
+
+    // A probe input that changes nothing visible; its latency runs until the
+    // first frame prepared after it is presented
+    LatencyStats inputLatency;
+    SDL_Event probe{};
+    probe.type = SDL_WINDOWEVENT;
+    probe.window.event = SDL_WINDOWEVENT_EXPOSED;
+
+    // --profile: stage times of every frame
+    const bool profiling = state->profiler.enabled;
+    FrameProfiler profiler(profiling ? static_cast<std::size_t>(std::max(config.frameCount, 1)) : 1);
+    FrameProfileSample profileSample;
+
+    const Uint64 runStart = SDL_GetPerformanceCounter();
+    for (int frame = 0; frame < config.frameCount && (pipelined ? !pipeline.finished() : state->running); ++frame)
+    {
+        const std::uint64_t allocationsBefore = heapAllocationCount();
+        const Uint64 frameStart = SDL_GetPerformanceCounter();
+        Uint64 inputTimestamp = 0;
+        const bool probeFrame = frame % INPUT_PROBE_INTERVAL == 0;
+        FrameProfileSample *sample = profiling ? &profileSample : nullptr;
+        const Framebuffer *frameImage = &framebuffer; // Software backend result of this frame
+        // The software backend draws straight into the ring's next slot
+        std::uint32_t *shmPixels = shmRing.isOpen() ? shmRing.beginFrame() : nullptr;
+        const bool shmInPlace = shmPixels && !pipelined && !renderer;
+        if (shmInPlace)
+            framebuffer.attach(shmPixels, width, height);
+
+        if (pipelined)
+        {
+            if (probeFrame)
+                pipeline.postEvent(probe, frameStart);
+            bool acquired = pipeline.acquireFrame();
+            while (!acquired && !pipeline.finished())
+            {
+                pipeline.waitForFrame(IDLE_WAIT_MS);
+                acquired = pipeline.acquireFrame();
+            }
+            if (!acquired)
+                break;
+            PipelineFrame &prepared = pipeline.frame();
+            sample = prepared.profiling ? &prepared.profile : nullptr;
+            frameImage = &prepared.framebuffer;
+            if (renderer)
+            {
+                StageTimer timer(sample, ProfileStage::Present);
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                SDL_RenderClear(renderer);
+                replayDrawCommands(renderer, prepared.commands);
+            }
+            inputTimestamp = prepared.inputTimestamp;
+        }
+        else
+        {
+            if (state->inputReplay && !state->inputReplay->applyNextFrame(*state))
+                break;
+            if (probeFrame && handleEvent(state, probe))
+                inputTimestamp = frameStart;
+            if (renderer)
+            {
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                SDL_RenderClear(renderer);
+            }
+            else
+            {
+                StageTimer timer(sample, ProfileStage::Rasterize);
+                framebuffer.clear(packColor(0, 0, 0));
+            }
+
+            state->profileSample = sample;
+            if (on_frame)
+            {
+                on_frame(nullptr, renderer, userData);
+            }
+            state->profileSample = nullptr;
+            if (state->inputRecorder)
+                state->inputRecorder->endFrame(state->lastDeltaSeconds);
+        }
+
+        if (renderer)
+        {
+            StageTimer timer(sample, ProfileStage::Present);
+            SDL_RenderPresent(renderer);
+        }
+        if (config.exportPath)
+        {
+            // Only waits when every export buffer is still queued for writing
+            StageTimer timer(sample, ProfileStage::Present);
+            std::uint32_t *exportPixels = exporter.beginFrame();
+            if (!exportPixels)
+            {
+                exportFailed = true;
+                break;
+            }
+            if (renderer)
+                SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, exportPixels, width * 4);
+            else if (frameImage->pixelCount() == static_cast<std::size_t>(width) * static_cast<std::size_t>(height))
+                std::memcpy(exportPixels, frameImage->pixels, frameImage->pixelCount() * sizeof(std::uint32_t));
+            exporter.submitFrame();
+        }
+        if (shmPixels)
+        {
+            StageTimer timer(sample, ProfileStage::Present);
+            if (renderer)
+                SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, shmPixels, static_cast<int>(shmRing.stride()));
+            else if (!shmInPlace && frameImage->pixelCount() == static_cast<std::size_t>(width) * static_cast<std::size_t>(height))
+                std::memcpy(shmPixels, frameImage->pixels, frameImage->pixelCount() * sizeof(std::uint32_t));
+            shmRing.publish(!shmInPlace);
+        }
+        const Uint64 frameEnd = SDL_GetPerformanceCounter();
+        if (sample)
+        {
+            sample->frameTicks = frameEnd - frameStart;
+            profiler.commit(*sample);
+            *sample = FrameProfileSample{};
+        }
+        frameMs.push_back(static_cast<double>(frameEnd - frameStart) * ticksToMs);
+        if (inputTimestamp != 0)
+            inputLatency.recordTicks(frameEnd - inputTimestamp, SDL_GetPerformanceFrequency());
+
+        const std::uint64_t frameAllocations = heapAllocationCount() - allocationsBefore;
+        if (frame == 0)
+            firstFrameAllocations = frameAllocations;
+        else if (frame < config.frameCount / 2)
+            warmupAllocations += frameAllocations;
+        else
+            steadyAllocations += frameAllocations;
+        if (frameAllocations > 0)
+            lastAllocatingFrame = frame;
+    }
+    const double totalMs = static_cast<double>(SDL_GetPerformanceCounter() - runStart) * ticksToMs;
+
+    // The last frame stays in the pipeline's read slot for the checksum
+    pipeline.stop();
+    const Framebuffer &finalFramebuffer = pipelined ? pipeline.frame().framebuffer : framebuffer;
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    const double fps = totalMs > 0.0 ? static_cast<double>(frameMs.size()) * 1000.0 / totalMs : 0.0;
+    std::printf("backend=%s size=%dx%d threads=%u frames=%zu vertices=%zu edges=%zu pipeline=%s\n",
+                state->backend == RenderBackend::Software ? "software" : "sdl", width, height, threadPool.threadCount(),
+                frameMs.size(), state->geometry.vertexCount, state->geometry.edgeCount, state->specializedPipeline ? "specialized" : "generic");
+    std::printf("total=%.3f ms fps=%.1f p50=%.4f ms p95=%.4f ms p99=%.4f ms max=%.4f ms\n",
+                totalMs, fps, percentile(sorted, 0.50), percentile(sorted, 0.95), percentile(sorted, 0.99),
+                sorted.empty() ? 0.0 : sorted.back());
+    if (profiling)
+    {
+        double stageMs[PROFILE_STAGE_COUNT];
+        const double meanFrameMs = profiler.average(profiler.size(), stageMs);
+        std::printf("stage_mean_ms frame=%.4f", meanFrameMs);
+        for (std::size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+            std::printf(" %s=%.4f", profileStageName(static_cast<ProfileStage>(stage)), stageMs[stage]);
+        std::printf("\n");
+        std::string error;
+        if (state->profiler.csvPath && !profiler.writeCsv(state->profiler.csvPath, error))
+            SDL_Log("Profile export failed: %s", error.c_str());
+    }
+    std::printf("input_latency mode=%s mean=%.4f ms p95=%.4f ms max=%.4f ms samples=%zu\n", pipelined ? "pipelined" : "sequential",
+                inputLatency.mean(), inputLatency.percentile(0.95), inputLatency.max(), inputLatency.count());
+    if (!state->scene.instances.empty())
+    {
+        std::size_t instancedVertices = 0, instancedEdges = 0;
+        for (const SceneInstance &instance : state->scene.instances)
+        {
+            instancedVertices += state->scene.meshes[instance.mesh].geometry.vertexCount;
+            instancedEdges += state->scene.meshes[instance.mesh].geometry.edgeCount;
+        }
+        std::printf("scene meshes=%zu instances=%zu instanced_vertices=%zu instanced_edges=%zu bvh_builds=%llu bvh_refits=%llu\n",
+                    state->scene.meshes.size(), state->scene.instances.size(), instancedVertices, instancedEdges,
+                    static_cast<unsigned long long>(state->scene.bvh.builds), static_cast<unsigned long long>(state->scene.bvh.refits));
+    }
+    const CullStats &cull = state->cullStats;
+    std::printf("last_frame bvh_nodes_visited=%zu instances_culled=%zu instances_drawn=%zu object_culled=%d object_lod=%d lod_edges_skipped=%zu edges_occluded=%zu\n",
+                cull.nodesVisited, cull.instancesCulled, cull.instancesDrawn, cull.objectCulled ? 1 : 0, state->geometryLodLevel,
+                cull.lodEdgesSkipped, cull.edgesOccluded);
+    const ClipStats &clip = state->clipStats;
+    std::printf("last_frame points_culled=%zu edges_culled=%zu edges_near_clipped=%zu edges_viewport_clipped=%zu\n",
+                clip.pointsCulled, clip.edgesCulled, clip.edgesNearClipped, clip.edgesViewportClipped);
+    if (config.exportPath)
+    {
+        std::string error;
+        exportFailed = !exporter.finish(error) || exportFailed;
+        const ExportStats &exported = exporter.stats();
+        const double exportFps = exported.seconds > 0.0 ? static_cast<double>(exported.frames) / exported.seconds : 0.0;
+        const double megabytesPerSecond = exported.seconds > 0.0 ? static_cast<double>(exported.bytes) / 1e6 / exported.seconds : 0.0;
+        std::printf("export format=%s path=%s frames=%llu bytes=%llu seconds=%.3f fps=%.1f mb_per_s=%.1f writer_busy=%.0f%% stalls=%llu stall_ms=%.3f\n",
+                    exportFormatName(config.exportFormat), config.exportPath, static_cast<unsigned long long>(exported.frames),
+                    static_cast<unsigned long long>(exported.bytes), exported.seconds, exportFps, megabytesPerSecond,
+                    exported.seconds > 0.0 ? 100.0 * exported.writeSeconds / exported.seconds : 0.0, static_cast<unsigned long long>(exported.stalls),
+                    exported.stallSeconds * 1000.0);
+        if (exportFailed)
+            SDL_Log("Export failed: %s", error.c_str());
+    }
+    if (shmRing.isOpen())
+    {
+        shmRing.finish();
+        const ShmFrameRingStats &shared = shmRing.stats();
+        std::printf("shm name=%s slots=%u frames=%llu copied=%llu lossless=%d attach_ms=%.3f attach_timed_out=%d waits=%llu wait_ms=%.3f\n",
+                    config.shmName, config.shmSlots, static_cast<unsigned long long>(shared.frames),
+                    static_cast<unsigned long long>(shared.copiedFrames), config.shmLossless ? 1 : 0, shared.attachSeconds * 1000.0,
+                    shared.attachTimedOut ? 1 : 0, static_cast<unsigned long long>(shared.waits), shared.waitSeconds * 1000.0);
+    }
+    if (HEAP_ALLOCATION_COUNTING)
+    {
+        std::printf("heap_allocations first_frame=%llu warmup=%llu steady=%llu last_allocating_frame=%d\n",
+                    static_cast<unsigned long long>(firstFrameAllocations), static_cast<unsigned long long>(warmupAllocations),
+                    static_cast<unsigned long long>(steadyAllocations), lastAllocatingFrame);
+        if (steadyAllocations > 0)
+            SDL_Log("Warning: %llu heap allocations in steady-state frames", static_cast<unsigned long long>(steadyAllocations));
+    }
+
+    if (config.printChecksum)
+    {
+        std::uint64_t checksum = 0;
+        if (renderer)
+        {
+            std::vector<std::uint32_t> pixels(static_cast<size_t>(width) * static_cast<size_t>(height));
+            SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, pixels.data(), width * 4);
+            checksum = hashPixels(pixels.data(), width, height, width * 4);
+        }
+        else
+        {
+            checksum = hashPixels(finalFramebuffer.pixels, finalFramebuffer.width, finalFramebuffer.height, finalFramebuffer.pitch());
+        }
+        std::printf("checksum=%016llx\n", static_cast<unsigned long long>(checksum));
+    }
+
+    state->framebuffer = nullptr;
+    state->threadPool = nullptr;
+    if (renderer)
+        SDL_DestroyRenderer(renderer);
+    if (surface)
+        SDL_FreeSurface(surface);
+    SDL_Quit();
+    return exportFailed ? 1 : 0;
+}
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <SDL2/SDL.h>
+#include "../frame_export/frame_exporter.h" // ExportFormat
+#include <cstddef>
 
 /**
  * @brief Per-frame callback invoked by the render loop.
@@ -31,6 +33,24 @@ using RendererFrameCallback = void (*)(SDL_Window *window, SDL_Renderer *rendere
  *  - calls the supplied frame callback,
  *  - presents the backbuffer.
  *
+ * Frames are only drawn when something they depend on changed (see
+ * dirty_tracking.h). While the image is static, for instance when every
+ * rotation speed is 0, the loop blocks in SDL_WaitEventTimeout and skips
+ * transform, draw and present. The first change, such as an event or a state
+ * update noticed when the wait times out, brings back full-rate rendering.
+ * RenderState::pacing counts drawn and skipped frames, and the totals are
+ * logged on exit.
+ *
+ * With RenderState::inputRecorder set, every event that changed the state
+ * and the animation step of every drawn frame are logged to the trace. With
+ * RenderState::inputReplay set, live input other than quitting is ignored,
+ * each frame first applies the trace's next frame of events, frames are drawn
+ * without idle skipping, and the loop ends with the trace.
+ *
+ * When RenderState::backend is RenderBackend::Software the callback draws
+ * into RenderState::framebuffer instead, and the loop uploads that buffer
+ * with one SDL_UpdateTexture/SDL_RenderCopy before presenting.
+ *
  * The loop terminates when the userData-provided state indicates shutdown
  * (e.g., RenderState::running is false) or when a fatal SDL error occurs.
  *
@@ -42,3 +62,58 @@ using RendererFrameCallback = void (*)(SDL_Window *window, SDL_Renderer *rendere
  * @return int      0 on normal shutdown, non-zero on initialization error.
  */
 int renderer_run(const char *title, int width, int height, RendererFrameCallback on_frame, void *userData);
+
+/**
+ * @brief Settings for an offscreen, fixed-length benchmark run.
+ */
+struct HeadlessConfig
+{
+    int width = 1000;           ///< Offscreen target width in pixels
+    int height = 1000;          ///< Offscreen target height in pixels
+    int frameCount = 1000;      ///< Number of frames to render
+    bool printChecksum = false; ///< Print an FNV-1a hash of the final frame
+
+    // Frame-sequence export (null exportPath = none)
+    const char *exportPath = nullptr;              ///< Output file, "-" = stdout
+    ExportFormat exportFormat = ExportFormat::Y4m; ///< Stream encoding
+    double exportFramesPerSecond = 60.0;           ///< Playback rate recorded in the stream
+    std::size_t exportQueueFrames = 4;             ///< Frame buffers between the loop and the writer
+
+    // Shared-memory frame ring (null shmName = none)
+    const char *shmName = nullptr; ///< POSIX shared-memory object the frames are published to
+    unsigned shmSlots = 3;         ///< Frame buffers in the ring
+    bool shmLossless = false;      ///< Wait for the consumer to take each frame
+};
+
+/**
+ * @brief Render a fixed number of frames without a window and report timing.
+ *
+ * No video subsystem, window or VSync is involved. With the SDL_Renderer
+ * backend the callback draws through SDL's software renderer into a memory
+ * surface; with the software backend it draws into a Framebuffer. The window
+ * argument of the callback is null. Events are not polled, so the run stops
+ * after config.frameCount frames (or earlier if RenderState::running is
+ * cleared). Set RenderState::fixedDeltaSeconds beforehand for a reproducible
+ * animation. Traces are recorded and replayed as in renderer_run (one trace
+ * frame per rendered frame; pipelined mode takes no traces).
+ *
+ * With config.exportPath set, every frame is also copied into a
+ * FrameExporter and written by its thread; the copy counts toward the frame
+ * time, the write does not unless the exporter's queue is full. The export
+ * stream's frames/sec, MB/s and stalls are printed after the drain.
+ *
+ * With config.shmName set, every frame is published to a ShmFrameRing. The
+ * software backend (without the pipeline) rasterizes straight into the
+ * ring's slot; otherwise the finished frame is copied into it.
+ *
+ * Prints frames/sec and p50/p95/p99 frame times (callback plus present) to
+ * stdout, and optionally the final-frame checksum. Debug builds also print
+ * the heap allocations of the first frame, the rest of the first half and
+ * the second (steady-state) half of the run, and warn if the latter is not 0.
+ *
+ * @param config   Target size, frame count, checksum flag and export stream.
+ * @param on_frame User callback invoked once per frame.
+ * @param userData RenderState passed to the callback.
+ * @return int     0 on success, non-zero on initialization error.
+ */
+int renderer_run_headless(const HeadlessConfig &config, RendererFrameCallback on_frame, void *userData);
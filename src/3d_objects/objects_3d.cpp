@@ -1,15 +1,38 @@
 // objects_3d.cpp
-// Implementation of simple wireframe primitives: cube, pyramid.
+// Implementation of simple wireframe primitives (cube, pyramid) and the
+// parametric stress-scene generators.
 
 #include "objects_3d.h"
+#include "../framebuffer/framebuffer.h" // packColor
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
 #include <utility>
 #include <vector>
 
+// Every array of a generated mesh starts on its own cache line
+constexpr std::size_t GENERATED_ALIGNMENT = 64;
+
+// Point clouds are seeded with a constant so runs are reproducible
+constexpr std::uint64_t POINT_CLOUD_SEED = 0x3D3D3D3DULL;
+
+// Torus radii (ring and tube), chosen so the torus fits in the unit sphere
+constexpr double TORUS_RING_RADIUS = 0.7;
+constexpr double TORUS_TUBE_RADIUS = 0.3;
+
+// Lattice cubes fill this fraction of their cell along each axis
+constexpr double LATTICE_FILL = 0.7;
+
+constexpr double PI = 3.14159265358979323846;
+
 /** Populate state with a unit cube scaled by 'size' and colored edges. */
 void Objects3d::makeCube(RenderState &state, float size, int red, int green, int blue)
 {
     state.basePoints3d.clear();
     state.edges3d.clear();
+    state.externalGeometry = GeometryView{};
 
     std::vector<Point3d> points3d = {
         {-size, -size, -size, red, green, blue},
@@ -35,8 +58,12 @@ void Objects3d::makeCube(RenderState &state, float size, int red, int green, int
         {2, 6, red, green, blue},
         {3, 7, red, green, blue}};
 
+    // Two triangles per side
+    state.triangles3d = {0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+                         1, 2, 6, 1, 6, 5, 2, 3, 7, 2, 7, 6, 3, 0, 4, 3, 4, 7};
     state.basePoints3d = std::move(points3d);
     state.edges3d = std::move(edges3d);
+    ++state.geometryRevision;
 }
 
 /** Populate state with a square-based pyramid scaled by 'size'. */
@@ -44,6 +71,7 @@ void Objects3d::makePyramid(RenderState &state, float size, int red, int green,
 {
     state.basePoints3d.clear();
     state.edges3d.clear();
+    state.externalGeometry = GeometryView{};
 
     std::vector<Point3d> points3d = {
         {-size, -size, -size, red, green, blue},
@@ -63,6 +91,556 @@ void Objects3d::makePyramid(RenderState &state, float size, int red, int green,
         {2, 4, red, green, blue},
         {3, 4, red, green, blue}};
 
+    state.triangles3d = {0, 1, 2, 0, 2, 3, 0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4};
     state.basePoints3d = std::move(points3d);
     state.edges3d = std::move(edges3d);
+    ++state.geometryRevision;
+}
+
+struct GeneratorInfo
+{
+    const char *name;
+    int minResolution;
+    int defaultResolution;
+};
+
+// Indexed by GeneratorKind
+static const GeneratorInfo GENERATORS[GENERATOR_KIND_COUNT] = {
+    {"uvsphere", 3, 160},   // 51k vertices, 102k edges
+    {"icosphere", 1, 58},   // 34k vertices, 101k edges
+    {"torus", 3, 160},      // 51k vertices, 102k edges
+    {"grid", 1, 224},       // 51k vertices, 101k edges
+    {"points", 1, 100000},  // 100k vertices
+    {"lattice", 1, 20},     // 64k vertices, 96k edges
+};
+
+const char *generatorName(GeneratorKind kind)
+{
+    return GENERATORS[static_cast<int>(kind)].name;
+}
+
+bool findGenerator(const char *name, GeneratorKind &kind)
+{
+    for (int i = 0; i < GENERATOR_KIND_COUNT; ++i)
+    {
+        if (std::strcmp(name, GENERATORS[i].name) == 0)
+        {
+            kind = static_cast<GeneratorKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+int defaultGeneratorResolution(GeneratorKind kind)
+{
+    return GENERATORS[static_cast<int>(kind)].defaultResolution;
+}
+
+bool generatorCounts(GeneratorKind kind, int resolution, std::size_t &vertices, std::size_t &edges, std::size_t &triangles)
+{
+    if (resolution < GENERATORS[static_cast<int>(kind)].minResolution)
+        return false;
+
+    // Rough size first so the exact 64-bit products below cannot overflow
+    const double r = resolution;
+    double estimate = 0.0;
+    switch (kind)
+    {
+    case GeneratorKind::UvSphere:
+    case GeneratorKind::Torus:
+        estimate = 2.0 * r * r;
+        break;
+    case GeneratorKind::IcoSphere:
+        estimate = 10.0 * r * r;
+        break;
+    case GeneratorKind::Grid:
+        estimate = (r + 1.0) * (r + 1.0);
+        break;
+    case GeneratorKind::PointCloud:
+        estimate = r;
+        break;
+    case GeneratorKind::Lattice:
+        estimate = 8.0 * r * r * r;
+        break;
+    }
+    if (estimate + 2.0 > static_cast<double>(std::numeric_limits<std::uint32_t>::max()))
+        return false;
+
+    const std::uint64_t n = static_cast<std::uint64_t>(resolution);
+    std::uint64_t v = 0, e = 0, t = 0;
+    switch (kind)
+    {
+    case GeneratorKind::UvSphere:
+        v = 2 + 2 * n * (n - 1);
+        e = 2 * n * (n - 1) + 2 * n * n;
+        t = 4 * n * (n - 1);
+        break;
+    case GeneratorKind::IcoSphere:
+        v = 10 * n * n + 2;
+        e = 30 * n * n;
+        t = 20 * n * n;
+        break;
+    case GeneratorKind::Torus:
+        v = 2 * n * n;
+        e = 4 * n * n;
+        t = 4 * n * n;
+        break;
+    case GeneratorKind::Grid:
+        v = (n + 1) * (n + 1);
+        e = 2 * n * (n + 1);
+        t = 2 * n * n;
+        break;
+    case GeneratorKind::PointCloud:
+        v = n;
+        e = 0;
+        break;
+    case GeneratorKind::Lattice:
+        v = 8 * n * n * n;
+        e = 12 * n * n * n;
+        t = 12 * n * n * n;
+        break;
+    }
+    vertices = static_cast<std::size_t>(v);
+    edges = static_cast<std::size_t>(e);
+    triangles = static_cast<std::size_t>(t);
+    return true;
+}
+
+void GeneratedMesh::AlignedDelete::operator()(void *block) const
+{
+    ::operator delete(block, std::align_val_t(GENERATED_ALIGNMENT));
+}
+
+static std::size_t alignedBytes(std::size_t bytes)
+{
+    return (bytes + GENERATED_ALIGNMENT - 1) & ~(GENERATED_ALIGNMENT - 1);
+}
+
+bool GeneratedMesh::allocate(std::size_t vertices, std::size_t edges, std::size_t triangles)
+{
+    const std::size_t coordinateBytes = alignedBytes(vertices * sizeof(float));
+    const std::size_t edgeBytes = alignedBytes(2 * edges * sizeof(std::uint32_t));
+    const std::size_t triangleBytes = alignedBytes(3 * triangles * sizeof(std::uint32_t));
+    void *memory = ::operator new(3 * coordinateBytes + edgeBytes + triangleBytes, std::align_val_t(GENERATED_ALIGNMENT), std::nothrow);
+    if (!memory)
+        return false;
+    block.reset(memory);
+
+    unsigned char *bytes = static_cast<unsigned char *>(memory);
+    x = reinterpret_cast<float *>(bytes);
+    y = reinterpret_cast<float *>(bytes + coordinateBytes);
+    z = reinterpret_cast<float *>(bytes + 2 * coordinateBytes);
+    edgeIndices = reinterpret_cast<std::uint32_t *>(bytes + 3 * coordinateBytes);
+    triangleIndices = reinterpret_cast<std::uint32_t *>(bytes + 3 * coordinateBytes + edgeBytes);
+    vertexCount = vertices;
+    edgeCount = edges;
+    triangleCount = triangles;
+    return true;
+}
+
+GeometryView GeneratedMesh::view(std::uint32_t color) const
+{
+    GeometryView geometry;
+    geometry.x = x;
+    geometry.y = y;
+    geometry.z = z;
+    geometry.edgeIndices = edgeIndices;
+    geometry.triangleIndices = triangleIndices;
+    geometry.uniformColor = color;
+    geometry.vertexCount = vertexCount;
+    geometry.edgeCount = edgeCount;
+    geometry.triangleCount = triangleCount;
+    return geometry;
+}
+
+static void setVertex(GeneratedMesh &mesh, std::size_t index, double x, double y, double z)
+{
+    mesh.x[index] = static_cast<float>(x);
+    mesh.y[index] = static_cast<float>(y);
+    mesh.z[index] = static_cast<float>(z);
+}
+
+static std::uint32_t *addEdge(std::uint32_t *out, std::size_t first, std::size_t second)
+{
+    out[0] = static_cast<std::uint32_t>(first);
+    out[1] = static_cast<std::uint32_t>(second);
+    return out + 2;
+}
+
+static std::uint32_t *addTriangle(std::uint32_t *out, std::size_t first, std::size_t second, std::size_t third)
+{
+    out[0] = static_cast<std::uint32_t>(first);
+    out[1] = static_cast<std::uint32_t>(second);
+    out[2] = static_cast<std::uint32_t>(third);
+    return out + 3;
+}
+
+// Two triangles of the quad a, b, c, d (in order around it)
+static std::uint32_t *addQuad(std::uint32_t *out, std::size_t a, std::size_t b, std::size_t c, std::size_t d)
+{
+    return addTriangle(addTriangle(out, a, b, c), a, c, d);
+}
+
+// North pole, rings 1..rings-1 of 'segments' vertices each, south pole
+static void fillUvSphere(GeneratedMesh &mesh, std::size_t rings)
+{
+    const std::size_t segments = 2 * rings;
+    const std::size_t southPole = 1 + segments * (rings - 1);
+    const auto ringVertex = [segments](std::size_t ring, std::size_t segment)
+    { return 1 + (ring - 1) * segments + segment % segments; };
+
+    setVertex(mesh, 0, 0.0, 0.0, 1.0);
+    setVertex(mesh, southPole, 0.0, 0.0, -1.0);
+    for (std::size_t ring = 1; ring < rings; ++ring)
+    {
+        const double polar = PI * static_cast<double>(ring) / static_cast<double>(rings);
+        const double radius = std::sin(polar), height = std::cos(polar);
+        for (std::size_t segment = 0; segment < segments; ++segment)
+        {
+            const double azimuth = 2.0 * PI * static_cast<double>(segment) / static_cast<double>(segments);
+            setVertex(mesh, ringVertex(ring, segment), radius * std::cos(azimuth), radius * std::sin(azimuth), height);
+        }
+    }
+
+    std::uint32_t *out = mesh.edgeIndices;
+    for (std::size_t ring = 1; ring < rings; ++ring)
+    {
+        for (std::size_t segment = 0; segment < segments; ++segment)
+        {
+            out = addEdge(out, ringVertex(ring, segment), ringVertex(ring, segment + 1));
+        }
+    }
+    for (std::size_t segment = 0; segment < segments; ++segment)
+    {
+        out = addEdge(out, 0, ringVertex(1, segment));
+        for (std::size_t ring = 1; ring + 1 < rings; ++ring)
+        {
+            out = addEdge(out, ringVertex(ring, segment), ringVertex(ring + 1, segment));
+        }
+        out = addEdge(out, ringVertex(rings - 1, segment), southPole);
+    }
+
+    std::uint32_t *faces = mesh.triangleIndices;
+    for (std::size_t segment = 0; segment < segments; ++segment)
+    {
+        faces = addTriangle(faces, 0, ringVertex(1, segment), ringVertex(1, segment + 1));
+        for (std::size_t ring = 1; ring + 1 < rings; ++ring)
+        {
+            faces = addQuad(faces, ringVertex(ring, segment), ringVertex(ring + 1, segment), ringVertex(ring + 1, segment + 1),
+                            ringVertex(ring, segment + 1));
+        }
+        faces = addTriangle(faces, ringVertex(rings - 1, segment), southPole, ringVertex(rings - 1, segment + 1));
+    }
+}
+
+static const double ICO_T = 1.61803398874989484820; // Golden ratio
+
+static const double ICO_VERTICES[12][3] = {
+    {-1, ICO_T, 0}, {1, ICO_T, 0}, {-1, -ICO_T, 0}, {1, -ICO_T, 0}, {0, -1, ICO_T}, {0, 1, ICO_T},
+    {0, -1, -ICO_T}, {0, 1, -ICO_T}, {ICO_T, 0, -1}, {ICO_T, 0, 1}, {-ICO_T, 0, -1}, {-ICO_T, 0, 1}};
+
+static const int ICO_FACES[20][3] = {
+    {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11}, {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+    {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9}, {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}};
+
+// Point at barycentric grid position (i, j) of a face with corners a, b, c, pushed onto the unit sphere
+static void setSpherePoint(GeneratedMesh &mesh, std::size_t index, const double *a, const double *b, const double *c, double u, double v)
+{
+    double p[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        p[axis] = a[axis] + (b[axis] - a[axis]) * u + (c[axis] - a[axis]) * v;
+    }
+    const double length = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+    setVertex(mesh, index, p[0] / length, p[1] / length, p[2] / length);
+}
+
+// Every icosahedron edge is split into n parts and every face into n^2
+// triangles. Vertices are numbered corners first, then the n-1 inner points
+// of each icosahedron edge, then each face's interior points, so indices are
+// computed directly instead of deduplicated. Segments on an icosahedron edge
+// are emitted only by the first face that has the edge.
+static void fillIcoSphere(GeneratedMesh &mesh, std::size_t n)
+{
+    int edgeCorners[30][2];
+    int faceEdges[20][3];
+    int edgeOwner[30];
+    int edgeTotal = 0;
+    for (int face = 0; face < 20; ++face)
+    {
+        const int *corners = ICO_FACES[face];
+        // AB, AC, BC, matching the boundary tests below
+        const int pairs[3][2] = {{corners[0], corners[1]}, {corners[0], corners[2]}, {corners[1], corners[2]}};
+        for (int side = 0; side < 3; ++side)
+        {
+            const int u = std::min(pairs[side][0], pairs[side][1]), v = std::max(pairs[side][0], pairs[side][1]);
+            int edge = 0;
+            while (edge < edgeTotal && (edgeCorners[edge][0] != u || edgeCorners[edge][1] != v))
+            {
+                ++edge;
+            }
+            if (edge == edgeTotal)
+            {
+                edgeCorners[edge][0] = u;
+                edgeCorners[edge][1] = v;
+                edgeOwner[edge] = face;
+                ++edgeTotal;
+            }
+            faceEdges[face][side] = edge;
+        }
+    }
+
+    const std::size_t inner = n - 1;
+    const std::size_t faceBase = 12 + 30 * inner;
+    const std::size_t faceInterior = n >= 2 ? (n - 1) * (n - 2) / 2 : 0;
+    const double step = 1.0 / static_cast<double>(n);
+
+    // Vertex 'steps' of n along the edge from corner 'from' to corner 'to'
+    const auto edgePoint = [&](int from, int to, std::size_t steps) -> std::size_t
+    {
+        if (steps == 0)
+            return static_cast<std::size_t>(from);
+        if (steps == n)
+            return static_cast<std::size_t>(to);
+        const int u = std::min(from, to);
+        int edge = 0;
+        while (edgeCorners[edge][0] != u || edgeCorners[edge][1] != std::max(from, to))
+        {
+            ++edge;
+        }
+        const std::size_t along = (from == u) ? steps : n - steps;
+        return 12 + static_cast<std::size_t>(edge) * inner + (along - 1);
+    };
+    // Rows i = 1..n-2 of the interior hold j = 1..n-1-i
+    const auto facePoint = [&](int face, std::size_t i, std::size_t j) -> std::size_t
+    {
+        const int *corners = ICO_FACES[face];
+        if (j == 0)
+            return edgePoint(corners[0], corners[1], i);
+        if (i == 0)
+            return edgePoint(corners[0], corners[2], j);
+        if (i + j == n)
+            return edgePoint(corners[1], corners[2], j);
+        return faceBase + static_cast<std::size_t>(face) * faceInterior + (i - 1) * (n - 1) - (i - 1) * i / 2 + (j - 1);
+    };
+
+    for (int corner = 0; corner < 12; ++corner)
+    {
+        setSpherePoint(mesh, static_cast<std::size_t>(corner), ICO_VERTICES[corner], ICO_VERTICES[corner], ICO_VERTICES[corner], 0.0, 0.0);
+    }
+    for (int edge = 0; edge < 30; ++edge)
+    {
+        const double *a = ICO_VERTICES[edgeCorners[edge][0]], *b = ICO_VERTICES[edgeCorners[edge][1]];
+        for (std::size_t along = 1; along < n; ++along)
+        {
+            setSpherePoint(mesh, 12 + static_cast<std::size_t>(edge) * inner + (along - 1), a, b, a, static_cast<double>(along) * step, 0.0);
+        }
+    }
+
+    std::uint32_t *out = mesh.edgeIndices;
+    std::uint32_t *faces = mesh.triangleIndices;
+    for (int face = 0; face < 20; ++face)
+    {
+        const double *a = ICO_VERTICES[ICO_FACES[face][0]], *b = ICO_VERTICES[ICO_FACES[face][1]], *c = ICO_VERTICES[ICO_FACES[face][2]];
+        const bool ownsAB = edgeOwner[faceEdges[face][0]] == face;
+        const bool ownsAC = edgeOwner[faceEdges[face][1]] == face;
+        const bool ownsBC = edgeOwner[faceEdges[face][2]] == face;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            for (std::size_t j = 0; i + j < n; ++j)
+            {
+                if (i > 0 && j > 0 && i + j < n)
+                    setSpherePoint(mesh, facePoint(face, i, j), a, b, c, static_cast<double>(i) * step, static_cast<double>(j) * step);
+
+                // Each grid edge belongs to exactly one upward triangle (i,j), (i+1,j), (i,j+1)
+                const std::size_t corner = facePoint(face, i, j);
+                const std::size_t right = facePoint(face, i + 1, j), up = facePoint(face, i, j + 1);
+                if (j > 0 || ownsAB)
+                    out = addEdge(out, corner, right);
+                if (i > 0 || ownsAC)
+                    out = addEdge(out, corner, up);
+                if (i + j + 1 < n || ownsBC)
+                    out = addEdge(out, right, up);
+
+                // The upward triangle, and the downward one sharing its right-up side
+                faces = addTriangle(faces, corner, right, up);
+                if (i + j + 1 < n)
+                    faces = addTriangle(faces, right, facePoint(face, i + 1, j + 1), up);
+            }
+        }
+    }
+}
+
+static void fillTorus(GeneratedMesh &mesh, std::size_t tubeSegments)
+{
+    const std::size_t ringSegments = 2 * tubeSegments;
+    const auto vertex = [tubeSegments, ringSegments](std::size_t ring, std::size_t tube)
+    { return (ring % ringSegments) * tubeSegments + tube % tubeSegments; };
+
+    for (std::size_t ring = 0; ring < ringSegments; ++ring)
+    {
+        const double around = 2.0 * PI * static_cast<double>(ring) / static_cast<double>(ringSegments);
+        const double cosAround = std::cos(around), sinAround = std::sin(around);
+        for (std::size_t tube = 0; tube < tubeSegments; ++tube)
+        {
+            const double across = 2.0 * PI * static_cast<double>(tube) / static_cast<double>(tubeSegments);
+            const double distance = TORUS_RING_RADIUS + TORUS_TUBE_RADIUS * std::cos(across);
+            setVertex(mesh, vertex(ring, tube), distance * cosAround, distance * sinAround, TORUS_TUBE_RADIUS * std::sin(across));
+        }
+    }
+
+    std::uint32_t *out = mesh.edgeIndices;
+    std::uint32_t *faces = mesh.triangleIndices;
+    for (std::size_t ring = 0; ring < ringSegments; ++ring)
+    {
+        for (std::size_t tube = 0; tube < tubeSegments; ++tube)
+        {
+            out = addEdge(out, vertex(ring, tube), vertex(ring, tube + 1));
+            out = addEdge(out, vertex(ring, tube), vertex(ring + 1, tube));
+            faces = addQuad(faces, vertex(ring, tube), vertex(ring + 1, tube), vertex(ring + 1, tube + 1), vertex(ring, tube + 1));
+        }
+    }
+}
+
+static void fillGrid(GeneratedMesh &mesh, std::size_t cells)
+{
+    const std::size_t side = cells + 1;
+    const double spacing = 2.0 / static_cast<double>(cells);
+    for (std::size_t row = 0; row < side; ++row)
+    {
+        for (std::size_t column = 0; column < side; ++column)
+        {
+            setVertex(mesh, row * side + column, -1.0 + spacing * static_cast<double>(column), -1.0 + spacing * static_cast<double>(row), 0.0);
+        }
+    }
+
+    std::uint32_t *out = mesh.edgeIndices;
+    std::uint32_t *faces = mesh.triangleIndices;
+    for (std::size_t row = 0; row < side; ++row)
+    {
+        for (std::size_t column = 0; column < side; ++column)
+        {
+            const std::size_t index = row * side + column;
+            if (column + 1 < side)
+                out = addEdge(out, index, index + 1);
+            if (row + 1 < side)
+                out = addEdge(out, index, index + side);
+            if (column + 1 < side && row + 1 < side)
+                faces = addQuad(faces, index, index + 1, index + 1 + side, index + side);
+        }
+    }
+}
+
+// SplitMix64: small, fast and identical on every platform
+static std::uint64_t nextRandom(std::uint64_t &state)
+{
+    std::uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+PointCloudSampler::PointCloudSampler() : random(POINT_CLOUD_SEED) {}
+
+// Uniform in the unit ball by rejection from the enclosing cube
+void PointCloudSampler::next(float &x, float &y, float &z)
+{
+    const auto coordinate = [this]()
+    { return static_cast<double>(nextRandom(random) >> 11) * (2.0 / 9007199254740992.0) - 1.0; };
+    double cx, cy, cz;
+    do
+    {
+        cx = coordinate();
+        cy = coordinate();
+        cz = coordinate();
+    } while (cx * cx + cy * cy + cz * cz > 1.0);
+    x = static_cast<float>(cx);
+    y = static_cast<float>(cy);
+    z = static_cast<float>(cz);
+}
+
+static void fillPointCloud(GeneratedMesh &mesh, std::size_t count)
+{
+    PointCloudSampler sampler;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        sampler.next(mesh.x[i], mesh.y[i], mesh.z[i]);
+    }
+}
+
+static void fillLattice(GeneratedMesh &mesh, std::size_t side)
+{
+    // Same corner numbering and edges as makeCube
+    static const int CORNERS[8][3] = {{-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1}, {-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1}};
+    static const int EDGES[12][2] = {{0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6}, {6, 7}, {7, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+    static const int SIDES[6][4] = {{0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}};
+
+    const double cell = 2.0 / static_cast<double>(side);
+    const double half = 0.5 * LATTICE_FILL * cell;
+    std::uint32_t *out = mesh.edgeIndices;
+    std::uint32_t *faces = mesh.triangleIndices;
+    std::size_t base = 0;
+    for (std::size_t ix = 0; ix < side; ++ix)
+    {
+        for (std::size_t iy = 0; iy < side; ++iy)
+        {
+            for (std::size_t iz = 0; iz < side; ++iz)
+            {
+                const double center[3] = {-1.0 + cell * (static_cast<double>(ix) + 0.5), -1.0 + cell * (static_cast<double>(iy) + 0.5),
+                                          -1.0 + cell * (static_cast<double>(iz) + 0.5)};
+                for (int corner = 0; corner < 8; ++corner)
+                {
+                    setVertex(mesh, base + corner, center[0] + half * CORNERS[corner][0], center[1] + half * CORNERS[corner][1],
+                              center[2] + half * CORNERS[corner][2]);
+                }
+                for (int edge = 0; edge < 12; ++edge)
+                {
+                    out = addEdge(out, base + EDGES[edge][0], base + EDGES[edge][1]);
+                }
+                for (const int *quad : SIDES)
+                {
+                    faces = addQuad(faces, base + quad[0], base + quad[1], base + quad[2], base + quad[3]);
+                }
+                base += 8;
+            }
+        }
+    }
+}
+
+bool Objects3d::generate(RenderState &state, GeneratorKind kind, int resolution, int red, int green, int blue)
+{
+    std::size_t vertices = 0, edges = 0, triangles = 0;
+    if (!generatorCounts(kind, resolution, vertices, edges, triangles) || !generated.allocate(vertices, edges, triangles))
+        return false;
+
+    const std::size_t n = static_cast<std::size_t>(resolution);
+    switch (kind)
+    {
+    case GeneratorKind::UvSphere:
+        fillUvSphere(generated, n);
+        break;
+    case GeneratorKind::IcoSphere:
+        fillIcoSphere(generated, n);
+        break;
+    case GeneratorKind::Torus:
+        fillTorus(generated, n);
+        break;
+    case GeneratorKind::Grid:
+        fillGrid(generated, n);
+        break;
+    case GeneratorKind::PointCloud:
+        fillPointCloud(generated, n);
+        break;
+    case GeneratorKind::Lattice:
+        fillLattice(generated, n);
+        break;
+    }
+
+    state.basePoints3d.clear();
+    state.edges3d.clear();
+    state.triangles3d.clear();
+    state.externalGeometry = generated.view(packColor(red, green, blue));
+    ++state.geometryRevision;
+    return true;
 }
@@ -1,16 +1,118 @@
 /**
  * @file objects_3d.h
  * @brief Helpers to populate RenderState with simple 3D primitives.
+ *
+ * Besides the hand-written cube and pyramid there are parametric stress
+ * scenes (spheres, torus, grid, point cloud, cube lattice) whose size grows
+ * with a resolution parameter, from a few thousand to tens of millions of
+ * edges. They are deterministic, so a kind and resolution always describe
+ * the same workload.
  */
 #pragma once
 
-#include "../app_state/app_state.h" // Point3d, Edge3d, RenderState
+#include "../app_state/app_state.h" // Point3d, Edge3d, RenderState, GeometryView
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/** Parametric stress scenes. */
+enum class GeneratorKind
+{
+    UvSphere,   ///< Latitude/longitude sphere, 2·res segments by res rings
+    IcoSphere,  ///< Geodesic sphere, each icosahedron edge split into res parts
+    Torus,      ///< 2·res segments around the ring by res around the tube
+    Grid,       ///< Flat res x res quad grid in the XY plane
+    PointCloud, ///< res random points in the unit ball, no edges
+    Lattice,    ///< res x res x res cubes
+};
+
+/** Number of GeneratorKind values. */
+constexpr int GENERATOR_KIND_COUNT = 6;
+
+/** Command-line name of kind ("uvsphere", "icosphere", ...). */
+const char *generatorName(GeneratorKind kind);
+
+/** Look up a kind by its command-line name; false if unknown. */
+bool findGenerator(const char *name, GeneratorKind &kind);
+
+/** Resolution giving about 100k edges (100k points for the point cloud). */
+int defaultGeneratorResolution(GeneratorKind kind);
 
 /**
- * @brief Factory for basic wireframe objects (cube, pyramid).
+ * @brief Vertex, edge and solid-face (triangle) counts of a generated mesh.
  *
- * Populates the provided RenderState's basePoints3d and edges3d with
- * vertices and colored edges for each primitive, centered at the origin.
+ * @return false if resolution is too small for the kind (spheres and torus
+ *         need 3, the rest 1) or the mesh would not be indexable with 32 bits.
+ */
+bool generatorCounts(GeneratorKind kind, int resolution, std::size_t &vertices, std::size_t &edges, std::size_t &triangles);
+
+/**
+ * @brief Structure-of-arrays mesh held in one 64-byte-aligned allocation.
+ *
+ * Generators write x, y, z, the edge indices and the triangle indices of
+ * the solid faces in place and draw the result through
+ * RenderState::externalGeometry, so building a mesh costs a single heap
+ * allocation whatever its size.
+ */
+class GeneratedMesh
+{
+public:
+    /**
+     * @brief Make room for the given counts.
+     *
+     * The previous block is released only after the new one was allocated,
+     * so on failure the old mesh is still intact.
+     *
+     * @return false if the allocation failed.
+     */
+    bool allocate(std::size_t vertices, std::size_t edges, std::size_t triangles);
+
+    float *x = nullptr;                       ///< vertexCount coordinates
+    float *y = nullptr;                       ///< vertexCount coordinates
+    float *z = nullptr;                       ///< vertexCount coordinates
+    std::uint32_t *edgeIndices = nullptr;     ///< 2 * edgeCount vertex indices
+    std::uint32_t *triangleIndices = nullptr; ///< 3 * triangleCount vertex indices
+    std::size_t vertexCount = 0;              ///< Vertices in the block
+    std::size_t edgeCount = 0;                ///< Edges in the block
+    std::size_t triangleCount = 0;            ///< Solid faces in the block
+
+    /** View of the mesh drawn in a single color. */
+    GeometryView view(std::uint32_t color) const;
+
+private:
+    struct AlignedDelete
+    {
+        void operator()(void *block) const;
+    };
+    std::unique_ptr<void, AlignedDelete> block;
+};
+
+/**
+ * @brief The points of GeneratorKind::PointCloud, one at a time.
+ *
+ * Yields the same sequence as generate(PointCloud, n) without holding the
+ * cloud, so clouds larger than memory can be written to a point stream file.
+ */
+class PointCloudSampler
+{
+public:
+    PointCloudSampler();
+
+    /** Next point, uniform in the unit ball. */
+    void next(float &x, float &y, float &z);
+
+private:
+    std::uint64_t random;
+};
+
+/**
+ * @brief Factory for basic wireframe objects (cube, pyramid) and stress scenes.
+ *
+ * Populates the provided RenderState's basePoints3d, edges3d and
+ * triangles3d with vertices, colored edges and solid faces for each
+ * primitive, centered at the origin. Generated stress scenes are kept by the factory and shown through
+ * RenderState::externalGeometry; the factory must outlive every view of them,
+ * including scene meshes created from them by instanceCurrentObject.
  */
 class Objects3d
 {
@@ -34,4 +136,25 @@ public:
      * @param blue  Edge/vertex color (0..255).
      */
     void makePyramid(RenderState &state, float size, int red, int green, int blue);
+
+    /**
+     * @brief Replace the current object with a parametric stress scene.
+     *
+     * Allocates once, fills the mesh (about 1 unit in radius, centered at the
+     * origin) and bumps the geometry revision. The previously generated mesh
+     * of this factory is released, so any view of it becomes invalid.
+     *
+     * @param state      Target render state; its point and edge lists are cleared.
+     * @param kind       Scene to build.
+     * @param resolution Detail level; see GeneratorKind for its meaning.
+     * @param red        Color of the whole mesh (0..255).
+     * @param green      Color of the whole mesh (0..255).
+     * @param blue       Color of the whole mesh (0..255).
+     * @return false (state unchanged) if the resolution is invalid or the
+     *         allocation failed.
+     */
+    bool generate(RenderState &state, GeneratorKind kind, int resolution, int red, int green, int blue);
+
+private:
+    GeneratedMesh generated;
 };
@@ -3,16 +3,41 @@
 // Responsibilities:
 //  - rotation around X/Y/Z
 //  - perspective projection
-//  - per-frame callback that animates and renders the current object
+//  - per-frame callback that animates and renders the current object and
+//    the instances of the scene
+//    (vertices go through the batch transform in batch_transform.cpp; the
+//    per-point helpers remain as the reference implementation)
+//  - hidden-line mode: solid faces into a depth buffer, then depth-tested
+//    points and edges
+//  - out-of-core point clouds drawn chunk by chunk from a point stream
 
 #include <SDL2/SDL.h>
 #include "../3d_renderer/3d_renderer.h"
+#include "../3d_renderer/batch_transform.h"
+#include "../3d_renderer/clipping.h"
+#include "../3d_renderer/draw_batches.h"
+#include "../3d_renderer/geometry_view.h"
+#include "../3d_renderer/lod.h"
+#include "../diagnostics/frame_profiler.h"
+#include "../framebuffer/depth_buffer.h"
+#include "../framebuffer/framebuffer.h"
+#include "../framebuffer/tile_rasterizer.h"
+#include "../mesh_io/background_loader.h"
+#include "../mesh_io/point_stream.h"
+#include "../scene/bvh.h"
+#include "../scene/scene.h"
+#include "../threading/thread_pool.h"
 #include <algorithm>
+#include <cstddef>
 #include <vector>
 #include <cmath>
 
 constexpr float PI_F = 3.14159265358979323846f;
 
+// Hidden-line mode accepts edge pixels this far (in pixels of sideways
+// movement on a face at 45 degrees) behind the faces they lie on
+constexpr float HIDDEN_LINE_BIAS_PIXELS = 4.0f;
+
 // Renderer3d implementations
 // --------------------------
 /** Project a 3D point into screen space with a small guard to avoid
@@ -61,23 +86,579 @@ Point3d Renderer3d::rotateZ(const Point3d &point3d, float angleDegrees)
     return {x, y, point3d.z, point3d.red, point3d.green, point3d.blue};
 }
 
+// Drawing backends
+// ----------------
+// Both draw one DrawItem at a time: the current object, then every scene
+// instance. Each item's vertices are projected into projectedPoints just before
+// it is drawn; its vertices go first, then its edges. Vertices and edges pass
+// through the clipping stage (clipping.cpp) first, so culled geometry never
+// reaches a rasterizer. The SDL path submits the color batches prepared by
+// draw_batches.cpp; the software path has no per-call overhead and walks the
+// edges of the geometry view directly.
+//
+// In hidden-line mode every item's triangles are first rasterized into
+// FrameScratch::depthBuffer. Edges the depth pyramid proves hidden are
+// dropped before rasterization; the rest are depth-tested per pixel.
+
+// One placement of geometry in the current frame
+struct DrawItem
+{
+    const GeometryView *geometry; ///< Vertices and edges
+    const DrawBatches *batches;   ///< Color batches of geometry
+    ProjectionMatrix matrix;      ///< Object space to screen for this placement
+    bool overrideColor;           ///< Draw everything in color instead of the geometry colors
+    std::uint32_t color;          ///< Packed instance color
+};
+
+// FrameScratch::submitPoints is handed to SDL as an SDL_Point array
+static_assert(sizeof(ScreenPoint) == sizeof(SDL_Point) && offsetof(ScreenPoint, x) == offsetof(SDL_Point, x) &&
+                  offsetof(ScreenPoint, y) == offsetof(SDL_Point, y),
+              "ScreenPoint must match SDL_Point");
+
+static const SDL_Point *asSdlPoints(const std::vector<ScreenPoint> &points)
+{
+    return reinterpret_cast<const SDL_Point *>(points.data());
+}
+
+static ScreenPoint toScreenPoint(float x, float y)
+{
+    return {toPixelCoordinate(x), toPixelCoordinate(y)};
+}
+
+// SDL backend calls go to the renderer, or into state.drawRecording when the
+// frame is prepared away from the thread that owns the renderer
+struct SdlTarget
+{
+    SDL_Renderer *renderer;
+    DrawCommandList *recording;
+};
+
+static void submitColor(const SdlTarget &target, std::uint8_t red, std::uint8_t green, std::uint8_t blue)
+{
+    if (target.recording)
+    {
+        target.recording->red = red;
+        target.recording->green = green;
+        target.recording->blue = blue;
+    }
+    else
+    {
+        SDL_SetRenderDrawColor(target.renderer, red, green, blue, 255);
+    }
+}
+
+static void recordCall(DrawCommandList &recording, bool lines, const ScreenPoint *points, std::size_t count)
+{
+    recording.commands.push_back({lines, recording.red, recording.green, recording.blue,
+                                  static_cast<std::uint32_t>(recording.points.size()), static_cast<std::uint32_t>(count)});
+    recording.points.insert(recording.points.end(), points, points + count);
+}
+
+static void submitPoints(const SdlTarget &target, const std::vector<ScreenPoint> &points)
+{
+    if (target.recording)
+        recordCall(*target.recording, false, points.data(), points.size());
+    else
+        SDL_RenderDrawPoints(target.renderer, asSdlPoints(points), static_cast<int>(points.size()));
+}
+
+static void submitLines(const SdlTarget &target, const std::vector<ScreenPoint> &points)
+{
+    if (target.recording)
+        recordCall(*target.recording, true, points.data(), points.size());
+    else
+        SDL_RenderDrawLines(target.renderer, asSdlPoints(points), static_cast<int>(points.size()));
+}
+
+static void submitLine(const SdlTarget &target, ScreenPoint start, ScreenPoint end)
+{
+    if (target.recording)
+    {
+        const ScreenPoint points[2] = {start, end};
+        recordCall(*target.recording, true, points, 2);
+    }
+    else
+    {
+        SDL_RenderDrawLine(target.renderer, start.x, start.y, end.x, end.y);
+    }
+}
+
+static void setBatchColor(const SdlTarget &target, const DrawItem &item, const DrawBatch &batch)
+{
+    if (item.overrideColor)
+    {
+        submitColor(target, (item.color >> 16) & 0xFF, (item.color >> 8) & 0xFF, item.color & 0xFF);
+    }
+    else
+    {
+        submitColor(target, batch.red, batch.green, batch.blue);
+    }
+}
+
+// Draw loop variants
+// ------------------
+// The per-point and per-edge loops below are templates over a color source and
+// a depth test. drawItem picks the policies once per item from the item, its
+// geometry and the state, so the specialized instantiations carry no branch or
+// unused division for either choice inside the loops. The Runtime policies
+// decide per element, as the loops always did; --generic-pipeline draws with
+// them so both paths can be benchmarked against each other.
+
+// Every point and edge in one color (instance override or a single-color mesh)
+struct UniformColors
+{
+    std::uint32_t color;
+    std::uint32_t point(std::size_t) const { return color; }
+    std::uint32_t edge(std::size_t) const { return color; }
+};
+
+// Per-vertex and per-edge color arrays of the geometry
+struct ElementColors
+{
+    const std::uint32_t *points;
+    const std::uint32_t *edges;
+    std::uint32_t point(std::size_t i) const { return points[i]; }
+    std::uint32_t edge(std::size_t i) const { return edges[i]; }
+};
+
+// Decided per element
+struct RuntimeColors
+{
+    const DrawItem *item;
+    const GeometryView *geometry;
+    std::uint32_t point(std::size_t i) const
+    {
+        return item->overrideColor ? item->color : geometry->pointColors ? geometry->pointColors[i] : geometry->uniformColor;
+    }
+    std::uint32_t edge(std::size_t i) const
+    {
+        return item->overrideColor ? item->color : geometry->edgeColors ? geometry->edgeColors[i] : geometry->uniformColor;
+    }
+};
+
+// Depth test policies; inverseDepths selects the clipEdge variant
+struct NoDepthTest
+{
+    static constexpr bool inverseDepths = false;
+    const DepthBuffer *buffer = nullptr;
+    bool enabled() const { return false; }
+};
+
+struct DepthTested
+{
+    static constexpr bool inverseDepths = true;
+    const DepthBuffer *buffer;
+    bool enabled() const { return true; }
+};
+
+struct RuntimeDepthTest
+{
+    static constexpr bool inverseDepths = true;
+    const DepthBuffer *buffer; ///< Null when hidden-line mode is off
+    bool enabled() const { return buffer != nullptr; }
+};
+
+/** Submit an item's color batches: per color one SDL_RenderDrawPoints call with
+ * the visible points, and one SDL_RenderDrawLines call per unclipped run of an
+ * edge strip (clipped edges are drawn on their own). */
+template <typename Depth>
+static void drawWithSdlRenderer(RenderState &state, SDL_Renderer *renderer, const DrawItem &item, Depth depthTest)
+{
+    const DrawBatches &batches = *item.batches;
+    const ScreenBuffer &projected = state.projectedPoints;
+    const ClipRegion region = makeClipRegion(state.screenWidth, state.screenHeight, state.nearPlane);
+    std::vector<ScreenPoint> &scratch = state.frameScratch.submitPoints; // Reserved for the largest batch
+    ClipStats &stats = state.clipStats;
+    const SdlTarget target{renderer, state.drawRecording};
+    const DepthBuffer *depth = depthTest.buffer;
+
+    // Hidden-line mode: true if the point at vertex index is not behind a face
+    auto pointUnoccluded = [&](int index)
+    {
+        const int x = toPixelCoordinate(projected.x[index]), y = toPixelCoordinate(projected.y[index]);
+        if (x < 0 || y < 0 || x >= depth->width || y >= depth->height)
+            return true;
+        return depth->visible(static_cast<size_t>(y) * static_cast<size_t>(depth->width) + static_cast<size_t>(x), 1.0f / projected.depth[index]);
+    };
+
+    // All points first so edges are drawn over them
+    for (const DrawBatch &batch : batches.batches)
+    {
+        if (batch.pointCount == 0)
+            continue;
+        scratch.clear();
+        for (size_t i = batch.pointBegin; i < batch.pointBegin + batch.pointCount; ++i)
+        {
+            const int index = batches.pointIndices[i];
+            if (pointVisible(projected, static_cast<size_t>(index), region) && (!depthTest.enabled() || pointUnoccluded(index)))
+                scratch.push_back(toScreenPoint(projected.x[index], projected.y[index]));
+        }
+        stats.pointsCulled += batch.pointCount - scratch.size();
+        if (scratch.empty())
+            continue;
+        setBatchColor(target, item, batch);
+        submitPoints(target, scratch);
+    }
+
+    // Strips are split wherever an edge is culled or clipped
+    auto flushRun = [&]()
+    {
+        if (scratch.size() >= 2)
+            submitLines(target, scratch);
+        scratch.clear();
+    };
+
+    for (const DrawBatch &batch : batches.batches)
+    {
+        if (batch.stripCount == 0)
+            continue;
+        setBatchColor(target, item, batch);
+
+        const int *vertices = batches.stripVertices.data() + batch.stripVertexBegin;
+        for (size_t strip = batch.stripBegin; strip < batch.stripBegin + batch.stripCount; ++strip)
+        {
+            const int length = batches.stripLengths[strip];
+            scratch.clear();
+            for (int k = 0; k + 1 < length; ++k)
+            {
+                const auto a = static_cast<std::uint32_t>(vertices[k]), b = static_cast<std::uint32_t>(vertices[k + 1]);
+                ClippedEdge clipped;
+                const EdgeClip result = clipEdge<Depth::inverseDepths>(item.matrix, *item.geometry, projected, a, b, region, clipped, stats);
+                if (depthTest.enabled() && result != EdgeClip::Culled)
+                {
+                    // Hidden edges break the run; partly hidden ones are drawn as their visible pieces
+                    const bool moved = result == EdgeClip::Clipped;
+                    const ScreenPoint start = moved ? toScreenPoint(clipped.x0, clipped.y0) : toScreenPoint(projected.x[a], projected.y[a]);
+                    const ScreenPoint end = moved ? toScreenPoint(clipped.x1, clipped.y1) : toScreenPoint(projected.x[b], projected.y[b]);
+                    const float inverse0 = moved ? clipped.inverseDepth0 : 1.0f / projected.depth[a];
+                    const float inverse1 = moved ? clipped.inverseDepth1 : 1.0f / projected.depth[b];
+                    const DepthTest test = depth->testLine(start.x, start.y, end.x, end.y, inverse0, inverse1);
+                    if (test == DepthTest::Hidden)
+                    {
+                        ++state.cullStats.edgesOccluded;
+                        flushRun();
+                        continue;
+                    }
+                    if (test == DepthTest::Partial)
+                    {
+                        flushRun();
+                        depth->forEachVisibleRun(start.x, start.y, end.x, end.y, inverse0, inverse1, [&](int x0, int y0, int x1, int y1)
+                                                 { submitLine(target, {x0, y0}, {x1, y1}); });
+                        continue;
+                    }
+                }
+                if (result == EdgeClip::Visible)
+                {
+                    if (scratch.empty())
+                        scratch.push_back(toScreenPoint(projected.x[a], projected.y[a]));
+                    scratch.push_back(toScreenPoint(projected.x[b], projected.y[b]));
+                    continue;
+                }
+
+                flushRun();
+                if (result == EdgeClip::Clipped)
+                {
+                    submitLine(target, toScreenPoint(clipped.x0, clipped.y0), toScreenPoint(clipped.x1, clipped.y1));
+                }
+            }
+            flushRun();
+            vertices += length;
+        }
+    }
+}
+
+void replayDrawCommands(SDL_Renderer *renderer, const DrawCommandList &recording)
+{
+    const SDL_Point *points = asSdlPoints(recording.points);
+    for (const DrawCommand &command : recording.commands)
+    {
+        SDL_SetRenderDrawColor(renderer, command.red, command.green, command.blue, 255);
+        if (command.lines)
+            SDL_RenderDrawLines(renderer, points + command.first, static_cast<int>(command.count));
+        else
+            SDL_RenderDrawPoints(renderer, points + command.first, static_cast<int>(command.count));
+    }
+}
+
+/** Rasterize and empty the queued segments, splitting the screen into tiles
+ * across the thread pool when more than one thread is set. */
+static void flushSegments(RenderState &state, Framebuffer &framebuffer)
+{
+    std::vector<ScreenSegment> &segments = state.frameScratch.segments;
+    if (segments.empty())
+        return;
+    StageTimer timer(state.profileSample, ProfileStage::Rasterize);
+    const DepthBuffer *depth = state.hiddenLines ? &state.frameScratch.depthBuffer : nullptr;
+    if (state.threadPool && state.threadPool->threadCount() > 1)
+    {
+        rasterizeSegmentsTiled(framebuffer, segments, state.frameScratch.tileBins, *state.threadPool, depth);
+    }
+    else
+    {
+        rasterizeSegments(framebuffer, segments, depth);
+    }
+    segments.clear();
+}
+
+/** Queue an item's visible points and edges for the software rasterizer. The
+ * queue is flushed whenever it reaches its reserved capacity; segments are
+ * painted in queue order either way, so the image does not depend on where
+ * the flushes fall. */
+template <typename Colors, typename Depth>
+static void drawToFramebuffer(RenderState &state, Framebuffer &framebuffer, const DrawItem &item, Colors colors, Depth depthTest)
+{
+    const GeometryView &geometry = *item.geometry;
+    const ScreenBuffer &projected = state.projectedPoints;
+    const ClipRegion region = makeClipRegion(framebuffer.width, framebuffer.height, state.nearPlane);
+    ClipStats &stats = state.clipStats;
+    const DepthBuffer *depth = depthTest.buffer;
+
+    // Points become zero-length segments so one primitive list keeps the draw order
+    std::vector<ScreenSegment> &segments = state.frameScratch.segments;
+    auto queue = [&](const ScreenSegment &segment)
+    {
+        if (segments.size() == segments.capacity() && !segments.empty())
+        {
+            // Counted as rasterization, not as part of the enclosing draw
+            const Uint64 flushStart = state.profileSample ? SDL_GetPerformanceCounter() : 0;
+            flushSegments(state, framebuffer);
+            if (state.profileSample)
+                state.profileSample->stageTicks[static_cast<std::size_t>(ProfileStage::Draw)] -= SDL_GetPerformanceCounter() - flushStart;
+        }
+        segments.push_back(segment);
+    };
+
+    for (size_t i = 0; i < geometry.vertexCount; ++i)
+    {
+        if (!pointVisible(projected, i, region))
+        {
+            ++stats.pointsCulled;
+            continue;
+        }
+        const int x = toPixelCoordinate(projected.x[i]), y = toPixelCoordinate(projected.y[i]);
+        const float inverse = depthTest.enabled() ? 1.0f / projected.depth[i] : 0.0f;
+        queue({x, y, x, y, colors.point(i), inverse, inverse});
+    }
+
+    for (size_t i = 0; i < geometry.edgeCount; ++i)
+    {
+        const std::uint32_t a = geometry.edgeIndices[2 * i], b = geometry.edgeIndices[2 * i + 1];
+        const std::uint32_t color = colors.edge(i);
+        ClippedEdge clipped;
+        ScreenSegment segment{};
+        switch (clipEdge<Depth::inverseDepths>(item.matrix, geometry, projected, a, b, region, clipped, stats))
+        {
+        case EdgeClip::Visible:
+            segment = {toPixelCoordinate(projected.x[a]), toPixelCoordinate(projected.y[a]),
+                       toPixelCoordinate(projected.x[b]), toPixelCoordinate(projected.y[b]), color,
+                       depthTest.enabled() ? 1.0f / projected.depth[a] : 0.0f, depthTest.enabled() ? 1.0f / projected.depth[b] : 0.0f};
+            break;
+        case EdgeClip::Clipped:
+            segment = {toPixelCoordinate(clipped.x0), toPixelCoordinate(clipped.y0),
+                       toPixelCoordinate(clipped.x1), toPixelCoordinate(clipped.y1), color, clipped.inverseDepth0, clipped.inverseDepth1};
+            break;
+        case EdgeClip::Culled:
+            continue;
+        }
+
+        // Edges entirely behind the faces never reach the rasterizer
+        if (depthTest.enabled() && depth->testLine(segment.x0, segment.y0, segment.x1, segment.y1, segment.depth0, segment.depth1) == DepthTest::Hidden)
+        {
+            ++state.cullStats.edgesOccluded;
+            continue;
+        }
+        queue(segment);
+    }
+}
+
+/** Project an item's vertices into projectedPoints. */
+static void projectItem(RenderState &state, const DrawItem &item)
+{
+    const GeometryView &geometry = *item.geometry;
+    ScreenBuffer &projected = state.projectedPoints;
+    StageTimer timer(state.profileSample, ProfileStage::Transform);
+    const TransformShape shape = state.specializedPipeline ? classifyProjection(item.matrix) : TransformShape::General;
+    if (state.threadPool)
+    {
+        // Large meshes are split into chunks across the pool; small ones stay serial
+        transformPositionsParallel(*state.threadPool, item.matrix, geometry.x, geometry.y, geometry.z, geometry.vertexCount,
+                                   projected.x.data(), projected.y.data(), projected.depth.data(), TransformKernel::Auto, shape);
+    }
+    else
+    {
+        transformPositions(item.matrix, geometry.x, geometry.y, geometry.z, geometry.vertexCount,
+                           projected.x.data(), projected.y.data(), projected.depth.data(), TransformKernel::Auto, shape);
+    }
+}
+
+/** Software backend: pick the color policy for the item, then draw. */
+template <typename Depth>
+static void drawToFramebufferWith(RenderState &state, Framebuffer &framebuffer, const DrawItem &item, Depth depthTest)
+{
+    const GeometryView &geometry = *item.geometry;
+    if (item.overrideColor || (!geometry.pointColors && !geometry.edgeColors))
+        drawToFramebuffer(state, framebuffer, item, UniformColors{item.overrideColor ? item.color : geometry.uniformColor}, depthTest);
+    else if (geometry.pointColors && (geometry.edgeColors || geometry.edgeCount == 0))
+        drawToFramebuffer(state, framebuffer, item, ElementColors{geometry.pointColors, geometry.edgeColors}, depthTest);
+    else
+        drawToFramebuffer(state, framebuffer, item, RuntimeColors{&item, &geometry}, depthTest);
+}
+
+/** Project an item (unless projectedPoints already holds it) and draw it with the active backend. */
+static void drawItem(RenderState &state, SDL_Renderer *renderer, const DrawItem &item, bool projected = false)
+{
+    if (!projected)
+        projectItem(state, item);
+
+    StageTimer timer(state.profileSample, ProfileStage::Draw);
+    const DepthBuffer *depth = state.hiddenLines ? &state.frameScratch.depthBuffer : nullptr;
+    const bool software = state.backend == RenderBackend::Software && state.framebuffer;
+    if (!state.specializedPipeline)
+    {
+        // Reference path: every choice made per element
+        if (software)
+            drawToFramebuffer(state, *state.framebuffer, item, RuntimeColors{&item, item.geometry}, RuntimeDepthTest{depth});
+        else
+            drawWithSdlRenderer(state, renderer, item, RuntimeDepthTest{depth});
+        return;
+    }
+
+    if (software)
+    {
+        if (depth)
+            drawToFramebufferWith(state, *state.framebuffer, item, DepthTested{depth});
+        else
+            drawToFramebufferWith(state, *state.framebuffer, item, NoDepthTest{});
+    }
+    else
+    {
+        if (depth)
+            drawWithSdlRenderer(state, renderer, item, DepthTested{depth});
+        else
+            drawWithSdlRenderer(state, renderer, item, NoDepthTest{});
+    }
+}
+
+/** Project an item and rasterize its triangles into the frame's depth buffer.
+ * Triangles reaching behind the near plane are left out, which can only
+ * make fewer edges hidden. With several threads each takes a band of rows. */
+static void drawOccluders(RenderState &state, const DrawItem &item)
+{
+    const GeometryView &geometry = *item.geometry;
+    projectItem(state, item);
+    if (geometry.triangleCount == 0)
+        return;
+
+    StageTimer timer(state.profileSample, ProfileStage::Rasterize);
+    const ScreenBuffer &projected = state.projectedPoints;
+    DepthBuffer &depth = state.frameScratch.depthBuffer;
+    const float nearDepth = state.nearPlane;
+    auto fillRows = [&](int firstRow, int lastRow)
+    {
+        for (std::size_t t = 0; t < geometry.triangleCount; ++t)
+        {
+            const std::uint32_t *corners = geometry.triangleIndices + 3 * t;
+            float x[3], y[3], inverse[3];
+            bool inFront = true;
+            for (int c = 0; c < 3; ++c)
+            {
+                x[c] = projected.x[corners[c]];
+                y[c] = projected.y[corners[c]];
+                inFront = inFront && projected.depth[corners[c]] >= nearDepth;
+                inverse[c] = 1.0f / projected.depth[corners[c]];
+            }
+            if (!inFront || std::max({y[0], y[1], y[2]}) < static_cast<float>(firstRow) ||
+                std::min({y[0], y[1], y[2]}) > static_cast<float>(lastRow + 1))
+                continue;
+            depth.drawTriangle(x, y, inverse, firstRow, lastRow);
+        }
+    };
+
+    const unsigned threads = state.threadPool ? state.threadPool->threadCount() : 1;
+    if (threads > 1)
+    {
+        const int bandRows = (depth.height + static_cast<int>(threads) - 1) / static_cast<int>(threads);
+        state.threadPool->parallelFor(threads, [&](std::size_t band, unsigned)
+                                      { fillRows(static_cast<int>(band) * bandRows, static_cast<int>(band + 1) * bandRows - 1); });
+    }
+    else
+    {
+        fillRows(0, depth.height - 1);
+    }
+}
+
+/** Draw the visible chunks of the streamed point cloud, each as its own item
+ * and only the prefix of each chunk the frame's point budget allows. */
+static void drawPointStream(RenderState &state, SDL_Renderer *renderer, const ProjectionMatrix &matrix, const Frustum &frustum)
+{
+    PointStream &stream = *state.pointStream;
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const double fraction = stream.beginFrame(&matrix, sizeof(matrix));
+
+    stream.visibleChunks.clear();
+    for (std::size_t chunk = 0; chunk < stream.chunkCount(); ++chunk)
+    {
+        if (testAabb(frustum, stream.chunkBounds(chunk)) != FrustumTest::Outside)
+            stream.visibleChunks.push_back(static_cast<std::uint32_t>(chunk));
+    }
+
+    // Scratch for the largest chunk (once; replacing the object may shrink it again)
+    ScreenBuffer &projected = state.projectedPoints;
+    if (projected.x.size() < stream.chunkCapacity())
+    {
+        projected.x.resize(stream.chunkCapacity());
+        projected.y.resize(stream.chunkCapacity());
+        projected.depth.resize(stream.chunkCapacity());
+        state.frameScratch.segments.reserve(stream.chunkCapacity());
+        state.frameScratch.submitPoints.reserve(stream.chunkCapacity());
+    }
+
+    const bool software = state.backend == RenderBackend::Software && state.framebuffer;
+    std::size_t pointsDrawn = 0;
+    for (std::size_t position = 0; position < stream.visibleChunks.size(); ++position)
+    {
+        const std::uint32_t chunk = stream.visibleChunks[position];
+        stream.prefetchAhead(position, fraction);
+        const GeometryView view = stream.chunkView(chunk, stream.chunkPrefix(chunk, fraction));
+        if (!software)
+            stream.buildChunkBatches(view);
+        drawItem(state, renderer, DrawItem{&view, &stream.batches, matrix, false, 0});
+        stream.finishChunk(chunk);
+        pointsDrawn += view.vertexCount;
+    }
+
+    const double seconds = static_cast<double>(SDL_GetPerformanceCounter() - start) / static_cast<double>(SDL_GetPerformanceFrequency());
+    stream.endFrame(pointsDrawn, stream.chunkCount() - stream.visibleChunks.size(), seconds);
+}
+
 // Frame callback
 // --------------
 // Advances rotation using measured delta time, projects the current vertices
-// to 2D, and draws points and edges using SDL_Renderer.
+// to 2D with the batch transform, and draws points and edges with the selected
+// backend (SDL_Renderer or the software framebuffer).
 void frame_callback(SDL_Window *, SDL_Renderer *renderer, void *userData)
 {
 
     auto *state = static_cast<RenderState *>(userData);
-    Renderer3d renderer3d;
 
     // Input handled in the main event loop within renderer_run
 
     // Compute delta time (seconds) using SDL high-resolution timer
+    StageTimer animateTimer(state->profileSample, ProfileStage::Animate);
     const Uint64 currentPerformanceCounter = SDL_GetPerformanceCounter();
     const Uint64 performanceCounterFrequency = SDL_GetPerformanceFrequency();
     float deltaSeconds = 0.0f;
-    if (state->lastPerformanceCounter != 0 && performanceCounterFrequency != 0)
+    if (state->useReplayDeltas)
+    {
+        // Replayed trace: the step the recorded run took on this frame
+        deltaSeconds = state->replayDeltaSeconds;
+    }
+    else if (state->fixedDeltaSeconds > 0.0f)
+    {
+        // Fixed timestep (headless runs): identical animation regardless of speed
+        deltaSeconds = state->fixedDeltaSeconds;
+    }
+    else if (state->lastPerformanceCounter != 0 && performanceCounterFrequency != 0)
     {
         deltaSeconds = static_cast<float>(static_cast<double>(currentPerformanceCounter - state->lastPerformanceCounter) / static_cast<double>(performanceCounterFrequency));
         // Clamp to avoid huge jumps after pauses/window moves
@@ -85,6 +666,7 @@ void frame_callback(SDL_Window *, SDL_Renderer *renderer, void *userData)
             deltaSeconds = 0.1f;
     }
     state->lastPerformanceCounter = currentPerformanceCounter;
+    state->lastDeltaSeconds = deltaSeconds;
 
     // Rotate in degrees per second
     state->angleX += state->rotateSpeedX * deltaSeconds;
@@ -109,42 +691,102 @@ void frame_callback(SDL_Window *, SDL_Renderer *renderer, void *userData)
     state->angleX = wrap360(state->angleX);
     state->angleY = wrap360(state->angleY);
     state->angleZ = wrap360(state->angleZ);
+    if (!state->scene.motion.empty())
+        animateSceneInstances(state->scene, deltaSeconds);
+    animateTimer.stop();
 
-    std::vector<Point3d> rotatedPoints3d;
-    rotatedPoints3d.reserve(state->basePoints3d.size());
-    for (const auto &point3d : state->basePoints3d)
-    {
-        Point3d rotatedPoint = point3d;
-        rotatedPoint = renderer3d.rotateY(rotatedPoint, state->angleY);
-        rotatedPoint = renderer3d.rotateX(rotatedPoint, state->angleX);
-        rotatedPoint = renderer3d.rotateZ(rotatedPoint, state->angleZ);
-        rotatedPoints3d.push_back(rotatedPoint);
-    }
+    // Rotate and project every vertex with one fused matrix per frame (per
+    // instance, the instance transform is folded into it)
+    StageTimer cullTimer(state->profileSample, ProfileStage::Cull);
+    if (state->meshLoader)
+        state->meshLoader->adoptReady(*state); // A mesh finished off-thread arrives with its derived data
+    syncGeometry(*state);
+    syncDrawBatches(*state);
+    syncGeometryLod(*state);
+    syncScene(*state);
+    const ProjectionMatrix matrix = buildProjectionMatrix(state->angleX, state->angleY, state->angleZ,
+                                                          state->focalLength, state->viewerDistance,
+                                                          state->screenWidth, state->screenHeight);
+
+    // Reject whole objects outside the view frustum before any vertex work,
+    // then clip and cull what is left
+    const bool software = state->backend == RenderBackend::Software && state->framebuffer;
+    const int targetWidth = software ? state->framebuffer->width : state->screenWidth;
+    const int targetHeight = software ? state->framebuffer->height : state->screenHeight;
+    const Frustum frustum = makeFrustum(matrix, makeClipRegion(targetWidth, targetHeight, state->nearPlane));
+    state->clipStats = ClipStats{};
+    state->cullStats = CullStats{};
+    state->frameScratch.segments.clear();
+    const bool objectVisible = state->geometry.vertexCount > 0 && testAabb(frustum, state->geometryBounds) != FrustumTest::Outside;
+    state->cullStats.objectCulled = state->geometry.vertexCount > 0 && !objectVisible;
+    std::vector<std::uint32_t> &visible = state->frameScratch.visibleInstances;
+    cullSceneInstances(state->scene, frustum, visible, state->cullStats);
+    cullTimer.stop();
 
-    std::vector<Point2d> projectedPoints2d;
-    projectedPoints2d.reserve(rotatedPoints3d.size());
-    for (const auto &vertex : rotatedPoints3d)
+    // Objects that survive are drawn at the level of detail their screen size
+    // needs; visit(item, edgesSkipped) is called for the object, then each
+    // visible instance. Selection is stable, so a second walk picks the same levels.
+    auto forEachItem = [&](auto &&visit)
     {
-        projectedPoints2d.push_back(renderer3d.projectPoint(vertex, state->focalLength, state->viewerDistance, state->screenWidth, state->screenHeight));
-    }
+        if (objectVisible)
+        {
+            const int level = selectLodLevel(state->geometryLod, matrix, state->geometryBounds, state->nearPlane, state->geometryLodLevel);
+            state->geometryLodLevel = level;
+            DrawItem item{&state->geometry, &state->drawBatches, matrix, false, 0};
+            std::size_t edgesSkipped = 0;
+            if (level > 0)
+            {
+                const LodLevel &lod = state->geometryLod.levels[level - 1];
+                item.geometry = &lod.geometry;
+                item.batches = &lod.drawBatches;
+                edgesSkipped = state->geometry.edgeCount - lod.geometry.edgeCount;
+            }
+            visit(item, edgesSkipped);
+        }
+        for (const std::uint32_t index : visible)
+        {
+            const SceneInstance &instance = state->scene.instances[index];
+            const SceneMesh &mesh = state->scene.meshes[instance.mesh];
+            DrawItem item{&mesh.geometry, &mesh.drawBatches, instanceProjectionMatrix(matrix, instance.transform),
+                          !instance.useMeshColors, instance.color};
+            const int level = selectLodLevel(mesh.lod, item.matrix, mesh.bounds, state->nearPlane, state->scene.lodLevels[index]);
+            state->scene.lodLevels[index] = static_cast<std::uint8_t>(level);
+            std::size_t edgesSkipped = 0;
+            if (level > 0)
+            {
+                const LodLevel &lod = mesh.lod.levels[level - 1];
+                item.geometry = &lod.geometry;
+                item.batches = &lod.drawBatches;
+                edgesSkipped = mesh.geometry.edgeCount - lod.geometry.edgeCount;
+            }
+            visit(item, edgesSkipped);
+        }
+    };
 
-    for (const auto &projectedPoint : projectedPoints2d)
+    // Hidden-line mode: every item's faces go into the depth buffer before any
+    // edge is drawn. A lone object keeps its projection for the drawing pass.
+    const bool reuseProjection = state->hiddenLines && visible.empty();
+    if (state->hiddenLines)
     {
-        SDL_SetRenderDrawColor(renderer, projectedPoint.red, projectedPoint.green, projectedPoint.blue, 255);
-        SDL_RenderDrawPoint(renderer, static_cast<int>(projectedPoint.x), static_cast<int>(projectedPoint.y));
+        DepthBuffer &depth = state->frameScratch.depthBuffer;
+        depth.resize(targetWidth, targetHeight);
+        depth.clear();
+        depth.setTolerance(HIDDEN_LINE_BIAS_PIXELS / std::max(state->focalLength, 1.0f));
+        forEachItem([&](const DrawItem &item, std::size_t) { drawOccluders(*state, item); });
+        StageTimer timer(state->profileSample, ProfileStage::Rasterize);
+        depth.buildPyramid();
     }
 
-    for (const auto &edge : state->edges3d)
-    {
-        if (edge.pointOneIndex < 0 || edge.pointTwoIndex < 0)
-            continue;
-        if (static_cast<size_t>(edge.pointOneIndex) >= projectedPoints2d.size() ||
-            static_cast<size_t>(edge.pointTwoIndex) >= projectedPoints2d.size())
-            continue;
+    forEachItem([&](const DrawItem &item, std::size_t edgesSkipped)
+                {
+                    state->cullStats.lodEdgesSkipped += edgesSkipped;
+                    drawItem(*state, renderer, item, reuseProjection); });
+
+    if (state->pointStream)
+        drawPointStream(*state, renderer, matrix, frustum);
 
-        const auto &pointOne = projectedPoints2d[edge.pointOneIndex];
-        const auto &pointTwo = projectedPoints2d[edge.pointTwoIndex];
-        SDL_SetRenderDrawColor(renderer, edge.red, edge.green, edge.blue, 255);
-        SDL_RenderDrawLine(renderer, static_cast<int>(pointOne.x), static_cast<int>(pointOne.y), static_cast<int>(pointTwo.x), static_cast<int>(pointTwo.y));
+    if (software)
+    {
+        flushSegments(*state, *state->framebuffer);
     }
-}
\ No newline at end of file
+}
@@ -40,5 +40,15 @@ public:
  * Computes rotation based on delta time, projects 3D vertices, and draws
  * points and edges using SDL_Renderer. Input handling occurs outside of this
  * function in the main render loop (2d_renderer.cpp).
+ *
+ * While RenderState::drawRecording is set, the SDL backend's draw calls are
+ * appended to that list instead and renderer may be null.
  */
 void frame_callback(SDL_Window *, SDL_Renderer *renderer, void *userData);
+
+/**
+ * @brief Issue the draw calls recorded by frame_callback, in order.
+ * @param renderer  Target renderer (drawn over, not cleared).
+ * @param recording Calls recorded through RenderState::drawRecording.
+ */
+void replayDrawCommands(SDL_Renderer *renderer, const DrawCommandList &recording);
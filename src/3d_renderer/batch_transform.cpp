@@ -0,0 +1,269 @@
+// batch_transform.cpp
+// Fused rotation + projection kernels over structure-of-arrays positions.
+// Responsibilities:
+//  - folding the per-frame rotations and projection into one matrix
+//  - scalar, SSE and AVX transform kernels with runtime dispatch, each
+//    instantiated per TransformShape
+//  - chunked parallel transform on the frame's thread pool
+
+#include "batch_transform.h"
+#include "../threading/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_TRANSFORM_X86 1
+#include <immintrin.h>
+#endif
+
+constexpr float PI_F = 3.14159265358979323846f;
+
+// Same guard as Renderer3d::projectPoint
+constexpr float MIN_DEPTH = 1e-3f;
+
+struct Matrix3
+{
+    double m[3][3];
+};
+
+static Matrix3 multiply(const Matrix3 &a, const Matrix3 &b)
+{
+    Matrix3 result{};
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 3; ++col)
+        {
+            result.m[row][col] = a.m[row][0] * b.m[0][col] + a.m[row][1] * b.m[1][col] + a.m[row][2] * b.m[2][col];
+        }
+    }
+    return result;
+}
+
+// Convert degrees exactly like Renderer3d::rotateX/Y/Z so both paths see the same angle
+static double toRadians(float angleDegrees)
+{
+    return static_cast<double>(angleDegrees * PI_F / 180.0f);
+}
+
+// Kernels are instantiated per TransformShape. ViewAxisOnly drops the terms
+// classifyProjection proved to be exactly 0 (and the multiply by 1 in the depth
+// row); adding or multiplying those never changes a finite result, so both
+// instantiations produce the same bits.
+
+// Scalar kernel; the SIMD kernels below mirror its operation order exactly
+template <TransformShape Shape>
+static void transformScalar(const ProjectionMatrix &m, const float *x, const float *y, const float *z,
+                            std::size_t begin, std::size_t end, float *outX, float *outY, float *outDepth)
+{
+    constexpr bool general = Shape == TransformShape::General;
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        float w = general ? m.wRow[0] * x[i] + m.wRow[1] * y[i] + m.wRow[2] * z[i] + m.wRow[3] : z[i] + m.wRow[3];
+        outDepth[i] = w;
+        if (std::fabs(w) < MIN_DEPTH)
+        {
+            w = (w >= 0.0f) ? MIN_DEPTH : -MIN_DEPTH;
+        }
+        const float px = general ? m.xRow[0] * x[i] + m.xRow[1] * y[i] + m.xRow[2] * z[i] + m.xRow[3] : m.xRow[0] * x[i] + m.xRow[1] * y[i] + m.xRow[3];
+        const float py = general ? m.yRow[0] * x[i] + m.yRow[1] * y[i] + m.yRow[2] * z[i] + m.yRow[3] : m.yRow[0] * x[i] + m.yRow[1] * y[i] + m.yRow[3];
+        outX[i] = m.centerX + px / w;
+        outY[i] = m.centerY + py / w;
+    }
+}
+
+#ifdef BATCH_TRANSFORM_X86
+template <TransformShape Shape>
+static __attribute__((target("sse2"))) void transformSSE(const ProjectionMatrix &m, const float *x, const float *y, const float *z,
+                                                        std::size_t count, float *outX, float *outY, float *outDepth)
+{
+    constexpr bool general = Shape == TransformShape::General;
+    const __m128 wr0 = _mm_set1_ps(m.wRow[0]), wr1 = _mm_set1_ps(m.wRow[1]), wr2 = _mm_set1_ps(m.wRow[2]), wr3 = _mm_set1_ps(m.wRow[3]);
+    const __m128 xr0 = _mm_set1_ps(m.xRow[0]), xr1 = _mm_set1_ps(m.xRow[1]), xr2 = _mm_set1_ps(m.xRow[2]), xr3 = _mm_set1_ps(m.xRow[3]);
+    const __m128 yr0 = _mm_set1_ps(m.yRow[0]), yr1 = _mm_set1_ps(m.yRow[1]), yr2 = _mm_set1_ps(m.yRow[2]), yr3 = _mm_set1_ps(m.yRow[3]);
+    const __m128 centerX = _mm_set1_ps(m.centerX), centerY = _mm_set1_ps(m.centerY);
+    const __m128 minDepth = _mm_set1_ps(MIN_DEPTH), negMinDepth = _mm_set1_ps(-MIN_DEPTH);
+    const __m128 signMask = _mm_set1_ps(-0.0f), zero = _mm_setzero_ps();
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+
+        __m128 w = general ? _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(wr0, vx), _mm_mul_ps(wr1, vy)), _mm_mul_ps(wr2, vz)), wr3)
+                           : _mm_add_ps(vz, wr3);
+        _mm_storeu_ps(outDepth + i, w);
+        // Replace |w| < MIN_DEPTH with +/-MIN_DEPTH, keeping the sign convention of the scalar path
+        const __m128 tooSmall = _mm_cmplt_ps(_mm_andnot_ps(signMask, w), minDepth);
+        const __m128 negative = _mm_cmplt_ps(w, zero);
+        const __m128 clamped = _mm_or_ps(_mm_and_ps(negative, negMinDepth), _mm_andnot_ps(negative, minDepth));
+        w = _mm_or_ps(_mm_and_ps(tooSmall, clamped), _mm_andnot_ps(tooSmall, w));
+
+        __m128 px = _mm_add_ps(_mm_mul_ps(xr0, vx), _mm_mul_ps(xr1, vy));
+        __m128 py = _mm_add_ps(_mm_mul_ps(yr0, vx), _mm_mul_ps(yr1, vy));
+        if (general)
+        {
+            px = _mm_add_ps(px, _mm_mul_ps(xr2, vz));
+            py = _mm_add_ps(py, _mm_mul_ps(yr2, vz));
+        }
+        px = _mm_add_ps(px, xr3);
+        py = _mm_add_ps(py, yr3);
+        _mm_storeu_ps(outX + i, _mm_add_ps(centerX, _mm_div_ps(px, w)));
+        _mm_storeu_ps(outY + i, _mm_add_ps(centerY, _mm_div_ps(py, w)));
+    }
+    transformScalar<Shape>(m, x, y, z, i, count, outX, outY, outDepth);
+}
+
+template <TransformShape Shape>
+static __attribute__((target("avx"))) void transformAVX(const ProjectionMatrix &m, const float *x, const float *y, const float *z,
+                                                       std::size_t count, float *outX, float *outY, float *outDepth)
+{
+    constexpr bool general = Shape == TransformShape::General;
+    const __m256 wr0 = _mm256_set1_ps(m.wRow[0]), wr1 = _mm256_set1_ps(m.wRow[1]), wr2 = _mm256_set1_ps(m.wRow[2]), wr3 = _mm256_set1_ps(m.wRow[3]);
+    const __m256 xr0 = _mm256_set1_ps(m.xRow[0]), xr1 = _mm256_set1_ps(m.xRow[1]), xr2 = _mm256_set1_ps(m.xRow[2]), xr3 = _mm256_set1_ps(m.xRow[3]);
+    const __m256 yr0 = _mm256_set1_ps(m.yRow[0]), yr1 = _mm256_set1_ps(m.yRow[1]), yr2 = _mm256_set1_ps(m.yRow[2]), yr3 = _mm256_set1_ps(m.yRow[3]);
+    const __m256 centerX = _mm256_set1_ps(m.centerX), centerY = _mm256_set1_ps(m.centerY);
+    const __m256 minDepth = _mm256_set1_ps(MIN_DEPTH), negMinDepth = _mm256_set1_ps(-MIN_DEPTH);
+    const __m256 signMask = _mm256_set1_ps(-0.0f), zero = _mm256_setzero_ps();
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+
+        __m256 w = general ? _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(wr0, vx), _mm256_mul_ps(wr1, vy)), _mm256_mul_ps(wr2, vz)), wr3)
+                           : _mm256_add_ps(vz, wr3);
+        _mm256_storeu_ps(outDepth + i, w);
+        const __m256 tooSmall = _mm256_cmp_ps(_mm256_andnot_ps(signMask, w), minDepth, _CMP_LT_OQ);
+        const __m256 negative = _mm256_cmp_ps(w, zero, _CMP_LT_OQ);
+        const __m256 clamped = _mm256_blendv_ps(minDepth, negMinDepth, negative);
+        w = _mm256_blendv_ps(w, clamped, tooSmall);
+
+        __m256 px = _mm256_add_ps(_mm256_mul_ps(xr0, vx), _mm256_mul_ps(xr1, vy));
+        __m256 py = _mm256_add_ps(_mm256_mul_ps(yr0, vx), _mm256_mul_ps(yr1, vy));
+        if (general)
+        {
+            px = _mm256_add_ps(px, _mm256_mul_ps(xr2, vz));
+            py = _mm256_add_ps(py, _mm256_mul_ps(yr2, vz));
+        }
+        px = _mm256_add_ps(px, xr3);
+        py = _mm256_add_ps(py, yr3);
+        _mm256_storeu_ps(outX + i, _mm256_add_ps(centerX, _mm256_div_ps(px, w)));
+        _mm256_storeu_ps(outY + i, _mm256_add_ps(centerY, _mm256_div_ps(py, w)));
+    }
+    // Finish the remainder 4-wide, then scalar
+    transformSSE<Shape>(m, x + i, y + i, z + i, count - i, outX + i, outY + i, outDepth + i);
+}
+#endif
+
+// One shape's kernel chosen by width
+template <TransformShape Shape>
+static void transformShaped(const ProjectionMatrix &matrix, const float *x, const float *y, const float *z, std::size_t count,
+                            float *outX, float *outY, float *outDepth, TransformKernel kernel)
+{
+#ifdef BATCH_TRANSFORM_X86
+    switch (kernel)
+    {
+    case TransformKernel::AVX:
+        transformAVX<Shape>(matrix, x, y, z, count, outX, outY, outDepth);
+        return;
+    case TransformKernel::SSE:
+        transformSSE<Shape>(matrix, x, y, z, count, outX, outY, outDepth);
+        return;
+    default:
+        break;
+    }
+#endif
+    transformScalar<Shape>(matrix, x, y, z, 0, count, outX, outY, outDepth);
+}
+
+ProjectionMatrix buildProjectionMatrix(float angleXDegrees, float angleYDegrees, float angleZDegrees,
+                                       float focalLength, float viewerDistance, int screenWidth, int screenHeight)
+{
+    const double ax = toRadians(angleXDegrees), ay = toRadians(angleYDegrees), az = toRadians(angleZDegrees);
+    const double cx = std::cos(ax), sx = std::sin(ax);
+    const double cy = std::cos(ay), sy = std::sin(ay);
+    const double cz = std::cos(az), sz = std::sin(az);
+
+    const Matrix3 rotY = {{{cy, 0.0, sy}, {0.0, 1.0, 0.0}, {-sy, 0.0, cy}}};
+    const Matrix3 rotX = {{{1.0, 0.0, 0.0}, {0.0, cx, -sx}, {0.0, sx, cx}}};
+    const Matrix3 rotZ = {{{cz, -sz, 0.0}, {sz, cz, 0.0}, {0.0, 0.0, 1.0}}};
+
+    // Points are rotated around Y first, then X, then Z
+    const Matrix3 rotation = multiply(rotZ, multiply(rotX, rotY));
+
+    ProjectionMatrix matrix{};
+    for (int col = 0; col < 3; ++col)
+    {
+        matrix.xRow[col] = static_cast<float>(focalLength * rotation.m[0][col]);
+        matrix.yRow[col] = static_cast<float>(-focalLength * rotation.m[1][col]);
+        matrix.wRow[col] = static_cast<float>(rotation.m[2][col]);
+    }
+    matrix.xRow[3] = 0.0f;
+    matrix.yRow[3] = 0.0f;
+    matrix.wRow[3] = viewerDistance;
+    matrix.centerX = screenWidth * 0.5f;
+    matrix.centerY = screenHeight * 0.5f;
+    return matrix;
+}
+
+TransformKernel detectTransformKernel()
+{
+#ifdef BATCH_TRANSFORM_X86
+    static const TransformKernel detected = []()
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx"))
+            return TransformKernel::AVX;
+        if (__builtin_cpu_supports("sse2"))
+            return TransformKernel::SSE;
+        return TransformKernel::Scalar;
+    }();
+    return detected;
+#else
+    return TransformKernel::Scalar;
+#endif
+}
+
+TransformShape classifyProjection(const ProjectionMatrix &matrix)
+{
+    const bool viewAxisOnly = matrix.wRow[0] == 0.0f && matrix.wRow[1] == 0.0f && matrix.wRow[2] == 1.0f &&
+                              matrix.xRow[2] == 0.0f && matrix.yRow[2] == 0.0f;
+    return viewAxisOnly ? TransformShape::ViewAxisOnly : TransformShape::General;
+}
+
+void transformPositions(const ProjectionMatrix &matrix, const float *x, const float *y, const float *z, std::size_t count,
+                        float *outX, float *outY, float *outDepth, TransformKernel kernel, TransformShape shape)
+{
+    // Never run a kernel wider than the CPU supports
+    const TransformKernel supported = detectTransformKernel();
+    if (kernel == TransformKernel::Auto || static_cast<int>(kernel) > static_cast<int>(supported))
+    {
+        kernel = supported;
+    }
+
+    if (shape == TransformShape::ViewAxisOnly)
+        transformShaped<TransformShape::ViewAxisOnly>(matrix, x, y, z, count, outX, outY, outDepth, kernel);
+    else
+        transformShaped<TransformShape::General>(matrix, x, y, z, count, outX, outY, outDepth, kernel);
+}
+
+// Chunk boundaries must not move a vertex between a SIMD lane and the scalar tail
+static_assert(TRANSFORM_CHUNK_VERTICES % 8 == 0, "chunks must be whole AVX and SSE iterations");
+
+void transformPositionsParallel(ThreadPool &pool, const ProjectionMatrix &matrix, const float *x, const float *y, const float *z,
+                                std::size_t count, float *outX, float *outY, float *outDepth, TransformKernel kernel, TransformShape shape)
+{
+    if (count < PARALLEL_TRANSFORM_MIN_VERTICES || pool.threadCount() <= 1)
+    {
+        transformPositions(matrix, x, y, z, count, outX, outY, outDepth, kernel, shape);
+        return;
+    }
+
+    const std::size_t chunks = (count + TRANSFORM_CHUNK_VERTICES - 1) / TRANSFORM_CHUNK_VERTICES;
+    pool.parallelFor(chunks, [&](std::size_t chunk, unsigned)
+                     {
+                         const std::size_t begin = chunk * TRANSFORM_CHUNK_VERTICES;
+                         const std::size_t length = std::min(TRANSFORM_CHUNK_VERTICES, count - begin);
+                         transformPositions(matrix, x + begin, y + begin, z + begin, length, outX + begin, outY + begin,
+                                            outDepth + begin, kernel, shape); });
+}
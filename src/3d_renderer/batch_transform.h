@@ -0,0 +1,131 @@
+/**
+ * @file batch_transform.h
+ * @brief Fused rotation + perspective projection over SoA vertex buffers.
+ *
+ * Renderer3d rotates and projects one Point3d at a time, recomputing the
+ * trigonometry for every vertex. The batch API instead folds the three
+ * rotations and the projection into a single ProjectionMatrix once per frame
+ * and runs it over whole position arrays with SIMD kernels.
+ *
+ * Accuracy: for the same angles and projection parameters the batch output
+ * matches Renderer3d::rotateY/rotateX/rotateZ followed by projectPoint to
+ * within 1e-3 px + 1e-5 * focalLength * |p| / depth, where |p| is the
+ * vertex's distance from the origin and depth = viewerDistance + rotated z
+ * (i.e. 1e-5 of the vertex's projected scale). All kernels (scalar, SSE, AVX)
+ * evaluate the same operations in the same order and are bit-identical to
+ * each other. bench/micro_bench.cpp checks both (transform_accuracy).
+ */
+#pragma once
+
+#include <cstddef>
+
+class ThreadPool;
+
+/**
+ * @brief Combined rotation + perspective projection for one frame.
+ *
+ * Each row holds the x/y/z coefficients and the constant term of an affine
+ * function of the object-space position. For a vertex p:
+ *   w       = wRow . (p, 1)            (view depth, guarded away from zero)
+ *   screenX = centerX + (xRow . (p, 1)) / w
+ *   screenY = centerY + (yRow . (p, 1)) / w
+ */
+struct ProjectionMatrix
+{
+    float xRow[4]; ///< focalLength * rotated x
+    float yRow[4]; ///< -focalLength * rotated y (screen Y grows down)
+    float wRow[4]; ///< rotated z + viewerDistance
+    float centerX; ///< Half of the backbuffer width
+    float centerY; ///< Half of the backbuffer height
+};
+
+/**
+ * @brief SIMD implementation used by transformPositions.
+ */
+enum class TransformKernel
+{
+    Auto,   ///< Widest kernel supported by the running CPU
+    Scalar, ///< Portable fallback
+    SSE,    ///< 4 vertices per iteration (x86 SSE2)
+    AVX     ///< 8 vertices per iteration (x86 AVX)
+};
+
+/**
+ * @brief Structure of a ProjectionMatrix the kernels are specialized for.
+ *
+ * Each shape instantiates the kernels with the terms that are structurally
+ * zero (or one) left out. Only exact zeros are dropped, so every shape gives
+ * the same bits as General for the matrices classifyProjection assigns to it.
+ */
+enum class TransformShape
+{
+    General,      ///< Any rotation: three dot products of four terms per vertex
+    ViewAxisOnly ///< Rotation about the view (Z) axis only: depth is z + viewerDistance and x / y ignore z
+};
+
+/**
+ * @brief Narrowest shape matrix can be transformed with.
+ *
+ * Returns ViewAxisOnly when the X and Y rotations are zero (and no instance
+ * transform tilts the object), General otherwise.
+ */
+TransformShape classifyProjection(const ProjectionMatrix &matrix);
+
+/**
+ * @brief Build the frame matrix equivalent to rotateY, then rotateX, then
+ *        rotateZ, followed by projectPoint.
+ * @param angleXDegrees  Rotation around X in degrees.
+ * @param angleYDegrees  Rotation around Y in degrees.
+ * @param angleZDegrees  Rotation around Z in degrees.
+ * @param focalLength    Perspective scale factor.
+ * @param viewerDistance Distance from the camera to origin.
+ * @param screenWidth    Current backbuffer width.
+ * @param screenHeight   Current backbuffer height.
+ */
+ProjectionMatrix buildProjectionMatrix(float angleXDegrees, float angleYDegrees, float angleZDegrees,
+                                       float focalLength, float viewerDistance, int screenWidth, int screenHeight);
+
+/**
+ * @brief Transform count vertices from SoA input arrays to screen space.
+ *
+ * Output arrays must hold at least count floats and may not alias the inputs.
+ *
+ * @param matrix   Frame matrix from buildProjectionMatrix.
+ * @param x,y,z    Object-space coordinates.
+ * @param count    Number of vertices.
+ * @param outX     Receives screen-space x in pixels.
+ * @param outY     Receives screen-space y in pixels.
+ * @param outDepth Receives the view depth w before the near-zero guard, so
+ *                 callers can tell vertices behind the camera apart.
+ * @param kernel   Implementation to use; Auto picks the widest one available,
+ *                 and unsupported requests fall back to the next narrower one.
+ * @param shape    Specialization from classifyProjection(matrix); General is
+ *                 always correct.
+ */
+void transformPositions(const ProjectionMatrix &matrix, const float *x, const float *y, const float *z, std::size_t count,
+                        float *outX, float *outY, float *outDepth, TransformKernel kernel = TransformKernel::Auto,
+                        TransformShape shape = TransformShape::General);
+
+/** Below this many vertices transformPositionsParallel stays on the calling thread. */
+constexpr std::size_t PARALLEL_TRANSFORM_MIN_VERTICES = 65536;
+
+/** Vertices per parallel task: 8192 * 24 bytes of input and output stays in a core's L2. */
+constexpr std::size_t TRANSFORM_CHUNK_VERTICES = 8192;
+
+/**
+ * @brief transformPositions split into chunks run on pool.
+ *
+ * Chunks are TRANSFORM_CHUNK_VERTICES long, a multiple of every kernel's
+ * width, so each vertex goes through the same SIMD lane or scalar tail as in
+ * a single call and the output is bit-identical to transformPositions for
+ * any thread count. Counts below PARALLEL_TRANSFORM_MIN_VERTICES, and pools
+ * of one thread, run as a single call on the calling thread.
+ */
+void transformPositionsParallel(ThreadPool &pool, const ProjectionMatrix &matrix, const float *x, const float *y, const float *z,
+                                std::size_t count, float *outX, float *outY, float *outDepth,
+                                TransformKernel kernel = TransformKernel::Auto, TransformShape shape = TransformShape::General);
+
+/**
+ * @brief Return the kernel that TransformKernel::Auto resolves to on this CPU.
+ */
+TransformKernel detectTransformKernel();
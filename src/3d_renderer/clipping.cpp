@@ -0,0 +1,184 @@
+// clipping.cpp
+// Near-plane clipping and Cohen-Sutherland / Liang-Barsky viewport culling.
+
+#include "clipping.h"
+#include <algorithm>
+
+// Pixels a truncated endpoint and Bresenham stepping can stray from the ideal
+// segment; culling keeps anything within this distance of the viewport
+constexpr float VIEWPORT_MARGIN = 2.0f;
+
+ClipRegion makeClipRegion(int width, int height, float nearDepth)
+{
+    ClipRegion region;
+    region.minX = -VIEWPORT_MARGIN;
+    region.minY = -VIEWPORT_MARGIN;
+    region.maxX = static_cast<float>(width) + VIEWPORT_MARGIN;
+    region.maxY = static_cast<float>(height) + VIEWPORT_MARGIN;
+
+    // Far enough out that moving an endpoint onto it does not change which
+    // on-screen pixels a line covers in practice
+    const float guard = 4.0f * static_cast<float>(std::max(std::max(width, height), 1));
+    region.guardMinX = region.minX - guard;
+    region.guardMinY = region.minY - guard;
+    region.guardMaxX = region.maxX + guard;
+    region.guardMaxY = region.maxY + guard;
+    region.nearDepth = nearDepth;
+    return region;
+}
+
+// Cohen-Sutherland outcode bits
+enum : unsigned
+{
+    OUT_LEFT = 1,
+    OUT_RIGHT = 2,
+    OUT_TOP = 4,
+    OUT_BOTTOM = 8
+};
+
+static unsigned outcode(float x, float y, float minX, float minY, float maxX, float maxY)
+{
+    unsigned code = 0;
+    if (x < minX)
+        code |= OUT_LEFT;
+    else if (x > maxX)
+        code |= OUT_RIGHT;
+    if (y < minY)
+        code |= OUT_TOP;
+    else if (y > maxY)
+        code |= OUT_BOTTOM;
+    return code;
+}
+
+// Liang-Barsky: narrow [t0, t1] to the part of p0 + t * (p1 - p0) inside the
+// rectangle; returns false if nothing is left
+static bool liangBarsky(double x0, double y0, double x1, double y1, double minX, double minY, double maxX, double maxY,
+                        double &t0, double &t1)
+{
+    const double dx = x1 - x0, dy = y1 - y0;
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {x0 - minX, maxX - x0, y0 - minY, maxY - y0};
+    for (int side = 0; side < 4; ++side)
+    {
+        if (p[side] == 0.0)
+        {
+            if (q[side] < 0.0)
+                return false;
+            continue;
+        }
+        const double r = q[side] / p[side];
+        if (p[side] < 0.0)
+            t0 = std::max(t0, r);
+        else
+            t1 = std::min(t1, r);
+    }
+    return t0 <= t1;
+}
+
+// Screen position where the edge from inside vertex to outside vertex meets
+// the near plane; numerators and depth are affine in object space, so they
+// are interpolated there and divided once
+static void nearPlaneIntersection(const ProjectionMatrix &m, const GeometryView &geometry, std::uint32_t inside,
+                                  std::uint32_t outside, float nearDepth, float &x, float &y)
+{
+    const double px[2] = {geometry.x[inside], geometry.x[outside]};
+    const double py[2] = {geometry.y[inside], geometry.y[outside]};
+    const double pz[2] = {geometry.z[inside], geometry.z[outside]};
+    double numeratorX[2], numeratorY[2], depth[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        numeratorX[i] = m.xRow[0] * px[i] + m.xRow[1] * py[i] + m.xRow[2] * pz[i] + m.xRow[3];
+        numeratorY[i] = m.yRow[0] * px[i] + m.yRow[1] * py[i] + m.yRow[2] * pz[i] + m.yRow[3];
+        depth[i] = m.wRow[0] * px[i] + m.wRow[1] * py[i] + m.wRow[2] * pz[i] + m.wRow[3];
+    }
+    const double span = depth[0] - depth[1];
+    const double t = span > 0.0 ? (depth[0] - nearDepth) / span : 0.0;
+    const double clippedX = numeratorX[0] + t * (numeratorX[1] - numeratorX[0]);
+    const double clippedY = numeratorY[0] + t * (numeratorY[1] - numeratorY[0]);
+    x = static_cast<float>(m.centerX + clippedX / nearDepth);
+    y = static_cast<float>(m.centerY + clippedY / nearDepth);
+}
+
+template <bool InverseDepths>
+EdgeClip clipEdge(const ProjectionMatrix &matrix, const GeometryView &geometry, const ScreenBuffer &projected,
+                  std::uint32_t a, std::uint32_t b, const ClipRegion &region, ClippedEdge &out, ClipStats &stats)
+{
+    float x0 = projected.x[a], y0 = projected.y[a], x1 = projected.x[b], y1 = projected.y[b];
+    float inverse0 = InverseDepths ? 1.0f / projected.depth[a] : 0.0f, inverse1 = InverseDepths ? 1.0f / projected.depth[b] : 0.0f;
+    bool moved = false;
+
+    // Near plane (view space)
+    const bool frontA = projected.depth[a] >= region.nearDepth, frontB = projected.depth[b] >= region.nearDepth;
+    if (!frontA && !frontB)
+    {
+        ++stats.edgesCulled;
+        return EdgeClip::Culled;
+    }
+    if (!frontA || !frontB)
+    {
+        if (!frontA)
+        {
+            nearPlaneIntersection(matrix, geometry, b, a, region.nearDepth, x0, y0);
+            inverse0 = InverseDepths ? 1.0f / region.nearDepth : 0.0f;
+        }
+        else
+        {
+            nearPlaneIntersection(matrix, geometry, a, b, region.nearDepth, x1, y1);
+            inverse1 = InverseDepths ? 1.0f / region.nearDepth : 0.0f;
+        }
+        ++stats.edgesNearClipped;
+        moved = true;
+    }
+
+    // Viewport: trivial accept / reject by outcodes, Liang-Barsky otherwise
+    const unsigned code0 = outcode(x0, y0, region.minX, region.minY, region.maxX, region.maxY);
+    const unsigned code1 = outcode(x1, y1, region.minX, region.minY, region.maxX, region.maxY);
+    if (code0 & code1)
+    {
+        ++stats.edgesCulled;
+        return EdgeClip::Culled;
+    }
+    if (code0 != 0 || code1 != 0)
+    {
+        double t0 = 0.0, t1 = 1.0;
+        if (!liangBarsky(x0, y0, x1, y1, region.minX, region.minY, region.maxX, region.maxY, t0, t1))
+        {
+            ++stats.edgesCulled;
+            return EdgeClip::Culled;
+        }
+
+        // Visible; bound far endpoints to the guard band
+        const unsigned guard0 = outcode(x0, y0, region.guardMinX, region.guardMinY, region.guardMaxX, region.guardMaxY);
+        const unsigned guard1 = outcode(x1, y1, region.guardMinX, region.guardMinY, region.guardMaxX, region.guardMaxY);
+        if (guard0 != 0 || guard1 != 0)
+        {
+            double g0 = 0.0, g1 = 1.0;
+            liangBarsky(x0, y0, x1, y1, region.guardMinX, region.guardMinY, region.guardMaxX, region.guardMaxY, g0, g1);
+            const double dx = static_cast<double>(x1) - x0, dy = static_cast<double>(y1) - y0;
+            const float startX = static_cast<float>(x0 + g0 * dx), startY = static_cast<float>(y0 + g0 * dy);
+            x1 = static_cast<float>(x0 + g1 * dx);
+            y1 = static_cast<float>(y0 + g1 * dy);
+            x0 = startX;
+            y0 = startY;
+            if (InverseDepths)
+            {
+                const double inverseSpan = static_cast<double>(inverse1) - inverse0;
+                const float startInverse = static_cast<float>(inverse0 + g0 * inverseSpan);
+                inverse1 = static_cast<float>(inverse0 + g1 * inverseSpan);
+                inverse0 = startInverse;
+            }
+            ++stats.edgesViewportClipped;
+            moved = true;
+        }
+    }
+
+    if (!moved)
+        return EdgeClip::Visible;
+    out = {x0, y0, x1, y1, inverse0, inverse1};
+    return EdgeClip::Clipped;
+}
+
+template EdgeClip clipEdge<true>(const ProjectionMatrix &, const GeometryView &, const ScreenBuffer &, std::uint32_t, std::uint32_t,
+                                 const ClipRegion &, ClippedEdge &, ClipStats &);
+template EdgeClip clipEdge<false>(const ProjectionMatrix &, const GeometryView &, const ScreenBuffer &, std::uint32_t, std::uint32_t,
+                                  const ClipRegion &, ClippedEdge &, ClipStats &);
@@ -0,0 +1,87 @@
+/**
+ * @file clipping.h
+ * @brief Near-plane clipping and viewport culling of projected points and edges.
+ *
+ * Runs between the batch transform and the backends so only geometry that
+ * can produce pixels reaches the rasterizer:
+ *  - vertices and edges entirely behind the near plane are culled, and edges
+ *    crossing it are cut there in view space (homogeneous coordinates are
+ *    recomputed from object space for the crossing edge only);
+ *  - the remaining segments get Cohen-Sutherland outcodes against the
+ *    viewport for trivial accept/reject, and Liang-Barsky for the rest.
+ *
+ * Culling is conservative: the viewport test uses a margin of two pixels so
+ * nothing that could round onto the screen is dropped. Visible segments keep
+ * their projected endpoints unless an endpoint lies outside a wide guard band
+ * around the viewport, in which case it is moved onto the guard band. Lines
+ * are therefore rasterized from their own endpoints except when those are far
+ * off screen, and the coordinates reaching the rasterizer stay bounded.
+ */
+#pragma once
+
+#include <cstdint>
+#include "../app_state/app_state.h" // ClipStats, GeometryView, ScreenBuffer
+#include "batch_transform.h"        // ProjectionMatrix
+
+/**
+ * @brief Per-frame clipping bounds.
+ */
+struct ClipRegion
+{
+    float minX, minY, maxX, maxY;                     ///< Viewport plus the conservative margin
+    float guardMinX, guardMinY, guardMaxX, guardMaxY; ///< Endpoints beyond this band are moved onto it
+    float nearDepth;                                  ///< Near plane view depth
+};
+
+/**
+ * @brief Result of clipping one edge.
+ */
+enum class EdgeClip
+{
+    Culled,   ///< Nothing of the edge is visible
+    Visible,  ///< Visible with its projected endpoints unchanged
+    Clipped   ///< Visible after moving one or both endpoints
+};
+
+/**
+ * @brief Screen-space endpoints of a clipped edge.
+ */
+struct ClippedEdge
+{
+    float x0, y0, x1, y1;               ///< Endpoints in pixels
+    float inverseDepth0, inverseDepth1; ///< 1 / view depth at the endpoints (linear in screen space)
+};
+
+/**
+ * @brief Build the clip region for a width x height target.
+ */
+ClipRegion makeClipRegion(int width, int height, float nearDepth);
+
+/**
+ * @brief True if vertex index lies in front of the near plane and on screen.
+ */
+inline bool pointVisible(const ScreenBuffer &projected, std::size_t index, const ClipRegion &region)
+{
+    const float x = projected.x[index], y = projected.y[index];
+    return projected.depth[index] >= region.nearDepth && x >= region.minX && x <= region.maxX && y >= region.minY &&
+           y <= region.maxY;
+}
+
+/**
+ * @brief Clip the edge (a, b) of the current frame.
+ *
+ * @param matrix    Frame matrix the projected buffer was produced with.
+ * @param geometry  Object-space vertices (read only for near-plane crossings).
+ * @param projected Screen coordinates and depths of the frame.
+ * @param a, b      Vertex indices of the edge.
+ * @param region    Clip bounds from makeClipRegion.
+ * @param out       Receives the endpoints when the result is Clipped.
+ * @param stats     Culled / clipped counters to update.
+ *
+ * InverseDepths = false skips the 1 / depth of the endpoints for callers that
+ * do not depth-test (out.inverseDepth0/1 are then 0); both variants are
+ * instantiated in clipping.cpp.
+ */
+template <bool InverseDepths = true>
+EdgeClip clipEdge(const ProjectionMatrix &matrix, const GeometryView &geometry, const ScreenBuffer &projected,
+                  std::uint32_t a, std::uint32_t b, const ClipRegion &region, ClippedEdge &out, ClipStats &stats);
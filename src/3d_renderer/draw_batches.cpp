@@ -0,0 +1,191 @@
+// draw_batches.cpp
+// Color bucketing and edge strip chaining for batched SDL submission.
+
+#include "draw_batches.h"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+// Returns the batch for a packed ARGB8888 color, appending a new one on first use
+static std::size_t batchForColor(std::unordered_map<std::uint32_t, std::size_t> &lookup, DrawBatches &out, std::uint32_t color)
+{
+    // find() first: emplace() would allocate a node even for colors already present
+    const std::uint32_t key = color & 0xFFFFFFu;
+    const auto found = lookup.find(key);
+    if (found != lookup.end())
+        return found->second;
+
+    const int red = static_cast<int>((color >> 16) & 0xFF), green = static_cast<int>((color >> 8) & 0xFF);
+    const int blue = static_cast<int>(color & 0xFF);
+    out.batches.push_back({red, green, blue, 0, 0, 0, 0, 0, 0});
+    lookup.emplace(key, out.batches.size() - 1);
+    return out.batches.size() - 1;
+}
+
+// Walk the edges of one batch into strips. edgeList holds global edge indices;
+// the per-vertex scratch arrays are sized to the vertex count and left zeroed.
+static void chainStrips(const std::uint32_t *edgeIndices, const int *edgeList, std::size_t edgeCount,
+                        std::vector<int> &degree, std::vector<int> &cursor, std::vector<int> &rangeEnd,
+                        std::vector<int> &adjacency, std::vector<int> &touched, DrawBatches &out)
+{
+    // Build a CSR adjacency (vertex -> incident local edge ids) over the touched vertices
+    touched.clear();
+    for (std::size_t e = 0; e < edgeCount; ++e)
+    {
+        const std::uint32_t *edge = edgeIndices + 2 * static_cast<std::size_t>(edgeList[e]);
+        for (const int vertex : {static_cast<int>(edge[0]), static_cast<int>(edge[1])})
+        {
+            if (degree[vertex]++ == 0)
+                touched.push_back(vertex);
+        }
+    }
+
+    // rangeEnd doubles as the fill pointer and ends up one past each vertex's range
+    int offset = 0;
+    for (const int vertex : touched)
+    {
+        cursor[vertex] = offset;
+        rangeEnd[vertex] = offset;
+        offset += degree[vertex];
+    }
+    adjacency.resize(static_cast<std::size_t>(offset));
+    for (std::size_t e = 0; e < edgeCount; ++e)
+    {
+        const std::uint32_t *edge = edgeIndices + 2 * static_cast<std::size_t>(edgeList[e]);
+        adjacency[rangeEnd[edge[0]]++] = static_cast<int>(e);
+        adjacency[rangeEnd[edge[1]]++] = static_cast<int>(e);
+    }
+
+    std::vector<bool> used(edgeCount, false);
+    auto nextEdge = [&](int vertex) -> int
+    {
+        // cursor[v] only moves forward, so each adjacency entry is skipped at most once
+        while (cursor[vertex] < rangeEnd[vertex])
+        {
+            const int candidate = adjacency[cursor[vertex]++];
+            if (!used[candidate])
+                return candidate;
+        }
+        return -1;
+    };
+
+    auto walkFrom = [&](int start)
+    {
+        int edgeIndex;
+        while ((edgeIndex = nextEdge(start)) >= 0)
+        {
+            const std::size_t stripStart = out.stripVertices.size();
+            out.stripVertices.push_back(start);
+            int current = start;
+            while (edgeIndex >= 0)
+            {
+                used[edgeIndex] = true;
+                const std::uint32_t *edge = edgeIndices + 2 * static_cast<std::size_t>(edgeList[edgeIndex]);
+                current = (static_cast<int>(edge[0]) == current) ? static_cast<int>(edge[1]) : static_cast<int>(edge[0]);
+                out.stripVertices.push_back(current);
+                edgeIndex = nextEdge(current);
+            }
+            out.stripLengths.push_back(static_cast<int>(out.stripVertices.size() - stripStart));
+        }
+    };
+
+    // Trails must start and end at odd-degree vertices; start there first
+    for (const int vertex : touched)
+    {
+        if (degree[vertex] % 2 != 0)
+            walkFrom(vertex);
+    }
+    for (const int vertex : touched)
+    {
+        walkFrom(vertex);
+    }
+
+    for (const int vertex : touched)
+    {
+        degree[vertex] = 0;
+    }
+}
+
+void buildDrawBatches(const GeometryView &geometry, DrawBatches &out)
+{
+    out.batches.clear();
+    out.pointIndices.clear();
+    out.stripVertices.clear();
+    out.stripLengths.clear();
+
+    std::unordered_map<std::uint32_t, std::size_t> lookup;
+    const std::size_t vertexCount = geometry.vertexCount, edgeCount = geometry.edgeCount;
+
+    // Assign every point and edge to a batch
+    std::vector<std::size_t> pointBatch(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; ++i)
+    {
+        pointBatch[i] = batchForColor(lookup, out, geometry.pointColors ? geometry.pointColors[i] : geometry.uniformColor);
+        ++out.batches[pointBatch[i]].pointCount;
+    }
+
+    std::vector<std::size_t> edgeBatch(edgeCount);
+    std::vector<std::size_t> edgeCounts;
+    for (std::size_t i = 0; i < edgeCount; ++i)
+    {
+        edgeBatch[i] = batchForColor(lookup, out, geometry.edgeColors ? geometry.edgeColors[i] : geometry.uniformColor);
+        edgeCounts.resize(out.batches.size(), 0);
+        ++edgeCounts[edgeBatch[i]];
+    }
+    edgeCounts.resize(out.batches.size(), 0);
+
+    // Counting sort of points and edges by batch (stable, so original order is kept within a color)
+    std::vector<std::size_t> pointFill(out.batches.size()), edgeBegin(out.batches.size());
+    std::size_t pointOffset = 0, edgeOffset = 0;
+    for (std::size_t b = 0; b < out.batches.size(); ++b)
+    {
+        out.batches[b].pointBegin = pointOffset;
+        pointFill[b] = pointOffset;
+        pointOffset += out.batches[b].pointCount;
+        edgeBegin[b] = edgeOffset;
+        edgeOffset += edgeCounts[b];
+    }
+
+    out.pointIndices.resize(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; ++i)
+    {
+        out.pointIndices[pointFill[pointBatch[i]]++] = static_cast<int>(i);
+    }
+
+    std::vector<int> sortedEdges(edgeOffset);
+    std::vector<std::size_t> edgeFill(edgeBegin);
+    for (std::size_t i = 0; i < edgeCount; ++i)
+    {
+        sortedEdges[edgeFill[edgeBatch[i]]++] = static_cast<int>(i);
+    }
+
+    // Chain each batch's edges into strips
+    std::vector<int> degree(vertexCount, 0), cursor(vertexCount, 0), rangeEnd(vertexCount, 0), adjacency, touched;
+    for (std::size_t b = 0; b < out.batches.size(); ++b)
+    {
+        DrawBatch &batch = out.batches[b];
+        batch.stripBegin = out.stripLengths.size();
+        batch.stripVertexBegin = out.stripVertices.size();
+        chainStrips(geometry.edgeIndices, sortedEdges.data() + edgeBegin[b], edgeCounts[b], degree, cursor, rangeEnd,
+                    adjacency, touched, out);
+        batch.stripCount = out.stripLengths.size() - batch.stripBegin;
+        batch.stripVertexCount = out.stripVertices.size() - batch.stripVertexBegin;
+    }
+}
+
+void syncDrawBatches(RenderState &state)
+{
+    if (state.drawBatches.revision == state.geometryRevision)
+        return;
+
+    buildDrawBatches(state.geometry, state.drawBatches);
+    state.drawBatches.revision = state.geometryRevision;
+
+    // Submission gathers one batch at a time into this buffer
+    std::size_t largestBatch = 0;
+    for (const DrawBatch &batch : state.drawBatches.batches)
+    {
+        largestBatch = std::max({largestBatch, batch.pointCount, batch.stripVertexCount});
+    }
+    state.frameScratch.submitPoints.reserve(largestBatch);
+}
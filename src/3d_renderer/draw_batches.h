@@ -0,0 +1,32 @@
+/**
+ * @file draw_batches.h
+ * @brief Regroups geometry by color and chains edges into polyline strips.
+ *
+ * The SDL_Renderer backend submits DrawBatches with SDL_RenderDrawPoints and
+ * SDL_RenderDrawLines, so the number of SDL calls per frame depends on the
+ * number of colors and strips rather than on the number of points and edges.
+ */
+#pragma once
+
+#include "../app_state/app_state.h" // DrawBatches, GeometryView, RenderState
+
+/**
+ * @brief Build color batches for the given geometry.
+ *
+ * Batches appear in order of first use of their color. Within a batch, edges
+ * are walked into strips greedily, starting from odd-degree vertices so that
+ * connected runs end up in as few strips as possible. A GeometryView only
+ * holds in-range edges, so submission needs no bounds checks.
+ *
+ * @param geometry Vertices and edges; their colors select the batches.
+ * @param out      Receives the batches; previous contents are replaced.
+ */
+void buildDrawBatches(const GeometryView &geometry, DrawBatches &out);
+
+/**
+ * @brief Rebuild state.drawBatches from state.geometry if the geometry changed
+ *        since the last build (call after syncGeometry).
+ *
+ * Also reserves state.frameScratch.submitPoints for the largest batch.
+ */
+void syncDrawBatches(RenderState &state);
@@ -0,0 +1,107 @@
+// geometry_view.cpp
+// Packs the editable Point3d/Edge3d geometry into the flat arrays the frame
+// pipeline reads, or adopts caller-owned external geometry as is.
+
+#include "geometry_view.h"
+#include "../framebuffer/framebuffer.h" // packColor
+#include <algorithm>
+
+void packGeometry(const std::vector<Point3d> &points, const std::vector<Edge3d> &edges, const std::vector<std::uint32_t> &triangles,
+                  PackedGeometry &packed)
+{
+    const std::size_t count = points.size();
+    packed.x.resize(count);
+    packed.y.resize(count);
+    packed.z.resize(count);
+    packed.pointColors.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        packed.x[i] = points[i].x;
+        packed.y[i] = points[i].y;
+        packed.z[i] = points[i].z;
+        packed.pointColors[i] = packColor(points[i].red, points[i].green, points[i].blue);
+    }
+
+    packed.edgeIndices.clear();
+    packed.edgeColors.clear();
+    for (const Edge3d &edge : edges)
+    {
+        if (edge.pointOneIndex < 0 || edge.pointTwoIndex < 0 ||
+            static_cast<std::size_t>(edge.pointOneIndex) >= count || static_cast<std::size_t>(edge.pointTwoIndex) >= count)
+            continue;
+        packed.edgeIndices.push_back(static_cast<std::uint32_t>(edge.pointOneIndex));
+        packed.edgeIndices.push_back(static_cast<std::uint32_t>(edge.pointTwoIndex));
+        packed.edgeColors.push_back(packColor(edge.red, edge.green, edge.blue));
+    }
+
+    packed.triangleIndices.clear();
+    for (std::size_t i = 0; i + 3 <= triangles.size(); i += 3)
+    {
+        if (triangles[i] >= count || triangles[i + 1] >= count || triangles[i + 2] >= count)
+            continue;
+        packed.triangleIndices.insert(packed.triangleIndices.end(), triangles.begin() + i, triangles.begin() + i + 3);
+    }
+}
+
+GeometryView viewOf(const PackedGeometry &packed)
+{
+    GeometryView view;
+    view.x = packed.x.data();
+    view.y = packed.y.data();
+    view.z = packed.z.data();
+    view.pointColors = packed.pointColors.data();
+    view.edgeIndices = packed.edgeIndices.data();
+    view.edgeColors = packed.edgeColors.data();
+    view.triangleIndices = packed.triangleIndices.data();
+    view.vertexCount = packed.x.size();
+    view.edgeCount = packed.edgeColors.size();
+    view.triangleCount = packed.triangleIndices.size() / 3;
+    return view;
+}
+
+Aabb computeBounds(const GeometryView &geometry)
+{
+    if (geometry.vertexCount == 0)
+        return Aabb{{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+
+    Aabb bounds{{geometry.x[0], geometry.y[0], geometry.z[0]}, {geometry.x[0], geometry.y[0], geometry.z[0]}};
+    const float *coordinates[3] = {geometry.x, geometry.y, geometry.z};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const auto range = std::minmax_element(coordinates[axis], coordinates[axis] + geometry.vertexCount);
+        bounds.min[axis] = *range.first;
+        bounds.max[axis] = *range.second;
+    }
+    return bounds;
+}
+
+void syncGeometry(RenderState &state)
+{
+    if (state.geometryViewRevision == state.geometryRevision)
+        return;
+
+    if (state.externalGeometry.x)
+    {
+        state.geometry = state.externalGeometry;
+    }
+    else
+    {
+        packGeometry(state.basePoints3d, state.edges3d, state.triangles3d, state.packedGeometry);
+        state.geometry = viewOf(state.packedGeometry);
+    }
+
+    state.geometryBounds = computeBounds(state.geometry);
+
+    const std::size_t vertexCount = state.geometry.vertexCount, primitiveCount = vertexCount + state.geometry.edgeCount;
+    state.projectedPoints.x.resize(vertexCount);
+    state.projectedPoints.y.resize(vertexCount);
+    state.projectedPoints.depth.resize(vertexCount);
+
+    // Size the per-frame scratch once here instead of growing it during frames.
+    // Tile bins usually hold each primitive in one or two tiles; rarer frames
+    // that need more grow the capacity once and keep it.
+    FrameScratch &scratch = state.frameScratch;
+    scratch.segments.reserve(primitiveCount);
+    scratch.tileBins.segmentIndices.reserve(2 * primitiveCount);
+    state.geometryViewRevision = state.geometryRevision;
+}
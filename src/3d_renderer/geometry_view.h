@@ -0,0 +1,38 @@
+/**
+ * @file geometry_view.h
+ * @brief Selects and prepares the geometry the frame pipeline draws.
+ */
+#pragma once
+
+#include <vector>
+#include "../app_state/app_state.h" // RenderState, GeometryView, PackedGeometry
+
+/**
+ * @brief Pack points/edges/triangles into flat arrays: SoA positions, packed
+ *        colors, and only the edges and triangles whose indices are in range.
+ */
+void packGeometry(const std::vector<Point3d> &points, const std::vector<Edge3d> &edges, const std::vector<std::uint32_t> &triangles,
+                  PackedGeometry &packed);
+
+/**
+ * @brief View of packed; valid until packed is modified or destroyed.
+ */
+GeometryView viewOf(const PackedGeometry &packed);
+
+/**
+ * @brief Object-space bounds of geometry (all zero when it has no vertices).
+ */
+Aabb computeBounds(const GeometryView &geometry);
+
+/**
+ * @brief Refresh state.geometry if the geometry changed.
+ *
+ * While state.externalGeometry is set it is used in place. Otherwise
+ * basePoints3d/edges3d/triangles3d are packed into state.packedGeometry (SoA positions,
+ * packed colors, out-of-range edges dropped) and the view points there.
+ * geometryBounds is recomputed for frustum culling.
+ * projectedPoints is sized to the vertex count and the frame scratch is
+ * reserved for the new primitive count. Does nothing while
+ * geometryViewRevision is current.
+ */
+void syncGeometry(RenderState &state);
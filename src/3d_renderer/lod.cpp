@@ -0,0 +1,182 @@
+// lod.cpp
+// Vertex-clustering decimation and per-frame level selection.
+
+#include "lod.h"
+#include "draw_batches.h"            // buildDrawBatches
+#include "geometry_view.h"           // viewOf
+#include "../mesh_io/edge_set.h"     // EdgeSet
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Meshes smaller than this are drawn as they are
+constexpr std::size_t LOD_MIN_VERTICES = 2048;
+
+constexpr std::size_t LOD_MAX_LEVELS = 8;
+
+// First clustering attempt uses cells this many times smaller than the mesh
+constexpr double LOD_FIRST_CELL_DIVISOR = 1024.0;
+
+// A level is kept only if it has at most this fraction of the previous level's vertices
+constexpr double LOD_MIN_REDUCTION = 0.5;
+
+// Stop once a level is this small
+constexpr std::size_t LOD_SMALLEST_LEVEL = 16;
+
+// Target geometric error in pixels, and the fraction of it a coarser level
+// must reach before it replaces the current one
+constexpr double LOD_PIXEL_ERROR = 1.0;
+constexpr double LOD_HYSTERESIS = 0.75;
+
+// Cluster source on a grid of cellSize cells anchored at bounds.min
+static void clusterVertices(const GeometryView &source, const Aabb &bounds, double cellSize, PackedGeometry &out)
+{
+    const std::size_t count = source.vertexCount;
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> cells(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const float position[3] = {source.x[i], source.y[i], source.z[i]};
+        std::uint64_t key = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const double cell = std::floor((position[axis] - bounds.min[axis]) / cellSize);
+            key = (key << 21) | static_cast<std::uint64_t>(std::clamp(cell, 0.0, double((1 << 21) - 1)));
+        }
+        cells[i] = {key, static_cast<std::uint32_t>(i)};
+    }
+    // Ties keep vertex order, so each cluster takes the color of its first vertex
+    std::sort(cells.begin(), cells.end());
+
+    out.x.clear();
+    out.y.clear();
+    out.z.clear();
+    out.pointColors.clear();
+    std::vector<std::uint32_t> remap(count);
+    for (std::size_t begin = 0; begin < count;)
+    {
+        std::size_t end = begin;
+        double sum[3] = {0.0, 0.0, 0.0};
+        for (; end < count && cells[end].first == cells[begin].first; ++end)
+        {
+            const std::uint32_t vertex = cells[end].second;
+            sum[0] += source.x[vertex];
+            sum[1] += source.y[vertex];
+            sum[2] += source.z[vertex];
+            remap[vertex] = static_cast<std::uint32_t>(out.x.size());
+        }
+        const double members = static_cast<double>(end - begin);
+        const std::uint32_t first = cells[begin].second;
+        out.x.push_back(static_cast<float>(sum[0] / members));
+        out.y.push_back(static_cast<float>(sum[1] / members));
+        out.z.push_back(static_cast<float>(sum[2] / members));
+        out.pointColors.push_back(source.pointColors ? source.pointColors[first] : source.uniformColor);
+        begin = end;
+    }
+
+    // Collapsed edges vanish (EdgeSet ignores self-loops) and merged ones are kept once
+    EdgeSet edges;
+    edges.reserve(source.edgeCount / 2);
+    out.edgeColors.clear();
+    for (std::size_t i = 0; i < source.edgeCount; ++i)
+    {
+        if (edges.insert(remap[source.edgeIndices[2 * i]], remap[source.edgeIndices[2 * i + 1]]))
+            out.edgeColors.push_back(source.edgeColors ? source.edgeColors[i] : source.uniformColor);
+    }
+    out.edgeIndices.clear();
+    out.edgeIndices.reserve(2 * edges.edges().size());
+    for (const std::uint64_t key : edges.edges())
+    {
+        out.edgeIndices.push_back(EdgeSet::first(key));
+        out.edgeIndices.push_back(EdgeSet::second(key));
+    }
+
+    // Faces keep occluding at coarser levels; collapsed ones are dropped
+    out.triangleIndices.clear();
+    for (std::size_t i = 0; i < source.triangleCount; ++i)
+    {
+        const std::uint32_t a = remap[source.triangleIndices[3 * i]], b = remap[source.triangleIndices[3 * i + 1]],
+                            c = remap[source.triangleIndices[3 * i + 2]];
+        if (a != b && b != c && a != c)
+            out.triangleIndices.insert(out.triangleIndices.end(), {a, b, c});
+    }
+}
+
+void buildMeshLod(const GeometryView &geometry, const Aabb &bounds, MeshLod &lod)
+{
+    lod.levels.clear();
+    if (geometry.vertexCount < LOD_MIN_VERTICES)
+        return;
+    const double extent = std::max({static_cast<double>(bounds.max[0]) - bounds.min[0], static_cast<double>(bounds.max[1]) - bounds.min[1],
+                                    static_cast<double>(bounds.max[2]) - bounds.min[2]});
+    if (!(extent > 0.0))
+        return;
+
+    // Each level clusters the previous one; levels never move, so views stay valid
+    lod.levels.reserve(LOD_MAX_LEVELS);
+    GeometryView source = geometry;
+    PackedGeometry candidate;
+    for (double cellSize = extent / LOD_FIRST_CELL_DIVISOR; lod.levels.size() < LOD_MAX_LEVELS && cellSize <= extent; cellSize *= 2.0)
+    {
+        clusterVertices(source, bounds, cellSize, candidate);
+        if (candidate.x.size() > LOD_MIN_REDUCTION * static_cast<double>(source.vertexCount))
+            continue;
+
+        lod.levels.emplace_back();
+        LodLevel &level = lod.levels.back();
+        level.storage = std::move(candidate);
+        candidate = PackedGeometry{};
+        level.geometry = viewOf(level.storage);
+        level.cellSize = static_cast<float>(cellSize);
+        buildDrawBatches(level.geometry, level.drawBatches);
+        source = level.geometry;
+        if (source.vertexCount <= LOD_SMALLEST_LEVEL)
+            break;
+    }
+}
+
+int selectLodLevel(const MeshLod &lod, const ProjectionMatrix &matrix, const Aabb &bounds, float nearDepth, int currentLevel)
+{
+    const int levelCount = static_cast<int>(lod.levels.size()) + 1;
+    if (levelCount == 1)
+        return 0;
+
+    // Depth of the box corner closest to the camera
+    double nearest = matrix.wRow[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const double center = 0.5 * (static_cast<double>(bounds.min[axis]) + bounds.max[axis]);
+        const double extent = 0.5 * (static_cast<double>(bounds.max[axis]) - bounds.min[axis]);
+        nearest += matrix.wRow[axis] * center - std::fabs(matrix.wRow[axis]) * extent;
+    }
+    if (nearest <= nearDepth)
+        return 0;
+
+    // Pixels per object unit at that depth (the rows carry focal length and scale)
+    const auto rowLength = [](const float *row)
+    { return std::sqrt(static_cast<double>(row[0]) * row[0] + static_cast<double>(row[1]) * row[1] + static_cast<double>(row[2]) * row[2]); };
+    const double pixelsPerUnit = std::max(rowLength(matrix.xRow), rowLength(matrix.yRow)) / nearest;
+    const auto error = [&](int level)
+    { return level == 0 ? 0.0 : lod.levels[level - 1].cellSize * pixelsPerUnit; };
+
+    int level = std::clamp(currentLevel, 0, levelCount - 1);
+    while (level > 0 && error(level) > LOD_PIXEL_ERROR)
+    {
+        --level;
+    }
+    while (level + 1 < levelCount && error(level + 1) <= LOD_PIXEL_ERROR * LOD_HYSTERESIS)
+    {
+        ++level;
+    }
+    return level;
+}
+
+void syncGeometryLod(RenderState &state)
+{
+    if (state.geometryLodRevision == state.geometryRevision)
+        return;
+
+    buildMeshLod(state.geometry, state.geometryBounds, state.geometryLod);
+    state.geometryLodLevel = 0;
+    state.geometryLodRevision = state.geometryRevision;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file lod.h
+ * @brief Screen-space level of detail for dense meshes.
+ *
+ * Dense meshes get coarser versions built by vertex clustering. Vertices are
+ * snapped to a grid, each occupied cell becomes one vertex at the mean of its
+ * members, and edges are remapped with collapsed and duplicate edges dropped.
+ * Each level doubles the cell size of the previous attempt and is kept only if
+ * it at least halves the vertex count, so the levels shrink geometrically.
+ *
+ * Every frame the coarsest level whose cell projects to at most about a pixel
+ * (measured at the object's nearest point) is drawn. Moving to a coarser level
+ * requires the error to drop clearly below that threshold. An object whose
+ * projected size hovers around a switch point therefore stays at one level
+ * instead of alternating between two.
+ */
+#pragma once
+
+#include "../app_state/app_state.h" // MeshLod, GeometryView, Aabb, RenderState
+#include "batch_transform.h"        // ProjectionMatrix
+
+/**
+ * @brief Build the decimated levels of geometry into lod.
+ *
+ * Meshes below a few thousand vertices get no levels. The levels are
+ * independent copies; geometry may be released or remapped afterwards only
+ * together with lod's owner.
+ *
+ * @param geometry Full-detail mesh.
+ * @param bounds   Object-space bounds of geometry.
+ * @param lod      Receives the levels; previous contents are replaced.
+ */
+void buildMeshLod(const GeometryView &geometry, const Aabb &bounds, MeshLod &lod);
+
+/**
+ * @brief Choose the level to draw this frame.
+ *
+ * @param lod          Levels of the mesh.
+ * @param matrix       Object-to-screen matrix of this placement.
+ * @param bounds       Object-space bounds of the full-detail mesh.
+ * @param nearDepth    Near plane; objects reaching it always get level 0.
+ * @param currentLevel Level drawn last frame (for hysteresis).
+ * @return 0 for the full mesh, i for lod.levels[i - 1].
+ */
+int selectLodLevel(const MeshLod &lod, const ProjectionMatrix &matrix, const Aabb &bounds, float nearDepth, int currentLevel);
+
+/**
+ * @brief Rebuild state.geometryLod if the geometry changed (call after syncGeometry).
+ */
+void syncGeometryLod(RenderState &state);
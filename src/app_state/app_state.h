@@ -4,7 +4,9 @@
  */
 #pragma once
 #include <vector>
+#include <cstddef>
 #include <cstdint>
+#include "../framebuffer/depth_buffer.h" // DepthBuffer
 
 /**
  * @brief A 3D point with per-vertex RGB color in integer 0..255.
@@ -33,18 +35,401 @@ struct Edge3d
     int red, green, blue;             ///< Edge color
 };
 
+/**
+ * @brief Flat, render-ready copy of basePoints3d / edges3d.
+ *
+ * Positions are stored as structure-of-arrays for the batch transform, colors
+ * are packed ARGB8888, and only edges and triangles whose indices are in
+ * range are kept.
+ */
+struct PackedGeometry
+{
+    std::vector<float> x, y, z;                 ///< Object-space coordinates, one entry per vertex
+    std::vector<std::uint32_t> pointColors;     ///< Packed color per vertex
+    std::vector<std::uint32_t> edgeIndices;     ///< Two vertex indices per edge
+    std::vector<std::uint32_t> edgeColors;      ///< Packed color per edge
+    std::vector<std::uint32_t> triangleIndices; ///< Three vertex indices per solid face (may be empty)
+};
+
+/**
+ * @brief Read-only geometry drawn by the per-frame pipeline.
+ *
+ * Points either into RenderState::packedGeometry or into memory owned
+ * elsewhere, such as a memory-mapped mesh cache. Every edge and triangle
+ * index is below vertexCount. Triangles are the solid faces of the mesh; they
+ * are never drawn, only used as occluders in hidden-line mode.
+ */
+struct GeometryView
+{
+    const float *x = nullptr;                       ///< vertexCount object-space x coordinates
+    const float *y = nullptr;                       ///< vertexCount object-space y coordinates
+    const float *z = nullptr;                       ///< vertexCount object-space z coordinates
+    const std::uint32_t *pointColors = nullptr;     ///< Packed color per vertex, or null for uniformColor
+    const std::uint32_t *edgeIndices = nullptr;     ///< 2 * edgeCount vertex indices
+    const std::uint32_t *edgeColors = nullptr;      ///< Packed color per edge, or null for uniformColor
+    const std::uint32_t *triangleIndices = nullptr; ///< 3 * triangleCount vertex indices of the solid faces
+    std::uint32_t uniformColor = 0xFFFFFFFFu;       ///< Color of everything when the color arrays are null
+    std::size_t vertexCount = 0;                    ///< Number of vertices
+    std::size_t edgeCount = 0;                      ///< Number of edges
+    std::size_t triangleCount = 0;                  ///< Number of solid faces (0 for pure wireframes)
+};
+
+/**
+ * @brief Structure-of-arrays screen coordinates written by the batch transform.
+ */
+struct ScreenBuffer
+{
+    std::vector<float> x, y;  ///< Screen-space coordinates in pixels
+    std::vector<float> depth; ///< View depth (camera distance along the view axis)
+};
+
+/**
+ * @brief Points and edges sharing one color, prepared for batched submission.
+ *
+ * Ranges index into the arrays of the owning DrawBatches.
+ */
+struct DrawBatch
+{
+    int red, green, blue;         ///< Shared color of every point and edge in the batch
+    std::size_t pointBegin;       ///< First entry in DrawBatches::pointIndices
+    std::size_t pointCount;       ///< Number of points in the batch
+    std::size_t stripBegin;       ///< First entry in DrawBatches::stripLengths
+    std::size_t stripCount;       ///< Number of polyline strips in the batch
+    std::size_t stripVertexBegin; ///< First entry in DrawBatches::stripVertices
+    std::size_t stripVertexCount; ///< Total vertices over the batch's strips
+};
+
+/**
+ * @brief Geometry regrouped by color, with edges chained into polyline strips.
+ *
+ * Rebuilt only when the geometry changes; each frame then needs a few draw
+ * calls per color instead of one per point and edge.
+ */
+struct DrawBatches
+{
+    std::vector<DrawBatch> batches;  ///< One entry per distinct color
+    std::vector<int> pointIndices;   ///< Vertex indices drawn as points, grouped by batch
+    std::vector<int> stripVertices;  ///< Vertex indices of all strips, concatenated
+    std::vector<int> stripLengths;   ///< Vertex count of each strip (>= 2)
+    std::uint64_t revision = 0;      ///< geometryRevision the batches were built from
+};
+
+/**
+ * @brief Integer screen-space segment queued for the software rasterizer.
+ *
+ * Points are stored as zero-length segments.
+ */
+struct ScreenSegment
+{
+    int x0, y0, x1, y1;   ///< Endpoints in pixels (inclusive)
+    std::uint32_t color;  ///< Packed ARGB8888 color
+    float depth0, depth1; ///< Inverse view depth of the endpoints (hidden-line mode only)
+};
+
+/**
+ * @brief Segments of one frame sorted into screen tiles for parallel rasterization.
+ *
+ * Tile t owns entries [offsets[t], offsets[t + 1]) of segmentIndices, listed in
+ * submission order so every tile paints overlapping segments in the same order
+ * as a single-threaded pass.
+ */
+struct TileBins
+{
+    int tileSize = 64;                         ///< Tile edge length in pixels
+    int tilesX = 0, tilesY = 0;                ///< Tile grid dimensions
+    std::vector<std::uint32_t> offsets;        ///< tilesX * tilesY + 1 prefix offsets
+    std::vector<std::uint32_t> segmentIndices; ///< Segment indices grouped by tile
+};
+
+/**
+ * @brief Integer screen point; same layout as SDL_Point.
+ */
+struct ScreenPoint
+{
+    int x, y; ///< Pixel coordinates
+};
+
+/**
+ * @brief Working memory of frame_callback, reused from frame to frame.
+ *
+ * Capacity is reserved when the geometry changes and never shrinks, so once
+ * a mesh is on screen drawing it does not touch the heap.
+ */
+struct FrameScratch
+{
+    std::vector<ScreenSegment> segments;         ///< Points and edges of the current frame (software backend)
+    TileBins tileBins;                           ///< Tile binning of segments
+    std::vector<ScreenPoint> submitPoints;       ///< Screen points of the batch being submitted (SDL backend)
+    std::vector<std::uint32_t> visibleInstances; ///< Scene instances that passed frustum culling
+    DepthBuffer depthBuffer;                     ///< Solid faces of the frame (hidden-line mode)
+};
+
+/**
+ * @brief One recorded SDL_RenderDrawPoints / SDL_RenderDrawLines call.
+ */
+struct DrawCommand
+{
+    bool lines;                    ///< Connected lines instead of points
+    std::uint8_t red, green, blue; ///< Draw color
+    std::uint32_t first, count;    ///< Range of DrawCommandList::points
+};
+
+/**
+ * @brief SDL backend draw calls of one frame, prepared on a thread that does
+ *        not own the renderer and replayed later by the one that does.
+ */
+struct DrawCommandList
+{
+    std::vector<DrawCommand> commands;         ///< Calls in submission order
+    std::vector<ScreenPoint> points;           ///< Point / line vertices of all calls
+    std::uint8_t red = 0, green = 0, blue = 0; ///< Color of the next recorded call
+
+    void clear()
+    {
+        commands.clear();
+        points.clear();
+    }
+};
+
+/**
+ * @brief What the clipping stage removed or shortened in the last frame.
+ */
+struct ClipStats
+{
+    std::size_t pointsCulled = 0;         ///< Vertices behind the near plane or off screen
+    std::size_t edgesCulled = 0;          ///< Edges entirely behind the near plane or off screen
+    std::size_t edgesNearClipped = 0;     ///< Edges cut at the near plane
+    std::size_t edgesViewportClipped = 0; ///< Edges shortened to the guard band around the viewport
+};
+
+/**
+ * @brief Object-to-world affine transform of a scene instance.
+ *
+ * Row-major 3x4: columns 0..2 hold rotation and scale, column 3 the translation.
+ */
+struct InstanceTransform
+{
+    float m[3][4]; ///< World = m * (x, y, z, 1)
+};
+
+/**
+ * @brief Axis-aligned bounding box.
+ */
+struct Aabb
+{
+    float min[3]; ///< Smallest x, y, z
+    float max[3]; ///< Largest x, y, z
+};
+
+/**
+ * @brief One decimated version of a mesh.
+ */
+struct LodLevel
+{
+    PackedGeometry storage;  ///< Clustered vertices and remapped, deduplicated edges
+    GeometryView geometry;   ///< View of storage
+    DrawBatches drawBatches; ///< Color batches of geometry (SDL backend)
+    float cellSize;          ///< Clustering cell edge in object units (the level's geometric error)
+};
+
+/**
+ * @brief Coarser versions of a dense mesh, finest first.
+ *
+ * Level 0 is the mesh itself and is not stored; levels[i] is level i + 1.
+ */
+struct MeshLod
+{
+    std::vector<LodLevel> levels; ///< Increasingly coarse decimations
+};
+
+/**
+ * @brief Immutable geometry shared by every instance that references it.
+ */
+struct SceneMesh
+{
+    PackedGeometry storage;  ///< Owned copy; empty when geometry points at caller-owned memory
+    GeometryView geometry;   ///< Vertices and edges drawn for each instance
+    DrawBatches drawBatches; ///< Color batches of geometry (SDL backend)
+    Aabb bounds;             ///< Object-space bounds of geometry
+    MeshLod lod;             ///< Decimated levels of geometry (empty for small meshes)
+};
+
+/**
+ * @brief One placement of a scene mesh.
+ *
+ * Costs a few dozen bytes however large the mesh is: vertices are transformed
+ * straight from the shared mesh with a per-instance matrix each frame.
+ */
+struct SceneInstance
+{
+    std::uint32_t mesh;          ///< Index into Scene::meshes
+    InstanceTransform transform; ///< Object-to-world placement
+    std::uint32_t color;         ///< Packed color of the whole instance
+    bool useMeshColors;          ///< Draw with the mesh's own colors instead of color
+};
+
+/**
+ * @brief Node of the instance bounding-volume hierarchy.
+ *
+ * Nodes are stored depth first: an inner node's first child follows it, and
+ * the instances of any subtree are one contiguous range of instanceOrder.
+ */
+struct BvhNode
+{
+    Aabb bounds;          ///< World bounds of every instance in the subtree
+    std::uint32_t first;  ///< First entry of SceneBvh::instanceOrder in the subtree
+    std::uint32_t count;  ///< Number of instances in the subtree
+    std::uint32_t right;  ///< Second child; 0 for a leaf
+    std::uint32_t parent; ///< Parent node (the root is its own parent)
+};
+
+/**
+ * @brief Bounding-volume hierarchy over the world bounds of scene instances.
+ *
+ * Rebuilt when instances are added or removed, refit when they move. Refits
+ * keep the tree shape, so when moves have loosened the nodes too much
+ * (surfaceArea grown past twice builtSurfaceArea) the tree is rebuilt.
+ */
+struct SceneBvh
+{
+    std::vector<BvhNode> nodes;                ///< Depth-first node array, root first
+    std::vector<std::uint32_t> instanceOrder;  ///< Instance indices grouped by leaf
+    std::vector<std::uint32_t> leafOfInstance; ///< Leaf node holding each instance
+    std::vector<Aabb> instanceBounds;          ///< World bounds of each instance
+    double builtSurfaceArea = 0.0;             ///< Summed node surface area right after the build
+    double surfaceArea = 0.0;                  ///< Summed node surface area now
+    std::uint64_t builds = 0;                  ///< Full builds, including those refits fell back to
+    std::uint64_t refits = 0;                  ///< Refits of moved instances
+};
+
+/**
+ * @brief Drift of one instance under --instance-motion.
+ */
+struct InstanceMotion
+{
+    float position[3]; ///< Current center in world units
+    float velocity[3]; ///< World units per second
+    float scale;       ///< Uniform scale of the transform
+    float angle;       ///< Current yaw in degrees
+    float spin;        ///< Yaw change in degrees per second
+};
+
+/**
+ * @brief What the frustum culling stage did in the last frame.
+ */
+struct CullStats
+{
+    std::size_t nodesVisited = 0;    ///< BVH nodes tested against the frustum
+    std::size_t instancesCulled = 0; ///< Instances rejected before any vertex work
+    std::size_t instancesDrawn = 0;  ///< Instances transformed and drawn
+    std::size_t lodEdgesSkipped = 0; ///< Edges of drawn objects left out by level-of-detail selection
+    std::size_t edgesOccluded = 0;   ///< Edges dropped whole by the depth pyramid (hidden-line mode)
+    bool objectCulled = false;       ///< The current object was outside the frustum
+};
+
+/**
+ * @brief Many instances of a few shared meshes, drawn after the current object.
+ */
+struct Scene
+{
+    std::vector<SceneMesh> meshes;        ///< Unique geometry
+    std::vector<SceneInstance> instances; ///< Placements, drawn in order
+    SceneBvh bvh;                         ///< Culling hierarchy over instances
+    std::vector<std::uint32_t> moved;     ///< Instances moved since the last refit
+    std::vector<InstanceMotion> motion;   ///< Per-instance drift; empty = instances stand still
+    float motionExtent = 0.0f;            ///< Drifting centers stay within [-extent, extent] on each axis
+    std::vector<std::uint8_t> lodLevels;  ///< Level of detail each instance was drawn with last
+    std::uint64_t revision = 0;           ///< Bumped whenever meshes or instances change
+    std::uint64_t preparedRevision = 0;   ///< revision the draw batches and scratch reflect
+    std::size_t largestMeshVertices = 0;  ///< Projection scratch needed by one instance
+};
+
+struct Framebuffer;
+class ThreadPool;
+struct FrameProfileSample;
+class InputRecorder;
+class InputReplay;
+class BackgroundMeshLoader;
+class PointStream;
+
+/**
+ * @brief Rasterization path used to draw each frame.
+ */
+enum class RenderBackend
+{
+    SdlRenderer, ///< SDL_Renderer draw calls for every point and edge
+    Software     ///< CPU framebuffer uploaded as one texture per frame
+};
+
+/**
+ * @brief What the last presented frame was drawn from.
+ *
+ * Compared against the live state to find out whether a new frame would
+ * differ (see dirty_tracking.h).
+ */
+struct PresentedFrame
+{
+    bool valid = false;                                 ///< False until the first present
+    std::uint64_t geometryRevision = 0;                 ///< RenderState::geometryRevision
+    std::uint64_t sceneRevision = 0;                    ///< Scene::revision
+    float angleX = 0.0f, angleY = 0.0f, angleZ = 0.0f;  ///< Rotation angles
+    int screenWidth = 0, screenHeight = 0;              ///< Viewport size
+    float focalLength = 0.0f, viewerDistance = 0.0f;    ///< Camera
+    float nearPlane = 0.0f;                             ///< Clipping
+    RenderBackend backend = RenderBackend::SdlRenderer; ///< Rasterization path
+};
+
+/**
+ * @brief Frames drawn and skipped by the interactive loop.
+ */
+struct FramePacingStats
+{
+    std::uint64_t framesDrawn = 0;   ///< Frames rendered and presented
+    std::uint64_t framesSkipped = 0; ///< Display refreshes not drawn because nothing changed
+    double idleSeconds = 0.0;        ///< Time spent blocked waiting for events
+};
+
+/**
+ * @brief Frame profiler switches, set from the command line and keyboard.
+ */
+struct ProfilerControls
+{
+    bool enabled = false;                      ///< Record stage timings (--profile)
+    bool overlay = false;                      ///< Show the profiler panel; records while shown
+    bool dumpRequested = false;                ///< Write the history to csvPath after the next present
+    const char *csvPath = "frame_profile.csv"; ///< CSV export target (--profile=PATH)
+};
+
 /**
  * @brief Mutable render/application state used across modules.
  */
 struct RenderState
 {
     // Geometry definition (object space)
-    std::vector<Point3d> basePoints3d; ///< Base vertices before rotation
-    std::vector<Edge3d> edges3d;       ///< Edges defined by vertex indices
+    std::vector<Point3d> basePoints3d;      ///< Base vertices before rotation
+    std::vector<Edge3d> edges3d;            ///< Edges defined by vertex indices
+    std::vector<std::uint32_t> triangles3d; ///< Solid faces as vertex index triples (hidden-line occluders; may be empty)
+    std::uint64_t geometryRevision = 0;     ///< Bumped whenever the geometry is replaced
+    GeometryView externalGeometry;          ///< Drawn instead of basePoints3d/edges3d while x is non-null (memory owned by the caller)
+
+    // Derived buffers (rebuilt when geometryRevision changes)
+    PackedGeometry packedGeometry;          ///< Packed copy of basePoints3d/edges3d
+    GeometryView geometry;                  ///< Geometry drawn this frame (packedGeometry or externalGeometry)
+    Aabb geometryBounds{};                  ///< Object-space bounds of geometry
+    MeshLod geometryLod;                    ///< Decimated levels of geometry
+    std::uint64_t geometryLodRevision = 0;  ///< geometryRevision geometryLod was built from
+    int geometryLodLevel = 0;               ///< Level the current object was drawn with last
+    ScreenBuffer projectedPoints;           ///< Projected screen coordinates of the current frame
+    std::uint64_t geometryViewRevision = 0; ///< geometryRevision that geometry reflects
+    DrawBatches drawBatches;                ///< Color-grouped points and edge strips
+
+    // Instanced geometry drawn in addition to the object above (see scene.h)
+    Scene scene;
 
     // Camera / projection parameters
     float focalLength = 100000.0f; ///< Perspective scale factor
     float viewerDistance = 500.0f; ///< Distance from camera to origin
+    float nearPlane = 1.0f;        ///< View depth below which geometry is clipped away
 
     // Backbuffer dimensions (updated on window resize)
     int screenWidth = 800;
@@ -60,9 +445,49 @@ struct RenderState
     float angleY = 0.0f;
     float angleZ = 0.0f;
 
+    // Rendering backend (chosen at startup; B toggles it at runtime)
+    RenderBackend backend = RenderBackend::SdlRenderer;
+    Framebuffer *framebuffer = nullptr;       ///< Software backend target, owned by renderer_run
+    DrawCommandList *drawRecording = nullptr; ///< SDL backend calls are recorded here instead of issued while set
+    bool pipelined = false;                   ///< Prepare frames on a worker thread (see frame_pipeline.h)
+    bool hiddenLines = false;                 ///< Hide points and edges behind solid faces (H toggles)
+    bool specializedPipeline = true;          ///< Draw with loops specialized per item; false = per-element checks (--generic-pipeline)
+
+    // Software rasterizer threading
+    int rasterThreads = 1;            ///< Pool workers (rasterizer, large transforms); 1 = single-threaded, 0 = all cores
+    ThreadPool *threadPool = nullptr; ///< Persistent worker pool, owned by renderer_run
+
+    // Per-frame working memory (see FrameScratch)
+    FrameScratch frameScratch;
+    ClipStats clipStats; ///< Counters of the last frame's clipping stage
+    CullStats cullStats; ///< Counters of the last frame's frustum culling
+
     // Lifecycle
     bool running = true; ///< Main loop flag
 
+    // Idle detection: the interactive loop only draws when a frame would change
+    PresentedFrame presentedFrame; ///< Inputs of the frame on screen
+    bool redrawRequested = false;  ///< Draw the next frame even if nothing changed (e.g. window exposed)
+    FramePacingStats pacing;       ///< Drawn / skipped frame counters
+
+    // Frame profiler (see frame_profiler.h); the loop owns the history
+    ProfilerControls profiler;
+    FrameProfileSample *profileSample = nullptr; ///< frame_callback's stage timers add here while set
+
     // Timing (SDL high-resolution counters)
     std::uint64_t lastPerformanceCounter = 0; ///< For delta time calculation
+    float fixedDeltaSeconds = 0.0f;           ///< If > 0, advance by this per frame instead of wall time
+    float lastDeltaSeconds = 0.0f;            ///< Step the last frame advanced the animation by
+    bool useReplayDeltas = false;             ///< Advance by replayDeltaSeconds (--replay-deltas)
+    float replayDeltaSeconds = 0.0f;          ///< Recorded step of the frame being replayed
+
+    // Input / timing traces (see input_trace.h), owned by main
+    InputRecorder *inputRecorder = nullptr; ///< --record: events and deltas are logged here
+    InputReplay *inputReplay = nullptr;     ///< --replay: events and deltas come from here instead of live input
+
+    // Asynchronous mesh replacement (see background_loader.h), owned by main
+    BackgroundMeshLoader *meshLoader = nullptr; ///< Object keys and --watch build meshes here; null = replace synchronously
+
+    // Out-of-core point cloud (see point_stream.h), owned by main
+    PointStream *pointStream = nullptr; ///< --stream: drawn chunk by chunk after the object and the scene
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+// dirty_tracking.cpp
+// Snapshot comparison between the live RenderState and the frame on screen.
+
+#include "dirty_tracking.h"
+#include "../mesh_io/background_loader.h"
+#include "../mesh_io/point_stream.h"
+
+unsigned frameDirtyFlags(const RenderState &state)
+{
+    const PresentedFrame &frame = state.presentedFrame;
+    if (!frame.valid)
+        return DIRTY_FIRST_FRAME;
+
+    unsigned flags = 0;
+    if (frame.geometryRevision != state.geometryRevision || frame.sceneRevision != state.scene.revision || !state.scene.moved.empty())
+        flags |= DIRTY_GEOMETRY;
+    if (state.meshLoader && state.meshLoader->hasReady())
+        flags |= DIRTY_GEOMETRY; // Installed by the next frame
+    if (frame.angleX != state.angleX || frame.angleY != state.angleY || frame.angleZ != state.angleZ)
+        flags |= DIRTY_ANGLES;
+    if (frame.screenWidth != state.screenWidth || frame.screenHeight != state.screenHeight)
+        flags |= DIRTY_VIEWPORT;
+    if (frame.focalLength != state.focalLength || frame.viewerDistance != state.viewerDistance || frame.nearPlane != state.nearPlane)
+        flags |= DIRTY_CAMERA;
+    if (frame.backend != state.backend)
+        flags |= DIRTY_BACKEND;
+    if (state.rotateSpeedX != 0.0f || state.rotateSpeedY != 0.0f || state.rotateSpeedZ != 0.0f || !state.scene.motion.empty())
+        flags |= DIRTY_ANIMATING;
+    if (state.redrawRequested)
+        flags |= DIRTY_REQUESTED;
+    if (state.pointStream && !state.pointStream->complete())
+        flags |= DIRTY_STREAMING;
+    return flags;
+}
+
+void markFramePresented(RenderState &state)
+{
+    PresentedFrame &frame = state.presentedFrame;
+    frame.valid = true;
+    frame.geometryRevision = state.geometryRevision;
+    frame.sceneRevision = state.scene.revision;
+    frame.angleX = state.angleX;
+    frame.angleY = state.angleY;
+    frame.angleZ = state.angleZ;
+    frame.screenWidth = state.screenWidth;
+    frame.screenHeight = state.screenHeight;
+    frame.focalLength = state.focalLength;
+    frame.viewerDistance = state.viewerDistance;
+    frame.nearPlane = state.nearPlane;
+    frame.backend = state.backend;
+    state.redrawRequested = false;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file dirty_tracking.h
+ * @brief Decides whether RenderState changed since the last presented frame.
+ *
+ * Instead of every mutation site raising a flag, the inputs a frame depends on
+ * are snapshotted into RenderState::presentedFrame after each present and
+ * compared with the live state before the next one. Geometry and the scene
+ * are tracked through their revision counters. Nonzero rotation speeds and
+ * drifting instances mean the next frame always differs.
+ */
+#pragma once
+
+#include "app_state.h" // RenderState
+
+constexpr unsigned DIRTY_FIRST_FRAME = 1u << 0; ///< Nothing presented yet
+constexpr unsigned DIRTY_GEOMETRY = 1u << 1;    ///< Geometry, scene, or instance placement changed
+constexpr unsigned DIRTY_ANGLES = 1u << 2;      ///< Rotation angles changed
+constexpr unsigned DIRTY_VIEWPORT = 1u << 3;    ///< Screen size changed
+constexpr unsigned DIRTY_CAMERA = 1u << 4;      ///< Focal length, viewer distance or near plane changed
+constexpr unsigned DIRTY_BACKEND = 1u << 5;     ///< Rasterization path switched
+constexpr unsigned DIRTY_ANIMATING = 1u << 6;   ///< A rotation speed is nonzero or instances drift
+constexpr unsigned DIRTY_REQUESTED = 1u << 7;   ///< RenderState::redrawRequested is set
+constexpr unsigned DIRTY_STREAMING = 1u << 8;   ///< The streamed point cloud is still refining
+
+/**
+ * @brief Reasons the next frame must be drawn; 0 when it would repeat the
+ *        frame on screen.
+ */
+unsigned frameDirtyFlags(const RenderState &state);
+
+/**
+ * @brief Record the state a just-presented frame was drawn from and clear
+ *        redrawRequested.
+ */
+void markFramePresented(RenderState &state);
@@ -0,0 +1,485 @@
+// cli.cpp
+// Minimal "--name=value" argument parsing for the demo executable.
+#include "cli.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// If arg is "--name=value" return a pointer to value, otherwise null
+static const char *optionValue(const char *arg, const char *name)
+{
+    const size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) != 0 || arg[length] != '=')
+        return nullptr;
+    return arg + length + 1;
+}
+
+// Parse a whole-string positive integer
+static bool parsePositiveInt(const char *text, int &out)
+{
+    char *end = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value <= 0 || value > 1000000000L)
+        return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+// Parse a whole-string positive float
+static bool parsePositiveFloat(const char *text, float &out)
+{
+    char *end = nullptr;
+    const float value = std::strtof(text, &end);
+    if (end == text || *end != '\0' || !(value > 0.0f))
+        return false;
+    out = value;
+    return true;
+}
+
+// Parse "WxH" with positive dimensions
+static bool parseSize(const char *text, int &width, int &height)
+{
+    char *end = nullptr;
+    const long w = std::strtol(text, &end, 10);
+    if (end == text || (*end != 'x' && *end != 'X'))
+        return false;
+    const char *heightText = end + 1;
+    const long h = std::strtol(heightText, &end, 10);
+    if (end == heightText || *end != '\0' || w <= 0 || h <= 0 || w > 32768 || h > 32768)
+        return false;
+    width = static_cast<int>(w);
+    height = static_cast<int>(h);
+    return true;
+}
+
+// Parse "KIND" or "KIND:RES"; resolution 0 means the kind's default
+static bool parseGenerator(const char *text, GeneratorKind &kind, int &resolution)
+{
+    const char *colon = std::strchr(text, ':');
+    const std::string name = colon ? std::string(text, colon) : std::string(text);
+    if (!findGenerator(name.c_str(), kind))
+        return false;
+    resolution = 0;
+    if (!colon)
+        return true;
+    std::size_t vertices = 0, edges = 0, triangles = 0;
+    return parsePositiveInt(colon + 1, resolution) && generatorCounts(kind, resolution, vertices, edges, triangles);
+}
+
+// Parse "X,Y,Z" finite floats
+static bool parseVector3(const char *text, float out[3])
+{
+    const char *cursor = text;
+    for (int i = 0; i < 3; ++i)
+    {
+        char *end = nullptr;
+        const float value = std::strtof(cursor, &end);
+        if (end == cursor || !(value == value) || value > 1e6f || value < -1e6f)
+            return false;
+        if (*end != (i < 2 ? ',' : '\0'))
+            return false;
+        out[i] = value;
+        cursor = end + 1;
+    }
+    return true;
+}
+
+bool parseCommandLine(int argc, char **argv, LaunchOptions &options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        const char *value = nullptr;
+
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0)
+        {
+            options.showHelp = true;
+        }
+        else if ((value = optionValue(arg, "--backend")))
+        {
+            if (std::strcmp(value, "sdl") == 0)
+                options.backend = RenderBackend::SdlRenderer;
+            else if (std::strcmp(value, "software") == 0)
+                options.backend = RenderBackend::Software;
+            else
+            {
+                std::fprintf(stderr, "Unknown backend '%s' (expected sdl or software)\n", value);
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--headless") == 0)
+        {
+            options.headless = true;
+        }
+        else if (std::strcmp(arg, "--pipelined") == 0)
+        {
+            options.pipelined = true;
+        }
+        else if (std::strcmp(arg, "--hidden-lines") == 0)
+        {
+            options.hiddenLines = true;
+        }
+        else if (std::strcmp(arg, "--instance-motion") == 0)
+        {
+            options.instanceMotion = true;
+        }
+        else if (std::strcmp(arg, "--generic-pipeline") == 0)
+        {
+            options.genericPipeline = true;
+        }
+        else if (std::strcmp(arg, "--profile") == 0)
+        {
+            options.profile = true;
+        }
+        else if ((value = optionValue(arg, "--profile")))
+        {
+            if (*value == '\0')
+            {
+                std::fprintf(stderr, "Missing CSV path for --profile=\n");
+                return false;
+            }
+            options.profile = true;
+            options.profilePath = value;
+        }
+        else if (std::strcmp(arg, "--checksum") == 0)
+        {
+            options.printChecksum = true;
+        }
+        else if ((value = optionValue(arg, "--frames")))
+        {
+            if (!parsePositiveInt(value, options.frameCount))
+            {
+                std::fprintf(stderr, "Invalid frame count '%s'\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--threads")))
+        {
+            if (std::strcmp(value, "0") == 0)
+                options.rasterThreads = 0;
+            else if (!parsePositiveInt(value, options.rasterThreads) || options.rasterThreads > 1024)
+            {
+                std::fprintf(stderr, "Invalid thread count '%s'\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--timestep")))
+        {
+            if (!parsePositiveFloat(value, options.timestepSeconds))
+            {
+                std::fprintf(stderr, "Invalid timestep '%s'\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--export")))
+        {
+            if (*value == '\0')
+            {
+                std::fprintf(stderr, "Missing output path for --export (use - for stdout)\n");
+                return false;
+            }
+            options.exportPath = value;
+            options.headless = true;
+        }
+        else if ((value = optionValue(arg, "--export-format")))
+        {
+            if (!findExportFormat(value, options.exportFormat))
+            {
+                std::fprintf(stderr, "Unknown export format '%s' (expected y4m, ppm or raw)\n", value);
+                return false;
+            }
+            options.exportFormatSet = true;
+        }
+        else if ((value = optionValue(arg, "--export-queue")))
+        {
+            if (!parsePositiveInt(value, options.exportQueueFrames) || options.exportQueueFrames < 2 || options.exportQueueFrames > 256)
+            {
+                std::fprintf(stderr, "Invalid export queue length '%s' (expected 2..256)\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--shm")))
+        {
+            if (value[0] != '/' || value[1] == '\0' || std::strchr(value + 1, '/'))
+            {
+                std::fprintf(stderr, "Invalid shared-memory name '%s' (expected /name)\n", value);
+                return false;
+            }
+            options.shmName = value;
+            options.headless = true;
+        }
+        else if ((value = optionValue(arg, "--shm-slots")))
+        {
+            if (!parsePositiveInt(value, options.shmSlots) || options.shmSlots < 3 || options.shmSlots > 16)
+            {
+                std::fprintf(stderr, "Invalid ring length '%s' (expected 3..16)\n", value);
+                return false;
+            }
+        }
+        else if (std::strcmp(arg, "--shm-lossless") == 0)
+        {
+            options.shmLossless = true;
+        }
+        else if ((value = optionValue(arg, "--record")))
+        {
+            if (*value == '\0')
+            {
+                std::fprintf(stderr, "Missing trace path for --record\n");
+                return false;
+            }
+            options.recordPath = value;
+        }
+        else if ((value = optionValue(arg, "--replay")))
+        {
+            if (*value == '\0')
+            {
+                std::fprintf(stderr, "Missing trace path for --replay\n");
+                return false;
+            }
+            options.replayPath = value;
+        }
+        else if (std::strcmp(arg, "--replay-deltas") == 0)
+        {
+            options.replayDeltas = true;
+        }
+        else if ((value = optionValue(arg, "--load")))
+        {
+            if (*value == '\0')
+            {
+                std::fprintf(stderr, "Missing mesh path for --load\n");
+                return false;
+            }
+            options.meshPath = value;
+        }
+        else if (std::strcmp(arg, "--watch") == 0)
+        {
+            options.watchMesh = true;
+        }
+        else if (std::strcmp(arg, "--cache") == 0)
+        {
+            options.useMeshCache = true;
+        }
+        else if ((value = optionValue(arg, "--cache")))
+        {
+            if (*value == '\0')
+            {
+                std::fprintf(stderr, "Missing cache path for --cache=\n");
+                return false;
+            }
+            options.useMeshCache = true;
+            options.meshCachePath = value;
+        }
+        else if ((value = optionValue(arg, "--generate")))
+        {
+            if (!parseGenerator(value, options.generator, options.generatorResolution))
+            {
+                std::fprintf(stderr, "Invalid generator '%s' (expected KIND or KIND:RES)\n", value);
+                return false;
+            }
+            options.generate = true;
+        }
+        else if ((value = optionValue(arg, "--rotate")))
+        {
+            if (!parseVector3(value, options.rotateSpeed))
+            {
+                std::fprintf(stderr, "Invalid rotation speeds '%s' (expected X,Y,Z degrees per second)\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--angles")))
+        {
+            if (!parseVector3(value, options.startAngles))
+            {
+                std::fprintf(stderr, "Invalid angles '%s' (expected X,Y,Z degrees)\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--instances")))
+        {
+            if (!parsePositiveInt(value, options.instanceCount))
+            {
+                std::fprintf(stderr, "Invalid instance count '%s'\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--stream")))
+        {
+            if (*value == '\0')
+            {
+                std::fprintf(stderr, "Missing point stream path for --stream\n");
+                return false;
+            }
+            options.streamPath = value;
+        }
+        else if ((value = optionValue(arg, "--write-stream")))
+        {
+            if (*value == '\0')
+            {
+                std::fprintf(stderr, "Missing output path for --write-stream\n");
+                return false;
+            }
+            options.writeStreamPath = value;
+        }
+        else if ((value = optionValue(arg, "--stream-budget")))
+        {
+            if (!parsePositiveInt(value, options.streamBudget))
+            {
+                std::fprintf(stderr, "Invalid point budget '%s'\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--stream-resident")))
+        {
+            if (!parsePositiveInt(value, options.streamResidentMb) || options.streamResidentMb > 1048576)
+            {
+                std::fprintf(stderr, "Invalid resident size '%s' (expected megabytes)\n", value);
+                return false;
+            }
+        }
+        else if ((value = optionValue(arg, "--size")))
+        {
+            if (!parseSize(value, options.width, options.height))
+            {
+                std::fprintf(stderr, "Invalid size '%s' (expected WxH)\n", value);
+                return false;
+            }
+        }
+        else
+        {
+            std::fprintf(stderr, "Unknown argument '%s'\n", arg);
+            return false;
+        }
+    }
+    if (options.generate && options.meshPath)
+    {
+        std::fprintf(stderr, "--generate and --load are mutually exclusive\n");
+        return false;
+    }
+    if (options.useMeshCache && !options.meshPath)
+    {
+        std::fprintf(stderr, "--cache needs --load=PATH\n");
+        return false;
+    }
+    if (options.watchMesh && (!options.meshPath || options.headless))
+    {
+        std::fprintf(stderr, "--watch needs --load=PATH and a window (no --headless or --export)\n");
+        return false;
+    }
+    if (options.watchMesh && (options.recordPath || options.replayPath))
+    {
+        std::fprintf(stderr, "--watch cannot be combined with --record or --replay\n");
+        return false;
+    }
+    if (options.recordPath && options.replayPath)
+    {
+        std::fprintf(stderr, "--record and --replay are mutually exclusive\n");
+        return false;
+    }
+    if ((options.recordPath || options.replayPath) && options.pipelined)
+    {
+        std::fprintf(stderr, "--record and --replay need the sequential loop (no --pipelined)\n");
+        return false;
+    }
+    if (options.replayDeltas && !options.replayPath)
+    {
+        std::fprintf(stderr, "--replay-deltas needs --replay=PATH\n");
+        return false;
+    }
+    if (options.instanceMotion && options.instanceCount == 0)
+    {
+        std::fprintf(stderr, "--instance-motion needs --instances=N\n");
+        return false;
+    }
+    if (options.streamPath && (options.meshPath || options.generate || options.instanceCount > 0 || options.writeStreamPath))
+    {
+        std::fprintf(stderr, "--stream cannot be combined with --load, --generate, --instances or --write-stream\n");
+        return false;
+    }
+    if (options.writeStreamPath && !options.meshPath && !options.generate)
+    {
+        std::fprintf(stderr, "--write-stream needs --load=PATH or --generate=KIND\n");
+        return false;
+    }
+    if ((options.shmLossless || options.shmSlots != 3) && !options.shmName)
+    {
+        std::fprintf(stderr, "--shm-slots and --shm-lossless need --shm=NAME\n");
+        return false;
+    }
+    if (options.exportPath && !options.exportFormatSet)
+        options.exportFormat = exportFormatForPath(options.exportPath);
+    return true;
+}
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --backend=sdl|software  Rasterize with SDL_Renderer draw calls (default) or\n"
+                "                          into a CPU framebuffer uploaded once per frame\n"
+                "  --threads=N             Worker threads; screen tiles (software backend) and\n"
+                "                          large meshes' vertices are processed in parallel\n"
+                "                          when N > 1, 0 uses all cores (default 1)\n"
+                "  --size=WxH              Window / offscreen target size (default 1000x1000)\n"
+                "  --headless              Render offscreen (no window, no VSync) and print\n"
+                "                          fps and p50/p95/p99 frame times\n"
+                "  --frames=N              Frames to render with --headless (default 1000)\n"
+                "  --timestep=S            Fixed seconds per frame with --headless (default 1/60)\n"
+                "  --checksum              Print a hash of the final --headless frame\n"
+                "  --load=PATH             Show an OBJ or PLY mesh (edges deduplicated) instead\n"
+                "                          of the cube\n"
+                "  --cache[=PATH]          Map the --load mesh from a binary cache, rebuilding\n"
+                "                          it when stale (default PATH: mesh path + .wfc)\n"
+                "  --watch                 Reload the --load mesh on a background thread each\n"
+                "                          time the file is saved; the old mesh stays on screen\n"
+                "                          until the new one is ready\n"
+                "  --generate=KIND[:RES]   Show a generated stress scene instead of the cube:\n"
+                "                          uvsphere, icosphere, torus, grid, points or lattice;\n"
+                "                          RES scales it (default about 100k edges)\n"
+                "  --rotate=X,Y,Z          Rotation speeds in degrees per second (default\n"
+                "                          50,-25,10); 0,0,0 shows a still image that is only\n"
+                "                          redrawn when something changes\n"
+                "  --angles=X,Y,Z          Starting angles in degrees (default 20,30,40)\n"
+                "  --instances=N           Draw a grid of N copies of the cube / --load mesh,\n"
+                "                          sharing one copy of its geometry\n"
+                "  --instance-motion       Let the --instances copies drift and spin; the\n"
+                "                          culling BVH is refit every frame\n"
+                "  --pipelined             Prepare frame N+1 on a worker thread while frame N\n"
+                "                          is presented; input latency and fps are reported\n"
+                "                          for either mode\n"
+                "  --profile[=PATH]        Time each frame stage; --headless prints the means\n"
+                "                          and writes every frame to PATH as CSV, windowed runs\n"
+                "                          write the history on D (default frame_profile.csv)\n"
+                "  --hidden-lines          Hide points and edges behind the mesh's faces, using\n"
+                "                          a depth buffer and a min/max depth pyramid (H toggles)\n"
+                "  --generic-pipeline      Transform and draw with per-element checks instead of\n"
+                "                          the loop variants specialized per object (benchmarking)\n"
+                "  --stream=PATH           Draw a point stream file (see --write-stream) out of\n"
+                "                          core: chunks are mapped, prefetched and released so\n"
+                "                          only --stream-resident MB stay in memory\n"
+                "  --write-stream=PATH     Write the vertices of the --load / --generate object\n"
+                "                          to a point stream file and exit (points:N is written\n"
+                "                          without holding the cloud in memory)\n"
+                "  --stream-budget=N       Points drawn per frame while the view moves; a still\n"
+                "                          view refines to every point (default: all)\n"
+                "  --stream-resident=MB    Stream file kept in memory at most (default 256)\n"
+                "  --export=PATH           Render the --headless frame sequence (--frames,\n"
+                "                          --timestep) and stream it to PATH, - for stdout;\n"
+                "                          implies --headless, reports go to stderr with -\n"
+                "  --export-format=FMT     y4m (4:2:0), ppm (P6 sequence) or raw (RGBA);\n"
+                "                          default from PATH's extension, else y4m\n"
+                "  --export-queue=N        Frames buffered for the writer thread (default 4)\n"
+                "  --shm=NAME              Publish every --headless frame to the POSIX shared-\n"
+                "                          memory frame ring NAME (/name) for another process;\n"
+                "                          the software backend renders straight into it;\n"
+                "                          implies --headless (consumer: make shm-consumer)\n"
+                "  --shm-slots=N           Frame buffers in the ring, 3..16 (default 3)\n"
+                "  --shm-lossless          Wait for a consumer to attach (up to 10 s) and to take\n"
+                "                          each frame instead of letting it skip to the newest\n"
+                "  --record=PATH           Log every input and frame time step to a binary trace\n"
+                "  --replay=PATH           Drive the run from a --record trace (same command line\n"
+                "                          otherwise); --headless renders exactly its frames\n"
+                "  --replay-deltas         With --replay, animate by the recorded time steps for\n"
+                "                          frame-for-frame identical images\n"
+                "  --help, -h              Show this message\n",
+                program ? program : "main");
+}
@@ -0,0 +1,129 @@
+/**
+ * @file cli.h
+ * @brief Command-line options for the demo executable.
+ */
+#pragma once
+#include "../app_state/app_state.h"         // RenderBackend
+#include "../3d_objects/objects_3d.h"       // GeneratorKind
+#include "../frame_export/frame_exporter.h" // ExportFormat
+
+/**
+ * @brief Settings chosen on the command line before the render loop starts.
+ */
+struct LaunchOptions
+{
+    RenderBackend backend = RenderBackend::SdlRenderer; ///< --backend=sdl|software
+    int rasterThreads = 1;                              ///< --threads=N (0 = all cores)
+    bool showHelp = false;                              ///< --help / -h
+    const char *meshPath = nullptr;                     ///< --load=PATH, OBJ / PLY to show instead of the cube
+    bool useMeshCache = false;                          ///< --cache[=PATH], map a binary cache of the --load mesh
+    const char *meshCachePath = nullptr;                ///< Cache file; null = the mesh path + ".wfc"
+    bool watchMesh = false;                             ///< --watch, reload the --load mesh in the background when it changes
+    bool generate = false;                              ///< --generate=KIND[:RES], show a stress scene instead of the cube
+    GeneratorKind generator = GeneratorKind::UvSphere;  ///< Stress scene kind
+    int generatorResolution = 0;                        ///< Stress scene resolution; 0 = the kind's default
+    float rotateSpeed[3] = {50.0f, -25.0f, 10.0f};      ///< --rotate=X,Y,Z in degrees per second
+    float startAngles[3] = {20.0f, 30.0f, 40.0f};       ///< --angles=X,Y,Z in degrees
+    int instanceCount = 0;                              ///< --instances=N, grid of shared-mesh copies (0 = single object)
+    bool instanceMotion = false;                        ///< --instance-motion, the instances drift and spin
+    bool pipelined = false;                             ///< --pipelined, prepare frames on a worker thread
+    bool hiddenLines = false;                           ///< --hidden-lines, hide edges behind solid faces
+    bool genericPipeline = false;                       ///< --generic-pipeline, draw without the specialized loop variants
+    bool profile = false;                               ///< --profile[=PATH], record per-stage frame times
+    const char *profilePath = nullptr;                  ///< CSV written by --headless and the D key; null = default
+
+    // Out-of-core point clouds
+    const char *streamPath = nullptr;      ///< --stream=PATH, draw a point stream file instead of the cube
+    const char *writeStreamPath = nullptr; ///< --write-stream=PATH, convert the --load / --generate object and exit
+    int streamBudget = 0;                  ///< --stream-budget=N points per frame while the view moves (0 = all)
+    int streamResidentMb = 256;            ///< --stream-resident=MB of the stream file kept in memory
+
+    // Headless benchmark (--headless)
+    bool headless = false;                ///< Render offscreen without a window or VSync
+    int frameCount = 1000;                ///< --frames=N
+    float timestepSeconds = 1.0f / 60.0f; ///< --timestep=S, fixed animation step per frame
+    bool printChecksum = false;           ///< --checksum
+    int width = 1000;                     ///< --size=WxH
+    int height = 1000;                    ///< --size=WxH
+
+    // Frame-sequence export (implies --headless)
+    const char *exportPath = nullptr;              ///< --export=PATH, "-" = stdout
+    bool exportFormatSet = false;                  ///< --export-format was given; otherwise the path's extension decides
+    ExportFormat exportFormat = ExportFormat::Y4m; ///< --export-format=y4m|ppm|raw
+    int exportQueueFrames = 4;                     ///< --export-queue=N frame buffers
+
+    // Shared-memory frame output (implies --headless)
+    const char *shmName = nullptr; ///< --shm=NAME, POSIX shared-memory ring the frames are published to
+    int shmSlots = 3;              ///< --shm-slots=N frame buffers in the ring
+    bool shmLossless = false;      ///< --shm-lossless, wait for a consumer and for it to take every frame
+
+    // Input / timing traces
+    const char *recordPath = nullptr; ///< --record=PATH, log events and frame deltas
+    const char *replayPath = nullptr; ///< --replay=PATH, drive the run from a recorded trace
+    bool replayDeltas = false;        ///< --replay-deltas, animate by the recorded deltas
+};
+
+/**
+ * @brief Parse argv into options.
+ *
+ * Recognized arguments:
+ *  --backend=sdl|software  Rasterization path (default: sdl)
+ *  --threads=N             Rasterizer and vertex transform threads; 0 = all cores (default: 1)
+ *  --size=WxH              Window / offscreen target size (default: 1000x1000)
+ *  --headless              Offscreen fixed-frame benchmark, no window or VSync
+ *  --frames=N              Frames to render in headless mode (default: 1000)
+ *  --timestep=S            Fixed seconds per frame in headless mode (default: 1/60)
+ *  --checksum              Print a hash of the final headless frame
+ *  --load=PATH             Show an OBJ or PLY mesh instead of the cube
+ *  --cache[=PATH]          Draw the --load mesh from a memory-mapped binary
+ *                          cache, rebuilding it when stale (default: PATH.wfc)
+ *  --watch                 Reload the --load mesh in the background whenever
+ *                          the file changes (windowed runs)
+ *  --generate=KIND[:RES]   Show a parametric stress scene instead of the cube
+ *                          (uvsphere, icosphere, torus, grid, points, lattice)
+ *  --rotate=X,Y,Z          Rotation speeds in degrees per second (default: 50,-25,10)
+ *  --angles=X,Y,Z          Starting angles in degrees (default: 20,30,40)
+ *  --instances=N           Show N instances of the object in a grid
+ *  --instance-motion       Move the instances every frame (BVH refit)
+ *  --pipelined             Transform and draw on a worker thread while the
+ *                          main thread presents the previous frame
+ *  --profile[=PATH]        Record per-stage frame times; PATH receives the
+ *                          CSV history (headless: at exit, windowed: on D)
+ *  --hidden-lines          Hide points and edges behind the solid faces
+ *  --generic-pipeline      Transform and draw with per-element checks instead of
+ *                          the specialized variants (for benchmarking)
+ *  --stream=PATH           Draw a point stream file out of core instead of the cube
+ *  --write-stream=PATH     Write the --load / --generate object's vertices as a
+ *                          point stream file and exit
+ *  --stream-budget=N       Points drawn per frame while the view moves; a still
+ *                          view refines to every point (default: all)
+ *  --stream-resident=MB    Stream file kept in memory at most (default: 256)
+ *  --export=PATH           Render the --headless sequence and stream every
+ *                          frame to PATH ("-" = stdout); implies --headless
+ *  --export-format=FMT     y4m, ppm or raw RGBA (default: from the extension,
+ *                          .ppm / .rgba / .raw, else y4m)
+ *  --export-queue=N        Frame buffers queued for the writer (default: 4)
+ *  --shm=NAME              Publish every --headless frame to the shared-memory
+ *                          frame ring NAME ("/name"); implies --headless
+ *  --shm-slots=N           Frame buffers in the ring, 3..16 (default: 3)
+ *  --shm-lossless          Wait for a consumer to attach (up to 10 s) and to
+ *                          take each frame instead of letting it skip to the newest
+ *  --record=PATH           Write the events and frame deltas of the run to PATH
+ *  --replay=PATH           Replay a --record trace instead of live input
+ *  --replay-deltas         With --replay, animate by the recorded deltas
+ *                          instead of wall time / --timestep
+ *  --help, -h              Print usage and exit
+ *
+ * @param argc    Argument count from main.
+ * @param argv    Argument vector from main.
+ * @param options Receives the parsed settings; untouched fields keep defaults.
+ * @return true on success, false if an argument was unknown or invalid
+ *         (a diagnostic has been printed to stderr).
+ */
+bool parseCommandLine(int argc, char **argv, LaunchOptions &options);
+
+/**
+ * @brief Print the argument summary to stdout.
+ * @param program Executable name shown in the usage line.
+ */
+void printUsage(const char *program);
@@ -0,0 +1,27 @@
+/**
+ * @file allocation_counter.h
+ * @brief Debug-build counter of C++ heap allocations.
+ *
+ * In debug builds (NDEBUG not defined, no AddressSanitizer) the global
+ * operator new is replaced by a counting wrapper around malloc, so the
+ * renderer can check that steady-state frames allocate nothing. Release and
+ * ASan builds keep the standard operators and the counter always reads 0.
+ * Allocations made by C libraries (SDL's malloc) are not included.
+ */
+#pragma once
+
+#include <cstdint>
+
+#if !defined(NDEBUG) && !defined(__SANITIZE_ADDRESS__)
+#define RENDERER_COUNT_ALLOCATIONS 1
+#else
+#define RENDERER_COUNT_ALLOCATIONS 0
+#endif
+
+/** True when heapAllocationCount() is live in this build. */
+constexpr bool HEAP_ALLOCATION_COUNTING = RENDERER_COUNT_ALLOCATIONS != 0;
+
+/**
+ * @brief Number of operator new calls (all threads) since program start.
+ */
+std::uint64_t heapAllocationCount();
@@ -0,0 +1,101 @@
+// frame_profiler.cpp
+// Frame sample ring buffer, averaging and CSV export.
+
+#include "frame_profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+const char *profileStageName(ProfileStage stage)
+{
+    switch (stage)
+    {
+    case ProfileStage::Events:
+        return "events";
+    case ProfileStage::Animate:
+        return "animate";
+    case ProfileStage::Cull:
+        return "cull";
+    case ProfileStage::Transform:
+        return "transform";
+    case ProfileStage::Draw:
+        return "draw";
+    case ProfileStage::Rasterize:
+        return "rasterize";
+    case ProfileStage::Present:
+        return "present";
+    default:
+        return "unknown";
+    }
+}
+
+FrameProfiler::FrameProfiler(std::size_t capacity)
+    : history(std::max<std::size_t>(capacity, 1))
+{
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    msPerTick = frequency != 0 ? 1000.0 / static_cast<double>(frequency) : 0.0;
+}
+
+void FrameProfiler::commit(const FrameProfileSample &sample)
+{
+    FrameProfileSample &slot = history[next];
+    slot = sample;
+    slot.frameIndex = committed++;
+    next = (next + 1) % history.size();
+    count = std::min(count + 1, history.size());
+}
+
+const FrameProfileSample &FrameProfiler::recent(std::size_t age) const
+{
+    return history[(next + history.size() - 1 - age) % history.size()];
+}
+
+double FrameProfiler::average(std::size_t frames, double *stageMs) const
+{
+    frames = std::min(frames, count);
+    std::uint64_t frameTicks = 0;
+    std::uint64_t stageTicks[PROFILE_STAGE_COUNT] = {};
+    for (std::size_t age = 0; age < frames; ++age)
+    {
+        const FrameProfileSample &sample = recent(age);
+        frameTicks += sample.frameTicks;
+        for (std::size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+            stageTicks[stage] += sample.stageTicks[stage];
+    }
+    const double divisor = frames > 0 ? static_cast<double>(frames) : 1.0;
+    for (std::size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+        stageMs[stage] = toMs(stageTicks[stage]) / divisor;
+    return toMs(frameTicks) / divisor;
+}
+
+bool FrameProfiler::writeCsv(const char *path, std::string &error) const
+{
+    std::FILE *file = std::fopen(path, "w");
+    if (!file)
+    {
+        error = std::string("cannot open ") + path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    std::fprintf(file, "frame,frame_ms");
+    for (std::size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+        std::fprintf(file, ",%s_ms", profileStageName(static_cast<ProfileStage>(stage)));
+    std::fprintf(file, "\n");
+
+    for (std::size_t age = count; age-- > 0;)
+    {
+        const FrameProfileSample &sample = recent(age);
+        std::fprintf(file, "%llu,%.4f", static_cast<unsigned long long>(sample.frameIndex), toMs(sample.frameTicks));
+        for (std::size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+            std::fprintf(file, ",%.4f", toMs(sample.stageTicks[stage]));
+        std::fprintf(file, "\n");
+    }
+
+    if (std::fclose(file) != 0)
+    {
+        error = std::string("cannot write ") + path + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
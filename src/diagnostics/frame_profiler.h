@@ -0,0 +1,124 @@
+/**
+ * @file frame_profiler.h
+ * @brief Per-stage frame timers and a fixed-size history of recent frames.
+ *
+ * Each frame accumulates performance-counter ticks per stage in a
+ * FrameProfileSample. StageTimer adds the time of one scope to a stage, and
+ * a stage may be timed several times per frame (transform and draw run once
+ * per drawn object). When profiling is off the sample pointer is null and a
+ * StageTimer costs one branch. Finished samples are committed to a
+ * FrameProfiler ring buffer, which backs the on-screen overlay and the CSV
+ * export.
+ */
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Timed parts of a frame.
+ */
+enum class ProfileStage
+{
+    Events,    ///< Polling and handling SDL events
+    Animate,   ///< Delta time and angle integration
+    Cull,      ///< Revision syncs, frustum / BVH culling and LOD selection
+    Transform, ///< Batch rotation + projection of the drawn vertices
+    Draw,      ///< Clipping and SDL submission / software segment queueing
+    Rasterize, ///< Software backend tile rasterization
+    Present,   ///< Upload or replay, overlay, and SDL_RenderPresent
+    Count
+};
+
+constexpr std::size_t PROFILE_STAGE_COUNT = static_cast<std::size_t>(ProfileStage::Count);
+
+/** Lower-case stage name used in the CSV header and headless output. */
+const char *profileStageName(ProfileStage stage);
+
+/**
+ * @brief Stage times of one frame, in performance-counter ticks.
+ */
+struct FrameProfileSample
+{
+    std::uint64_t stageTicks[PROFILE_STAGE_COUNT] = {}; ///< Accumulated per stage
+    std::uint64_t frameTicks = 0;                       ///< Whole frame, present to present
+    std::uint64_t frameIndex = 0;                       ///< Set by FrameProfiler::commit
+};
+
+/**
+ * @brief Adds the lifetime of the timer to one stage of a sample (no-op for a null sample).
+ */
+class StageTimer
+{
+public:
+    StageTimer(FrameProfileSample *sample, ProfileStage stage)
+        : sample(sample), stage(stage), start(sample ? SDL_GetPerformanceCounter() : 0)
+    {
+    }
+
+    ~StageTimer() { stop(); }
+
+    /** End the timed scope early; later calls and the destructor do nothing. */
+    void stop()
+    {
+        if (sample)
+            sample->stageTicks[static_cast<std::size_t>(stage)] += SDL_GetPerformanceCounter() - start;
+        sample = nullptr;
+    }
+
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+private:
+    FrameProfileSample *sample;
+    ProfileStage stage;
+    std::uint64_t start;
+};
+
+/**
+ * @brief Ring buffer of the most recent frame samples.
+ *
+ * Storage is allocated once in the constructor; commit() never allocates.
+ */
+class FrameProfiler
+{
+public:
+    /** @param capacity Number of frames kept. */
+    explicit FrameProfiler(std::size_t capacity = 600);
+
+    /** Append a finished frame, overwriting the oldest one when full. */
+    void commit(const FrameProfileSample &sample);
+
+    /** Frames currently held (at most the capacity). */
+    std::size_t size() const { return count; }
+
+    /** Sample by age: 0 is the newest, size() - 1 the oldest. */
+    const FrameProfileSample &recent(std::size_t age) const;
+
+    /** Convert ticks to milliseconds. */
+    double toMs(std::uint64_t ticks) const { return static_cast<double>(ticks) * msPerTick; }
+
+    /**
+     * @brief Mean stage and frame times of the newest frames.
+     * @param frames  Frames to average (clamped to size()).
+     * @param stageMs Receives PROFILE_STAGE_COUNT means in milliseconds.
+     * @return Mean frame time in milliseconds (0 if there are no frames).
+     */
+    double average(std::size_t frames, double *stageMs) const;
+
+    /**
+     * @brief Write the history, oldest first, as CSV (one row per frame, times in ms).
+     * @return false with a message in error if the file cannot be written.
+     */
+    bool writeCsv(const char *path, std::string &error) const;
+
+private:
+    std::vector<FrameProfileSample> history;
+    std::size_t next = 0;
+    std::size_t count = 0;
+    std::uint64_t committed = 0;
+    double msPerTick = 0.0;
+};
@@ -0,0 +1,43 @@
+// latency_stats.cpp
+// Ring of recent latency samples plus running totals.
+
+#include "latency_stats.h"
+#include <algorithm>
+
+LatencyStats::LatencyStats(std::size_t capacity)
+{
+    recent.reserve(std::max<std::size_t>(capacity, 1));
+}
+
+void LatencyStats::record(double milliseconds)
+{
+    if (recent.size() < recent.capacity())
+        recent.push_back(milliseconds);
+    else
+        recent[next] = milliseconds;
+    next = (next + 1) % recent.capacity();
+    ++total;
+    sum += milliseconds;
+    maximum = std::max(maximum, milliseconds);
+}
+
+void LatencyStats::recordTicks(std::uint64_t ticks, std::uint64_t ticksPerSecond)
+{
+    if (ticksPerSecond != 0)
+        record(static_cast<double>(ticks) * 1000.0 / static_cast<double>(ticksPerSecond));
+}
+
+double LatencyStats::mean() const
+{
+    return total > 0 ? sum / static_cast<double>(total) : 0.0;
+}
+
+double LatencyStats::percentile(double fraction) const
+{
+    if (recent.empty())
+        return 0.0;
+    std::vector<double> sorted = recent;
+    std::sort(sorted.begin(), sorted.end());
+    const std::size_t rank = static_cast<std::size_t>(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
@@ -0,0 +1,42 @@
+/**
+ * @file latency_stats.h
+ * @brief Running summary of input-to-present latencies.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Mean and maximum over every sample and percentiles over the most recent ones.
+ *
+ * Storage for the recent samples is allocated up front, so record() never
+ * touches the heap.
+ */
+class LatencyStats
+{
+public:
+    /** @param capacity Number of recent samples kept for percentile(). */
+    explicit LatencyStats(std::size_t capacity = 4096);
+
+    /** Add one sample in milliseconds. */
+    void record(double milliseconds);
+
+    /** Convert performance-counter ticks to milliseconds and record them. */
+    void recordTicks(std::uint64_t ticks, std::uint64_t ticksPerSecond);
+
+    std::size_t count() const { return total; } ///< Samples recorded so far
+    double mean() const;                        ///< Mean of all samples; 0 if none
+    double max() const { return maximum; }      ///< Largest sample; 0 if none
+
+    /** Nearest-rank percentile (fraction in [0, 1]) of the recent samples; 0 if none. */
+    double percentile(double fraction) const;
+
+private:
+    std::vector<double> recent;
+    std::size_t next = 0;
+    std::size_t total = 0;
+    double sum = 0.0;
+    double maximum = 0.0;
+};
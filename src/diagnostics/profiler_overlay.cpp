@@ -0,0 +1,124 @@
+// profiler_overlay.cpp
+// Profiler panel: stage bars, numbers in a 3x5 pixel font, frame-time graph.
+
+#include "profiler_overlay.h"
+#include <algorithm>
+#include <cstdio>
+
+constexpr int OVERLAY_MARGIN = 8;
+constexpr int OVERLAY_GLYPH_SCALE = 2;                          // Font pixel size
+constexpr int OVERLAY_ADVANCE = 4 * OVERLAY_GLYPH_SCALE;        // Glyph width plus spacing
+constexpr int OVERLAY_ROW_HEIGHT = 7 * OVERLAY_GLYPH_SCALE;     // Glyph height plus spacing
+constexpr int OVERLAY_BAR_X = OVERLAY_MARGIN + 9 * OVERLAY_ADVANCE;
+constexpr double OVERLAY_BAR_PX_PER_MS = 8.0;
+constexpr int OVERLAY_BAR_MAX = 200;
+constexpr std::size_t OVERLAY_AVERAGE_FRAMES = 30;
+constexpr int OVERLAY_GRAPH_FRAMES = 240; // One pixel column per frame
+constexpr int OVERLAY_GRAPH_HEIGHT = 80;
+constexpr double OVERLAY_GRAPH_MAX_MS = 100.0 / 3.0;
+
+// 3x5 glyphs, one row per 3 bits, top row in the high bits
+struct Glyph
+{
+    char character;
+    unsigned short rows;
+};
+
+static constexpr Glyph GLYPHS[] = {
+    {'0', 0b111101101101111}, {'1', 0b010110010010111}, {'2', 0b111001111100111}, {'3', 0b111001111001111},
+    {'4', 0b101101111001001}, {'5', 0b111100111001111}, {'6', 0b111100111101111}, {'7', 0b111001001001001},
+    {'8', 0b111101111101111}, {'9', 0b111101111001111}, {'.', 0b000000000000010}, {'A', 0b010101111101101},
+    {'C', 0b111100100100111}, {'D', 0b110101101101110}, {'E', 0b111100110100111}, {'F', 0b111100110100100},
+    {'P', 0b110101110100100}, {'R', 0b110101110101101}, {'T', 0b111010010010010},
+};
+
+// Stage initials and colors, in ProfileStage order
+static constexpr char STAGE_INITIALS[PROFILE_STAGE_COUNT] = {'E', 'A', 'C', 'T', 'D', 'R', 'P'};
+static constexpr Uint8 STAGE_COLORS[PROFILE_STAGE_COUNT][3] = {
+    {160, 160, 160}, {230, 200, 60}, {230, 140, 40}, {80, 200, 90}, {60, 180, 230}, {90, 110, 240}, {210, 90, 200}};
+
+void ProfilerOverlay::addText(const char *text, int x, int y)
+{
+    for (; *text; ++text, x += OVERLAY_ADVANCE)
+    {
+        const Glyph *glyph = std::find_if(std::begin(GLYPHS), std::end(GLYPHS), [&](const Glyph &g)
+                                          { return g.character == *text; });
+        if (glyph == std::end(GLYPHS))
+            continue;
+        for (int bit = 0; bit < 15; ++bit)
+        {
+            if (glyph->rows & (1u << (14 - bit)))
+                rects.push_back({x + (bit % 3) * OVERLAY_GLYPH_SCALE, y + (bit / 3) * OVERLAY_GLYPH_SCALE, OVERLAY_GLYPH_SCALE, OVERLAY_GLYPH_SCALE});
+        }
+    }
+}
+
+static int barWidth(double ms)
+{
+    return std::clamp(static_cast<int>(ms * OVERLAY_BAR_PX_PER_MS + 0.5), 1, OVERLAY_BAR_MAX);
+}
+
+void ProfilerOverlay::draw(SDL_Renderer *renderer, const FrameProfiler &profiler)
+{
+    double stageMs[PROFILE_STAGE_COUNT];
+    const double frameMs = profiler.average(OVERLAY_AVERAGE_FRAMES, stageMs);
+
+    const int rows = static_cast<int>(PROFILE_STAGE_COUNT) + 1;
+    const int graphTop = OVERLAY_MARGIN + rows * OVERLAY_ROW_HEIGHT + OVERLAY_MARGIN;
+    const int panelWidth = std::max(OVERLAY_BAR_X + OVERLAY_BAR_MAX, OVERLAY_MARGIN + OVERLAY_GRAPH_FRAMES) + OVERLAY_MARGIN;
+    const SDL_Rect panel{0, 0, panelWidth, graphTop + OVERLAY_GRAPH_HEIGHT + OVERLAY_MARGIN};
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 170);
+    SDL_RenderFillRect(renderer, &panel);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    // Bars: frame time in white, then one colored bar per stage
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    const SDL_Rect frameBar{OVERLAY_BAR_X, OVERLAY_MARGIN, barWidth(frameMs), 5 * OVERLAY_GLYPH_SCALE};
+    SDL_RenderFillRect(renderer, &frameBar);
+    for (std::size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+    {
+        const int y = OVERLAY_MARGIN + static_cast<int>(stage + 1) * OVERLAY_ROW_HEIGHT;
+        const SDL_Rect bar{OVERLAY_BAR_X, y, barWidth(stageMs[stage]), 5 * OVERLAY_GLYPH_SCALE};
+        SDL_SetRenderDrawColor(renderer, STAGE_COLORS[stage][0], STAGE_COLORS[stage][1], STAGE_COLORS[stage][2], 255);
+        SDL_RenderFillRect(renderer, &bar);
+    }
+
+    // Labels and values, e.g. "T 1.25"
+    rects.clear();
+    char line[32];
+    std::snprintf(line, sizeof(line), "F %.2f", frameMs);
+    addText(line, OVERLAY_MARGIN, OVERLAY_MARGIN);
+    for (std::size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage)
+    {
+        std::snprintf(line, sizeof(line), "%c %.2f", STAGE_INITIALS[stage], stageMs[stage]);
+        addText(line, OVERLAY_MARGIN, OVERLAY_MARGIN + static_cast<int>(stage + 1) * OVERLAY_ROW_HEIGHT);
+    }
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderFillRects(renderer, rects.data(), static_cast<int>(rects.size()));
+
+    // Frame-time graph, newest frame on the right
+    const int graphBottom = graphTop + OVERLAY_GRAPH_HEIGHT;
+    const auto graphY = [&](double ms)
+    { return graphBottom - static_cast<int>(std::min(ms, OVERLAY_GRAPH_MAX_MS) / OVERLAY_GRAPH_MAX_MS * OVERLAY_GRAPH_HEIGHT + 0.5); };
+    SDL_SetRenderDrawColor(renderer, 90, 90, 90, 255);
+    for (const double guideMs : {1000.0 / 60.0, OVERLAY_GRAPH_MAX_MS})
+    {
+        const int y = graphY(guideMs);
+        SDL_RenderDrawLine(renderer, OVERLAY_MARGIN, y, OVERLAY_MARGIN + OVERLAY_GRAPH_FRAMES - 1, y);
+    }
+
+    graph.clear();
+    const std::size_t frames = std::min<std::size_t>(profiler.size(), OVERLAY_GRAPH_FRAMES);
+    for (std::size_t age = frames; age-- > 0;)
+    {
+        const int x = OVERLAY_MARGIN + OVERLAY_GRAPH_FRAMES - 1 - static_cast<int>(age);
+        graph.push_back({x, graphY(profiler.toMs(profiler.recent(age).frameTicks))});
+    }
+    if (graph.size() >= 2)
+    {
+        SDL_SetRenderDrawColor(renderer, 80, 220, 120, 255);
+        SDL_RenderDrawLines(renderer, graph.data(), static_cast<int>(graph.size()));
+    }
+}
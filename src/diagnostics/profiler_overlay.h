@@ -0,0 +1,33 @@
+/**
+ * @file profiler_overlay.h
+ * @brief On-screen panel with per-stage frame times and a frame-time graph.
+ */
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "frame_profiler.h"
+#include <vector>
+
+/**
+ * @brief Draws a FrameProfiler's recent history with SDL_Renderer calls.
+ *
+ * The panel in the top-left corner shows the mean frame time and the mean
+ * time of each stage over the last 30 frames, as numbers and bars, followed
+ * by a graph of the last 240 frame times with 16.7 ms and 33.3 ms guides.
+ * Text uses a built-in 3x5 pixel font (digits and the stage initials), so
+ * no font library is needed. Drawn after the frame and before present, it
+ * works with both backends. Rectangles and points are kept in member
+ * vectors, so after the first draw no memory is allocated.
+ */
+class ProfilerOverlay
+{
+public:
+    /** Draw the panel on top of the current backbuffer contents. */
+    void draw(SDL_Renderer *renderer, const FrameProfiler &profiler);
+
+private:
+    void addText(const char *text, int x, int y);
+
+    std::vector<SDL_Rect> rects;
+    std::vector<SDL_Point> graph;
+};
@@ -0,0 +1,356 @@
+// frame_exporter.cpp
+// Frame buffer ring, writer thread, and the Y4M / PPM / raw encoders.
+
+#include "frame_exporter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+const char *exportFormatName(ExportFormat format)
+{
+    switch (format)
+    {
+    case ExportFormat::Y4m:
+        return "y4m";
+    case ExportFormat::Ppm:
+        return "ppm";
+    case ExportFormat::Raw:
+        return "raw";
+    }
+    return "unknown";
+}
+
+bool findExportFormat(const char *name, ExportFormat &format)
+{
+    for (const ExportFormat candidate : {ExportFormat::Y4m, ExportFormat::Ppm, ExportFormat::Raw})
+    {
+        if (std::strcmp(name, exportFormatName(candidate)) == 0)
+        {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// True if path ends with suffix, ignoring ASCII case
+static bool hasExtension(const char *path, const char *suffix)
+{
+    const std::size_t length = std::strlen(path), suffixLength = std::strlen(suffix);
+    if (length < suffixLength)
+        return false;
+    for (std::size_t i = 0; i < suffixLength; ++i)
+    {
+        const char c = path[length - suffixLength + i];
+        if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != suffix[i])
+            return false;
+    }
+    return true;
+}
+
+ExportFormat exportFormatForPath(const char *path)
+{
+    if (hasExtension(path, ".ppm"))
+        return ExportFormat::Ppm;
+    if (hasExtension(path, ".rgba") || hasExtension(path, ".raw"))
+        return ExportFormat::Raw;
+    return ExportFormat::Y4m;
+}
+
+FrameExporter::~FrameExporter()
+{
+    std::string error;
+    finish(error);
+}
+
+bool FrameExporter::open(const char *path, ExportFormat newFormat, int newWidth, int newHeight, double newFramesPerSecond,
+                         std::size_t queueFrames, std::string &error)
+{
+    if (writer.joinable())
+    {
+        error = "export stream already open";
+        return false;
+    }
+    if (newWidth <= 0 || newHeight <= 0)
+    {
+        error = "invalid frame size";
+        return false;
+    }
+
+    if (std::strcmp(path, "-") == 0)
+    {
+        // Keep the real stdout for the frames and send everything else to stderr
+        std::fflush(stdout);
+        fd = dup(STDOUT_FILENO);
+        if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+        {
+            error = std::string("cannot take over stdout: ") + std::strerror(errno);
+            if (fd >= 0)
+                ::close(fd);
+            fd = -1;
+            return false;
+        }
+        std::signal(SIGPIPE, SIG_IGN);
+    }
+    else
+    {
+        fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            error = std::string("cannot create '") + path + "': " + std::strerror(errno);
+            return false;
+        }
+    }
+    ownsDescriptor = true;
+
+    format = newFormat;
+    width = newWidth;
+    height = newHeight;
+    framesPerSecond = newFramesPerSecond;
+    const std::size_t pixelCount = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    buffers.assign(std::max<std::size_t>(queueFrames, 2), std::vector<std::uint32_t>(pixelCount));
+    const std::size_t chromaCount = static_cast<std::size_t>((width + 1) / 2) * static_cast<std::size_t>((height + 1) / 2);
+    switch (format)
+    {
+    case ExportFormat::Y4m:
+        encoded.resize(6 + pixelCount + 2 * chromaCount); // "FRAME\n" + Y, Cb, Cr planes
+        break;
+    case ExportFormat::Ppm:
+        encoded.resize(32 + 3 * pixelCount); // Room for "P6\nW H\n255\n"
+        break;
+    case ExportFormat::Raw:
+        encoded.resize(4 * pixelCount);
+        break;
+    }
+
+    firstQueued = 0;
+    queued = 0;
+    frameOpen = false;
+    stopRequested = false;
+    failed = false;
+    writeError.clear();
+    totals = ExportStats{};
+    openTime = std::chrono::steady_clock::now();
+    writer = std::thread(&FrameExporter::writerLoop, this);
+    return true;
+}
+
+std::uint32_t *FrameExporter::beginFrame()
+{
+    if (!writer.joinable())
+        return nullptr;
+    std::unique_lock<std::mutex> lock(mutex);
+    if (queued == buffers.size() && !failed)
+    {
+        const auto waitStart = std::chrono::steady_clock::now();
+        bufferFree.wait(lock, [this]()
+                        { return queued < buffers.size() || failed; });
+        ++totals.stalls;
+        totals.stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+    }
+    if (failed)
+        return nullptr;
+    frameOpen = true;
+    return buffers[(firstQueued + queued) % buffers.size()].data();
+}
+
+void FrameExporter::submitFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!frameOpen)
+            return;
+        frameOpen = false;
+        ++queued;
+    }
+    frameReady.notify_one();
+}
+
+bool FrameExporter::finish(std::string &error)
+{
+    if (writer.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+            frameOpen = false;
+        }
+        frameReady.notify_one();
+        writer.join();
+        totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - openTime).count();
+    }
+    if (ownsDescriptor)
+    {
+        if (::close(fd) != 0 && !failed)
+        {
+            failed = true;
+            writeError = std::string("close failed: ") + std::strerror(errno);
+        }
+        fd = -1;
+        ownsDescriptor = false;
+    }
+    if (failed)
+        error = writeError;
+    return !failed;
+}
+
+void FrameExporter::writerLoop()
+{
+    if (format == ExportFormat::Y4m)
+    {
+        // Integer rates are written as N:1, others as a ratio over microseconds
+        char header[128];
+        const double rounded = std::round(framesPerSecond);
+        const int length = (std::fabs(framesPerSecond - rounded) < 1e-3 && rounded >= 1.0)
+                               ? std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%.0f:1 Ip A1:1 C420jpeg XYSCSS=420JPEG\n", width, height, rounded)
+                               : std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F1000000:%.0f Ip A1:1 C420jpeg XYSCSS=420JPEG\n", width,
+                                               height, std::max(std::round(1e6 / framesPerSecond), 1.0));
+        if (!writeAll(reinterpret_cast<const unsigned char *>(header), static_cast<std::size_t>(length)))
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = true;
+            bufferFree.notify_all();
+            return;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        frameReady.wait(lock, [this]()
+                        { return queued > 0 || stopRequested; });
+        if (queued == 0)
+            return; // Stop requested and everything written
+
+        // The buffer stays reserved until written; the render loop fills the others
+        const std::uint32_t *pixels = buffers[firstQueued].data();
+        lock.unlock();
+        const auto writeStart = std::chrono::steady_clock::now();
+        const bool written = writeFrame(pixels);
+        totals.writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - writeStart).count();
+        lock.lock();
+
+        firstQueued = (firstQueued + 1) % buffers.size();
+        --queued;
+        if (!written)
+            failed = true;
+        bufferFree.notify_one();
+        if (failed)
+            return;
+    }
+}
+
+bool FrameExporter::writeAll(const unsigned char *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            std::lock_guard<std::mutex> lock(mutex);
+            writeError = std::string("write failed: ") + std::strerror(errno);
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+        totals.bytes += static_cast<std::uint64_t>(written);
+    }
+    return true;
+}
+
+// Full-range BT.601 (JFIF) in 16-bit fixed point, rounded
+static unsigned char lumaOf(std::uint32_t red, std::uint32_t green, std::uint32_t blue)
+{
+    return static_cast<unsigned char>((19595u * red + 38470u * green + 7471u * blue + 32768u) >> 16);
+}
+
+static unsigned char chromaOf(std::int32_t weightRed, std::int32_t weightGreen, std::int32_t weightBlue, std::int32_t red, std::int32_t green,
+                              std::int32_t blue)
+{
+    const std::int32_t value = (weightRed * red + weightGreen * green + weightBlue * blue + (128 << 16) + 32768) >> 16;
+    return static_cast<unsigned char>(std::clamp(value, 0, 255));
+}
+
+bool FrameExporter::writeFrame(const std::uint32_t *pixels)
+{
+    unsigned char *out = encoded.data();
+    std::size_t size = 0;
+    switch (format)
+    {
+    case ExportFormat::Y4m:
+    {
+        std::memcpy(out, "FRAME\n", 6);
+        unsigned char *luma = out + 6;
+        for (std::size_t i = 0, count = static_cast<std::size_t>(width) * static_cast<std::size_t>(height); i < count; ++i)
+        {
+            const std::uint32_t pixel = pixels[i];
+            luma[i] = lumaOf((pixel >> 16) & 0xFF, (pixel >> 8) & 0xFF, pixel & 0xFF);
+        }
+
+        // Chroma from the mean color of each 2x2 block (clipped at odd edges)
+        const int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+        unsigned char *blueDifference = luma + static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+        unsigned char *redDifference = blueDifference + static_cast<std::size_t>(chromaWidth) * static_cast<std::size_t>(chromaHeight);
+        for (int cy = 0; cy < chromaHeight; ++cy)
+        {
+            const int rows = std::min(2, height - 2 * cy);
+            for (int cx = 0; cx < chromaWidth; ++cx)
+            {
+                const int columns = std::min(2, width - 2 * cx);
+                std::int32_t sum[3] = {0, 0, 0};
+                for (int dy = 0; dy < rows; ++dy)
+                {
+                    const std::uint32_t *row = pixels + static_cast<std::size_t>(2 * cy + dy) * static_cast<std::size_t>(width) + 2 * cx;
+                    for (int dx = 0; dx < columns; ++dx)
+                    {
+                        sum[0] += (row[dx] >> 16) & 0xFF;
+                        sum[1] += (row[dx] >> 8) & 0xFF;
+                        sum[2] += row[dx] & 0xFF;
+                    }
+                }
+                const std::int32_t count = rows * columns;
+                const std::int32_t red = (sum[0] + count / 2) / count, green = (sum[1] + count / 2) / count, blue = (sum[2] + count / 2) / count;
+                const std::size_t index = static_cast<std::size_t>(cy) * static_cast<std::size_t>(chromaWidth) + cx;
+                blueDifference[index] = chromaOf(-11059, -21709, 32768, red, green, blue);
+                redDifference[index] = chromaOf(32768, -27439, -5329, red, green, blue);
+            }
+        }
+        size = encoded.size();
+        break;
+    }
+    case ExportFormat::Ppm:
+    {
+        size = static_cast<std::size_t>(std::snprintf(reinterpret_cast<char *>(out), 32, "P6\n%d %d\n255\n", width, height));
+        for (std::size_t i = 0, count = static_cast<std::size_t>(width) * static_cast<std::size_t>(height); i < count; ++i, size += 3)
+        {
+            out[size] = static_cast<unsigned char>(pixels[i] >> 16);
+            out[size + 1] = static_cast<unsigned char>(pixels[i] >> 8);
+            out[size + 2] = static_cast<unsigned char>(pixels[i]);
+        }
+        break;
+    }
+    case ExportFormat::Raw:
+    {
+        for (std::size_t i = 0, count = static_cast<std::size_t>(width) * static_cast<std::size_t>(height); i < count; ++i, size += 4)
+        {
+            out[size] = static_cast<unsigned char>(pixels[i] >> 16);
+            out[size + 1] = static_cast<unsigned char>(pixels[i] >> 8);
+            out[size + 2] = static_cast<unsigned char>(pixels[i]);
+            out[size + 3] = static_cast<unsigned char>(pixels[i] >> 24);
+        }
+        break;
+    }
+    }
+
+    if (!writeAll(out, size))
+        return false;
+    ++totals.frames;
+    return true;
+}
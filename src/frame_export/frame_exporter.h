@@ -0,0 +1,145 @@
+/**
+ * @file frame_exporter.h
+ * @brief Streams rendered frames to a file or stdout on a writer thread.
+ *
+ * The render loop copies each finished frame into one of a fixed set of
+ * buffers and hands it over; a writer thread converts it to the output
+ * format and writes it. Buffers are allocated once in open() and reused, so
+ * exporting adds no heap allocations per frame. Rendering only waits when
+ * every buffer is still queued for writing (backpressure from a slow disk or
+ * encoder).
+ *
+ * Formats:
+ *  - Y4M: YUV4MPEG2, 4:2:0 full-range BT.601 ("C420jpeg"), one stream with
+ *    the frame rate in its header; readable by ffmpeg, x264, mpv, ...
+ *  - PPM: a sequence of binary P6 images (ffmpeg's image2pipe / ppm_pipe).
+ *  - Raw: headerless RGBA bytes, width * height * 4 per frame.
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Output encoding of an export stream.
+ */
+enum class ExportFormat
+{
+    Y4m, ///< YUV4MPEG2 4:2:0
+    Ppm, ///< Concatenated binary PPM (P6) images
+    Raw  ///< RGBA8 without a header
+};
+
+/** Lower-case format name ("y4m", "ppm", "raw"). */
+const char *exportFormatName(ExportFormat format);
+
+/** Look up a format by exportFormatName(); false if unknown. */
+bool findExportFormat(const char *name, ExportFormat &format);
+
+/** Format implied by a path's extension (.ppm, .rgba / .raw); Y4M otherwise. */
+ExportFormat exportFormatForPath(const char *path);
+
+/**
+ * @brief Totals of an export run.
+ */
+struct ExportStats
+{
+    std::uint64_t frames = 0;  ///< Frames written
+    std::uint64_t bytes = 0;   ///< Bytes written, headers included
+    double seconds = 0.0;      ///< open() to the end of finish(), including the final drain
+    double writeSeconds = 0.0; ///< Writer thread time spent converting and writing
+    std::uint64_t stalls = 0;  ///< beginFrame() calls that had to wait for a free buffer
+    double stallSeconds = 0.0; ///< Time the render loop spent in those waits
+};
+
+/**
+ * @brief Bounded queue of reusable frame buffers drained by a writer thread.
+ *
+ * Usage per frame: beginFrame(), fill the returned width * height ARGB8888
+ * pixels, submitFrame(). finish() writes the queued frames and closes the
+ * output. open() and finish() are called from the thread that submits.
+ */
+class FrameExporter
+{
+public:
+    FrameExporter() = default;
+    ~FrameExporter();
+
+    FrameExporter(const FrameExporter &) = delete;
+    FrameExporter &operator=(const FrameExporter &) = delete;
+
+    /**
+     * @brief Create the output and start the writer thread.
+     *
+     * A path of "-" streams to stdout. stdout is then reserved for the
+     * frames: the original descriptor is kept for the writer and file
+     * descriptor 1 is pointed at stderr, so text the program prints later
+     * cannot corrupt the stream. SIGPIPE is ignored so a reader that exits
+     * early shows up as a write error.
+     *
+     * @param path            Output file, or "-" for stdout.
+     * @param format          Stream encoding.
+     * @param width           Frame width in pixels.
+     * @param height          Frame height in pixels.
+     * @param framesPerSecond Playback rate written to the Y4M header.
+     * @param queueFrames     Number of frame buffers (at least 2).
+     * @param error           Receives a message on failure.
+     * @return true on success.
+     */
+    bool open(const char *path, ExportFormat format, int width, int height, double framesPerSecond, std::size_t queueFrames,
+              std::string &error);
+
+    /**
+     * @brief Buffer for the next frame: width * height ARGB8888 pixels, row-major.
+     *
+     * Blocks while every buffer is queued. Returns null if the writer has
+     * failed (finish() reports why) or nothing is open.
+     */
+    std::uint32_t *beginFrame();
+
+    /** Queue the buffer returned by the last beginFrame() for writing. */
+    void submitFrame();
+
+    /**
+     * @brief Write the remaining frames, stop the writer and close the output.
+     * @param error Receives the first write error.
+     * @return false if any write failed.
+     */
+    bool finish(std::string &error);
+
+    const ExportStats &stats() const { return totals; }
+
+private:
+    void writerLoop();
+    bool writeFrame(const std::uint32_t *pixels);
+    bool writeAll(const unsigned char *data, std::size_t size);
+
+    ExportFormat format = ExportFormat::Y4m;
+    int width = 0;
+    int height = 0;
+    double framesPerSecond = 0.0;
+    int fd = -1;
+    bool ownsDescriptor = false;
+    std::chrono::steady_clock::time_point openTime;
+
+    std::vector<std::vector<std::uint32_t>> buffers; ///< Ring of frame buffers
+    std::vector<unsigned char> encoded;             ///< Writer-owned conversion output
+    std::size_t firstQueued = 0;                    ///< Oldest buffer not yet written
+    std::size_t queued = 0;                         ///< Buffers submitted or being written
+    bool frameOpen = false;                         ///< beginFrame() returned a buffer not yet submitted
+
+    std::thread writer;
+    std::mutex mutex;                   ///< Guards firstQueued, queued, stopRequested, failed, writeError
+    std::condition_variable frameReady; ///< A frame was submitted or stop requested
+    std::condition_variable bufferFree; ///< The writer finished a frame or failed
+    bool stopRequested = false;
+    bool failed = false;
+    std::string writeError;
+    ExportStats totals;
+};
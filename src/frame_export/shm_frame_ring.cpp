@@ -0,0 +1,395 @@
+// shm_frame_ring.cpp
+// POSIX shared-memory frame ring: producer, consumer and the futex handshake
+// between them (see shm_frame_ring.h for the protocol).
+
+#include "shm_frame_ring.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Bump whenever the layout or the meaning of a field changes
+constexpr std::uint32_t SHM_FRAME_RING_VERSION = 1;
+constexpr char SHM_FRAME_RING_MAGIC[8] = {'W', 'F', 'S', 'H', 'M', 'R', 'N', 'G'};
+
+// A lossless producer re-checks that its consumer is still alive this often
+constexpr int CONSUMER_CHECK_MS = 100;
+
+// Before its first frame a lossless producer waits this long for a consumer to attach
+constexpr int LOSSLESS_ATTACH_TIMEOUT_MS = 10000;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+              "the ring's atomics are shared between processes");
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex words must be plain 32-bit integers");
+static_assert(SHM_FRAME_RING_MAX_SLOTS <= 256, "latest keeps the slot in its low 8 bits");
+
+std::uint64_t shmFrameClockNs()
+{
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<std::uint64_t>(now.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(now.tv_nsec);
+}
+
+// Shared (not process-private) futex operations on a word of the mapping
+static void futexWait(std::atomic<std::uint32_t> &word, std::uint32_t expected, int timeoutMs)
+{
+    timespec timeout{timeoutMs / 1000, static_cast<long>(timeoutMs % 1000) * 1000000L};
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+static void futexWake(std::atomic<std::uint32_t> &word)
+{
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// The process behind pid has exited (a consumer that died without close())
+static bool processGone(std::int32_t pid)
+{
+    return pid > 0 && kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+// Producer
+// --------
+
+ShmFrameRing::~ShmFrameRing()
+{
+    finish();
+    if (base)
+        munmap(base, mapBytes);
+}
+
+bool ShmFrameRing::open(const char *ringName, int width, int height, std::uint32_t slotCount, bool lossless, std::string &error)
+{
+    if (!ringName || ringName[0] != '/' || std::strchr(ringName + 1, '/'))
+    {
+        error = "shared-memory names look like /name";
+        return false;
+    }
+    if (width <= 0 || height <= 0 || slotCount < 3 || slotCount > SHM_FRAME_RING_MAX_SLOTS)
+    {
+        error = "invalid ring size";
+        return false;
+    }
+
+    const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t stride = static_cast<std::size_t>(width) * sizeof(std::uint32_t);
+    const std::size_t headerBytes = alignUp(sizeof(ShmFrameRingHeader), page);
+    const std::size_t slotBytes = alignUp(stride * static_cast<std::size_t>(height), page);
+    const std::size_t totalBytes = headerBytes + slotBytes * slotCount;
+
+    // A ring left behind by a crashed run is replaced
+    shm_unlink(ringName);
+    const int fd = shm_open(ringName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+    {
+        error = std::string("shm_open failed: ") + std::strerror(errno);
+        return false;
+    }
+    name = ringName;
+    linked = true;
+    if (ftruncate(fd, static_cast<off_t>(totalBytes)) != 0)
+    {
+        error = std::string("cannot size the ring: ") + std::strerror(errno);
+        ::close(fd);
+        finish();
+        return false;
+    }
+    // Populated up front, so first frames do not fault their slots in
+    void *mapping = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        error = std::string("cannot map the ring: ") + std::strerror(errno);
+        finish();
+        return false;
+    }
+    base = static_cast<unsigned char *>(mapping);
+    mapBytes = totalBytes;
+
+    header = new (base) ShmFrameRingHeader();
+    header->version = SHM_FRAME_RING_VERSION;
+    header->flags = lossless ? SHM_FRAME_RING_LOSSLESS : 0;
+    header->slotCount = slotCount;
+    header->width = static_cast<std::uint32_t>(width);
+    header->height = static_cast<std::uint32_t>(height);
+    header->stride = static_cast<std::uint32_t>(stride);
+    header->format = SHM_FRAME_FORMAT_ARGB8888;
+    header->slotBytes = slotBytes;
+    header->mapBytes = totalBytes;
+    header->readingSlot.store(SHM_FRAME_NO_SLOT);
+    header->producerState.store(SHM_FRAME_PRODUCER_RUNNING);
+    for (std::uint32_t i = 0; i < slotCount; ++i)
+    {
+        ShmFrameSlot &entry = header->slots[i];
+        entry.offset = headerBytes + slotBytes * i;
+        entry.width = header->width;
+        entry.height = header->height;
+        entry.stride = header->stride;
+        entry.format = header->format;
+    }
+    // The magic goes in last: a consumer that sees it sees a complete header
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, SHM_FRAME_RING_MAGIC, sizeof(header->magic));
+
+    slot = 0;
+    sequence = 0;
+    totals = ShmFrameRingStats{};
+    return true;
+}
+
+std::uint32_t *ShmFrameRing::beginFrame()
+{
+    if (!header)
+        return nullptr;
+    // Any slot but the newest frame's and the one the consumer holds
+    const std::uint64_t latest = header->latest.load();
+    const std::uint32_t newest = latest != 0 ? static_cast<std::uint32_t>(latest & 0xFF) : SHM_FRAME_NO_SLOT;
+    const std::uint32_t reading = header->readingSlot.load();
+    do
+    {
+        slot = (slot + 1) % header->slotCount;
+    } while (slot == newest || slot == reading);
+    return reinterpret_cast<std::uint32_t *>(base + header->slots[slot].offset);
+}
+
+void ShmFrameRing::waitForAttach()
+{
+    if (!header || !(header->flags & SHM_FRAME_RING_LOSSLESS) || totals.attachTimedOut)
+        return;
+    const std::uint64_t start = shmFrameClockNs();
+    const std::uint64_t deadline = start + static_cast<std::uint64_t>(LOSSLESS_ATTACH_TIMEOUT_MS) * 1000000ull;
+    for (;;)
+    {
+        // The consumer wakes takenFutex once it has attached
+        const std::uint32_t taken = header->takenFutex.load();
+        if (header->consumerPid.load() != 0)
+            break;
+        const std::uint64_t now = shmFrameClockNs();
+        if (now >= deadline)
+        {
+            totals.attachTimedOut = true;
+            break;
+        }
+        futexWait(header->takenFutex, taken, std::min(CONSUMER_CHECK_MS, static_cast<int>((deadline - now) / 1000000ull) + 1));
+    }
+    totals.attachSeconds += static_cast<double>(shmFrameClockNs() - start) * 1e-9;
+}
+
+void ShmFrameRing::waitForConsumer(std::uint64_t previous)
+{
+    const std::uint32_t target = static_cast<std::uint32_t>(previous);
+    double waited = 0.0;
+    for (;;)
+    {
+        const std::int32_t pid = header->consumerPid.load();
+        const std::uint32_t taken = header->takenFutex.load();
+        if (pid == 0 || static_cast<std::int32_t>(taken - target) >= 0)
+            break;
+        if (waited == 0.0)
+            ++totals.waits;
+        const std::uint64_t start = shmFrameClockNs();
+        futexWait(header->takenFutex, taken, CONSUMER_CHECK_MS);
+        waited += static_cast<double>(shmFrameClockNs() - start) * 1e-9;
+        if (processGone(pid))
+        {
+            // Its slot is free again and nobody waits for frames
+            std::int32_t expected = pid;
+            if (header->consumerPid.compare_exchange_strong(expected, 0))
+                header->readingSlot.store(SHM_FRAME_NO_SLOT);
+        }
+    }
+    totals.waitSeconds += waited;
+}
+
+void ShmFrameRing::publish(bool copied)
+{
+    if (!header)
+        return;
+    if (header->flags & SHM_FRAME_RING_LOSSLESS)
+    {
+        if (sequence == 0)
+            waitForAttach();
+        else
+            waitForConsumer(sequence);
+    }
+
+    ++sequence;
+    ShmFrameSlot &entry = header->slots[slot];
+    entry.sequence.store(sequence, std::memory_order_relaxed);
+    entry.publishNs = shmFrameClockNs();
+    header->latest.store(sequence << 8 | slot);
+    header->frameFutex.store(static_cast<std::uint32_t>(sequence), std::memory_order_release);
+    futexWake(header->frameFutex);
+
+    ++totals.frames;
+    if (copied)
+        ++totals.copiedFrames;
+}
+
+void ShmFrameRing::finish()
+{
+    if (header && header->producerState.load() != SHM_FRAME_PRODUCER_FINISHED)
+    {
+        header->producerState.store(SHM_FRAME_PRODUCER_FINISHED);
+        futexWake(header->frameFutex);
+    }
+    if (linked)
+    {
+        shm_unlink(name.c_str());
+        linked = false;
+    }
+}
+
+// Consumer
+// --------
+
+ShmFrameReader::~ShmFrameReader()
+{
+    close();
+}
+
+bool ShmFrameReader::open(const char *ringName, std::string &error)
+{
+    close();
+    const int fd = shm_open(ringName, O_RDWR, 0);
+    if (fd < 0)
+    {
+        error = std::string("shm_open failed: ") + std::strerror(errno);
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(ShmFrameRingHeader))
+    {
+        error = "not a frame ring (too small)";
+        ::close(fd);
+        return false;
+    }
+    const std::size_t size = static_cast<std::size_t>(info.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        error = std::string("cannot map the ring: ") + std::strerror(errno);
+        return false;
+    }
+    auto *ring = static_cast<ShmFrameRingHeader *>(mapping);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (std::memcmp(ring->magic, SHM_FRAME_RING_MAGIC, sizeof(ring->magic)) != 0 || ring->version != SHM_FRAME_RING_VERSION ||
+        ring->mapBytes != size || ring->slotCount < 3 || ring->slotCount > SHM_FRAME_RING_MAX_SLOTS)
+    {
+        error = "not a frame ring, or a different version";
+        munmap(mapping, size);
+        return false;
+    }
+    for (std::uint32_t i = 0; i < ring->slotCount; ++i)
+    {
+        const ShmFrameSlot &entry = ring->slots[i];
+        if (entry.offset + static_cast<std::uint64_t>(entry.stride) * entry.height > size)
+        {
+            error = "frame ring slot outside the mapping";
+            munmap(mapping, size);
+            return false;
+        }
+    }
+
+    // One consumer at a time; a dead one's place is taken over
+    std::int32_t current = 0;
+    const std::int32_t self = static_cast<std::int32_t>(getpid());
+    while (!ring->consumerPid.compare_exchange_strong(current, self))
+    {
+        if (!processGone(current))
+        {
+            error = "the ring already has a consumer (pid " + std::to_string(current) + ")";
+            munmap(mapping, size);
+            return false;
+        }
+    }
+    header = ring;
+    base = static_cast<unsigned char *>(mapping);
+    mapBytes = size;
+    lastSequence = 0;
+    // A lossless producer holds its first frame until a consumer is attached
+    if (ring->flags & SHM_FRAME_RING_LOSSLESS)
+        futexWake(ring->takenFutex);
+    return true;
+}
+
+bool ShmFrameReader::take(ShmFrame &frame, int timeoutMs)
+{
+    if (!header)
+        return false;
+    const std::uint64_t deadline = shmFrameClockNs() + static_cast<std::uint64_t>(timeoutMs) * 1000000ull;
+    for (;;)
+    {
+        const std::uint64_t latest = header->latest.load();
+        if ((latest >> 8) > lastSequence)
+        {
+            // Claim the slot, then make sure it still holds the newest frame:
+            // if so, the producer has seen the claim before picking its next slot
+            const std::uint32_t slot = static_cast<std::uint32_t>(latest & 0xFF);
+            header->readingSlot.store(slot);
+            if (header->latest.load() != latest)
+                continue;
+
+            const ShmFrameSlot &entry = header->slots[slot];
+            frame.pixels = reinterpret_cast<const std::uint32_t *>(base + entry.offset);
+            frame.sequence = latest >> 8;
+            frame.publishNs = entry.publishNs;
+            frame.width = entry.width;
+            frame.height = entry.height;
+            frame.stride = entry.stride;
+            frame.format = entry.format;
+            frame.slot = slot;
+            lastSequence = frame.sequence;
+            header->takenFutex.store(static_cast<std::uint32_t>(frame.sequence));
+            if (header->flags & SHM_FRAME_RING_LOSSLESS)
+                futexWake(header->takenFutex);
+            return true;
+        }
+        if (header->producerState.load() == SHM_FRAME_PRODUCER_FINISHED)
+            return false;
+        const std::uint64_t now = shmFrameClockNs();
+        if (now >= deadline)
+            return false;
+        const int remainingMs = static_cast<int>((deadline - now + 999999) / 1000000);
+        futexWait(header->frameFutex, static_cast<std::uint32_t>(latest >> 8), remainingMs);
+    }
+}
+
+bool ShmFrameReader::intact(const ShmFrame &frame) const
+{
+    return header && frame.slot < header->slotCount && header->slots[frame.slot].sequence.load() == frame.sequence;
+}
+
+bool ShmFrameReader::producerFinished() const
+{
+    return header && header->producerState.load() == SHM_FRAME_PRODUCER_FINISHED;
+}
+
+void ShmFrameReader::close()
+{
+    if (!header)
+        return;
+    header->readingSlot.store(SHM_FRAME_NO_SLOT);
+    std::int32_t self = static_cast<std::int32_t>(getpid());
+    header->consumerPid.compare_exchange_strong(self, 0);
+    futexWake(header->takenFutex); // A lossless producer stops waiting for us
+    munmap(base, mapBytes);
+    header = nullptr;
+    base = nullptr;
+    mapBytes = 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file shm_frame_ring.h
+ * @brief Rendered frames handed to another process through a POSIX
+ *        shared-memory ring of frame buffers.
+ *
+ * FrameExporter encodes frames into a byte stream. A compositor or streamer
+ * on the same host only needs the pixels, so here they stay in shared
+ * memory: the producer renders into a slot of the ring, and a consumer maps
+ * the same object and reads the slot in place. Neither side copies a frame.
+ *
+ * Mapping layout (shm_open name, e.g. "/wireframe"):
+ *   header  ShmFrameRingHeader: geometry of the ring, the newest frame, the
+ *           consumer's handshake words and one ShmFrameSlot per slot
+ *   slots   slotCount page-aligned frame buffers of slotBytes each
+ *
+ * Protocol (one producer, at most one consumer at a time):
+ *  - The producer writes frame N into a slot that is neither the newest
+ *    frame's nor the one the consumer reports in readingSlot, fills that
+ *    slot's ShmFrameSlot, then stores latest = N << 8 | slot and
+ *    wakes futex waiters on frameFutex (the low 32 bits of N). With three
+ *    or more slots such a slot always exists, so the producer never waits
+ *    for a reader unless the ring is lossless.
+ *  - The consumer loads latest, stores its slot in readingSlot and loads
+ *    latest again; if it changed, it retries. Once both loads agree the
+ *    producer cannot pick that slot until readingSlot changes, so the frame
+ *    can be read in place for as long as the consumer likes. It then stores
+ *    the sequence in takenFutex.
+ *  - Sequence numbers start at 1 and increase by one per frame. A consumer
+ *    slower than the producer sees gaps (dropped frames), never torn or
+ *    reordered frames. A lossless ring makes the producer wait, before it
+ *    publishes frame N + 1, until an attached consumer has taken frame N,
+ *    and before frame 1 until a consumer has attached (for at most 10 s;
+ *    after that frames published without a consumer are lost).
+ *
+ * Signalling uses futexes on words inside the mapping (Linux). Pixels are
+ * ARGB8888 (DRM fourcc 'AR24') in native byte order.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** Pixel format of every slot: ARGB8888, the DRM fourcc "AR24". */
+constexpr std::uint32_t SHM_FRAME_FORMAT_ARGB8888 = 0x34325241u;
+
+/** Most slots a ring can have. */
+constexpr std::uint32_t SHM_FRAME_RING_MAX_SLOTS = 16;
+
+/** readingSlot value of a ring without a consumer holding a slot. */
+constexpr std::uint32_t SHM_FRAME_NO_SLOT = 0xFFFFFFFFu;
+
+/** ShmFrameRingHeader::producerState values. */
+constexpr std::uint32_t SHM_FRAME_PRODUCER_RUNNING = 1;
+constexpr std::uint32_t SHM_FRAME_PRODUCER_FINISHED = 2;
+
+/** ShmFrameRingHeader::flags: the producer waits for the consumer to take every frame. */
+constexpr std::uint32_t SHM_FRAME_RING_LOSSLESS = 1u << 0;
+
+/**
+ * @brief Description of the frame in one slot, written before it is published.
+ */
+struct ShmFrameSlot
+{
+    std::atomic<std::uint64_t> sequence; ///< Frame number (from 1); 0 = never written
+    std::uint64_t publishNs;             ///< CLOCK_MONOTONIC time of publication in nanoseconds
+    std::uint64_t offset;                ///< Byte offset of the pixels from the start of the mapping
+    std::uint32_t width;                 ///< Frame width in pixels
+    std::uint32_t height;                ///< Frame height in pixels
+    std::uint32_t stride;                ///< Bytes from one row to the next
+    std::uint32_t format;                ///< SHM_FRAME_FORMAT_ARGB8888
+};
+
+/**
+ * @brief Start of the shared mapping.
+ *
+ * The atomics are lock-free and address-free, so they work across processes;
+ * the futex words are plain 32-bit integers in memory.
+ */
+struct ShmFrameRingHeader
+{
+    char magic[8];           ///< "WFSHMRNG"
+    std::uint32_t version;   ///< SHM_FRAME_RING_VERSION in shm_frame_ring.cpp
+    std::uint32_t flags;     ///< SHM_FRAME_RING_LOSSLESS
+    std::uint32_t slotCount; ///< Slots in the ring (3 .. SHM_FRAME_RING_MAX_SLOTS)
+    std::uint32_t width;     ///< Frame width of every slot
+    std::uint32_t height;    ///< Frame height of every slot
+    std::uint32_t stride;    ///< Row pitch of every slot in bytes
+    std::uint32_t format;    ///< SHM_FRAME_FORMAT_ARGB8888
+    std::uint32_t reserved;  ///< Zero
+    std::uint64_t slotBytes; ///< Distance between slots (page multiple)
+    std::uint64_t mapBytes;  ///< Size of the whole mapping
+
+    // Producer side, on its own cache line
+    alignas(64) std::atomic<std::uint64_t> latest; ///< Newest frame: sequence << 8 | slot; 0 = none yet
+    std::atomic<std::uint32_t> frameFutex;         ///< Low 32 bits of the newest sequence; consumers wait here
+    std::atomic<std::uint32_t> producerState;      ///< SHM_FRAME_PRODUCER_RUNNING / _FINISHED
+
+    // Consumer side, on its own cache line
+    alignas(64) std::atomic<std::uint32_t> readingSlot; ///< Slot the consumer reads; SHM_FRAME_NO_SLOT = none
+    std::atomic<std::uint32_t> takenFutex;              ///< Low 32 bits of the newest sequence taken; the producer waits here
+    std::atomic<std::int32_t> consumerPid;              ///< Attached consumer process; 0 = none
+
+    alignas(64) ShmFrameSlot slots[SHM_FRAME_RING_MAX_SLOTS];
+};
+
+/**
+ * @brief Counters of the producing side.
+ */
+struct ShmFrameRingStats
+{
+    std::uint64_t frames = 0;       ///< Frames published
+    std::uint64_t copiedFrames = 0; ///< Frames copied into their slot instead of rendered in place
+    std::uint64_t waits = 0;        ///< Lossless publishes that waited for the consumer
+    double waitSeconds = 0.0;       ///< Time spent in those waits
+    double attachSeconds = 0.0;     ///< Lossless: time the first frame waited for a consumer to attach
+    bool attachTimedOut = false;    ///< Lossless: no consumer attached before the first frame
+};
+
+/**
+ * @brief Producer end of a ring: creates the shared-memory object and publishes frames.
+ *
+ * Used from the thread that renders. Per frame: beginFrame() returns the
+ * slot to draw into, publish() hands it to the consumer.
+ */
+class ShmFrameRing
+{
+public:
+    ShmFrameRing() = default;
+    ~ShmFrameRing();
+
+    ShmFrameRing(const ShmFrameRing &) = delete;
+    ShmFrameRing &operator=(const ShmFrameRing &) = delete;
+
+    /**
+     * @brief Create (or replace) the shared-memory object name and map it.
+     * @param name      POSIX shared-memory name, starting with '/'.
+     * @param width     Frame width in pixels.
+     * @param height    Frame height in pixels.
+     * @param slotCount Frame buffers in the ring (3 .. SHM_FRAME_RING_MAX_SLOTS).
+     * @param lossless  Wait for a consumer to attach before the first frame, and for it
+     *                  to take each frame before publishing the next.
+     * @param error     Receives a message on failure.
+     * @return true on success.
+     */
+    bool open(const char *name, int width, int height, std::uint32_t slotCount, bool lossless, std::string &error);
+
+    bool isOpen() const { return header != nullptr; }
+
+    /**
+     * @brief Lossless rings: block until a consumer has attached, for at most 10 s.
+     *
+     * publish() does this before the first frame; calling it earlier keeps
+     * the wait out of the first frame's time. Returns at once once a
+     * consumer attached or an earlier wait timed out.
+     */
+    void waitForAttach();
+
+    /** Pixels of the slot the next frame goes to: height rows of stride() bytes. */
+    std::uint32_t *beginFrame();
+
+    /** Bytes per row of every slot. */
+    std::size_t stride() const { return header ? header->stride : 0; }
+
+    /**
+     * @brief Publish the slot returned by the last beginFrame() as the newest frame.
+     * @param copied The frame was copied into the slot rather than rendered there (statistics only).
+     */
+    void publish(bool copied);
+
+    /** Tell the consumer no more frames follow, and remove the name (mapped consumers keep the memory). */
+    void finish();
+
+    const ShmFrameRingStats &stats() const { return totals; }
+
+private:
+    void waitForConsumer(std::uint64_t sequence);
+
+    ShmFrameRingHeader *header = nullptr;
+    unsigned char *base = nullptr;
+    std::size_t mapBytes = 0;
+    std::string name;
+    bool linked = false;        ///< name still exists
+    std::uint32_t slot = 0;     ///< Slot of the frame being written
+    std::uint64_t sequence = 0; ///< Sequence of the last published frame
+    ShmFrameRingStats totals;
+};
+
+/**
+ * @brief A frame held by a ShmFrameReader, valid until the next take().
+ */
+struct ShmFrame
+{
+    const std::uint32_t *pixels = nullptr; ///< height rows of stride bytes
+    std::uint64_t sequence = 0;            ///< Frame number
+    std::uint64_t publishNs = 0;           ///< CLOCK_MONOTONIC publication time
+    std::uint32_t width = 0;               ///< Width in pixels
+    std::uint32_t height = 0;              ///< Height in pixels
+    std::uint32_t stride = 0;              ///< Bytes per row
+    std::uint32_t format = 0;              ///< SHM_FRAME_FORMAT_ARGB8888
+    std::uint32_t slot = 0;                ///< Ring slot holding the pixels
+};
+
+/**
+ * @brief Consumer end of a ring: maps an existing object and takes the newest frames in place.
+ */
+class ShmFrameReader
+{
+public:
+    ShmFrameReader() = default;
+    ~ShmFrameReader();
+
+    ShmFrameReader(const ShmFrameReader &) = delete;
+    ShmFrameReader &operator=(const ShmFrameReader &) = delete;
+
+    /**
+     * @brief Map the ring name and attach as its consumer.
+     * @return false (with error set) if it does not exist, is not a frame ring or already has a consumer.
+     */
+    bool open(const char *name, std::string &error);
+
+    /**
+     * @brief Take the newest frame published after the last one taken.
+     *
+     * Releases the previously taken frame. Waits up to timeoutMs for a new
+     * frame (futex wait on frameFutex).
+     *
+     * @return false on timeout, or once the producer finished and the last frame was taken.
+     */
+    bool take(ShmFrame &frame, int timeoutMs);
+
+    /** True if frame's slot still holds frame (the protocol guarantees it while the frame is held). */
+    bool intact(const ShmFrame &frame) const;
+
+    /** True once the producer called finish(). */
+    bool producerFinished() const;
+
+    /** The ring's fixed description. */
+    const ShmFrameRingHeader &ring() const { return *header; }
+
+    /** Release the held frame and detach, leaving the ring to another consumer. */
+    void close();
+
+private:
+    ShmFrameRingHeader *header = nullptr;
+    unsigned char *base = nullptr;
+    std::size_t mapBytes = 0;
+    std::uint64_t lastSequence = 0;
+};
+
+/** CLOCK_MONOTONIC now in nanoseconds, the clock of ShmFrameSlot::publishNs. */
+std::uint64_t shmFrameClockNs();
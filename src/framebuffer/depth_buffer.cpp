@@ -0,0 +1,243 @@
+// depth_buffer.cpp
+// Inverse-depth triangle rasterization and the min/max pyramid used to reject
+// hidden edges in bulk.
+
+#include "depth_buffer.h"
+#include <algorithm>
+#include <cmath>
+
+void DepthBuffer::resize(int newWidth, int newHeight)
+{
+    newWidth = std::max(newWidth, 0);
+    newHeight = std::max(newHeight, 0);
+    if (newWidth == width && newHeight == height)
+        return;
+    width = newWidth;
+    height = newHeight;
+    inverseDepth.assign(static_cast<std::size_t>(width) * static_cast<std::size_t>(height), 0.0f);
+    rowFirst.assign(static_cast<std::size_t>(height), width);
+    rowLast.assign(static_cast<std::size_t>(height), -1);
+    built = PixelRect{0, 0, -1, -1};
+
+    // Halve until a single cell covers the buffer
+    std::size_t levelCount = 0;
+    for (int w = width, h = height; w > 1 || h > 1; w = (w + 1) / 2, h = (h + 1) / 2)
+    {
+        if (pyramid.size() <= levelCount)
+            pyramid.emplace_back();
+        DepthPyramidLevel &level = pyramid[levelCount++];
+        level.width = (w + 1) / 2;
+        level.height = (h + 1) / 2;
+        level.cells.assign(static_cast<std::size_t>(level.width) * static_cast<std::size_t>(level.height), DepthRange{0.0f, 0.0f});
+    }
+    pyramid.resize(levelCount);
+}
+
+// Cells of pyramid level index that cover any pixel of rect
+static PixelRect cellsCovering(const PixelRect &rect, std::size_t index)
+{
+    const int shift = static_cast<int>(index) + 1;
+    return {rect.minX >> shift, rect.minY >> shift, rect.maxX >> shift, rect.maxY >> shift};
+}
+
+void DepthBuffer::clear()
+{
+    for (int row = 0; row < height; ++row)
+    {
+        if (rowFirst[row] > rowLast[row])
+            continue;
+        float *pixels = inverseDepth.data() + static_cast<std::size_t>(row) * static_cast<std::size_t>(width);
+        std::fill(pixels + rowFirst[row], pixels + rowLast[row] + 1, 0.0f);
+        rowFirst[row] = width;
+        rowLast[row] = -1;
+    }
+    if (built.minX > built.maxX)
+        return;
+    for (std::size_t index = 0; index < pyramid.size(); ++index)
+    {
+        DepthPyramidLevel &level = pyramid[index];
+        const PixelRect cells = cellsCovering(built, index);
+        for (int cellY = cells.minY; cellY <= cells.maxY; ++cellY)
+        {
+            DepthRange *row = level.cells.data() + static_cast<std::size_t>(cellY) * level.width;
+            std::fill(row + cells.minX, row + cells.maxX + 1, DepthRange{0.0f, 0.0f});
+        }
+    }
+    built = PixelRect{0, 0, -1, -1};
+}
+
+// ceil / floor for values in [0, INT_MAX]; without SSE4.1 std::ceil and
+// std::floor are library calls, which dominated small triangles
+static int ceilNonNegative(double value)
+{
+    const int truncated = static_cast<int>(value);
+    return truncated + (static_cast<double>(truncated) < value ? 1 : 0);
+}
+
+static int floorNonNegative(double value)
+{
+    return static_cast<int>(value);
+}
+
+void DepthBuffer::drawTriangle(const float x[3], const float y[3], const float d[3], int firstRow, int lastRow)
+{
+    const double x0 = x[0], y0 = y[0];
+    const double area = (static_cast<double>(x[1]) - x0) * (static_cast<double>(y[2]) - y0) -
+                        (static_cast<double>(x[2]) - x0) * (static_cast<double>(y[1]) - y0);
+    if (!(std::fabs(area) > 1e-12))
+        return; // Degenerate (or NaN) triangles cover no pixel center
+
+    // Pixel centers (px + 0.5, py + 0.5) inside the bounding box and the row band
+    const double minY = std::min({y[0], y[1], y[2]}), maxY = std::max({y[0], y[1], y[2]});
+    const double minX = std::min({x[0], x[1], x[2]}), maxX = std::max({x[0], x[1], x[2]});
+    if (!(maxX >= 0.5 && maxY >= 0.5 && minX <= width - 0.5 && minY <= height - 0.5))
+        return;
+    const int rowBegin = std::max(firstRow, ceilNonNegative(std::max(minY - 0.5, 0.0)));
+    const int rowEnd = std::min({lastRow, height - 1, floorNonNegative(std::min(maxY - 0.5, static_cast<double>(height)))});
+    const int columnBegin = ceilNonNegative(std::max(minX - 0.5, 0.0));
+    const int columnEnd = std::min(width - 1, floorNonNegative(std::min(maxX - 0.5, static_cast<double>(width))));
+    if (rowBegin > rowEnd || columnBegin > columnEnd)
+        return;
+
+    // Inverse depth is a plane over the screen
+    const double dd1 = static_cast<double>(d[1]) - d[0], dd2 = static_cast<double>(d[2]) - d[0];
+    const double inverseArea = 1.0 / area;
+    const double gradientX = (dd1 * (static_cast<double>(y[2]) - y0) - dd2 * (static_cast<double>(y[1]) - y0)) * inverseArea;
+    const double gradientY = (dd2 * (static_cast<double>(x[1]) - x0) - dd1 * (static_cast<double>(x[2]) - x0)) * inverseArea;
+
+    // Each non-horizontal side bounds the span from the left or the right; its
+    // x at a row is a linear function of the row (no division in the row
+    // loop). The unused bound gets an infinite bias so the loop has no
+    // branches, which mispredict constantly on small triangles.
+    struct Side
+    {
+        double x, y, step;
+        double beginBias, endBias;
+    } sides[3];
+    for (int corner = 0; corner < 3; ++corner)
+    {
+        const int next = (corner + 1) % 3;
+        const double dx = static_cast<double>(x[next]) - x[corner], dy = static_cast<double>(y[next]) - y[corner];
+        const bool left = (dy < 0.0) == (area > 0.0);
+        if (dy == 0.0)
+            sides[corner] = {x[corner], y[corner], 0.0, INFINITY, INFINITY}; // The other two sides bound the same rows
+        else
+            sides[corner] = {x[corner], y[corner], dx / dy, left ? 0.0 : INFINITY, left ? INFINITY : 0.0};
+    }
+
+    for (int row = rowBegin; row <= rowEnd; ++row)
+    {
+        const double centerY = row + 0.5;
+        double spanBegin = columnBegin + 0.5, spanEnd = columnEnd + 0.5;
+        for (const Side &side : sides)
+        {
+            const double sideX = side.x + (centerY - side.y) * side.step;
+            spanBegin = std::max(spanBegin, sideX - side.beginBias);
+            spanEnd = std::min(spanEnd, sideX + side.endBias);
+        }
+        if (spanBegin > spanEnd)
+            continue;
+
+        // spanBegin >= columnBegin + 0.5 >= 0.5
+        const int first = ceilNonNegative(spanBegin - 0.5);
+        const int last = floorNonNegative(spanEnd - 0.5);
+        if (first > last)
+            continue;
+        float *out = inverseDepth.data() + static_cast<std::size_t>(row) * static_cast<std::size_t>(width);
+        const float startDepth = static_cast<float>(d[0] + gradientY * (centerY - y0) + gradientX * (first + 0.5 - x0));
+        const float step = static_cast<float>(gradientX);
+        for (int k = 0; k <= last - first; ++k)
+        {
+            out[first + k] = std::max(out[first + k], startDepth + step * static_cast<float>(k));
+        }
+        rowFirst[row] = std::min(rowFirst[row], first);
+        rowLast[row] = std::max(rowLast[row], last);
+    }
+}
+
+// Reduce the 2x2 blocks of a sourceWidth x sourceHeight grid into the given
+// cells of level; blocks on an odd last row / column repeat their edge values
+template <typename RangeAt>
+static void reduceLevel(int sourceWidth, int sourceHeight, RangeAt &&rangeAt, const PixelRect &cells, DepthPyramidLevel &level)
+{
+    for (int cellY = cells.minY; cellY <= cells.maxY; ++cellY)
+    {
+        const int top = 2 * cellY, bottom = std::min(top + 1, sourceHeight - 1);
+        DepthRange *out = level.cells.data() + static_cast<std::size_t>(cellY) * level.width;
+        for (int cellX = cells.minX; cellX <= cells.maxX; ++cellX)
+        {
+            const int left = 2 * cellX, right = std::min(left + 1, sourceWidth - 1);
+            const DepthRange a = rangeAt(left, top), b = rangeAt(right, top), c = rangeAt(left, bottom), e = rangeAt(right, bottom);
+            out[cellX] = {std::min(std::min(a.farthest, b.farthest), std::min(c.farthest, e.farthest)),
+                          std::max(std::max(a.nearest, b.nearest), std::max(c.nearest, e.nearest))};
+        }
+    }
+}
+
+void DepthBuffer::buildPyramid()
+{
+    // Only cells over drawn pixels can differ from the cleared state
+    built = PixelRect{width, height, -1, -1};
+    for (int row = 0; row < height; ++row)
+    {
+        if (rowFirst[row] > rowLast[row])
+            continue;
+        built.minX = std::min(built.minX, rowFirst[row]);
+        built.maxX = std::max(built.maxX, rowLast[row]);
+        built.minY = std::min(built.minY, row);
+        built.maxY = row;
+    }
+    if (pyramid.empty() || built.minX > built.maxX)
+    {
+        built = PixelRect{0, 0, -1, -1};
+        return;
+    }
+
+    const float *pixels = inverseDepth.data();
+    const std::size_t stride = static_cast<std::size_t>(width);
+    reduceLevel(width, height, [pixels, stride](int px, int py)
+                {
+                    const float depth = pixels[static_cast<std::size_t>(py) * stride + px];
+                    return DepthRange{depth, depth}; }, cellsCovering(built, 0), pyramid[0]);
+    for (std::size_t index = 1; index < pyramid.size(); ++index)
+    {
+        const DepthPyramidLevel &finer = pyramid[index - 1];
+        reduceLevel(finer.width, finer.height, [&finer](int cellX, int cellY)
+                    { return finer.cells[static_cast<std::size_t>(cellY) * finer.width + cellX]; }, cellsCovering(built, index), pyramid[index]);
+    }
+}
+
+DepthTest DepthBuffer::testLine(int x0, int y0, int x1, int y1, float d0, float d1) const
+{
+    const int minX = std::min(x0, x1), maxX = std::max(x0, x1), minY = std::min(y0, y1), maxY = std::max(y0, y1);
+    if (maxX < 0 || maxY < 0 || minX >= width || minY >= height)
+        return DepthTest::Visible;
+    if (minX < 0 || minY < 0 || maxX >= width || maxY >= height || pyramid.empty())
+        return DepthTest::Partial;
+
+    // Finest level where the rectangle spans at most 2x2 cells
+    std::size_t index = 0;
+    int shift = 1;
+    while (index + 1 < pyramid.size() && ((maxX >> shift) - (minX >> shift) > 1 || (maxY >> shift) - (minY >> shift) > 1))
+    {
+        ++index;
+        ++shift;
+    }
+    const DepthPyramidLevel &level = pyramid[index];
+    DepthRange range{INFINITY, 0.0f};
+    for (int cellY = minY >> shift; cellY <= (maxY >> shift); ++cellY)
+    {
+        for (int cellX = minX >> shift; cellX <= (maxX >> shift); ++cellX)
+        {
+            const DepthRange &cell = level.cells[static_cast<std::size_t>(cellY) * level.width + cellX];
+            range.farthest = std::min(range.farthest, cell.farthest);
+            range.nearest = std::max(range.nearest, cell.nearest);
+        }
+    }
+
+    if (std::max(d0, d1) * slack < range.farthest)
+        return DepthTest::Hidden;
+    if (std::min(d0, d1) * slack >= range.nearest)
+        return DepthTest::Visible;
+    return DepthTest::Partial;
+}
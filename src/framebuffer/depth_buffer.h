@@ -0,0 +1,169 @@
+/**
+ * @file depth_buffer.h
+ * @brief Depth-only target and min/max depth pyramid for hidden-line removal.
+ *
+ * Solid faces are rasterized as inverse view depth (1 / w). Inverse depth is
+ * linear in screen space, so it interpolates exactly across triangles and
+ * along lines; 0 means nothing was drawn there (infinitely far) and larger
+ * values are nearer. A line pixel is visible if it is not behind the stored
+ * depth by more than the tolerance.
+ *
+ * After the faces are in, buildPyramid() reduces the buffer into levels of
+ * 2x2, 4x4, ... pixel cells, each holding the farthest and nearest depth in
+ * the cell. An edge whose nearest point is behind the farthest face depth
+ * over its screen rectangle is hidden at every pixel and can be dropped with
+ * a handful of lookups; an edge entirely in front of the nearest depth needs
+ * no per-pixel test.
+ *
+ * The buffer remembers which pixels were drawn, so clearing and building the
+ * pyramid cost in proportion to the area the faces cover, not the target.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * @brief Result of testing an edge against the depth pyramid.
+ */
+enum class DepthTest
+{
+    Hidden,  ///< Behind the faces at every pixel it can touch
+    Visible, ///< In front of every face it can touch
+    Partial  ///< Needs the per-pixel test
+};
+
+/**
+ * @brief Farthest and nearest stored inverse depth over a cell.
+ */
+struct DepthRange
+{
+    float farthest; ///< Smallest inverse depth
+    float nearest;  ///< Largest inverse depth
+};
+
+/**
+ * @brief Inclusive rectangle of pixels or cells (empty when minX > maxX).
+ */
+struct PixelRect
+{
+    int minX, minY, maxX, maxY;
+};
+
+/**
+ * @brief One reduction level of the pyramid.
+ */
+struct DepthPyramidLevel
+{
+    int width = 0, height = 0;    ///< Cells per row / column
+    std::vector<DepthRange> cells; ///< width * height ranges, row-major
+};
+
+/**
+ * @brief Row-major inverse-depth buffer with its min/max pyramid.
+ */
+struct DepthBuffer
+{
+    int width = 0;                          ///< Width in pixels
+    int height = 0;                         ///< Height in pixels
+    std::vector<float> inverseDepth;        ///< width * height values, 0 = empty
+    std::vector<DepthPyramidLevel> pyramid; ///< Level i has cells of 2^(i+1) pixels
+    float slack = 1.0f;                     ///< A line pixel at inverse depth d passes if d * slack >= stored
+    std::vector<int> rowFirst, rowLast;     ///< Drawn columns per row since the last clear() (first > last = none)
+    PixelRect built = {0, 0, -1, -1};       ///< Pixels the pyramid was last built over
+
+    /** Resize the buffer and pyramid; a buffer that changes size comes back empty. */
+    void resize(int newWidth, int newHeight);
+
+    /** Mark every pixel empty (only the drawn rows and built cells are touched). */
+    void clear();
+
+    /**
+     * @brief Accept line pixels up to relativeDepth * depth behind the faces.
+     *
+     * Edges lie on their own faces, so they need some slack to survive the
+     * rounding of pixel positions and interpolation.
+     */
+    void setTolerance(float relativeDepth) { slack = 1.0f + relativeDepth; }
+
+    /**
+     * @brief Rasterize a triangle, keeping the nearest depth per pixel.
+     *
+     * Covers the pixels whose centers lie inside the triangle (either
+     * winding), restricted to rows [firstRow, lastRow] so disjoint row bands
+     * can be filled by different threads.
+     *
+     * @param x, y         Screen positions of the three corners.
+     * @param inverseDepth 1 / view depth of the three corners.
+     */
+    void drawTriangle(const float x[3], const float y[3], const float inverseDepth[3], int firstRow, int lastRow);
+
+    /** Rebuild the pyramid from the buffer (call after the last triangle). */
+    void buildPyramid();
+
+    /**
+     * @brief Classify a line from (x0,y0) to (x1,y1) with endpoint inverse depths d0, d1.
+     *
+     * Looks at no more than four pyramid cells. Parts of the line outside
+     * the buffer count as visible.
+     */
+    DepthTest testLine(int x0, int y0, int x1, int y1, float d0, float d1) const;
+
+    /** True if a line pixel at offset y * width + x with inverse depth d is visible. */
+    bool visible(std::size_t offset, float d) const { return d * slack >= inverseDepth[offset]; }
+
+    /**
+     * @brief Split a line into runs of visible pixels.
+     *
+     * Steps the same pixels as Framebuffer::drawLine and calls
+     * emit(startX, startY, endX, endY) for each maximal visible run.
+     * Pixels outside the buffer count as visible.
+     */
+    template <typename Emit>
+    void forEachVisibleRun(int x0, int y0, int x1, int y1, float d0, float d1, Emit &&emit) const
+    {
+        const std::int64_t dx = static_cast<std::int64_t>(x1) - x0, dy = static_cast<std::int64_t>(y1) - y0;
+        const bool xMajor = std::llabs(dx) >= std::llabs(dy);
+        const std::int64_t n = xMajor ? std::llabs(dx) : std::llabs(dy), m = xMajor ? std::llabs(dy) : std::llabs(dx);
+        const int majorSign = ((xMajor ? dx : dy) < 0) ? -1 : 1, minorSign = ((xMajor ? dy : dx) < 0) ? -1 : 1;
+        const float depthStep = n > 0 ? (d1 - d0) / static_cast<float>(n) : 0.0f;
+
+        bool inRun = false;
+        int runX = 0, runY = 0, lastX = 0, lastY = 0;
+        std::int64_t remainder = n;
+        int major = 0, minor = 0;
+        for (std::int64_t i = 0; i <= n; ++i)
+        {
+            const int x = xMajor ? x0 + major : x0 + minor, y = xMajor ? y0 + minor : y0 + major;
+            const bool inside = x >= 0 && x < width && y >= 0 && y < height;
+            const bool pass = !inside || visible(static_cast<std::size_t>(y) * static_cast<std::size_t>(width) + static_cast<std::size_t>(x),
+                                                 d0 + depthStep * static_cast<float>(i));
+            if (pass && !inRun)
+            {
+                runX = x;
+                runY = y;
+                inRun = true;
+            }
+            else if (!pass && inRun)
+            {
+                emit(runX, runY, lastX, lastY);
+                inRun = false;
+            }
+            lastX = x;
+            lastY = y;
+
+            // Bresenham midpoint stepping, as in framebuffer.cpp
+            major += majorSign;
+            remainder += 2 * m;
+            if (remainder >= 2 * n)
+            {
+                remainder -= 2 * n;
+                minor += minorSign;
+            }
+        }
+        if (inRun)
+            emit(runX, runY, lastX, lastY);
+    }
+};
@@ -0,0 +1,171 @@
+// framebuffer.cpp
+// Software rasterization of points and lines into a CPU-owned framebuffer.
+//
+// Line stepping: for a major-axis length n and minor-axis length m (m <= n),
+// the pixel at step i is offset along the minor axis by
+//     k(i) = floor((2*i*m + n) / (2*n))
+// which is Bresenham's midpoint rule written in closed form. Because k(i) is
+// monotonic, the visible step range for a clip rectangle can be solved
+// directly and stepping then resumes incrementally from the first visible
+// step without walking the invisible part of the line.
+
+#include "framebuffer.h"
+#include "depth_buffer.h"
+#include <algorithm>
+#include <cstdlib>
+
+// Keeps every intermediate of the step math comfortably inside int64
+constexpr float MAX_PIXEL_COORDINATE = 268435456.0f; // 2^28
+
+int toPixelCoordinate(float value)
+{
+    if (!(value > -MAX_PIXEL_COORDINATE))
+        return -static_cast<int>(MAX_PIXEL_COORDINATE);
+    if (!(value < MAX_PIXEL_COORDINATE))
+        return static_cast<int>(MAX_PIXEL_COORDINATE);
+    return static_cast<int>(value);
+}
+
+void Framebuffer::resize(int newWidth, int newHeight)
+{
+    width = std::max(newWidth, 0);
+    height = std::max(newHeight, 0);
+    storage.resize(pixelCount());
+    pixels = storage.data();
+}
+
+void Framebuffer::attach(std::uint32_t *memory, int newWidth, int newHeight)
+{
+    width = std::max(newWidth, 0);
+    height = std::max(newHeight, 0);
+    pixels = memory;
+}
+
+void Framebuffer::clear(std::uint32_t color)
+{
+    std::fill(pixels, pixels + pixelCount(), color);
+}
+
+void Framebuffer::drawPoint(int x, int y, std::uint32_t color, const ClipRect &clip)
+{
+    if (x < clip.minX || x > clip.maxX || y < clip.minY || y > clip.maxY)
+        return;
+    if (x < 0 || x >= width || y < 0 || y >= height)
+        return;
+    pixels[static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)] = color;
+}
+
+// Smallest integer >= a / b for b > 0
+static std::int64_t ceilDiv(std::int64_t a, std::int64_t b)
+{
+    return (a >= 0) ? (a + b - 1) / b : -((-a) / b);
+}
+
+// Largest integer <= a / b for b > 0
+static std::int64_t floorDiv(std::int64_t a, std::int64_t b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+// Visit the pixels of the segment (x0,y0)-(x1,y1) inside clip as
+// plot(pixelOffset, step), where step counts from (x0,y0) along the major axis
+template <typename Plot>
+static void traceLine(int width, int height, int x0, int y0, int x1, int y1, const ClipRect &clip, Plot &&plot)
+{
+    // Restrict the clip rect to the buffer so writes can never go out of range
+    const int clipMinX = std::max(clip.minX, 0), clipMaxX = std::min(clip.maxX, width - 1);
+    const int clipMinY = std::max(clip.minY, 0), clipMaxY = std::min(clip.maxY, height - 1);
+    if (clipMinX > clipMaxX || clipMinY > clipMaxY)
+        return;
+
+    const std::int64_t dx = static_cast<std::int64_t>(x1) - x0;
+    const std::int64_t dy = static_cast<std::int64_t>(y1) - y0;
+    const bool xMajor = std::llabs(dx) >= std::llabs(dy);
+
+    // Express the line in (major, minor) axes so one loop handles both octant families
+    const std::int64_t major0 = xMajor ? x0 : y0, minor0 = xMajor ? y0 : x0;
+    const std::int64_t majorDelta = xMajor ? dx : dy, minorDelta = xMajor ? dy : dx;
+    const std::int64_t majorLo = xMajor ? clipMinX : clipMinY, majorHi = xMajor ? clipMaxX : clipMaxY;
+    const std::int64_t minorLo = xMajor ? clipMinY : clipMinX, minorHi = xMajor ? clipMaxY : clipMaxX;
+    const std::int64_t majorSign = (majorDelta < 0) ? -1 : 1, minorSign = (minorDelta < 0) ? -1 : 1;
+    const std::int64_t n = std::llabs(majorDelta), m = std::llabs(minorDelta);
+
+    // Visible steps along the major axis
+    std::int64_t first = 0, last = n;
+    if (majorSign > 0)
+    {
+        first = std::max(first, majorLo - major0);
+        last = std::min(last, majorHi - major0);
+    }
+    else
+    {
+        first = std::max(first, major0 - majorHi);
+        last = std::min(last, major0 - majorLo);
+    }
+
+    // Visible minor offsets k, then the steps whose k(i) falls inside them
+    const std::int64_t kLo = (minorSign > 0) ? minorLo - minor0 : minor0 - minorHi;
+    const std::int64_t kHi = (minorSign > 0) ? minorHi - minor0 : minor0 - minorLo;
+    if (kHi < 0)
+        return;
+    if (m == 0)
+    {
+        if (kLo > 0)
+            return;
+    }
+    else
+    {
+        if (kLo > 0)
+            first = std::max(first, ceilDiv(2 * n * kLo - n, 2 * m));
+        last = std::min(last, floorDiv(2 * n * (kHi + 1) - n - 1, 2 * m));
+    }
+    if (first > last)
+        return;
+
+    // Resume the incremental stepping at the first visible step
+    const std::int64_t twoN = 2 * n, twoM = 2 * m;
+    const std::int64_t numerator = 2 * first * m + n;
+    const std::int64_t k = (n == 0) ? 0 : numerator / twoN;
+    std::int64_t remainder = (n == 0) ? 0 : numerator % twoN;
+
+    const std::int64_t majorPos = major0 + majorSign * first;
+    const std::int64_t minorPos = minor0 + minorSign * k;
+    const std::int64_t px = xMajor ? majorPos : minorPos, py = xMajor ? minorPos : majorPos;
+    std::ptrdiff_t pixel = static_cast<std::ptrdiff_t>(py * width + px);
+
+    const std::ptrdiff_t majorStep = xMajor ? majorSign : majorSign * width;
+    const std::ptrdiff_t minorStep = xMajor ? minorSign * width : minorSign;
+
+    for (std::int64_t i = first;; ++i)
+    {
+        plot(pixel, i);
+        if (i == last)
+            break;
+        pixel += majorStep;
+        remainder += twoM;
+        if (remainder >= twoN)
+        {
+            remainder -= twoN;
+            pixel += minorStep;
+        }
+    }
+}
+
+void Framebuffer::drawLine(int x0, int y0, int x1, int y1, std::uint32_t color, const ClipRect &clip)
+{
+    std::uint32_t *out = pixels;
+    traceLine(width, height, x0, y0, x1, y1, clip, [out, color](std::ptrdiff_t pixel, std::int64_t) { out[pixel] = color; });
+}
+
+void Framebuffer::drawLineDepthTested(int x0, int y0, int x1, int y1, float depth0, float depth1, std::uint32_t color, const ClipRect &clip,
+                                      const DepthBuffer &depth)
+{
+    // Inverse depth is linear along the major axis
+    const std::int64_t steps = std::max(std::llabs(static_cast<std::int64_t>(x1) - x0), std::llabs(static_cast<std::int64_t>(y1) - y0));
+    const float depthStep = steps > 0 ? (depth1 - depth0) / static_cast<float>(steps) : 0.0f;
+    std::uint32_t *out = pixels;
+    traceLine(width, height, x0, y0, x1, y1, clip, [&](std::ptrdiff_t pixel, std::int64_t step)
+              {
+                  if (depth.visible(static_cast<std::size_t>(pixel), depth0 + depthStep * static_cast<float>(step)))
+                      out[pixel] = color; });
+}
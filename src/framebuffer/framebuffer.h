@@ -0,0 +1,104 @@
+/**
+ * @file framebuffer.h
+ * @brief CPU-owned 32-bit framebuffer with clipped point and line drawing.
+ *
+ * Used by the software render backend: the frame is rasterized here and
+ * uploaded to the window with a single texture update per frame.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct DepthBuffer;
+
+/**
+ * @brief Pack an RGB color (0..255 per channel) into opaque ARGB8888.
+ */
+inline std::uint32_t packColor(int red, int green, int blue)
+{
+    return 0xFF000000u | (static_cast<std::uint32_t>(red & 0xFF) << 16) |
+           (static_cast<std::uint32_t>(green & 0xFF) << 8) | static_cast<std::uint32_t>(blue & 0xFF);
+}
+
+/**
+ * @brief Convert a projected coordinate to an integer pixel coordinate.
+ *
+ * Truncates toward zero like the SDL_Renderer path, but clamps far
+ * off-screen values (and NaN) so the integer line math cannot overflow.
+ */
+int toPixelCoordinate(float value);
+
+/**
+ * @brief Inclusive pixel rectangle that drawing is restricted to.
+ */
+struct ClipRect
+{
+    int minX, minY; ///< Top-left pixel (inclusive)
+    int maxX, maxY; ///< Bottom-right pixel (inclusive)
+};
+
+/**
+ * @brief Row-major ARGB8888 pixel buffer.
+ *
+ * Lines use an integer Bresenham stepping whose pixel at step i has a closed
+ * form, so clipping only changes which steps are visited, never which pixels
+ * are produced. Drawing a line once against the whole buffer or piecewise
+ * against disjoint clip rects that cover it yields the same pixels.
+ */
+struct Framebuffer
+{
+    int width = 0;                       ///< Width in pixels
+    int height = 0;                      ///< Height in pixels
+    std::uint32_t *pixels = nullptr;     ///< width * height pixels, row-major (storage or attached memory)
+    std::vector<std::uint32_t> storage; ///< Owned pixels; unused while attached
+
+    Framebuffer() = default;
+    Framebuffer(const Framebuffer &) = delete; // pixels may point into storage
+    Framebuffer &operator=(const Framebuffer &) = delete;
+    Framebuffer(Framebuffer &&) = default;
+    Framebuffer &operator=(Framebuffer &&) = default;
+
+    /** Resize the owned buffer and draw into it; contents are unspecified until the next clear(). */
+    void resize(int newWidth, int newHeight);
+
+    /**
+     * @brief Draw into memory owned by the caller (a shared-memory frame slot)
+     *        until the next attach() or resize().
+     *
+     * memory must hold newWidth * newHeight pixels with rows packed (pitch()).
+     */
+    void attach(std::uint32_t *memory, int newWidth, int newHeight);
+
+    /** width * height. */
+    std::size_t pixelCount() const { return static_cast<std::size_t>(width) * static_cast<std::size_t>(height); }
+
+    /** Fill the whole buffer with color. */
+    void clear(std::uint32_t color);
+
+    /** Bytes per row, as expected by SDL_UpdateTexture. */
+    int pitch() const { return width * static_cast<int>(sizeof(std::uint32_t)); }
+
+    /** Rectangle covering the whole buffer. */
+    ClipRect bounds() const { return {0, 0, width - 1, height - 1}; }
+
+    /** Plot one pixel if it lies inside clip. */
+    void drawPoint(int x, int y, std::uint32_t color, const ClipRect &clip);
+
+    /** Draw the segment (x0,y0)-(x1,y1), endpoints included, restricted to clip. */
+    void drawLine(int x0, int y0, int x1, int y1, std::uint32_t color, const ClipRect &clip);
+
+    /**
+     * @brief drawLine, but only the pixels that pass depth's visibility test.
+     *
+     * depth must have the framebuffer's size. depth0 and depth1 are the
+     * inverse view depths of the endpoints.
+     */
+    void drawLineDepthTested(int x0, int y0, int x1, int y1, float depth0, float depth1, std::uint32_t color, const ClipRect &clip,
+                             const DepthBuffer &depth);
+
+    /** Convenience overloads clipped to the whole buffer. */
+    void drawPoint(int x, int y, std::uint32_t color) { drawPoint(x, y, color, bounds()); }
+    void drawLine(int x0, int y0, int x1, int y1, std::uint32_t color) { drawLine(x0, y0, x1, y1, color, bounds()); }
+};
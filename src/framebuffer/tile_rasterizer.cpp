@@ -0,0 +1,118 @@
+// tile_rasterizer.cpp
+// Screen-tile binning and parallel per-tile line rasterization.
+
+#include "tile_rasterizer.h"
+#include "depth_buffer.h"
+#include "../threading/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+static void drawSegment(Framebuffer &framebuffer, const ScreenSegment &segment, const ClipRect &clip, const DepthBuffer *depth)
+{
+    if (depth)
+        framebuffer.drawLineDepthTested(segment.x0, segment.y0, segment.x1, segment.y1, segment.depth0, segment.depth1, segment.color, clip, *depth);
+    else
+        framebuffer.drawLine(segment.x0, segment.y0, segment.x1, segment.y1, segment.color, clip);
+}
+
+void rasterizeSegments(Framebuffer &framebuffer, const std::vector<ScreenSegment> &segments, const DepthBuffer *depth)
+{
+    const ClipRect clip = framebuffer.bounds();
+    for (const ScreenSegment &segment : segments)
+    {
+        drawSegment(framebuffer, segment, clip, depth);
+    }
+}
+
+// Call visit(tileX, tileY) for every tile the segment may touch. Per tile row,
+// the ideal line is evaluated over the row band widened by one pixel and the
+// resulting x span is widened by one more pixel; Bresenham pixels never stray
+// more than half a pixel from the ideal line, so no touched tile is missed.
+template <typename Visit>
+static void forEachTouchedTile(const ScreenSegment &segment, int width, int height, int tileSize, Visit &&visit)
+{
+    const int minX = std::max(std::min(segment.x0, segment.x1), 0);
+    const int maxX = std::min(std::max(segment.x0, segment.x1), width - 1);
+    const int minY = std::max(std::min(segment.y0, segment.y1), 0);
+    const int maxY = std::min(std::max(segment.y0, segment.y1), height - 1);
+    if (minX > maxX || minY > maxY)
+        return;
+
+    const double dx = static_cast<double>(segment.x1) - segment.x0;
+    const double dy = static_cast<double>(segment.y1) - segment.y0;
+
+    for (int tileY = minY / tileSize; tileY <= maxY / tileSize; ++tileY)
+    {
+        int spanMinX = minX, spanMaxX = maxX;
+        if (dy != 0.0)
+        {
+            const double bandTop = static_cast<double>(tileY * tileSize) - 1.0;
+            const double bandBottom = static_cast<double>(tileY * tileSize + tileSize - 1) + 1.0;
+            const double xAtTop = segment.x0 + dx * (bandTop - segment.y0) / dy;
+            const double xAtBottom = segment.x0 + dx * (bandBottom - segment.y0) / dy;
+            const double low = std::min(xAtTop, xAtBottom) - 1.0, high = std::max(xAtTop, xAtBottom) + 1.0;
+            spanMinX = std::max(spanMinX, static_cast<int>(std::max(std::floor(low), static_cast<double>(minX))));
+            spanMaxX = std::min(spanMaxX, static_cast<int>(std::min(std::ceil(high), static_cast<double>(maxX))));
+        }
+        for (int tileX = spanMinX / tileSize; tileX <= spanMaxX / tileSize && spanMinX <= spanMaxX; ++tileX)
+        {
+            visit(tileX, tileY);
+        }
+    }
+}
+
+void binSegments(const std::vector<ScreenSegment> &segments, int width, int height, TileBins &bins)
+{
+    const int tileSize = std::max(bins.tileSize, 1);
+    bins.tilesX = (width + tileSize - 1) / tileSize;
+    bins.tilesY = (height + tileSize - 1) / tileSize;
+    const size_t tileCount = static_cast<size_t>(bins.tilesX) * static_cast<size_t>(bins.tilesY);
+    bins.offsets.assign(tileCount + 1, 0);
+    if (tileCount == 0)
+    {
+        bins.segmentIndices.clear();
+        return;
+    }
+
+    // Count per tile into offsets[tile + 1]
+    for (const ScreenSegment &segment : segments)
+    {
+        forEachTouchedTile(segment, width, height, tileSize, [&](int tileX, int tileY)
+                           { ++bins.offsets[static_cast<size_t>(tileY) * bins.tilesX + tileX + 1]; });
+    }
+
+    // offsets[tile + 1] becomes the tile's start; the fill pass advances it to the tile's end
+    std::uint32_t total = 0;
+    for (size_t tile = 0; tile < tileCount; ++tile)
+    {
+        const std::uint32_t count = bins.offsets[tile + 1];
+        bins.offsets[tile + 1] = total;
+        total += count;
+    }
+    bins.segmentIndices.resize(total);
+
+    for (size_t index = 0; index < segments.size(); ++index)
+    {
+        forEachTouchedTile(segments[index], width, height, tileSize, [&](int tileX, int tileY)
+                           { bins.segmentIndices[bins.offsets[static_cast<size_t>(tileY) * bins.tilesX + tileX + 1]++] = static_cast<std::uint32_t>(index); });
+    }
+}
+
+void rasterizeSegmentsTiled(Framebuffer &framebuffer, const std::vector<ScreenSegment> &segments, TileBins &bins, ThreadPool &pool,
+                            const DepthBuffer *depth)
+{
+    binSegments(segments, framebuffer.width, framebuffer.height, bins);
+
+    const size_t tileCount = static_cast<size_t>(bins.tilesX) * static_cast<size_t>(bins.tilesY);
+    pool.parallelFor(tileCount, [&](size_t tile, unsigned)
+                     {
+                         const int tileX = static_cast<int>(tile % static_cast<size_t>(bins.tilesX));
+                         const int tileY = static_cast<int>(tile / static_cast<size_t>(bins.tilesX));
+                         const ClipRect clip = {tileX * bins.tileSize, tileY * bins.tileSize,
+                                                std::min(tileX * bins.tileSize + bins.tileSize, framebuffer.width) - 1,
+                                                std::min(tileY * bins.tileSize + bins.tileSize, framebuffer.height) - 1};
+                         for (std::uint32_t entry = bins.offsets[tile]; entry < bins.offsets[tile + 1]; ++entry)
+                         {
+                             drawSegment(framebuffer, segments[bins.segmentIndices[entry]], clip, depth);
+                         } });
+}
@@ -0,0 +1,43 @@
+/**
+ * @file tile_rasterizer.h
+ * @brief Single-threaded and tile-parallel rasterization of screen segments.
+ *
+ * Both paths produce identical pixels: tiles partition the screen, each tile
+ * draws its binned segments in submission order, and Framebuffer::drawLine
+ * yields the same pixels whether a segment is clipped to the whole buffer or
+ * to each tile it touches.
+ */
+#pragma once
+
+#include <vector>
+#include "../app_state/app_state.h"    // ScreenSegment, TileBins
+#include "../framebuffer/framebuffer.h" // Framebuffer
+
+class ThreadPool;
+struct DepthBuffer;
+
+/**
+ * @brief Draw all segments in order, clipped to the framebuffer.
+ *
+ * With a depth buffer (hidden-line mode) each pixel is drawn only if it
+ * passes the depth test, using the segment's endpoint depths.
+ */
+void rasterizeSegments(Framebuffer &framebuffer, const std::vector<ScreenSegment> &segments, const DepthBuffer *depth = nullptr);
+
+/**
+ * @brief Sort segments into the screen tiles they may touch.
+ *
+ * Binning is conservative (a segment may be listed for a tile it misses by
+ * a pixel) and keeps submission order within each tile. Reuses the storage
+ * already held by bins.
+ */
+void binSegments(const std::vector<ScreenSegment> &segments, int width, int height, TileBins &bins);
+
+/**
+ * @brief Bin the segments and rasterize the tiles in parallel on pool.
+ *
+ * Produces exactly the same framebuffer contents as rasterizeSegments for
+ * any thread count, with or without a depth buffer.
+ */
+void rasterizeSegmentsTiled(Framebuffer &framebuffer, const std::vector<ScreenSegment> &segments, TileBins &bins, ThreadPool &pool,
+                            const DepthBuffer *depth = nullptr);
@@ -4,10 +4,27 @@
 #include "input.h"
 #include "../app_state/app_state.h"
 #include "../3d_objects/objects_3d.h"
+#include "../mesh_io/background_loader.h"
 
 // A single global helper is sufficient to construct primitives on demand.
 static Objects3d g_objects3d;
 
+// Build a primitive or stress scene on the loader thread when there is one;
+// the current object stays on screen until the new one is ready
+static bool requestMesh(RenderState *state, MeshRequest::Kind kind, GeneratorKind generator, int red, int green, int blue)
+{
+    if (!state->meshLoader)
+        return false;
+    MeshRequest request;
+    request.kind = kind;
+    request.generator = generator;
+    request.red = red;
+    request.green = green;
+    request.blue = blue;
+    state->meshLoader->request(request);
+    return true;
+}
+
 bool handleEvent(RenderState *state, const SDL_Event &event)
 {
     if (event.type == SDL_QUIT)
@@ -24,6 +41,12 @@ bool handleEvent(RenderState *state, const SDL_Event &event)
             state->screenHeight = event.window.data2;
             return true;
         }
+        if (event.window.event == SDL_WINDOWEVENT_EXPOSED)
+        {
+            // Window contents were lost; repaint even if nothing else changed
+            state->redrawRequested = true;
+            return true;
+        }
     }
 
     if (event.type == SDL_KEYDOWN)
@@ -36,12 +59,43 @@ bool handleEvent(RenderState *state, const SDL_Event &event)
         case SDLK_1:    // top-row '1'
         case SDLK_KP_1: // keypad '1'
         case SDLK_c:
-            g_objects3d.makeCube(*state, 1, 255, 0, 0);
+            if (!requestMesh(state, MeshRequest::Kind::Cube, GeneratorKind::UvSphere, 255, 0, 0))
+                g_objects3d.makeCube(*state, 1, 255, 0, 0);
             return true;
         case SDLK_2:    // top-row '2'
         case SDLK_KP_2: // keypad '2'
         case SDLK_p:
-            g_objects3d.makePyramid(*state, 1, 0, 0, 255);
+            if (!requestMesh(state, MeshRequest::Kind::Pyramid, GeneratorKind::UvSphere, 0, 0, 255))
+                g_objects3d.makePyramid(*state, 1, 0, 0, 255);
+            return true;
+        case SDLK_3: // Stress scenes at their default resolution
+        case SDLK_4:
+        case SDLK_5:
+        case SDLK_6:
+        case SDLK_7:
+        case SDLK_8:
+        {
+            const GeneratorKind kind = static_cast<GeneratorKind>(event.key.keysym.sym - SDLK_3);
+            if (requestMesh(state, MeshRequest::Kind::Generator, kind, 0, 255, 0))
+                return true;
+            if (!g_objects3d.generate(*state, kind, defaultGeneratorResolution(kind), 0, 255, 0))
+                SDL_Log("Failed to generate %s", generatorName(kind));
+            return true;
+        }
+        case SDLK_b:
+            state->backend = (state->backend == RenderBackend::Software) ? RenderBackend::SdlRenderer : RenderBackend::Software;
+            return true;
+        case SDLK_h:
+            state->hiddenLines = !state->hiddenLines;
+            state->redrawRequested = true;
+            return true;
+        case SDLK_o:
+            state->profiler.overlay = !state->profiler.overlay;
+            state->redrawRequested = true;
+            return true;
+        case SDLK_d:
+            state->profiler.dumpRequested = true;
+            state->redrawRequested = true;
             return true;
         default:
             break;
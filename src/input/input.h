@@ -16,6 +16,7 @@
  *      Esc: quit
  *      C / 1:   create cube primitive
  *      P / 2:   create pyramid primitive
+ *      B:       toggle SDL_Renderer / software framebuffer backend
  *
  * @param state Mutable application state
  * @param event SDL event to handle
@@ -5,34 +5,298 @@
 #include "2d_renderer/2d_renderer.h" // renderer_run declaration
 #include "app_state/app_state.h"
 #include "3d_objects/objects_3d.h"
+#include "cli/cli.h"
+#include "framebuffer/framebuffer.h" // packColor
+#include "mesh_io/background_loader.h"
+#include "mesh_io/mesh_cache.h"
+#include "mesh_io/mesh_loader.h"
+#include "mesh_io/point_stream.h"
+#include "replay/input_trace.h"
+#include "scene/scene.h"
+#include "3d_renderer/geometry_view.h" // syncGeometry
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
 
 /**
  * @brief Program entry: configures the scene and starts the renderer.
  */
-int main()
+int main(int argc, char **argv)
 {
     RenderState state;
     Objects3d objects3d;
+    LaunchOptions options;
+    MeshCache meshCache; // Mapped geometry drawn in place; outlives the render loop
+    InputRecorder inputRecorder;
+    InputReplay inputReplay;
+    BackgroundMeshLoader meshLoader; // Destroyed before state; frees the meshes it installed
+    MeshRequest watchRequest;        // --watch: how to reload the --load mesh
+    PointStream pointStream;         // --stream: mapped file drawn chunk by chunk
 
-    state.screenWidth = 1000;
-    state.screenHeight = 1000;
+    if (!parseCommandLine(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (options.showHelp)
+    {
+        printUsage(argv[0]);
+        return 0;
+    }
+
+    state.screenWidth = options.width;
+    state.screenHeight = options.height;
 
     // Projection parameters (tweak to change perspective strength)
     state.focalLength = 100000.0f;
     state.viewerDistance = 500.0f;
 
-    // Angular velocities (deg/sec)
-    state.rotateSpeedX = 50;
-    state.rotateSpeedY = -25;
-    state.rotateSpeedZ = 10;
+    // Angular velocities (deg/sec); all 0 leaves the loop idle between changes
+    state.rotateSpeedX = options.rotateSpeed[0];
+    state.rotateSpeedY = options.rotateSpeed[1];
+    state.rotateSpeedZ = options.rotateSpeed[2];
 
     // Starting angles
-    state.angleX = 20;
-    state.angleY = 30;
-    state.angleZ = 40;
+    state.angleX = options.startAngles[0];
+    state.angleY = options.startAngles[1];
+    state.angleZ = options.startAngles[2];
+
+    // Rasterization backend (B toggles it while running)
+    state.backend = options.backend;
+    state.rasterThreads = options.rasterThreads;
+
+    // Frame preparation on a worker thread, overlapping present
+    state.pipelined = options.pipelined;
+
+    // Depth-tested wireframe (H toggles it while running)
+    state.hiddenLines = options.hiddenLines;
+
+    // Loop variants specialized per object, or the per-element reference path
+    state.specializedPipeline = !options.genericPipeline;
+
+    // Stage timers (O toggles the overlay, D exports the history)
+    state.profiler.enabled = options.profile;
+    state.profiler.csvPath = options.profilePath;
+
+    // --write-stream with a generated point cloud: sample it straight into the
+    // file, so clouds larger than memory can be written
+    if (options.writeStreamPath && options.generate && options.generator == GeneratorKind::PointCloud)
+    {
+        const int count = options.generatorResolution > 0 ? options.generatorResolution : defaultGeneratorResolution(options.generator);
+        const auto start = std::chrono::steady_clock::now();
+        PointStreamWriter writer;
+        PointCloudSampler sampler;
+        std::string error;
+        bool written = writer.open(options.writeStreamPath, POINT_STREAM_CHUNK_POINTS, false, packColor(255, 0, 0), error);
+        for (int i = 0; written && i < count; ++i)
+        {
+            float x, y, z;
+            sampler.next(x, y, z);
+            writer.append(x, y, z);
+        }
+        if (!written || !writer.finish(error))
+        {
+            std::fprintf(stderr, "Failed to write '%s': %s\n", options.writeStreamPath, error.c_str());
+            return 1;
+        }
+        long currentKb = 0, peakKb = 0;
+        residentMemoryKb(currentKb, peakKb);
+        std::printf("stream_written=%s points=%d bytes=%llu seconds=%.3f peak_rss_kb=%ld\n", options.writeStreamPath, count,
+                    static_cast<unsigned long long>(writer.fileBytes()),
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), peakKb);
+        return 0;
+    }
+
+    if (options.meshPath)
+    {
+        MeshLoadOptions loadOptions;
+        loadOptions.red = 255;
+        loadOptions.green = 0;
+        loadOptions.blue = 0;
+        MeshLoadStats stats;
+        std::string error;
+        bool loaded = false;
+        watchRequest.kind = MeshRequest::Kind::File;
+        watchRequest.path = options.meshPath;
+        watchRequest.options = loadOptions;
+        if (options.useMeshCache)
+        {
+            const std::string cachePath = options.meshCachePath ? options.meshCachePath : std::string(options.meshPath) + ".wfc";
+            loaded = loadMeshWithCache(options.meshPath, cachePath.c_str(), state, loadOptions, meshCache, stats, error);
+            watchRequest.cachePath = cachePath;
+        }
+        else
+        {
+            loaded = loadMeshFile(options.meshPath, state, loadOptions, stats, error);
+        }
+        if (!loaded)
+        {
+            std::fprintf(stderr, "Failed to load '%s': %s\n", options.meshPath, error.c_str());
+            return 1;
+        }
+        std::printf("loaded=%s source=%s bytes=%zu vertices=%zu faces=%zu edges=%zu duplicate_edges=%zu seconds=%.3f peak_rss_kb=%ld\n",
+                    options.meshPath, stats.fromCache ? "cache" : "import", stats.fileBytes, stats.vertices, stats.faces, stats.edges, stats.duplicateEdges,
+                    stats.seconds, stats.peakResidentKb);
+    }
+    else if (options.generate)
+    {
+        const int resolution = options.generatorResolution > 0 ? options.generatorResolution : defaultGeneratorResolution(options.generator);
+        const auto start = std::chrono::steady_clock::now();
+        if (!objects3d.generate(state, options.generator, resolution, 255, 0, 0))
+        {
+            std::fprintf(stderr, "Failed to generate %s:%d (out of memory)\n", generatorName(options.generator), resolution);
+            return 1;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("generated=%s resolution=%d vertices=%zu edges=%zu seconds=%.3f\n", generatorName(options.generator), resolution,
+                    state.externalGeometry.vertexCount, state.externalGeometry.edgeCount, seconds);
+    }
+    else if (options.streamPath)
+    {
+        // The stream is the only object; nothing else is loaded
+        std::string error;
+        if (!pointStream.open(options.streamPath, error))
+        {
+            std::fprintf(stderr, "Failed to open '%s': %s\n", options.streamPath, error.c_str());
+            return 1;
+        }
+        pointStream.configure(static_cast<std::size_t>(options.streamBudget), static_cast<std::size_t>(options.streamResidentMb) << 20);
+        state.pointStream = &pointStream;
+        std::printf("stream=%s points=%llu chunks=%zu bytes=%zu resident_limit_mb=%d budget=%d\n", options.streamPath,
+                    static_cast<unsigned long long>(pointStream.pointCount()), pointStream.chunkCount(), pointStream.fileBytes(),
+                    options.streamResidentMb, options.streamBudget);
+    }
+    else
+    {
+        objects3d.makeCube(state, 1.0f, 255, 0, 0);
+    }
+
+    if (options.writeStreamPath)
+    {
+        // Convert the loaded / generated object's vertices and exit
+        syncGeometry(state);
+        const auto start = std::chrono::steady_clock::now();
+        std::string error;
+        if (!writePointStream(options.writeStreamPath, state.geometry, POINT_STREAM_CHUNK_POINTS, error))
+        {
+            std::fprintf(stderr, "Failed to write '%s': %s\n", options.writeStreamPath, error.c_str());
+            return 1;
+        }
+        std::printf("stream_written=%s points=%zu seconds=%.3f\n", options.writeStreamPath, state.geometry.vertexCount,
+                    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        return 0;
+    }
+
+    if (options.instanceCount > 0)
+    {
+        // The object becomes one shared scene mesh placed instanceCount times
+        if (!instanceCurrentObject(state, static_cast<std::size_t>(options.instanceCount), options.instanceMotion))
+        {
+            std::fprintf(stderr, "Nothing to instance\n");
+            return 1;
+        }
+    }
+
+    // Input / timing traces: the trace's starting conditions replace the command line's
+    std::string traceError;
+    if (options.replayPath)
+    {
+        if (!inputReplay.load(options.replayPath, traceError))
+        {
+            std::fprintf(stderr, "Failed to load trace '%s': %s\n", options.replayPath, traceError.c_str());
+            return 1;
+        }
+        if (!inputReplay.applyStart(state))
+            std::fprintf(stderr, "Warning: the trace was recorded with different geometry (%llu vertices, %llu edges)\n",
+                         static_cast<unsigned long long>(inputReplay.traceHeader().vertexCount),
+                         static_cast<unsigned long long>(inputReplay.traceHeader().edgeCount));
+        state.inputReplay = &inputReplay;
+        state.useReplayDeltas = options.replayDeltas;
+    }
+    else if (options.recordPath)
+    {
+        if (!inputRecorder.open(options.recordPath, state, traceError))
+        {
+            std::fprintf(stderr, "Failed to record: %s\n", traceError.c_str());
+            return 1;
+        }
+        state.inputRecorder = &inputRecorder;
+    }
+
+    int result = 0;
+    if (options.headless)
+    {
+        // Offscreen benchmark: fixed frame count and timestep, no window or VSync
+        HeadlessConfig config;
+        config.width = state.screenWidth;
+        config.height = state.screenHeight;
+        config.frameCount = options.replayPath ? static_cast<int>(std::min<std::uint64_t>(inputReplay.traceHeader().frameCount, 1000000000u))
+                                               : options.frameCount;
+        config.printChecksum = options.printChecksum;
+        config.exportPath = options.exportPath;
+        config.exportFormat = options.exportFormat;
+        config.exportFramesPerSecond = 1.0 / options.timestepSeconds;
+        config.exportQueueFrames = static_cast<std::size_t>(options.exportQueueFrames);
+        config.shmName = options.shmName;
+        config.shmSlots = static_cast<unsigned>(options.shmSlots);
+        config.shmLossless = options.shmLossless;
+        state.fixedDeltaSeconds = options.timestepSeconds;
+        result = renderer_run_headless(config, frame_callback, &state);
+    }
+    else
+    {
+        // Object keys and --watch build meshes off the frame thread. Traces
+        // keep the synchronous path: the frame a background mesh arrives on
+        // depends on how long it took to build.
+        std::string loaderError;
+        if (!options.recordPath && !options.replayPath)
+        {
+            if (meshLoader.start(loaderError))
+                state.meshLoader = &meshLoader;
+            else
+                std::fprintf(stderr, "Warning: loading meshes on the frame thread (%s)\n", loaderError.c_str());
+        }
+        if (options.watchMesh && (!state.meshLoader || !meshLoader.watchFile(watchRequest, loaderError)))
+        {
+            std::fprintf(stderr, "Cannot watch '%s': %s\n", options.meshPath, loaderError.c_str());
+            return 1;
+        }
+
+        // Enter the render loop; returns 0 on normal shutdown
+        result = renderer_run("3D Renderer Demo", state.screenWidth, state.screenHeight, frame_callback, &state);
+        meshLoader.stop();
+        state.meshLoader = nullptr;
+    }
 
-    objects3d.makeCube(state, 1.0f, 255, 0, 0);
+    if (state.pointStream)
+    {
+        const PointStreamStats &stats = pointStream.stats();
+        long currentKb = 0, peakKb = 0;
+        residentMemoryKb(currentKb, peakKb);
+        std::printf("stream_frames=%llu points_drawn=%llu points_per_second=%.0f last_points=%zu last_fraction=%.3f last_chunks_culled=%zu "
+                    "prefetched=%llu released=%llu file_kb=%zu rss_kb=%ld peak_rss_kb=%ld\n",
+                    static_cast<unsigned long long>(stats.frames), static_cast<unsigned long long>(stats.pointsDrawn),
+                    stats.drawSeconds > 0.0 ? static_cast<double>(stats.pointsDrawn) / stats.drawSeconds : 0.0, stats.lastPoints, stats.lastFraction,
+                    stats.lastChunksCulled, static_cast<unsigned long long>(stats.chunksPrefetched),
+                    static_cast<unsigned long long>(stats.chunksReleased), pointStream.fileBytes() >> 10, currentKb, peakKb);
+        state.pointStream = nullptr;
+    }
 
-    // Enter the render loop; returns 0 on normal shutdown
-    return renderer_run("3D Renderer Demo", state.screenWidth, state.screenHeight, frame_callback, &state);
+    if (options.recordPath)
+    {
+        if (!inputRecorder.finish(traceError))
+        {
+            std::fprintf(stderr, "Failed to record: %s\n", traceError.c_str());
+            return 1;
+        }
+        std::printf("recorded=%s frames=%llu bytes=%llu\n", options.recordPath, static_cast<unsigned long long>(inputRecorder.frames()),
+                    static_cast<unsigned long long>(inputRecorder.bytes()));
+    }
+    if (options.replayPath)
+    {
+        std::printf("replayed=%s frames=%llu of %llu timing=%s\n", options.replayPath, static_cast<unsigned long long>(inputReplay.framesReplayed()),
+                    static_cast<unsigned long long>(inputReplay.traceHeader().frameCount), options.replayDeltas ? "recorded" : "live");
+    }
+    return result;
 }
\ No newline at end of file
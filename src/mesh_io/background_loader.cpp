@@ -0,0 +1,392 @@
+// background_loader.cpp
+// Mesh preparation thread, the frame-boundary swap and inotify-driven reloads.
+
+#include "background_loader.h"
+#include "../3d_renderer/draw_batches.h"  // buildDrawBatches
+#include "../3d_renderer/geometry_view.h" // packGeometry, viewOf, computeBounds
+#include "../3d_renderer/lod.h"           // buildMeshLod
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Quiet time after the last change to a watched file before it is reloaded
+constexpr int WATCH_DEBOUNCE_MS = 100;
+
+// Retired entries kept without reallocating while the worker is busy building
+constexpr std::size_t RETIRED_RESERVE = 16;
+
+static const char *describeRequest(const MeshRequest &request)
+{
+    switch (request.kind)
+    {
+    case MeshRequest::Kind::Cube:
+        return "cube";
+    case MeshRequest::Kind::Pyramid:
+        return "pyramid";
+    case MeshRequest::Kind::Generator:
+        return generatorName(request.generator);
+    case MeshRequest::Kind::File:
+        return request.path.c_str();
+    }
+    return "mesh";
+}
+
+// Load or generate request into mesh and derive everything a frame needs.
+// Returns null (with error set) if the geometry could not be produced; may
+// also throw (std::bad_alloc) while deriving, which frees the mesh.
+static std::unique_ptr<PreparedMesh> prepareMesh(const MeshRequest &request, std::string &error)
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto mesh = std::make_unique<PreparedMesh>();
+    mesh->name = describeRequest(request);
+
+    // The geometry producers write into a RenderState; this one is private to the worker
+    RenderState scratch;
+    Objects3d primitives;
+    bool built = true;
+    switch (request.kind)
+    {
+    case MeshRequest::Kind::Cube:
+        primitives.makeCube(scratch, 1.0f, request.red, request.green, request.blue);
+        break;
+    case MeshRequest::Kind::Pyramid:
+        primitives.makePyramid(scratch, 1.0f, request.red, request.green, request.blue);
+        break;
+    case MeshRequest::Kind::Generator:
+    {
+        const int resolution = request.resolution > 0 ? request.resolution : defaultGeneratorResolution(request.generator);
+        built = mesh->factory.generate(scratch, request.generator, resolution, request.red, request.green, request.blue);
+        if (!built)
+            error = "out of memory";
+        break;
+    }
+    case MeshRequest::Kind::File:
+    {
+        MeshLoadStats stats;
+        built = request.cachePath.empty()
+                    ? loadMeshFile(request.path.c_str(), scratch, request.options, stats, error)
+                    : loadMeshWithCache(request.path.c_str(), request.cachePath.c_str(), scratch, request.options, mesh->cache, stats, error);
+        break;
+    }
+    }
+    if (!built)
+        return nullptr;
+
+    if (scratch.externalGeometry.x)
+    {
+        mesh->geometry = scratch.externalGeometry;
+    }
+    else
+    {
+        packGeometry(scratch.basePoints3d, scratch.edges3d, scratch.triangles3d, mesh->storage);
+        mesh->geometry = viewOf(mesh->storage);
+    }
+    mesh->bounds = computeBounds(mesh->geometry);
+    buildDrawBatches(mesh->geometry, mesh->drawBatches);
+    buildMeshLod(mesh->geometry, mesh->bounds, mesh->lod);
+
+    // Frame scratch sized as syncGeometry / syncDrawBatches would size it
+    const std::size_t vertexCount = mesh->geometry.vertexCount, primitiveCount = vertexCount + mesh->geometry.edgeCount;
+    mesh->projected.x.resize(vertexCount);
+    mesh->projected.y.resize(vertexCount);
+    mesh->projected.depth.resize(vertexCount);
+    mesh->segments.reserve(primitiveCount);
+    mesh->tileSegmentIndices.reserve(2 * primitiveCount);
+    std::size_t largestBatch = 0;
+    for (const DrawBatch &batch : mesh->drawBatches.batches)
+    {
+        largestBatch = std::max({largestBatch, batch.pointCount, batch.stripVertexCount});
+    }
+    mesh->submitPoints.reserve(largestBatch);
+
+    mesh->buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return mesh;
+}
+
+// Take theirs if it has more room than ours; either way the smaller one ends up in theirs
+template <typename T>
+static void adoptLarger(std::vector<T> &ours, std::vector<T> &theirs)
+{
+    if (theirs.capacity() > ours.capacity())
+        ours.swap(theirs);
+}
+
+// Free the buffers a mesh received from RenderState at adoption
+static void releaseHandover(PreparedMesh &mesh)
+{
+    mesh.drawBatches = DrawBatches{};
+    mesh.lod = MeshLod{};
+    mesh.projected = ScreenBuffer{};
+    std::vector<ScreenSegment>().swap(mesh.segments);
+    std::vector<std::uint32_t>().swap(mesh.tileSegmentIndices);
+    std::vector<ScreenPoint>().swap(mesh.submitPoints);
+    std::vector<Point3d>().swap(mesh.points);
+    std::vector<Edge3d>().swap(mesh.edges);
+    std::vector<std::uint32_t>().swap(mesh.triangles);
+    mesh.replacedStorage = PackedGeometry{};
+}
+
+BackgroundMeshLoader::~BackgroundMeshLoader()
+{
+    stop();
+    delete installed;
+}
+
+bool BackgroundMeshLoader::start(std::string &error)
+{
+    if (worker.joinable())
+        return true;
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd < 0)
+    {
+        error = std::string("eventfd: ") + std::strerror(errno);
+        return false;
+    }
+    inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotifyFd < 0)
+    {
+        error = std::string("inotify_init1: ") + std::strerror(errno);
+        close(wakeFd);
+        wakeFd = -1;
+        return false;
+    }
+    retired.reserve(RETIRED_RESERVE);
+    stopRequested = false;
+    worker = std::thread(&BackgroundMeshLoader::workerLoop, this);
+    return true;
+}
+
+void BackgroundMeshLoader::stop()
+{
+    if (worker.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        wakeWorker();
+        worker.join();
+    }
+    delete ready.exchange(nullptr, std::memory_order_acq_rel);
+    for (const Retired &entry : retired)
+    {
+        if (entry.whole)
+            delete entry.mesh;
+        else
+            releaseHandover(*entry.mesh);
+    }
+    retired.clear();
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+    if (wakeFd >= 0)
+        close(wakeFd);
+    inotifyFd = wakeFd = -1;
+}
+
+void BackgroundMeshLoader::request(const MeshRequest &next)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingRequest = next;
+        hasRequest = true;
+    }
+    wakeWorker();
+}
+
+bool BackgroundMeshLoader::watchFile(const MeshRequest &fileRequest, std::string &error)
+{
+    const std::size_t slash = fileRequest.path.rfind('/');
+    const std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : fileRequest.path.substr(0, slash));
+    const std::string name = slash == std::string::npos ? fileRequest.path : fileRequest.path.substr(slash + 1);
+    if (inotifyFd < 0)
+    {
+        error = "loader not started";
+        return false;
+    }
+    // Writes in place, and editors that save to a temporary file and rename it over the original
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        error = "cannot watch '" + directory + "': " + std::strerror(errno);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    watchedRequest = fileRequest;
+    watchedName = name;
+    return true;
+}
+
+void BackgroundMeshLoader::wakeWorker()
+{
+    const std::uint64_t one = 1;
+    if (write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        SDL_Log("BackgroundMeshLoader: cannot wake the worker: %s", std::strerror(errno));
+}
+
+void BackgroundMeshLoader::publish(std::unique_ptr<PreparedMesh> mesh)
+{
+    // A mesh the frame thread has not taken yet is superseded by the newer one
+    delete ready.exchange(mesh.release(), std::memory_order_acq_rel);
+    const Uint32 eventType = wakeEventType.load(std::memory_order_relaxed);
+    if (eventType != 0)
+    {
+        SDL_Event event{};
+        event.type = eventType;
+        SDL_PushEvent(&event);
+    }
+}
+
+bool BackgroundMeshLoader::adoptReady(RenderState &state)
+{
+    PreparedMesh *mesh = ready.exchange(nullptr, std::memory_order_acq_rel);
+    if (!mesh)
+        return false;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Derived data comes prebuilt; the state's buffers move into the mesh
+    std::swap(state.drawBatches, mesh->drawBatches);
+    std::swap(state.geometryLod, mesh->lod);
+    FrameScratch &scratch = state.frameScratch;
+    if (mesh->projected.x.size() > state.projectedPoints.x.size())
+        std::swap(state.projectedPoints, mesh->projected);
+    adoptLarger(scratch.segments, mesh->segments);
+    adoptLarger(scratch.tileBins.segmentIndices, mesh->tileSegmentIndices);
+    adoptLarger(scratch.submitPoints, mesh->submitPoints);
+
+    // The previous object's editable and packed copies are freed with the rest
+    state.basePoints3d.swap(mesh->points);
+    state.edges3d.swap(mesh->edges);
+    state.triangles3d.swap(mesh->triangles);
+    std::swap(state.packedGeometry, mesh->replacedStorage);
+
+    state.externalGeometry = mesh->geometry;
+    state.geometry = mesh->geometry;
+    state.geometryBounds = mesh->bounds;
+    ++state.geometryRevision;
+    state.geometryViewRevision = state.geometryRevision;
+    state.drawBatches.revision = state.geometryRevision;
+    state.geometryLodRevision = state.geometryRevision;
+    state.geometryLodLevel = 0;
+
+    PreparedMesh *previous = installed;
+    installed = mesh;
+    mesh->adoptSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (previous)
+            retired.push_back(Retired{previous, true});
+        retired.push_back(Retired{mesh, false});
+    }
+    wakeWorker();
+    return true;
+}
+
+void BackgroundMeshLoader::workerLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    bool reloadPending = false;
+    Clock::time_point reloadAt;
+    std::vector<Retired> freeing;
+    freeing.reserve(RETIRED_RESERVE);
+    alignas(inotify_event) char events[4096];
+
+    for (;;)
+    {
+        int timeoutMs = -1;
+        if (reloadPending)
+        {
+            const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(reloadAt - Clock::now()).count();
+            timeoutMs = static_cast<int>(std::max<long long>(0, remaining));
+        }
+        pollfd descriptors[2] = {{wakeFd, POLLIN, 0}, {inotifyFd, POLLIN, 0}};
+        if (poll(descriptors, 2, timeoutMs) < 0 && errno != EINTR)
+        {
+            SDL_Log("BackgroundMeshLoader: poll failed: %s", std::strerror(errno));
+            return;
+        }
+        std::uint64_t wakeCount = 0;
+        if (read(wakeFd, &wakeCount, sizeof(wakeCount)) < 0 && errno != EAGAIN)
+            return;
+
+        // Changes to the watched file restart the quiet period
+        std::string name;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            name = watchedName;
+        }
+        for (ssize_t length; (length = read(inotifyFd, events, sizeof(events))) > 0;)
+        {
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(events + offset);
+                if (event->len > 0 && name == event->name)
+                {
+                    reloadPending = true;
+                    reloadAt = Clock::now() + std::chrono::milliseconds(WATCH_DEBOUNCE_MS);
+                }
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+
+        MeshRequest next;
+        bool build = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopRequested)
+                return;
+            freeing.swap(retired);
+            if (reloadPending && Clock::now() >= reloadAt)
+            {
+                reloadPending = false;
+                if (!hasRequest)
+                {
+                    pendingRequest = watchedRequest;
+                    hasRequest = true;
+                }
+            }
+            if (hasRequest)
+            {
+                next = pendingRequest;
+                hasRequest = false;
+                build = true;
+            }
+        }
+
+        for (const Retired &entry : freeing)
+        {
+            if (entry.whole)
+            {
+                delete entry.mesh;
+                continue;
+            }
+            SDL_Log("Installed %s: prepared in %.1f ms, swapped in %.1f us", entry.mesh->name.c_str(), entry.mesh->buildSeconds * 1000.0,
+                    entry.mesh->adoptSeconds * 1e6);
+            releaseHandover(*entry.mesh);
+        }
+        freeing.clear();
+
+        if (build)
+        {
+            // A failed load or rebuild keeps the current mesh on screen
+            std::string error;
+            std::unique_ptr<PreparedMesh> mesh;
+            try
+            {
+                mesh = prepareMesh(next, error);
+            }
+            catch (const std::exception &exception)
+            {
+                error = exception.what();
+            }
+            if (mesh)
+                publish(std::move(mesh));
+            else
+                SDL_Log("Failed to load %s: %s", describeRequest(next), error.c_str());
+        }
+    }
+}
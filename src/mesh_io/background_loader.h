@@ -0,0 +1,175 @@
+/**
+ * @file background_loader.h
+ * @brief Builds and loads meshes on a worker thread and swaps them in between frames.
+ *
+ * Replacing the object synchronously (makeCube, generate, loadMeshFile)
+ * rebuilds RenderState's vectors in place, and the next frame then packs the
+ * geometry, groups the draw batches and clusters the levels of detail before
+ * it can draw. For a large mesh that is a freeze of the whole import plus a
+ * few hundred milliseconds of derived data.
+ *
+ * With a BackgroundMeshLoader the worker does all of that into a separate
+ * PreparedMesh: the geometry (owned arrays, a mapped cache or a generated
+ * block), its bounds, draw batches, levels of detail and frame scratch sized
+ * for it. The finished mesh is published through an atomic pointer. At the
+ * start of the next frame, adoptReady() takes it and swaps its buffers into
+ * the RenderState, which is a constant number of pointer swaps. The buffers
+ * it replaces, and the mesh shown before, go back to the worker to be freed,
+ * so neither building nor freeing a mesh runs on the frame thread.
+ *
+ * The worker can also watch a mesh file with inotify and reload it whenever
+ * it is rewritten or replaced (editors often write a temporary file and
+ * rename it over the original, so the directory is watched).
+ */
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "../app_state/app_state.h"   // RenderState, GeometryView, DrawBatches, MeshLod
+#include "../3d_objects/objects_3d.h" // Objects3d, GeneratorKind
+#include "mesh_cache.h"               // MeshCache
+#include "mesh_loader.h"              // MeshLoadOptions, MeshLoadStats
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief What to build.
+ */
+struct MeshRequest
+{
+    enum class Kind
+    {
+        Cube,      ///< Objects3d::makeCube
+        Pyramid,   ///< Objects3d::makePyramid
+        Generator, ///< Objects3d::generate(generator, resolution)
+        File       ///< loadMeshFile, or loadMeshWithCache if cachePath is set
+    };
+
+    Kind kind = Kind::Cube;
+    int red = 255, green = 0, blue = 0;               ///< Color (primitives and generators)
+    GeneratorKind generator = GeneratorKind::UvSphere; ///< Stress scene kind
+    int resolution = 0;                                ///< Stress scene resolution
+    std::string path;                                  ///< Mesh file
+    std::string cachePath;                             ///< Binary cache of the mesh file; empty = none
+    MeshLoadOptions options;                           ///< Import settings
+};
+
+/**
+ * @brief A mesh and everything the frame needs to draw it, built off the frame thread.
+ *
+ * The geometry members stay with the mesh while it is shown. The handover
+ * members are swapped with RenderState's by adoptReady(), after which they
+ * hold the state's previous buffers until the worker frees them.
+ */
+struct PreparedMesh
+{
+    // Geometry; whichever holds the data behind geometry is kept alive here
+    PackedGeometry storage; ///< Owned arrays (primitives, imported files without a cache)
+    MeshCache cache;        ///< Mapped cache (files with a cachePath)
+    Objects3d factory;      ///< Generated block (stress scenes)
+    GeometryView geometry;  ///< What is drawn
+    Aabb bounds{};          ///< Object-space bounds of geometry
+
+    // Handover buffers
+    DrawBatches drawBatches;                       ///< Color batches of geometry
+    MeshLod lod;                                   ///< Levels of detail of geometry
+    ScreenBuffer projected;                        ///< Projection output sized for geometry
+    std::vector<ScreenSegment> segments;           ///< Segment capacity for geometry
+    std::vector<std::uint32_t> tileSegmentIndices; ///< Tile bin capacity for geometry
+    std::vector<ScreenPoint> submitPoints;         ///< Capacity for the largest draw batch
+    std::vector<Point3d> points;                   ///< Empty; replaces RenderState::basePoints3d
+    std::vector<Edge3d> edges;                     ///< Empty; replaces RenderState::edges3d
+    std::vector<std::uint32_t> triangles;          ///< Empty; replaces RenderState::triangles3d
+    PackedGeometry replacedStorage;                ///< Empty; replaces RenderState::packedGeometry
+
+    std::string name;          ///< Shown in log messages
+    double buildSeconds = 0.0; ///< Worker time to load and prepare
+    double adoptSeconds = 0.0; ///< Frame thread time spent in adoptReady()
+};
+
+/**
+ * @brief Worker thread that prepares meshes and hands them to the frame thread.
+ *
+ * request() and watchFile() may be called from any thread; adoptReady() and
+ * hasReady() from the thread that owns the RenderState.
+ */
+class BackgroundMeshLoader
+{
+public:
+    BackgroundMeshLoader() = default;
+    ~BackgroundMeshLoader();
+
+    BackgroundMeshLoader(const BackgroundMeshLoader &) = delete;
+    BackgroundMeshLoader &operator=(const BackgroundMeshLoader &) = delete;
+
+    /**
+     * @brief Start the worker.
+     * @return false (with error set) if the wake-up descriptors cannot be created.
+     */
+    bool start(std::string &error);
+
+    /** Stop and join the worker; meshes not yet adopted are dropped. */
+    void stop();
+
+    /** SDL event pushed when a mesh is ready, to wake a loop blocked in SDL_WaitEvent; 0 pushes nothing. */
+    void setWakeEvent(Uint32 eventType) { wakeEventType.store(eventType, std::memory_order_relaxed); }
+
+    /** Build request next; a request still waiting is replaced (the newest one wins). */
+    void request(const MeshRequest &next);
+
+    /**
+     * @brief Reload fileRequest whenever its file changes.
+     *
+     * Changes are debounced, so a file written in several steps is loaded
+     * once, after it has been quiet for a moment.
+     *
+     * @return false (with error set) if the file's directory cannot be watched.
+     */
+    bool watchFile(const MeshRequest &fileRequest, std::string &error);
+
+    /** True if a finished mesh is waiting for adoptReady(). */
+    bool hasReady() const { return ready.load(std::memory_order_acquire) != nullptr; }
+
+    /**
+     * @brief Install the finished mesh, if any, as the current object.
+     *
+     * Call at a frame boundary. Swaps the mesh's prepared buffers into state,
+     * bumps geometryRevision and marks the derived data current, so the
+     * frame's sync steps have nothing left to rebuild. The replaced buffers
+     * and the previous mesh are freed on the worker.
+     *
+     * @return true if a mesh was installed.
+     */
+    bool adoptReady(RenderState &state);
+
+private:
+    struct Retired
+    {
+        PreparedMesh *mesh;
+        bool whole; ///< Delete the mesh; otherwise only release its handover buffers
+    };
+
+    void workerLoop();
+    void wakeWorker();
+    void publish(std::unique_ptr<PreparedMesh> mesh);
+
+    std::thread worker;
+    int wakeFd = -1;    ///< eventfd: request, retired mesh or stop
+    int inotifyFd = -1; ///< Directory watch of watchedRequest.path
+
+    std::mutex mutex; ///< Guards everything below up to watchedName
+    bool stopRequested = false;
+    bool hasRequest = false;
+    MeshRequest pendingRequest;
+    std::vector<Retired> retired;
+    MeshRequest watchedRequest;
+    std::string watchedName; ///< File name within the watched directory
+
+    std::atomic<PreparedMesh *> ready{nullptr}; ///< Finished mesh waiting for adoptReady()
+    std::atomic<Uint32> wakeEventType{0};
+    PreparedMesh *installed = nullptr; ///< Mesh on screen (frame thread only)
+};
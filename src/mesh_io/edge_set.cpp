@@ -0,0 +1,83 @@
+// edge_set.cpp
+// Linear-probing hash set of packed (min, max) vertex index pairs.
+
+#include "edge_set.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+static std::size_t slotFor(std::uint64_t key, unsigned shift)
+{
+    // Fibonacci hashing: the high bits of the product are well mixed
+    return static_cast<std::size_t>((key * 11400714819323198485ull) >> shift);
+}
+
+void EdgeSet::reserve(std::size_t expectedEdges)
+{
+    order.reserve(expectedEdges);
+    // Keep the load factor at or below one half. Capping the request keeps
+    // the doubling from overflowing; a table that large fails to allocate
+    const std::size_t wanted = std::min(expectedEdges, std::numeric_limits<std::size_t>::max() / 4) * 2;
+    std::size_t capacity = 16;
+    unsigned bits = 4;
+    while (capacity < wanted)
+    {
+        capacity <<= 1;
+        ++bits;
+    }
+    if (capacity <= table.size())
+        return;
+
+    std::vector<std::uint64_t> old;
+    old.swap(table);
+    table.assign(capacity, 0);
+    shift = 64 - bits;
+    for (const std::uint64_t key : old)
+    {
+        if (key == 0)
+            continue;
+        std::size_t slot = slotFor(key, shift);
+        while (table[slot] != 0)
+            slot = (slot + 1) & (capacity - 1);
+        table[slot] = key;
+    }
+}
+
+void EdgeSet::grow()
+{
+    reserve(table.empty() ? 8 : table.size());
+}
+
+bool EdgeSet::insert(std::uint32_t a, std::uint32_t b)
+{
+    if (a == b)
+        return false;
+    if (a > b)
+        std::swap(a, b);
+    const std::uint64_t key = (static_cast<std::uint64_t>(a) << 32) | b;
+
+    if ((order.size() + 1) * 2 > table.size())
+        grow();
+
+    const std::size_t mask = table.size() - 1;
+    for (std::size_t slot = slotFor(key, shift);; slot = (slot + 1) & mask)
+    {
+        if (table[slot] == key)
+        {
+            ++duplicateCount;
+            return false;
+        }
+        if (table[slot] == 0)
+        {
+            table[slot] = key;
+            order.push_back(key);
+            return true;
+        }
+    }
+}
+
+void EdgeSet::releaseTable()
+{
+    std::vector<std::uint64_t>().swap(table);
+    shift = 64;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file edge_set.h
+ * @brief Hash set that turns face/polyline indices into unique undirected edges.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Open-addressing set of undirected edges keyed by (min, max) index.
+ *
+ * Each edge is stored once as a 64-bit key; insertion order is kept in
+ * edges() so output is deterministic. Self-loops are ignored.
+ */
+class EdgeSet
+{
+public:
+    /** Pre-size for about expectedEdges unique edges. */
+    void reserve(std::size_t expectedEdges);
+
+    /**
+     * @brief Insert the edge (a, b).
+     * @return true if the edge was new, false if it was a duplicate or a self-loop.
+     */
+    bool insert(std::uint32_t a, std::uint32_t b);
+
+    /** Unique edges as (min, max) pairs in first-insertion order. */
+    const std::vector<std::uint64_t> &edges() const { return order; }
+
+    /** Number of duplicate insertions rejected so far. */
+    std::size_t duplicates() const { return duplicateCount; }
+
+    /** Unpack a key from edges() into its two vertex indices. */
+    static std::uint32_t first(std::uint64_t key) { return static_cast<std::uint32_t>(key >> 32); }
+    static std::uint32_t second(std::uint64_t key) { return static_cast<std::uint32_t>(key); }
+
+    /** Free the hash table after the last insert, keeping edges(). */
+    void releaseTable();
+
+private:
+    void grow();
+
+    std::vector<std::uint64_t> table; // 0 = empty slot (a valid key always has min < max)
+    std::vector<std::uint64_t> order;
+    std::size_t duplicateCount = 0;
+    unsigned shift = 64;
+};
@@ -0,0 +1,82 @@
+// mapped_file.cpp
+// POSIX implementation of MappedFile.
+
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : mappedData(other.mappedData), mappedSize(other.mappedSize)
+{
+    other.mappedData = nullptr;
+    other.mappedSize = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        mappedData = other.mappedData;
+        mappedSize = other.mappedSize;
+        other.mappedData = nullptr;
+        other.mappedSize = 0;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const char *path, bool sequential, std::string &error)
+{
+    close();
+
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        error = std::string("cannot open '") + path + "': " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        error = std::string("cannot map '") + path + "': empty or unreadable file";
+        ::close(fd);
+        return false;
+    }
+
+    void *address = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced
+    if (address == MAP_FAILED)
+    {
+        error = std::string("mmap failed for '") + path + "': " + std::strerror(errno);
+        return false;
+    }
+
+    if (sequential)
+    {
+        madvise(address, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+    }
+
+    mappedData = static_cast<const char *>(address);
+    mappedSize = static_cast<std::size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mappedData)
+    {
+        munmap(const_cast<char *>(mappedData), mappedSize);
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
+}
@@ -0,0 +1,45 @@
+/**
+ * @file mapped_file.h
+ * @brief Read-only memory mapping of a whole file.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief RAII wrapper around open + mmap (POSIX) of a file for reading.
+ *
+ * Pages are faulted in on access, so parsing walks the file without first
+ * copying it into heap memory.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    /**
+     * @brief Map path read-only, replacing any previous mapping.
+     * @param path       File to map.
+     * @param sequential Hint the kernel that the file is read front to back.
+     * @param error      Receives a message on failure.
+     * @return true on success. Empty files fail.
+     */
+    bool open(const char *path, bool sequential, std::string &error);
+
+    /** Unmap the file (no-op if nothing is mapped). */
+    void close();
+
+    const char *data() const { return mappedData; }
+    std::size_t size() const { return mappedSize; }
+
+private:
+    const char *mappedData = nullptr;
+    std::size_t mappedSize = 0;
+};
@@ -0,0 +1,499 @@
+// mesh_cache.cpp
+// Binary wireframe cache: writer, validating reader and the import-or-map
+// entry point used by main.
+
+#include "mesh_cache.h"
+#include "../framebuffer/framebuffer.h" // packColor
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+// Bump whenever the layout or the meaning of a field changes
+constexpr std::uint32_t MESH_CACHE_VERSION = 2;
+constexpr std::uint32_t MESH_CACHE_BYTE_ORDER = 0x01020304u;
+constexpr char MESH_CACHE_MAGIC[8] = {'W', 'F', 'M', 'C', 'A', 'C', 'H', 'E'};
+constexpr std::size_t MESH_CACHE_ALIGNMENT = 64;
+constexpr std::size_t MESH_CACHE_HEADER_BYTES = 192; // Header struct padded to the block alignment
+
+constexpr std::uint32_t MESH_CACHE_HAS_COLORS = 1u << 0;
+
+enum MeshCacheBlock
+{
+    BLOCK_X,
+    BLOCK_Y,
+    BLOCK_Z,
+    BLOCK_POINT_COLORS,
+    BLOCK_EDGE_INDICES,
+    BLOCK_EDGE_COLORS,
+    BLOCK_TRIANGLE_INDICES,
+    BLOCK_COUNT
+};
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t fileBytes;
+    std::uint64_t checksum; // Of the whole file with this field zeroed
+    std::uint64_t vertexCount;
+    std::uint64_t edgeCount;
+    std::uint64_t triangleCount;
+    std::uint64_t faceCount;
+    std::uint64_t duplicateEdges;
+    std::uint64_t sourceBytes;
+    std::int64_t sourceModifiedNs;
+    std::uint32_t optionsKey;
+    std::uint32_t flags;
+    std::uint32_t uniformColor;
+    std::uint32_t reserved;
+    std::uint64_t blockOffsets[BLOCK_COUNT]; // 0 = block absent
+};
+
+static_assert(std::is_trivially_copyable<MeshCacheHeader>::value, "header is written with memcpy");
+static_assert(sizeof(MeshCacheHeader) <= MESH_CACHE_HEADER_BYTES, "header must fit its reserved space");
+
+// Checksum
+// --------
+// Four independent multiply-rotate lanes over 32-byte stripes (the xxHash64
+// round), so verification runs near memory bandwidth.
+
+constexpr std::uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+
+static std::uint64_t rotateLeft(std::uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static std::uint64_t mixRound(std::uint64_t lane, std::uint64_t word)
+{
+    lane += word * PRIME_2;
+    return rotateLeft(lane, 31) * PRIME_1;
+}
+
+class Checksum
+{
+public:
+    void update(const void *data, std::size_t size)
+    {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        totalBytes += size;
+        if (pendingBytes > 0)
+        {
+            const std::size_t take = std::min(size, sizeof(pending) - pendingBytes);
+            std::memcpy(pending + pendingBytes, bytes, take);
+            pendingBytes += take;
+            bytes += take;
+            size -= take;
+            if (pendingBytes < sizeof(pending))
+                return;
+            consumeStripe(pending);
+            pendingBytes = 0;
+        }
+        for (; size >= sizeof(pending); bytes += sizeof(pending), size -= sizeof(pending))
+        {
+            consumeStripe(bytes);
+        }
+        std::memcpy(pending, bytes, size);
+        pendingBytes = size;
+    }
+
+    std::uint64_t finish() const
+    {
+        std::uint64_t hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+        hash ^= totalBytes * PRIME_1;
+        for (std::size_t i = 0; i < pendingBytes; ++i)
+        {
+            hash = rotateLeft(hash ^ (pending[i] * PRIME_2), 11) * PRIME_1;
+        }
+        hash ^= hash >> 33;
+        hash *= PRIME_2;
+        hash ^= hash >> 29;
+        return hash;
+    }
+
+private:
+    void consumeStripe(const unsigned char *stripe)
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, stripe + 8 * lane, sizeof(word));
+            lanes[lane] = mixRound(lanes[lane], word);
+        }
+    }
+
+    std::uint64_t lanes[4] = {PRIME_1 + PRIME_2, PRIME_2, 0, 0 - PRIME_1};
+    unsigned char pending[32];
+    std::size_t pendingBytes = 0;
+    std::uint64_t totalBytes = 0;
+};
+
+static std::uint64_t alignUp(std::uint64_t value)
+{
+    return (value + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+// Hash the header region with the checksum field zeroed
+static void hashHeaderRegion(Checksum &checksum, const char *region)
+{
+    char copy[MESH_CACHE_HEADER_BYTES];
+    std::memcpy(copy, region, sizeof(copy));
+    std::memset(copy + offsetof(MeshCacheHeader, checksum), 0, sizeof(std::uint64_t));
+    checksum.update(copy, sizeof(copy));
+}
+
+// Source identity
+// ---------------
+
+bool describeMeshSource(const char *meshPath, const MeshLoadOptions &options, MeshCacheSource &source, std::string &error)
+{
+    struct stat info;
+    if (stat(meshPath, &info) != 0)
+    {
+        error = std::string("cannot stat '") + meshPath + "': " + std::strerror(errno);
+        return false;
+    }
+    source.bytes = static_cast<std::uint64_t>(info.st_size);
+    source.modifiedNs = static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+
+    // FNV-1a over the settings that change the imported geometry
+    const int settings[4] = {options.red, options.green, options.blue, options.normalize ? 1 : 0};
+    std::uint32_t key = 2166136261u;
+    for (const int setting : settings)
+    {
+        key = (key ^ static_cast<std::uint32_t>(setting)) * 16777619u;
+    }
+    source.optionsKey = key;
+    return true;
+}
+
+// Writer
+// ------
+
+// Streams blocks to the file while hashing them
+struct CacheWriter
+{
+    std::FILE *file = nullptr;
+    Checksum checksum;
+    std::uint64_t written = 0;
+    bool ok = true;
+
+    void write(const void *data, std::size_t size)
+    {
+        if (!ok || size == 0)
+            return;
+        checksum.update(data, size);
+        ok = std::fwrite(data, 1, size, file) == size;
+        written += size;
+    }
+
+    void padTo(std::uint64_t offset)
+    {
+        static const char zeros[MESH_CACHE_ALIGNMENT] = {};
+        while (ok && written < offset)
+        {
+            write(zeros, static_cast<std::size_t>(std::min<std::uint64_t>(offset - written, sizeof(zeros))));
+        }
+    }
+
+    // Write count values produced by value(i) through a bounded staging buffer
+    template <typename T, typename Produce>
+    void writeBlock(std::uint64_t offset, std::size_t count, Produce value)
+    {
+        padTo(offset);
+        T staging[4096];
+        for (std::size_t begin = 0; begin < count; begin += 4096)
+        {
+            const std::size_t chunk = std::min<std::size_t>(4096, count - begin);
+            for (std::size_t i = 0; i < chunk; ++i)
+            {
+                staging[i] = value(begin + i);
+            }
+            write(staging, chunk * sizeof(T));
+        }
+    }
+};
+
+bool writeMeshCache(const char *cachePath, const std::vector<Point3d> &points, const std::vector<Edge3d> &edges,
+                    const std::vector<std::uint32_t> &triangles, const MeshCacheSource &source, const MeshLoadStats &stats,
+                    std::string &error)
+{
+    std::vector<std::uint32_t> validEdges;
+    validEdges.reserve(edges.size());
+    for (std::size_t i = 0; i < edges.size(); ++i)
+    {
+        const Edge3d &edge = edges[i];
+        if (edge.pointOneIndex >= 0 && edge.pointTwoIndex >= 0 &&
+            static_cast<std::size_t>(edge.pointOneIndex) < points.size() && static_cast<std::size_t>(edge.pointTwoIndex) < points.size())
+            validEdges.push_back(static_cast<std::uint32_t>(i));
+    }
+    std::vector<std::uint32_t> validTriangles;
+    validTriangles.reserve(triangles.size() / 3);
+    for (std::size_t i = 0; i + 2 < triangles.size(); i += 3)
+    {
+        if (triangles[i] < points.size() && triangles[i + 1] < points.size() && triangles[i + 2] < points.size())
+            validTriangles.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    // Color blocks are only stored when the colors actually vary
+    const std::uint32_t firstColor = !points.empty() ? packColor(points[0].red, points[0].green, points[0].blue) : 0xFFFFFFFFu;
+    bool uniform = true;
+    for (const Point3d &point : points)
+    {
+        uniform = uniform && packColor(point.red, point.green, point.blue) == firstColor;
+    }
+    for (const std::uint32_t index : validEdges)
+    {
+        uniform = uniform && packColor(edges[index].red, edges[index].green, edges[index].blue) == firstColor;
+    }
+
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.byteOrder = MESH_CACHE_BYTE_ORDER;
+    header.vertexCount = points.size();
+    header.edgeCount = validEdges.size();
+    header.triangleCount = validTriangles.size();
+    header.faceCount = stats.faces;
+    header.duplicateEdges = stats.duplicateEdges;
+    header.sourceBytes = source.bytes;
+    header.sourceModifiedNs = source.modifiedNs;
+    header.optionsKey = source.optionsKey;
+    header.flags = uniform ? 0 : MESH_CACHE_HAS_COLORS;
+    header.uniformColor = firstColor;
+
+    const std::uint64_t blockBytes[BLOCK_COUNT] = {
+        header.vertexCount * sizeof(float), header.vertexCount * sizeof(float), header.vertexCount * sizeof(float),
+        uniform ? 0 : header.vertexCount * sizeof(std::uint32_t), header.edgeCount * 2 * sizeof(std::uint32_t),
+        uniform ? 0 : header.edgeCount * sizeof(std::uint32_t), header.triangleCount * 3 * sizeof(std::uint32_t)};
+    std::uint64_t offset = MESH_CACHE_HEADER_BYTES;
+    for (int block = 0; block < BLOCK_COUNT; ++block)
+    {
+        const bool present = (block != BLOCK_POINT_COLORS && block != BLOCK_EDGE_COLORS) || !uniform;
+        header.blockOffsets[block] = present ? offset : 0;
+        offset = alignUp(offset + blockBytes[block]);
+    }
+    header.fileBytes = offset;
+
+    const std::string temporaryPath = std::string(cachePath) + ".tmp" + std::to_string(getpid());
+    CacheWriter writer;
+    writer.file = std::fopen(temporaryPath.c_str(), "wb");
+    if (!writer.file)
+    {
+        error = "cannot create '" + temporaryPath + "': " + std::strerror(errno);
+        return false;
+    }
+
+    char headerRegion[MESH_CACHE_HEADER_BYTES] = {};
+    std::memcpy(headerRegion, &header, sizeof(header));
+    writer.write(headerRegion, sizeof(headerRegion));
+
+    writer.writeBlock<float>(header.blockOffsets[BLOCK_X], points.size(), [&](std::size_t i) { return points[i].x; });
+    writer.writeBlock<float>(header.blockOffsets[BLOCK_Y], points.size(), [&](std::size_t i) { return points[i].y; });
+    writer.writeBlock<float>(header.blockOffsets[BLOCK_Z], points.size(), [&](std::size_t i) { return points[i].z; });
+    if (!uniform)
+    {
+        writer.writeBlock<std::uint32_t>(header.blockOffsets[BLOCK_POINT_COLORS], points.size(), [&](std::size_t i)
+                                         { return packColor(points[i].red, points[i].green, points[i].blue); });
+    }
+    writer.writeBlock<std::uint32_t>(header.blockOffsets[BLOCK_EDGE_INDICES], validEdges.size() * 2, [&](std::size_t i)
+                                     {
+                                         const Edge3d &edge = edges[validEdges[i / 2]];
+                                         return static_cast<std::uint32_t>((i % 2 == 0) ? edge.pointOneIndex : edge.pointTwoIndex);
+                                     });
+    if (!uniform)
+    {
+        writer.writeBlock<std::uint32_t>(header.blockOffsets[BLOCK_EDGE_COLORS], validEdges.size(), [&](std::size_t i)
+                                         {
+                                             const Edge3d &edge = edges[validEdges[i]];
+                                             return packColor(edge.red, edge.green, edge.blue);
+                                         });
+    }
+    writer.writeBlock<std::uint32_t>(header.blockOffsets[BLOCK_TRIANGLE_INDICES], validTriangles.size() * 3, [&](std::size_t i)
+                                     { return triangles[validTriangles[i / 3] + i % 3]; });
+    writer.padTo(header.fileBytes);
+
+    // The checksum covered the header with a zero checksum field; patch it in
+    header.checksum = writer.checksum.finish();
+    bool ok = writer.ok && std::fseek(writer.file, 0, SEEK_SET) == 0 &&
+              std::fwrite(&header, sizeof(header), 1, writer.file) == 1;
+    ok = (std::fclose(writer.file) == 0) && ok;
+    if (!ok || std::rename(temporaryPath.c_str(), cachePath) != 0)
+    {
+        error = std::string("cannot write '") + cachePath + "': " + std::strerror(errno);
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Reader
+// ------
+
+bool MeshCache::open(const char *path, const MeshCacheSource *expected, std::string &error)
+{
+    close();
+    if (!file.open(path, false, error))
+        return false;
+
+    auto fail = [&](const std::string &what)
+    {
+        error = std::string("'") + path + "': " + what;
+        close();
+        return false;
+    };
+
+    const std::size_t size = file.size();
+    if (size < MESH_CACHE_HEADER_BYTES)
+        return fail("too small to be a mesh cache");
+    MeshCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0)
+        return fail("not a mesh cache");
+    if (header.version != MESH_CACHE_VERSION)
+        return fail("cache version " + std::to_string(header.version) + ", expected " + std::to_string(MESH_CACHE_VERSION));
+    if (header.byteOrder != MESH_CACHE_BYTE_ORDER)
+        return fail("cache was written on a machine with a different byte order");
+    if (header.fileBytes != size)
+        return fail("truncated cache");
+    if (expected && (header.sourceBytes != expected->bytes || header.sourceModifiedNs != expected->modifiedNs ||
+                     header.optionsKey != expected->optionsKey))
+        return fail("cache is stale (source or import options changed)");
+
+    // Counts are bounded by the file size before any multiplication below
+    if (header.vertexCount > size / sizeof(float) || header.edgeCount > size / (2 * sizeof(std::uint32_t)) ||
+        header.triangleCount > size / (3 * sizeof(std::uint32_t)) || header.vertexCount > static_cast<std::uint64_t>(INT32_MAX))
+        return fail("corrupt block counts");
+
+    const bool hasColors = (header.flags & MESH_CACHE_HAS_COLORS) != 0;
+    const std::uint64_t blockBytes[BLOCK_COUNT] = {
+        header.vertexCount * sizeof(float), header.vertexCount * sizeof(float), header.vertexCount * sizeof(float),
+        hasColors ? header.vertexCount * sizeof(std::uint32_t) : 0, header.edgeCount * 2 * sizeof(std::uint32_t),
+        hasColors ? header.edgeCount * sizeof(std::uint32_t) : 0, header.triangleCount * 3 * sizeof(std::uint32_t)};
+    for (int block = 0; block < BLOCK_COUNT; ++block)
+    {
+        const std::uint64_t offset = header.blockOffsets[block];
+        const bool optional = (block == BLOCK_POINT_COLORS || block == BLOCK_EDGE_COLORS);
+        if (optional && !hasColors)
+            continue;
+        if (offset < MESH_CACHE_HEADER_BYTES || offset % MESH_CACHE_ALIGNMENT != 0 || offset > size ||
+            blockBytes[block] > size - offset)
+            return fail("corrupt block offsets");
+    }
+
+    Checksum checksum;
+    hashHeaderRegion(checksum, file.data());
+    checksum.update(file.data() + MESH_CACHE_HEADER_BYTES, size - MESH_CACHE_HEADER_BYTES);
+    if (checksum.finish() != header.checksum)
+        return fail("checksum mismatch");
+
+    const char *base = file.data();
+    GeometryView view;
+    view.x = reinterpret_cast<const float *>(base + header.blockOffsets[BLOCK_X]);
+    view.y = reinterpret_cast<const float *>(base + header.blockOffsets[BLOCK_Y]);
+    view.z = reinterpret_cast<const float *>(base + header.blockOffsets[BLOCK_Z]);
+    view.edgeIndices = reinterpret_cast<const std::uint32_t *>(base + header.blockOffsets[BLOCK_EDGE_INDICES]);
+    view.triangleIndices = reinterpret_cast<const std::uint32_t *>(base + header.blockOffsets[BLOCK_TRIANGLE_INDICES]);
+    if (hasColors)
+    {
+        view.pointColors = reinterpret_cast<const std::uint32_t *>(base + header.blockOffsets[BLOCK_POINT_COLORS]);
+        view.edgeColors = reinterpret_cast<const std::uint32_t *>(base + header.blockOffsets[BLOCK_EDGE_COLORS]);
+    }
+    view.uniformColor = header.uniformColor;
+    view.vertexCount = static_cast<std::size_t>(header.vertexCount);
+    view.edgeCount = static_cast<std::size_t>(header.edgeCount);
+    view.triangleCount = static_cast<std::size_t>(header.triangleCount);
+
+    // The renderer indexes projected vertices with these without further checks
+    std::uint32_t maxIndex = 0;
+    for (std::size_t i = 0; i < 2 * view.edgeCount; ++i)
+    {
+        maxIndex = std::max(maxIndex, view.edgeIndices[i]);
+    }
+    if (view.edgeCount > 0 && maxIndex >= view.vertexCount)
+        return fail("edge index out of range");
+    maxIndex = 0;
+    for (std::size_t i = 0; i < 3 * view.triangleCount; ++i)
+    {
+        maxIndex = std::max(maxIndex, view.triangleIndices[i]);
+    }
+    if (view.triangleCount > 0 && maxIndex >= view.vertexCount)
+        return fail("triangle index out of range");
+
+    geometry = view;
+    faceCount = static_cast<std::size_t>(header.faceCount);
+    duplicateCount = static_cast<std::size_t>(header.duplicateEdges);
+    return true;
+}
+
+void MeshCache::close()
+{
+    file.close();
+    geometry = GeometryView{};
+    faceCount = 0;
+    duplicateCount = 0;
+}
+
+// Import-or-map
+// -------------
+
+// Install the mapped geometry and drop any heap copy of the previous mesh
+static void useCache(const MeshCache &cache, RenderState &state)
+{
+    std::vector<Point3d>().swap(state.basePoints3d);
+    std::vector<Edge3d>().swap(state.edges3d);
+    std::vector<std::uint32_t>().swap(state.triangles3d);
+    state.externalGeometry = cache.view();
+    ++state.geometryRevision;
+}
+
+bool loadMeshWithCache(const char *meshPath, const char *cachePath, RenderState &state, const MeshLoadOptions &options,
+                       MeshCache &cache, MeshLoadStats &stats, std::string &error)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    MeshCacheSource source;
+    if (!describeMeshSource(meshPath, options, source, error))
+        return false;
+
+    std::string reason;
+    const bool cacheCurrent = cache.open(cachePath, &source, reason);
+    if (!cacheCurrent)
+    {
+        std::fprintf(stderr, "Rebuilding mesh cache: %s\n", reason.c_str());
+
+        // open() dropped any previous mapping; stop drawing from it
+        state.externalGeometry = GeometryView{};
+        ++state.geometryRevision;
+        if (!loadMeshFile(meshPath, state, options, stats, error))
+            return false;
+
+        std::string writeError;
+        if (!writeMeshCache(cachePath, state.basePoints3d, state.edges3d, state.triangles3d, source, stats, writeError) ||
+            !cache.open(cachePath, &source, writeError))
+        {
+            std::fprintf(stderr, "Mesh cache not used: %s\n", writeError.c_str());
+            return true;
+        }
+    }
+
+    useCache(cache, state);
+    stats.fileBytes = cache.fileBytes();
+    stats.vertices = cache.view().vertexCount;
+    stats.edges = cache.view().edgeCount;
+    stats.faces = cache.faces();
+    stats.duplicateEdges = cache.duplicateEdges();
+    stats.fromCache = cacheCurrent;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    struct rusage usage;
+    stats.peakResidentKb = (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss : 0;
+    return true;
+}
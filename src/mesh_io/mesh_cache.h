@@ -0,0 +1,123 @@
+/**
+ * @file mesh_cache.h
+ * @brief Memory-mappable binary wireframe cache for imported meshes.
+ *
+ * Layout (native little-endian, every block 64-byte aligned):
+ *   header       magic, version, byte-order mark, counts, block offsets,
+ *                source identity and a checksum of the whole file
+ *   x, y, z      vertexCount floats each (structure of arrays)
+ *   pointColors  vertexCount packed ARGB8888 colors   (optional)
+ *   edgeIndices  2 * edgeCount uint32 vertex indices
+ *   edgeColors   edgeCount packed ARGB8888 colors     (optional)
+ *   triangles    3 * triangleCount uint32 vertex indices (solid faces)
+ *
+ * The blocks match GeometryView, so an opened cache is drawn straight from
+ * the mapping: startup cost is the checksum pass plus page faults, with no
+ * parsing and no copy into std::vector<Point3d>. When the color blocks are
+ * absent every point and edge uses the header's uniform color.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../app_state/app_state.h" // Point3d, Edge3d, GeometryView, RenderState
+#include "mapped_file.h"
+#include "mesh_loader.h"           // MeshLoadOptions, MeshLoadStats
+
+/**
+ * @brief Identity of the source file and import settings a cache was built from.
+ *
+ * A cache whose recorded source differs from the current one is stale.
+ */
+struct MeshCacheSource
+{
+    std::uint64_t bytes = 0;      ///< Source file size
+    std::int64_t modifiedNs = 0;  ///< Source modification time (ns since the epoch)
+    std::uint32_t optionsKey = 0; ///< Hash of the MeshLoadOptions used for the import
+};
+
+/**
+ * @brief Describe meshPath and options as a MeshCacheSource.
+ * @return false (with error set) if the file cannot be stat'ed.
+ */
+bool describeMeshSource(const char *meshPath, const MeshLoadOptions &options, MeshCacheSource &source, std::string &error);
+
+/**
+ * @brief Write points/edges/triangles as a cache file.
+ *
+ * The file is written to a temporary name and renamed into place, so readers
+ * never observe a partial cache. Edges and triangles with out-of-range
+ * indices are dropped.
+ *
+ * @param cachePath Destination file.
+ * @param points    Vertices to store.
+ * @param edges     Edges to store.
+ * @param triangles Solid faces to store, three vertex indices each.
+ * @param source    Identity recorded for staleness checks.
+ * @param stats     Face and duplicate-edge counts recorded for reporting.
+ * @param error     Receives a message on failure.
+ * @return true on success.
+ */
+bool writeMeshCache(const char *cachePath, const std::vector<Point3d> &points, const std::vector<Edge3d> &edges,
+                    const std::vector<std::uint32_t> &triangles, const MeshCacheSource &source, const MeshLoadStats &stats,
+                    std::string &error);
+
+/**
+ * @brief A mapped, validated cache file exposed as a GeometryView.
+ *
+ * The view points into the mapping and stays valid until close(), open() or
+ * destruction.
+ */
+class MeshCache
+{
+public:
+    /**
+     * @brief Map and validate path, replacing any previous mapping.
+     *
+     * Checks the magic, version, byte order, block bounds, checksum, edge and
+     * triangle indices. If expected is non-null the recorded source must match it.
+     *
+     * @param path     Cache file.
+     * @param expected Current source identity, or null to skip the check.
+     * @param error    Receives the reason the cache is unusable.
+     * @return true if the cache can be drawn.
+     */
+    bool open(const char *path, const MeshCacheSource *expected, std::string &error);
+
+    /** Unmap the cache and reset the view. */
+    void close();
+
+    const GeometryView &view() const { return geometry; }
+    std::size_t fileBytes() const { return file.size(); }
+    std::size_t faces() const { return faceCount; }
+    std::size_t duplicateEdges() const { return duplicateCount; }
+
+private:
+    MappedFile file;
+    GeometryView geometry;
+    std::size_t faceCount = 0;
+    std::size_t duplicateCount = 0;
+};
+
+/**
+ * @brief Show meshPath through its binary cache.
+ *
+ * Maps cachePath if it is current for meshPath and options. Otherwise the
+ * mesh is imported with loadMeshFile, a fresh cache is written and mapped.
+ * Either way the mapped geometry is installed as state.externalGeometry and
+ * geometryRevision is bumped. If the cache cannot be written the imported
+ * copy in basePoints3d/edges3d is used and a warning is printed.
+ *
+ * @param meshPath  OBJ / PLY source.
+ * @param cachePath Cache file to use or (re)build.
+ * @param state     Receives the geometry.
+ * @param options   Import settings (part of the cache identity).
+ * @param cache     Owns the mapping; must outlive every frame that draws it.
+ * @param stats     Receives counts, time and peak memory (fromCache tells which path ran).
+ * @param error     Receives a message on failure.
+ * @return true on success.
+ */
+bool loadMeshWithCache(const char *meshPath, const char *cachePath, RenderState &state, const MeshLoadOptions &options,
+                       MeshCache &cache, MeshLoadStats &stats, std::string &error);
@@ -0,0 +1,741 @@
+// mesh_loader.cpp
+// Single-pass OBJ / PLY import from a memory-mapped file.
+// Responsibilities:
+//  - OBJ 'v', 'f' and 'l' records (other records are skipped)
+//  - PLY header parsing and ascii / binary element decoding
+//  - face -> unique edge conversion through EdgeSet
+//  - face -> triangle fan conversion for hidden-line removal
+//  - normalization and hand-off into RenderState
+
+#include "mesh_loader.h"
+#include "edge_set.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sys/resource.h>
+#include <vector>
+
+// Parsed geometry before it is committed to RenderState
+struct ImportedMesh
+{
+    std::vector<Point3d> points;
+    EdgeSet edges;
+    std::vector<std::uint32_t> triangles; ///< Closed faces as triangle fans
+    std::size_t faces = 0;
+    std::uint64_t maxIndex = 0; ///< Largest vertex index referenced (+1), validated at the end
+    bool hasVertexColors = false;
+};
+
+static void addPolygon(ImportedMesh &mesh, const std::vector<std::uint32_t> &polygon, bool closed)
+{
+    for (std::size_t i = 0; i + 1 < polygon.size(); ++i)
+    {
+        mesh.edges.insert(polygon[i], polygon[i + 1]);
+    }
+    if (closed && polygon.size() > 2)
+    {
+        mesh.edges.insert(polygon.back(), polygon.front());
+        for (std::size_t i = 1; i + 1 < polygon.size(); ++i)
+        {
+            mesh.triangles.insert(mesh.triangles.end(), {polygon.front(), polygon[i], polygon[i + 1]});
+        }
+    }
+    for (const std::uint32_t index : polygon)
+    {
+        mesh.maxIndex = std::max<std::uint64_t>(mesh.maxIndex, static_cast<std::uint64_t>(index) + 1);
+    }
+    ++mesh.faces;
+}
+
+static int colorFromUnit(float value)
+{
+    return static_cast<int>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+}
+
+// Text helpers
+// ------------
+
+struct TextCursor
+{
+    const char *pos;
+    const char *end;
+};
+
+static void skipBlanks(TextCursor &cursor)
+{
+    while (cursor.pos < cursor.end && (*cursor.pos == ' ' || *cursor.pos == '\t' || *cursor.pos == '\r'))
+        ++cursor.pos;
+}
+
+static void skipLine(TextCursor &cursor)
+{
+    const void *newline = std::memchr(cursor.pos, '\n', static_cast<std::size_t>(cursor.end - cursor.pos));
+    cursor.pos = newline ? static_cast<const char *>(newline) + 1 : cursor.end;
+}
+
+static bool atLineEnd(const TextCursor &cursor)
+{
+    return cursor.pos >= cursor.end || *cursor.pos == '\n' || *cursor.pos == '#';
+}
+
+static void skipToken(TextCursor &cursor)
+{
+    while (cursor.pos < cursor.end && *cursor.pos != ' ' && *cursor.pos != '\t' && *cursor.pos != '\r' && *cursor.pos != '\n')
+        ++cursor.pos;
+}
+
+template <typename Number>
+static bool parseNumber(TextCursor &cursor, Number &out)
+{
+    if (cursor.pos < cursor.end && *cursor.pos == '+')
+        ++cursor.pos;
+    const std::from_chars_result result = std::from_chars(cursor.pos, cursor.end, out);
+    if (result.ec != std::errc())
+        return false;
+    cursor.pos = result.ptr;
+    return true;
+}
+
+// Wavefront OBJ
+// -------------
+
+static bool parseObj(const char *data, std::size_t size, const MeshLoadOptions &options, ImportedMesh &mesh, std::string &error)
+{
+    TextCursor cursor{data, data + size};
+    std::vector<std::uint32_t> polygon;
+    std::size_t line = 1;
+
+    auto fail = [&](const char *what)
+    {
+        error = "OBJ line " + std::to_string(line) + ": " + what;
+        return false;
+    };
+
+    for (; cursor.pos < cursor.end; skipLine(cursor), ++line)
+    {
+        skipBlanks(cursor);
+        if (cursor.end - cursor.pos < 2 || (cursor.pos[1] != ' ' && cursor.pos[1] != '\t'))
+            continue;
+        const char record = cursor.pos[0];
+
+        if (record == 'v')
+        {
+            cursor.pos += 2;
+            Point3d point{0.0f, 0.0f, 0.0f, options.red, options.green, options.blue};
+            float *coordinates[3] = {&point.x, &point.y, &point.z};
+            for (float *coordinate : coordinates)
+            {
+                skipBlanks(cursor);
+                if (!parseNumber(cursor, *coordinate))
+                    return fail("expected three vertex coordinates");
+            }
+
+            // Optional "w" and/or the common "r g b" color extension (0..1)
+            float extra[4];
+            int extraCount = 0;
+            for (skipBlanks(cursor); extraCount < 4 && !atLineEnd(cursor); skipBlanks(cursor))
+            {
+                if (!parseNumber(cursor, extra[extraCount]))
+                    break;
+                ++extraCount;
+            }
+            if (extraCount >= 3)
+            {
+                const float *rgb = extra + (extraCount - 3);
+                point.red = colorFromUnit(rgb[0]);
+                point.green = colorFromUnit(rgb[1]);
+                point.blue = colorFromUnit(rgb[2]);
+                mesh.hasVertexColors = true;
+            }
+            mesh.points.push_back(point);
+        }
+        else if (record == 'f' || record == 'l')
+        {
+            cursor.pos += 2;
+            polygon.clear();
+            for (skipBlanks(cursor); !atLineEnd(cursor); skipBlanks(cursor))
+            {
+                long index = 0;
+                if (!parseNumber(cursor, index) || index == 0)
+                    return fail("invalid vertex index");
+                skipToken(cursor); // Texture / normal references ("i/t/n")
+
+                // Negative indices count back from the most recent vertex
+                const long resolved = (index > 0) ? index - 1 : static_cast<long>(mesh.points.size()) + index;
+                if (resolved < 0 || resolved > static_cast<long>(UINT32_MAX - 1))
+                    return fail("vertex index out of range");
+                polygon.push_back(static_cast<std::uint32_t>(resolved));
+            }
+            if (polygon.size() < 2)
+                return fail("face or line needs at least two vertices");
+            addPolygon(mesh, polygon, record == 'f');
+        }
+    }
+    return true;
+}
+
+// PLY
+// ---
+
+enum class PlyFormat
+{
+    Ascii,
+    BinaryLittleEndian,
+    BinaryBigEndian
+};
+
+enum class PlyType
+{
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64,
+    Invalid
+};
+
+struct PlyProperty
+{
+    std::string name;
+    PlyType type = PlyType::Invalid;
+    bool isList = false;
+    PlyType countType = PlyType::Invalid;
+};
+
+struct PlyElement
+{
+    std::string name;
+    std::size_t count = 0;
+    std::vector<PlyProperty> properties;
+};
+
+static PlyType plyTypeFromName(const std::string &name)
+{
+    if (name == "char" || name == "int8")
+        return PlyType::Int8;
+    if (name == "uchar" || name == "uint8")
+        return PlyType::UInt8;
+    if (name == "short" || name == "int16")
+        return PlyType::Int16;
+    if (name == "ushort" || name == "uint16")
+        return PlyType::UInt16;
+    if (name == "int" || name == "int32")
+        return PlyType::Int32;
+    if (name == "uint" || name == "uint32")
+        return PlyType::UInt32;
+    if (name == "float" || name == "float32")
+        return PlyType::Float32;
+    if (name == "double" || name == "float64")
+        return PlyType::Float64;
+    return PlyType::Invalid;
+}
+
+static std::size_t plyTypeSize(PlyType type)
+{
+    switch (type)
+    {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+        return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+        return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+        return 4;
+    case PlyType::Float64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+static bool isFloatType(PlyType type)
+{
+    return type == PlyType::Float32 || type == PlyType::Float64;
+}
+
+// Reads one scalar at a time from the element data in the file's encoding
+template <PlyFormat Format>
+struct PlyReader
+{
+    TextCursor cursor;
+
+    bool read(PlyType type, double &out)
+    {
+        if (Format == PlyFormat::Ascii)
+        {
+            while (cursor.pos < cursor.end && (*cursor.pos == ' ' || *cursor.pos == '\t' || *cursor.pos == '\r' || *cursor.pos == '\n'))
+                ++cursor.pos;
+            return parseNumber(cursor, out);
+        }
+
+        const std::size_t size = plyTypeSize(type);
+        if (static_cast<std::size_t>(cursor.end - cursor.pos) < size)
+            return false;
+        unsigned char bytes[8];
+        std::memcpy(bytes, cursor.pos, size);
+        cursor.pos += size;
+
+        const bool fileIsLittleEndian = (Format == PlyFormat::BinaryLittleEndian);
+        const bool hostIsLittleEndian = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+        if (fileIsLittleEndian != hostIsLittleEndian)
+            std::reverse(bytes, bytes + size);
+
+        switch (type)
+        {
+        case PlyType::Int8:
+            out = static_cast<std::int8_t>(bytes[0]);
+            return true;
+        case PlyType::UInt8:
+            out = bytes[0];
+            return true;
+        case PlyType::Int16:
+        {
+            std::int16_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            out = value;
+            return true;
+        }
+        case PlyType::UInt16:
+        {
+            std::uint16_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            out = value;
+            return true;
+        }
+        case PlyType::Int32:
+        {
+            std::int32_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            out = value;
+            return true;
+        }
+        case PlyType::UInt32:
+        {
+            std::uint32_t value;
+            std::memcpy(&value, bytes, sizeof(value));
+            out = value;
+            return true;
+        }
+        case PlyType::Float32:
+        {
+            float value;
+            std::memcpy(&value, bytes, sizeof(value));
+            out = value;
+            return true;
+        }
+        case PlyType::Float64:
+        {
+            std::memcpy(&out, bytes, sizeof(out));
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+};
+
+// Fewest body bytes one item of element can take: its binary size, or in
+// ASCII one digit and one separator per value (empty lists included)
+static std::size_t minimumItemBytes(const PlyElement &element, PlyFormat format)
+{
+    std::size_t bytes = 0;
+    for (const PlyProperty &property : element.properties)
+        bytes += format == PlyFormat::Ascii ? 2 : plyTypeSize(property.isList ? property.countType : property.type);
+    return std::max<std::size_t>(bytes, 1);
+}
+
+// Split the header into elements; returns the offset of the first body byte
+static bool parsePlyHeader(const char *data, std::size_t size, PlyFormat &format, std::vector<PlyElement> &elements,
+                           std::size_t &bodyOffset, std::string &error)
+{
+    TextCursor cursor{data, data + size};
+    bool sawFormat = false;
+
+    for (std::size_t line = 1; cursor.pos < cursor.end; ++line)
+    {
+        const char *lineStart = cursor.pos;
+        skipLine(cursor);
+        std::vector<std::string> words;
+        TextCursor words_cursor{lineStart, cursor.pos};
+        for (skipBlanks(words_cursor); words_cursor.pos < words_cursor.end && *words_cursor.pos != '\n'; skipBlanks(words_cursor))
+        {
+            const char *wordStart = words_cursor.pos;
+            skipToken(words_cursor);
+            words.emplace_back(wordStart, words_cursor.pos);
+        }
+
+        auto fail = [&](const char *what)
+        {
+            error = "PLY header line " + std::to_string(line) + ": " + what;
+            return false;
+        };
+
+        if (line == 1)
+        {
+            if (words.size() != 1 || words[0] != "ply")
+                return fail("missing 'ply' magic");
+            continue;
+        }
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+            continue;
+
+        if (words[0] == "format")
+        {
+            if (words.size() < 2)
+                return fail("incomplete format line");
+            if (words[1] == "ascii")
+                format = PlyFormat::Ascii;
+            else if (words[1] == "binary_little_endian")
+                format = PlyFormat::BinaryLittleEndian;
+            else if (words[1] == "binary_big_endian")
+                format = PlyFormat::BinaryBigEndian;
+            else
+                return fail("unknown format");
+            sawFormat = true;
+        }
+        else if (words[0] == "element")
+        {
+            if (words.size() != 3)
+                return fail("malformed element line");
+            PlyElement element;
+            element.name = words[1];
+            char *end = nullptr;
+            element.count = static_cast<std::size_t>(std::strtoull(words[2].c_str(), &end, 10));
+            if (!end || *end != '\0')
+                return fail("invalid element count");
+            elements.push_back(std::move(element));
+        }
+        else if (words[0] == "property")
+        {
+            if (elements.empty())
+                return fail("property before any element");
+            PlyProperty property;
+            if (words.size() == 5 && words[1] == "list")
+            {
+                property.isList = true;
+                property.countType = plyTypeFromName(words[2]);
+                property.type = plyTypeFromName(words[3]);
+                property.name = words[4];
+                if (property.countType == PlyType::Invalid || isFloatType(property.countType))
+                    return fail("invalid list count type");
+            }
+            else if (words.size() == 3)
+            {
+                property.type = plyTypeFromName(words[1]);
+                property.name = words[2];
+            }
+            else
+            {
+                return fail("malformed property line");
+            }
+            if (property.type == PlyType::Invalid)
+                return fail("unknown property type");
+            elements.back().properties.push_back(std::move(property));
+        }
+        else if (words[0] == "end_header")
+        {
+            if (!sawFormat)
+                return fail("missing format line");
+            bodyOffset = static_cast<std::size_t>(cursor.pos - data);
+
+            // The counts size reservations, so none may claim more items than
+            // the body can hold (the last ASCII value may lack its separator)
+            std::size_t remaining = size - bodyOffset + (format == PlyFormat::Ascii ? 1 : 0);
+            for (const PlyElement &element : elements)
+            {
+                const std::size_t itemBytes = minimumItemBytes(element, format);
+                if (element.count > remaining / itemBytes)
+                {
+                    error = "PLY element '" + element.name + "': invalid element count";
+                    return false;
+                }
+                remaining -= element.count * itemBytes;
+            }
+            return true;
+        }
+        else
+        {
+            return fail("unknown header keyword");
+        }
+    }
+    error = "PLY header has no end_header";
+    return false;
+}
+
+static int propertyIndex(const PlyElement &element, std::initializer_list<const char *> names)
+{
+    for (std::size_t i = 0; i < element.properties.size(); ++i)
+    {
+        for (const char *name : names)
+        {
+            if (element.properties[i].name == name)
+                return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+template <PlyFormat Format>
+static bool parsePlyBody(PlyReader<Format> &reader, const std::vector<PlyElement> &elements, const MeshLoadOptions &options,
+                         ImportedMesh &mesh, std::string &error)
+{
+    std::vector<std::uint32_t> polygon;
+    std::vector<double> scalars;
+
+    for (const PlyElement &element : elements)
+    {
+        const bool isVertex = (element.name == "vertex");
+        const bool isFace = (element.name == "face");
+        const bool isEdge = (element.name == "edge");
+
+        // Property roles for the elements we understand (-1 = not present)
+        const int xIndex = isVertex ? propertyIndex(element, {"x"}) : -1;
+        const int yIndex = isVertex ? propertyIndex(element, {"y"}) : -1;
+        const int zIndex = isVertex ? propertyIndex(element, {"z"}) : -1;
+        const int redIndex = isVertex ? propertyIndex(element, {"red", "r", "diffuse_red"}) : -1;
+        const int greenIndex = isVertex ? propertyIndex(element, {"green", "g", "diffuse_green"}) : -1;
+        const int blueIndex = isVertex ? propertyIndex(element, {"blue", "b", "diffuse_blue"}) : -1;
+        const int listIndex = isFace ? propertyIndex(element, {"vertex_indices", "vertex_index"}) : -1;
+        const int firstIndex = isEdge ? propertyIndex(element, {"vertex1"}) : -1;
+        const int secondIndex = isEdge ? propertyIndex(element, {"vertex2"}) : -1;
+
+        if (isVertex && (xIndex < 0 || yIndex < 0 || zIndex < 0))
+        {
+            error = "PLY vertex element lacks x/y/z";
+            return false;
+        }
+        const bool hasColor = isVertex && redIndex >= 0 && greenIndex >= 0 && blueIndex >= 0;
+        mesh.hasVertexColors = mesh.hasVertexColors || hasColor;
+        if (isVertex)
+            mesh.points.reserve(mesh.points.size() + element.count);
+
+        scalars.resize(element.properties.size());
+        for (std::size_t item = 0; item < element.count; ++item)
+        {
+            polygon.clear();
+            for (std::size_t p = 0; p < element.properties.size(); ++p)
+            {
+                const PlyProperty &property = element.properties[p];
+                if (!property.isList)
+                {
+                    if (!reader.read(property.type, scalars[p]))
+                    {
+                        error = "PLY data ended early in element '" + element.name + "'";
+                        return false;
+                    }
+                    continue;
+                }
+
+                double countValue = 0.0;
+                if (!reader.read(property.countType, countValue) || countValue < 0.0)
+                {
+                    error = "PLY data ended early in element '" + element.name + "'";
+                    return false;
+                }
+                const auto count = static_cast<std::size_t>(countValue);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    double value = 0.0;
+                    if (!reader.read(property.type, value))
+                    {
+                        error = "PLY data ended early in element '" + element.name + "'";
+                        return false;
+                    }
+                    if (static_cast<int>(p) == listIndex)
+                    {
+                        if (value < 0.0 || value > static_cast<double>(UINT32_MAX - 1))
+                        {
+                            error = "PLY face has an invalid vertex index";
+                            return false;
+                        }
+                        polygon.push_back(static_cast<std::uint32_t>(value));
+                    }
+                }
+            }
+
+            if (isVertex)
+            {
+                Point3d point{static_cast<float>(scalars[xIndex]), static_cast<float>(scalars[yIndex]), static_cast<float>(scalars[zIndex]),
+                              options.red, options.green, options.blue};
+                if (hasColor)
+                {
+                    const double rgb[3] = {scalars[redIndex], scalars[greenIndex], scalars[blueIndex]};
+                    int *channels[3] = {&point.red, &point.green, &point.blue};
+                    const int colorIndices[3] = {redIndex, greenIndex, blueIndex};
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        *channels[c] = isFloatType(element.properties[colorIndices[c]].type)
+                                           ? colorFromUnit(static_cast<float>(rgb[c]))
+                                           : static_cast<int>(std::min(std::max(rgb[c], 0.0), 255.0));
+                    }
+                }
+                mesh.points.push_back(point);
+            }
+            else if (isFace && polygon.size() >= 2)
+            {
+                addPolygon(mesh, polygon, true);
+            }
+            else if (isEdge && firstIndex >= 0 && secondIndex >= 0)
+            {
+                const double a = scalars[firstIndex], b = scalars[secondIndex];
+                if (a < 0.0 || b < 0.0 || a > static_cast<double>(UINT32_MAX - 1) || b > static_cast<double>(UINT32_MAX - 1))
+                {
+                    error = "PLY edge has an invalid vertex index";
+                    return false;
+                }
+                polygon.push_back(static_cast<std::uint32_t>(a));
+                polygon.push_back(static_cast<std::uint32_t>(b));
+                addPolygon(mesh, polygon, false);
+            }
+        }
+    }
+    return true;
+}
+
+static bool parsePly(const char *data, std::size_t size, const MeshLoadOptions &options, ImportedMesh &mesh, std::string &error)
+{
+    PlyFormat format = PlyFormat::Ascii;
+    std::vector<PlyElement> elements;
+    std::size_t bodyOffset = 0;
+    if (!parsePlyHeader(data, size, format, elements, bodyOffset, error))
+        return false;
+
+    // Reserve the dedup table from the face count (about 1.5 edges per triangle)
+    for (const PlyElement &element : elements)
+    {
+        if (element.name == "face")
+            mesh.edges.reserve(element.count * 3 / 2 + 16);
+    }
+
+    const TextCursor body{data + bodyOffset, data + size};
+    switch (format)
+    {
+    case PlyFormat::Ascii:
+    {
+        PlyReader<PlyFormat::Ascii> reader{body};
+        return parsePlyBody(reader, elements, options, mesh, error);
+    }
+    case PlyFormat::BinaryLittleEndian:
+    {
+        PlyReader<PlyFormat::BinaryLittleEndian> reader{body};
+        return parsePlyBody(reader, elements, options, mesh, error);
+    }
+    default:
+    {
+        PlyReader<PlyFormat::BinaryBigEndian> reader{body};
+        return parsePlyBody(reader, elements, options, mesh, error);
+    }
+    }
+}
+
+// Import entry point
+// ------------------
+
+// Center on the bounding box and scale so the farthest vertex sits at the
+// cube's corner distance (sqrt(3)), matching the built-in primitives
+static void normalizePoints(std::vector<Point3d> &points)
+{
+    if (points.empty())
+        return;
+
+    float minimum[3] = {points[0].x, points[0].y, points[0].z};
+    float maximum[3] = {points[0].x, points[0].y, points[0].z};
+    for (const Point3d &point : points)
+    {
+        const float coordinates[3] = {point.x, point.y, point.z};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            minimum[axis] = std::min(minimum[axis], coordinates[axis]);
+            maximum[axis] = std::max(maximum[axis], coordinates[axis]);
+        }
+    }
+    const float center[3] = {(minimum[0] + maximum[0]) * 0.5f, (minimum[1] + maximum[1]) * 0.5f, (minimum[2] + maximum[2]) * 0.5f};
+
+    double radiusSquared = 0.0;
+    for (const Point3d &point : points)
+    {
+        const double dx = point.x - center[0], dy = point.y - center[1], dz = point.z - center[2];
+        radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+    }
+    const float scale = radiusSquared > 0.0 ? static_cast<float>(std::sqrt(3.0 / radiusSquared)) : 1.0f;
+
+    for (Point3d &point : points)
+    {
+        point.x = (point.x - center[0]) * scale;
+        point.y = (point.y - center[1]) * scale;
+        point.z = (point.z - center[2]) * scale;
+    }
+}
+
+bool loadMeshFile(const char *path, RenderState &state, const MeshLoadOptions &options, MeshLoadStats &stats, std::string &error)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    MappedFile file;
+    if (!file.open(path, true, error))
+        return false;
+
+    ImportedMesh mesh;
+    const bool isPly = file.size() >= 4 && std::memcmp(file.data(), "ply", 3) == 0 &&
+                       (file.data()[3] == '\n' || file.data()[3] == '\r');
+    const bool parsed = isPly ? parsePly(file.data(), file.size(), options, mesh, error)
+                              : parseObj(file.data(), file.size(), options, mesh, error);
+    if (!parsed)
+        return false;
+
+    if (mesh.maxIndex > mesh.points.size())
+    {
+        error = "mesh references vertex " + std::to_string(mesh.maxIndex) + " but has only " + std::to_string(mesh.points.size());
+        return false;
+    }
+    if (mesh.points.size() > static_cast<std::size_t>(INT32_MAX))
+    {
+        error = "mesh has too many vertices";
+        return false;
+    }
+
+    if (options.normalize)
+        normalizePoints(mesh.points);
+
+    // Edges take their first vertex's color when the file carries vertex colors
+    mesh.edges.releaseTable();
+    const std::vector<std::uint64_t> &uniqueEdges = mesh.edges.edges();
+    std::vector<Edge3d> edges3d;
+    edges3d.reserve(uniqueEdges.size());
+    for (const std::uint64_t key : uniqueEdges)
+    {
+        const int a = static_cast<int>(EdgeSet::first(key)), b = static_cast<int>(EdgeSet::second(key));
+        const Point3d &colorSource = mesh.points[a];
+        if (mesh.hasVertexColors)
+            edges3d.push_back({a, b, colorSource.red, colorSource.green, colorSource.blue});
+        else
+            edges3d.push_back({a, b, options.red, options.green, options.blue});
+    }
+
+    stats.fileBytes = file.size();
+    stats.vertices = mesh.points.size();
+    stats.faces = mesh.faces;
+    stats.edges = edges3d.size();
+    stats.duplicateEdges = mesh.edges.duplicates();
+
+    state.basePoints3d = std::move(mesh.points);
+    state.edges3d = std::move(edges3d);
+    state.triangles3d = std::move(mesh.triangles);
+    state.externalGeometry = GeometryView{};
+    ++state.geometryRevision;
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    struct rusage usage;
+    stats.peakResidentKb = (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss : 0;
+    return true;
+}
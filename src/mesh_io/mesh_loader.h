@@ -0,0 +1,57 @@
+/**
+ * @file mesh_loader.h
+ * @brief Wavefront OBJ and PLY (ASCII / binary) import into RenderState.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "../app_state/app_state.h" // RenderState
+
+/**
+ * @brief Import settings.
+ */
+struct MeshLoadOptions
+{
+    int red = 255, green = 255, blue = 255; ///< Color used when the file has no vertex colors
+    bool normalize = true;                  ///< Center the mesh and scale it to the cube's bounding radius
+};
+
+/**
+ * @brief What an import read and what it cost.
+ */
+struct MeshLoadStats
+{
+    std::size_t fileBytes = 0;      ///< Size of the mapped file
+    std::size_t vertices = 0;       ///< Vertices read
+    std::size_t faces = 0;          ///< Faces and polylines read
+    std::size_t edges = 0;          ///< Unique edges produced
+    std::size_t duplicateEdges = 0; ///< Shared edges dropped by deduplication
+    double seconds = 0.0;           ///< Wall time for the whole import
+    long peakResidentKb = 0;        ///< Process peak resident set size after the import
+    bool fromCache = false;         ///< Geometry was mapped from a binary cache instead of parsed
+};
+
+/**
+ * @brief Load an OBJ or PLY file into state.basePoints3d / state.edges3d.
+ *
+ * The file is memory-mapped and parsed in one forward pass. Faces (and OBJ
+ * 'l' polylines, PLY 'edge' elements) are turned into undirected edges and
+ * deduplicated with a hash set, so an edge shared by two faces is drawn once.
+ * Faces are also split into triangle fans in state.triangles3d, which the
+ * hidden-line mode uses as occluders.
+ * PLY files may be ascii, binary_little_endian or binary_big_endian; the
+ * format is detected from the "ply" magic, everything else is read as OBJ.
+ * Vertex colors (PLY red/green/blue, OBJ "v x y z r g b") are kept; edges
+ * take the color of their first vertex.
+ *
+ * On success externalGeometry is cleared and geometryRevision is bumped. On failure state is left unchanged.
+ *
+ * @param path    File to load.
+ * @param state   Receives the geometry.
+ * @param options Default color and normalization.
+ * @param stats   Receives counts, load time and peak memory.
+ * @param error   Receives a message on failure.
+ * @return true on success.
+ */
+bool loadMeshFile(const char *path, RenderState &state, const MeshLoadOptions &options, MeshLoadStats &stats, std::string &error);
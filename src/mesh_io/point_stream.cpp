@@ -0,0 +1,596 @@
+// point_stream.cpp
+// Chunked point cloud files: streaming writer, validating reader and the
+// prefetch / release bookkeeping that bounds the resident set.
+
+#include "point_stream.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <type_traits>
+#include <unistd.h>
+
+// Bump whenever the layout or the meaning of a field changes
+constexpr std::uint32_t POINT_STREAM_VERSION = 1;
+constexpr std::uint32_t POINT_STREAM_BYTE_ORDER = 0x01020304u;
+constexpr char POINT_STREAM_MAGIC[8] = {'W', 'F', 'P', 'O', 'I', 'N', 'T', 'S'};
+constexpr std::size_t POINT_STREAM_BLOCK_ALIGNMENT = 64;
+constexpr std::size_t POINT_STREAM_CHUNK_ALIGNMENT = 4096; // Chunks start on a page so they can be released alone
+constexpr std::size_t POINT_STREAM_HEADER_BYTES = 4096;
+constexpr std::uint32_t POINT_STREAM_MAX_CHUNK_POINTS = 1u << 24;
+
+constexpr std::uint32_t POINT_STREAM_HAS_COLORS = 1u << 0;
+
+// Chunks requested ahead of the one being drawn
+constexpr std::size_t PREFETCH_CHUNKS = 4;
+
+struct PointStreamHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t fileBytes;
+    std::uint64_t pointCount;
+    std::uint64_t chunkCount;
+    std::uint64_t chunkTableOffset;
+    std::uint32_t chunkPoints; // Most points in any chunk
+    std::uint32_t flags;
+    std::uint32_t uniformColor;
+    float boundsMin[3];
+    float boundsMax[3];
+    std::uint32_t reserved;
+};
+
+static_assert(std::is_trivially_copyable<PointStreamHeader>::value, "header is written with memcpy");
+static_assert(sizeof(PointStreamHeader) <= POINT_STREAM_HEADER_BYTES, "header must fit its reserved page");
+static_assert(std::is_trivially_copyable<PointStreamChunkRecord>::value && sizeof(PointStreamChunkRecord) == 40,
+              "chunk table entries are written with memcpy");
+
+static std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Bytes from one block of a chunk to the next
+static std::uint64_t blockStride(std::uint64_t count)
+{
+    return alignUp(count * sizeof(float), POINT_STREAM_BLOCK_ALIGNMENT);
+}
+
+static std::uint64_t chunkBytes(std::uint64_t count, bool hasColors)
+{
+    return blockStride(count) * (hasColors ? 4 : 3);
+}
+
+static void growBounds(Aabb &box, float x, float y, float z)
+{
+    const float point[3] = {x, y, z};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        box.min[axis] = std::min(box.min[axis], point[axis]);
+        box.max[axis] = std::max(box.max[axis], point[axis]);
+    }
+}
+
+static Aabb emptyBounds()
+{
+    return {{3.4e38f, 3.4e38f, 3.4e38f}, {-3.4e38f, -3.4e38f, -3.4e38f}};
+}
+
+// SplitMix64, for the per-chunk shuffle
+static std::uint64_t nextRandom(std::uint64_t &state)
+{
+    std::uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Writer
+// ------
+
+PointStreamWriter::~PointStreamWriter()
+{
+    if (file)
+    {
+        std::fclose(file);
+        std::remove(temporaryPath.c_str());
+    }
+}
+
+bool PointStreamWriter::open(const char *destination, std::uint32_t pointsPerChunk, bool withColors, std::uint32_t color, std::string &error)
+{
+    if (pointsPerChunk == 0 || pointsPerChunk > POINT_STREAM_MAX_CHUNK_POINTS)
+    {
+        error = "invalid chunk size";
+        return false;
+    }
+    path = destination;
+    temporaryPath = path + ".tmp" + std::to_string(getpid());
+    file = std::fopen(temporaryPath.c_str(), "wb");
+    if (!file)
+    {
+        error = "cannot create '" + temporaryPath + "': " + std::strerror(errno);
+        return false;
+    }
+    chunkPoints = pointsPerChunk;
+    hasColors = withColors;
+    uniformColor = color;
+    ok = true;
+    written = 0;
+    totalPoints = 0;
+    x.clear();
+    y.clear();
+    z.clear();
+    colors.clear();
+    chunks.clear();
+    bounds = emptyBounds();
+    x.reserve(chunkPoints);
+    y.reserve(chunkPoints);
+    z.reserve(chunkPoints);
+    if (hasColors)
+        colors.reserve(chunkPoints);
+
+    // The header is patched in by finish()
+    padTo(POINT_STREAM_HEADER_BYTES);
+    return ok;
+}
+
+void PointStreamWriter::append(float px, float py, float pz, std::uint32_t color)
+{
+    x.push_back(px);
+    y.push_back(py);
+    z.push_back(pz);
+    if (hasColors)
+        colors.push_back(color);
+    ++totalPoints;
+    if (x.size() == chunkPoints)
+        flushChunk();
+}
+
+void PointStreamWriter::write(const void *data, std::size_t size)
+{
+    if (!ok || size == 0)
+        return;
+    ok = std::fwrite(data, 1, size, file) == size;
+    written += size;
+}
+
+void PointStreamWriter::padTo(std::uint64_t offset)
+{
+    static const char zeros[POINT_STREAM_CHUNK_ALIGNMENT] = {};
+    while (ok && written < offset)
+    {
+        write(zeros, static_cast<std::size_t>(std::min<std::uint64_t>(offset - written, sizeof(zeros))));
+    }
+}
+
+void PointStreamWriter::flushChunk()
+{
+    const std::size_t count = x.size();
+    if (count == 0)
+        return;
+
+    // Shuffle so any prefix of the chunk samples all of it evenly; seeded by
+    // the chunk index, so the same input always gives the same file
+    order.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+        order[i] = static_cast<std::uint32_t>(i);
+    std::uint64_t random = chunks.size() + 1;
+    for (std::size_t i = count - 1; i > 0; --i)
+        std::swap(order[i], order[static_cast<std::size_t>(nextRandom(random) % (i + 1))]);
+
+    PointStreamChunkRecord record{};
+    record.offset = alignUp(written, POINT_STREAM_CHUNK_ALIGNMENT);
+    record.count = static_cast<std::uint32_t>(count);
+    Aabb box = emptyBounds();
+    for (std::size_t i = 0; i < count; ++i)
+        growBounds(box, x[i], y[i], z[i]);
+    std::memcpy(record.boundsMin, box.min, sizeof(box.min));
+    std::memcpy(record.boundsMax, box.max, sizeof(box.max));
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        bounds.min[axis] = std::min(bounds.min[axis], box.min[axis]);
+        bounds.max[axis] = std::max(bounds.max[axis], box.max[axis]);
+    }
+
+    // Each block goes through a staging buffer in shuffled order
+    const std::uint64_t stride = blockStride(count);
+    float staging[4096];
+    const std::vector<float> *blocks[3] = {&x, &y, &z};
+    for (int block = 0; block < 3; ++block)
+    {
+        padTo(record.offset + stride * block);
+        const std::vector<float> &values = *blocks[block];
+        for (std::size_t begin = 0; begin < count; begin += 4096)
+        {
+            const std::size_t length = std::min<std::size_t>(4096, count - begin);
+            for (std::size_t i = 0; i < length; ++i)
+                staging[i] = values[order[begin + i]];
+            write(staging, length * sizeof(float));
+        }
+    }
+    if (hasColors)
+    {
+        padTo(record.offset + stride * 3);
+        std::uint32_t colorStaging[4096];
+        for (std::size_t begin = 0; begin < count; begin += 4096)
+        {
+            const std::size_t length = std::min<std::size_t>(4096, count - begin);
+            for (std::size_t i = 0; i < length; ++i)
+                colorStaging[i] = colors[order[begin + i]];
+            write(colorStaging, length * sizeof(std::uint32_t));
+        }
+    }
+    padTo(record.offset + chunkBytes(count, hasColors));
+
+    chunks.push_back(record);
+    x.clear();
+    y.clear();
+    z.clear();
+    colors.clear();
+}
+
+bool PointStreamWriter::finish(std::string &error)
+{
+    if (!file)
+    {
+        error = "no file open";
+        return false;
+    }
+    flushChunk();
+
+    PointStreamHeader header = {};
+    std::memcpy(header.magic, POINT_STREAM_MAGIC, sizeof(header.magic));
+    header.version = POINT_STREAM_VERSION;
+    header.byteOrder = POINT_STREAM_BYTE_ORDER;
+    header.pointCount = totalPoints;
+    header.chunkCount = chunks.size();
+    header.chunkTableOffset = alignUp(written, POINT_STREAM_BLOCK_ALIGNMENT);
+    header.chunkPoints = chunkPoints;
+    header.flags = hasColors ? POINT_STREAM_HAS_COLORS : 0;
+    header.uniformColor = uniformColor;
+    const Aabb box = totalPoints > 0 ? bounds : Aabb{{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+    std::memcpy(header.boundsMin, box.min, sizeof(box.min));
+    std::memcpy(header.boundsMax, box.max, sizeof(box.max));
+
+    padTo(header.chunkTableOffset);
+    write(chunks.data(), chunks.size() * sizeof(PointStreamChunkRecord));
+    header.fileBytes = written;
+
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = (std::fclose(file) == 0) && ok;
+    file = nullptr;
+    if (!ok || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        error = "cannot write '" + path + "': " + std::strerror(errno);
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool writePointStream(const char *path, const GeometryView &geometry, std::uint32_t chunkPoints, std::string &error)
+{
+    PointStreamWriter writer;
+    if (!writer.open(path, chunkPoints, geometry.pointColors != nullptr, geometry.uniformColor, error))
+        return false;
+    for (std::size_t i = 0; i < geometry.vertexCount; ++i)
+        writer.append(geometry.x[i], geometry.y[i], geometry.z[i], geometry.pointColors ? geometry.pointColors[i] : 0);
+    return writer.finish(error);
+}
+
+// Reader
+// ------
+
+bool PointStream::open(const char *path, std::string &error)
+{
+    chunkTable.clear();
+    ringHead = 0;
+    ringSize = 0;
+    batches.pointIndices.clear(); // A colored file's grouping leaves them permuted
+    if (!file.open(path, false, error))
+        return false;
+
+    const char *base = file.data();
+    const std::uint64_t size = file.size();
+    PointStreamHeader header;
+    if (size < POINT_STREAM_HEADER_BYTES)
+    {
+        error = "not a point stream (file too small)";
+        return false;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, POINT_STREAM_MAGIC, sizeof(header.magic)) != 0)
+    {
+        error = "not a point stream (bad magic)";
+        return false;
+    }
+    if (header.version != POINT_STREAM_VERSION || header.byteOrder != POINT_STREAM_BYTE_ORDER)
+    {
+        error = "unsupported point stream version or byte order";
+        return false;
+    }
+    if (header.fileBytes != size || header.chunkPoints == 0 || header.chunkPoints > POINT_STREAM_MAX_CHUNK_POINTS ||
+        header.chunkTableOffset < POINT_STREAM_HEADER_BYTES || header.chunkTableOffset > size)
+    {
+        error = "truncated or inconsistent point stream header";
+        return false;
+    }
+
+    // Chunk table: every chunk inside the data area, counts summing to the header's
+    if (header.chunkCount > (size - header.chunkTableOffset) / sizeof(PointStreamChunkRecord))
+    {
+        error = "truncated point stream chunk table";
+        return false;
+    }
+    hasColors = (header.flags & POINT_STREAM_HAS_COLORS) != 0;
+    std::uint64_t points = 0;
+    chunkTable.reserve(static_cast<std::size_t>(header.chunkCount));
+    for (std::uint64_t i = 0; i < header.chunkCount; ++i)
+    {
+        PointStreamChunkRecord record;
+        std::memcpy(&record, base + header.chunkTableOffset + i * sizeof(PointStreamChunkRecord), sizeof(record));
+        if (record.count == 0 || record.count > header.chunkPoints || record.offset % POINT_STREAM_CHUNK_ALIGNMENT != 0 ||
+            record.offset < POINT_STREAM_HEADER_BYTES || record.offset > header.chunkTableOffset ||
+            chunkBytes(record.count, hasColors) > header.chunkTableOffset - record.offset)
+        {
+            error = "point stream chunk " + std::to_string(i) + " lies outside the file";
+            chunkTable.clear();
+            return false;
+        }
+        Chunk chunk;
+        chunk.data = base + record.offset;
+        chunk.count = record.count;
+        chunk.stride = static_cast<std::size_t>(blockStride(record.count));
+        std::memcpy(chunk.bounds.min, record.boundsMin, sizeof(chunk.bounds.min));
+        std::memcpy(chunk.bounds.max, record.boundsMax, sizeof(chunk.bounds.max));
+        chunkTable.push_back(chunk);
+        points += record.count;
+    }
+    if (points != header.pointCount)
+    {
+        error = "point stream chunk counts do not add up";
+        chunkTable.clear();
+        return false;
+    }
+
+    totalPoints = header.pointCount;
+    maxChunkPoints = header.chunkPoints;
+    uniformColor = header.uniformColor;
+    std::memcpy(fileBounds.min, header.boundsMin, sizeof(fileBounds.min));
+    std::memcpy(fileBounds.max, header.boundsMax, sizeof(fileBounds.max));
+    resident.assign(chunkTable.size(), 0);
+    configure(pointBudget, residentChunkLimit * chunkBytes(maxChunkPoints, hasColors));
+    counters = PointStreamStats{};
+    lastMatrix.clear();
+    fraction = 1.0;
+    frameComplete = true;
+    return true;
+}
+
+void PointStream::configure(std::size_t budget, std::size_t residentBytes)
+{
+    // Chunks still resident from an earlier limit are released as usual
+    pointBudget = budget;
+    const std::uint64_t perChunk = std::max<std::uint64_t>(1, chunkBytes(std::max<std::size_t>(maxChunkPoints, 1), hasColors));
+    residentChunkLimit = std::max<std::size_t>(2, static_cast<std::size_t>(residentBytes / perChunk));
+    std::vector<std::uint32_t> ring(residentChunkLimit);
+    const std::size_t keep = std::min(ringSize, residentChunkLimit);
+    for (std::size_t i = 0; i < ringSize; ++i)
+    {
+        const std::uint32_t chunk = residentRing[(ringHead + i) % residentRing.size()];
+        if (i < ringSize - keep)
+            release(chunk);
+        else
+            ring[i - (ringSize - keep)] = chunk;
+    }
+    residentRing.swap(ring);
+    ringHead = 0;
+    ringSize = keep;
+}
+
+double PointStream::beginFrame(const void *matrixKey, std::size_t matrixBytes)
+{
+    const bool sameView = lastMatrix.size() == matrixBytes && std::memcmp(lastMatrix.data(), matrixKey, matrixBytes) == 0;
+    const double budgetFraction = pointBudget == 0 || totalPoints <= pointBudget
+                                      ? 1.0
+                                      : static_cast<double>(pointBudget) / static_cast<double>(totalPoints);
+    // A still view refines where the last frame stopped (and stays complete);
+    // a new view starts over
+    fraction = sameView ? std::min(1.0, fraction * 2.0) : budgetFraction;
+    if (!sameView)
+        lastMatrix.assign(static_cast<const unsigned char *>(matrixKey), static_cast<const unsigned char *>(matrixKey) + matrixBytes);
+    frameComplete = fraction >= 1.0;
+    return fraction;
+}
+
+void PointStream::endFrame(std::size_t pointsDrawn, std::size_t chunksCulled, double seconds)
+{
+    counters.pointsDrawn += pointsDrawn;
+    counters.frames += 1;
+    counters.drawSeconds += seconds;
+    counters.lastPoints = pointsDrawn;
+    counters.lastChunksCulled = chunksCulled;
+    counters.lastFraction = fraction;
+
+    // The next frame most likely starts with the same chunks; have them read
+    // while this frame is presented
+    prefetchAhead(0, fraction);
+}
+
+std::size_t PointStream::chunkPrefix(std::size_t chunk, double share) const
+{
+    const std::size_t count = chunkTable[chunk].count;
+    if (share >= 1.0)
+        return count;
+    return std::min(count, std::max<std::size_t>(1, static_cast<std::size_t>(static_cast<double>(count) * share + 0.5)));
+}
+
+GeometryView PointStream::chunkView(std::size_t chunk, std::size_t count) const
+{
+    const Chunk &entry = chunkTable[chunk];
+    GeometryView view;
+    view.x = reinterpret_cast<const float *>(entry.data);
+    view.y = reinterpret_cast<const float *>(entry.data + entry.stride);
+    view.z = reinterpret_cast<const float *>(entry.data + 2 * entry.stride);
+    view.pointColors = hasColors ? reinterpret_cast<const std::uint32_t *>(entry.data + 3 * entry.stride) : nullptr;
+    view.uniformColor = uniformColor;
+    view.vertexCount = std::min(count, entry.count);
+    return view;
+}
+
+void PointStream::buildChunkBatches(const GeometryView &view)
+{
+    // Sized once for the largest chunk; colored files also get the grouping scratch
+    if (batches.pointIndices.size() < maxChunkPoints)
+    {
+        const std::size_t filled = batches.pointIndices.size();
+        batches.pointIndices.resize(maxChunkPoints);
+        for (std::size_t i = filled; i < maxChunkPoints; ++i)
+            batches.pointIndices[i] = static_cast<int>(i);
+        if (hasColors)
+        {
+            std::size_t slots = 16;
+            while (slots < 2 * maxChunkPoints)
+                slots <<= 1;
+            colorTable.assign(slots, 0);
+            pointBatch.resize(maxChunkPoints);
+            batchFill.reserve(maxChunkPoints);
+            batches.batches.reserve(maxChunkPoints);
+        }
+        else
+        {
+            batches.batches.reserve(1);
+        }
+    }
+
+    batches.batches.clear();
+    const auto addBatch = [this](std::uint32_t color)
+    {
+        const int red = static_cast<int>((color >> 16) & 0xFF), green = static_cast<int>((color >> 8) & 0xFF);
+        const int blue = static_cast<int>(color & 0xFF);
+        batches.batches.push_back({red, green, blue, 0, 0, 0, 0, 0, 0});
+    };
+    if (!view.pointColors)
+    {
+        // The identity prefix is the whole batch
+        if (view.vertexCount > 0)
+        {
+            addBatch(view.uniformColor);
+            batches.batches.back().pointCount = view.vertexCount;
+        }
+        return;
+    }
+
+    // Counting sort by color, as buildDrawBatches does, with the table in
+    // place of its map. Entries are color << 32 | (batch + 1).
+    const std::size_t mask = colorTable.size() - 1;
+    const auto slotOf = [&](std::uint32_t key)
+    {
+        std::size_t slot = static_cast<std::size_t>((key * 11400714819323198485ull) >> 40) & mask;
+        while (colorTable[slot] != 0 && static_cast<std::uint32_t>(colorTable[slot] >> 32) != key)
+            slot = (slot + 1) & mask;
+        return slot;
+    };
+    for (std::size_t i = 0; i < view.vertexCount; ++i)
+    {
+        const std::uint32_t key = view.pointColors[i] & 0xFFFFFFu;
+        std::uint64_t &entry = colorTable[slotOf(key)];
+        if (entry == 0)
+        {
+            addBatch(key);
+            entry = static_cast<std::uint64_t>(key) << 32 | batches.batches.size();
+        }
+        pointBatch[i] = static_cast<std::uint32_t>(entry) - 1;
+        ++batches.batches[pointBatch[i]].pointCount;
+    }
+
+    // Empty the table for the next chunk, touching only the used slots (all
+    // found before any is cleared, which would cut the probe sequences)
+    batchFill.clear();
+    for (const DrawBatch &batch : batches.batches)
+        batchFill.push_back(slotOf(static_cast<std::uint32_t>(batch.red << 16 | batch.green << 8 | batch.blue)));
+    for (const std::size_t slot : batchFill)
+        colorTable[slot] = 0;
+
+    std::size_t offset = 0;
+    for (std::size_t b = 0; b < batches.batches.size(); ++b)
+    {
+        batches.batches[b].pointBegin = offset;
+        batchFill[b] = offset;
+        offset += batches.batches[b].pointCount;
+    }
+    for (std::size_t i = 0; i < view.vertexCount; ++i)
+        batches.pointIndices[batchFill[pointBatch[i]]++] = static_cast<int>(i);
+}
+
+// madvise wants page-aligned ranges; widen [begin, begin + length) to whole pages
+static void adviseRange(const char *begin, std::size_t length, int advice)
+{
+    static const std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(begin) / page * page;
+    const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(begin) + length + page - 1) / page * page;
+    madvise(reinterpret_cast<void *>(start), end - start, advice);
+}
+
+void PointStream::prefetchAhead(std::size_t position, double share)
+{
+    // Ahead by at most the resident limit, so prefetched pages are not released before use
+    const std::size_t depth = std::min(PREFETCH_CHUNKS, residentChunkLimit - 1);
+    const std::size_t first = position == 0 ? 0 : position + depth;
+    for (std::size_t k = first; k <= position + depth && k < visibleChunks.size(); ++k)
+    {
+        const std::uint32_t chunk = visibleChunks[k];
+        if (!resident[chunk])
+            prefetch(chunk, chunkPrefix(chunk, share));
+    }
+}
+
+void PointStream::prefetch(std::size_t chunk, std::size_t count)
+{
+    const Chunk &entry = chunkTable[chunk];
+    count = std::min(count, entry.count);
+    for (int block = 0; block < (hasColors ? 4 : 3); ++block)
+        adviseRange(entry.data + block * entry.stride, count * sizeof(float), MADV_WILLNEED);
+    ++counters.chunksPrefetched;
+}
+
+void PointStream::release(std::size_t chunk)
+{
+    const Chunk &entry = chunkTable[chunk];
+    adviseRange(entry.data, static_cast<std::size_t>(chunkBytes(entry.count, hasColors)), MADV_DONTNEED);
+    resident[chunk] = 0;
+    ++counters.chunksReleased;
+}
+
+void PointStream::finishChunk(std::size_t chunk)
+{
+    if (resident[chunk])
+        return; // Drawn again while still resident; keeps its place
+    if (ringSize == residentRing.size())
+    {
+        release(residentRing[ringHead]);
+        ringHead = (ringHead + 1) % residentRing.size();
+        --ringSize;
+    }
+    residentRing[(ringHead + ringSize) % residentRing.size()] = static_cast<std::uint32_t>(chunk);
+    ++ringSize;
+    resident[chunk] = 1;
+}
+
+void residentMemoryKb(long &currentKb, long &peakKb)
+{
+    currentKb = 0;
+    long pages = 0, residentPages = 0;
+    if (std::FILE *statm = std::fopen("/proc/self/statm", "r"))
+    {
+        if (std::fscanf(statm, "%ld %ld", &pages, &residentPages) == 2)
+            currentKb = residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+        std::fclose(statm);
+    }
+    struct rusage usage;
+    peakKb = (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss : 0;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file point_stream.h
+ * @brief Chunked on-disk point clouds drawn out of core from a memory mapping.
+ *
+ * A point cloud held in RenderState costs 24 bytes per point (Point3d), or
+ * 12-16 packed, and all of it has to be resident. A point stream file keeps
+ * the cloud on disk in chunks that are mapped, drawn and released one after
+ * the other, so the resident set stays within a fixed budget whatever the
+ * file size.
+ *
+ * Layout (native little-endian):
+ *   header       magic, version, byte-order mark, counts, flags, bounds
+ *                (one 4 KiB page)
+ *   chunks       each page aligned: x, y, z (count floats each) and packed
+ *                ARGB8888 colors (optional), every block 64-byte aligned
+ *   chunk table  offset, point count and bounds of each chunk
+ *
+ * The points of a chunk are stored in a shuffled order, so any prefix of a
+ * chunk is a uniform sample of it. Drawing the same fraction of every chunk
+ * therefore thins the whole cloud evenly, which is how a frame is kept
+ * within a point budget.
+ *
+ * Unlike the mesh cache there is no whole-file checksum: verifying it would
+ * read the entire dataset at startup. Opening checks the header and that
+ * every chunk lies inside the file.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../app_state/app_state.h" // Aabb, DrawBatches, GeometryView
+#include "mapped_file.h"
+
+/** Points per chunk written by default: 1 MiB of positions and colors. */
+constexpr std::uint32_t POINT_STREAM_CHUNK_POINTS = 65536;
+
+/**
+ * @brief Chunk table entry as stored in the file.
+ */
+struct PointStreamChunkRecord
+{
+    std::uint64_t offset;             ///< File offset of the chunk (page aligned)
+    std::uint32_t count;              ///< Points in the chunk
+    std::uint32_t reserved;           ///< Zero
+    float boundsMin[3], boundsMax[3]; ///< Object-space bounds of the chunk's points
+};
+
+/**
+ * @brief Writes a point stream file one point at a time.
+ *
+ * Holds one chunk in memory, so clouds larger than RAM can be converted. The
+ * file is written under a temporary name and renamed into place by finish().
+ */
+class PointStreamWriter
+{
+public:
+    PointStreamWriter() = default;
+    ~PointStreamWriter();
+
+    PointStreamWriter(const PointStreamWriter &) = delete;
+    PointStreamWriter &operator=(const PointStreamWriter &) = delete;
+
+    /**
+     * @brief Start writing path.
+     * @param path           Destination file.
+     * @param chunkPoints    Points per chunk.
+     * @param hasColors      Store a color per point; otherwise every point uses uniformColor.
+     * @param uniformColor   Packed color used when hasColors is false.
+     * @param error          Receives a message on failure.
+     * @return true on success.
+     */
+    bool open(const char *path, std::uint32_t chunkPoints, bool hasColors, std::uint32_t uniformColor, std::string &error);
+
+    /** Add one point; color is ignored without hasColors. */
+    void append(float x, float y, float z, std::uint32_t color = 0);
+
+    /**
+     * @brief Write the last chunk, the chunk table and the header, and move
+     *        the file into place.
+     * @return false (with error set) if any write failed; the temporary file is removed.
+     */
+    bool finish(std::string &error);
+
+    /** Points appended so far. */
+    std::uint64_t pointCount() const { return totalPoints; }
+
+    /** Bytes written so far; the file size once finish() succeeded. */
+    std::uint64_t fileBytes() const { return written; }
+
+private:
+    void flushChunk();
+    void write(const void *data, std::size_t size);
+    void padTo(std::uint64_t offset);
+
+    std::FILE *file = nullptr;
+    std::string path, temporaryPath;
+    std::uint32_t chunkPoints = POINT_STREAM_CHUNK_POINTS;
+    bool hasColors = false;
+    std::uint32_t uniformColor = 0xFFFFFFFFu;
+    bool ok = true;
+    std::uint64_t written = 0;
+    std::uint64_t totalPoints = 0;
+    std::vector<float> x, y, z;                 ///< Points of the chunk being filled
+    std::vector<std::uint32_t> colors;          ///< Colors of the chunk being filled (hasColors only)
+    std::vector<std::uint32_t> order;           ///< Shuffle scratch
+    std::vector<PointStreamChunkRecord> chunks; ///< Table of the chunks written so far
+    Aabb bounds{};                              ///< Bounds of every point appended
+};
+
+/**
+ * @brief Write the vertices of geometry (with its colors) as a point stream file.
+ */
+bool writePointStream(const char *path, const GeometryView &geometry, std::uint32_t chunkPoints, std::string &error);
+
+/**
+ * @brief Counters of a PointStream, for reporting.
+ */
+struct PointStreamStats
+{
+    std::uint64_t pointsDrawn = 0;      ///< Points handed to the renderer, all frames
+    std::uint64_t frames = 0;           ///< Frames that drew the stream
+    double drawSeconds = 0.0;           ///< Time spent transforming and drawing chunks, all frames
+    std::uint64_t chunksPrefetched = 0; ///< madvise(WILLNEED) calls
+    std::uint64_t chunksReleased = 0;   ///< madvise(DONTNEED) calls
+    std::size_t lastPoints = 0;         ///< Points drawn in the last frame
+    std::size_t lastChunksCulled = 0;   ///< Chunks outside the view in the last frame
+    double lastFraction = 1.0;          ///< Share of each chunk drawn in the last frame
+};
+
+/**
+ * @brief A mapped point stream file and its resident-set bookkeeping.
+ *
+ * Used from the thread that draws frames. Each frame calls beginFrame(),
+ * fills visibleChunks, and for each of them calls prefetchAhead(),
+ * chunkView() to draw it and finishChunk() after it; endFrame() closes the
+ * frame. Chunks beyond the resident budget are released (least recently
+ * drawn first), so the process keeps at most about residentBytes of the file
+ * in memory.
+ */
+class PointStream
+{
+public:
+    /**
+     * @brief Map and validate path, replacing any previous file.
+     * @return false (with error set) if the file is not a valid point stream.
+     */
+    bool open(const char *path, std::string &error);
+
+    /**
+     * @brief Set the per-frame budget and the resident-set bound.
+     * @param pointBudget   Points drawn per frame while the view changes; 0 = every point.
+     * @param residentBytes Mapped bytes kept resident at most (at least two chunks).
+     */
+    void configure(std::size_t pointBudget, std::size_t residentBytes);
+
+    /**
+     * @brief Start a frame drawn with matrixKey (the frame's projection matrix bytes).
+     *
+     * While the view stays unchanged and the previous frame did not draw
+     * every point, the drawn fraction doubles each frame, so a still view
+     * refines to the full cloud progressively.
+     *
+     * @return Fraction of each chunk to draw this frame.
+     */
+    double beginFrame(const void *matrixKey, std::size_t matrixBytes);
+
+    /** Close the frame: pointsDrawn and culled chunks, seconds spent drawing. */
+    void endFrame(std::size_t pointsDrawn, std::size_t chunksCulled, double seconds);
+
+    /** True once a frame drew every point of the current view (or no budget is set). */
+    bool complete() const { return frameComplete; }
+
+    std::size_t chunkCount() const { return chunkTable.size(); }
+    std::uint64_t pointCount() const { return totalPoints; }
+    std::size_t chunkCapacity() const { return maxChunkPoints; }
+    std::size_t fileBytes() const { return file.size(); }
+    const Aabb &bounds() const { return fileBounds; }
+    const Aabb &chunkBounds(std::size_t chunk) const { return chunkTable[chunk].bounds; }
+
+    /** Points of chunk drawn at fraction (at least one while the chunk is not empty). */
+    std::size_t chunkPrefix(std::size_t chunk, double fraction) const;
+
+    /** The first count points of chunk as drawable geometry (points only). */
+    GeometryView chunkView(std::size_t chunk, std::size_t count) const;
+
+    /**
+     * @brief Fill batches with the SDL backend batches of view (a chunkView()).
+     *
+     * A uniform-color chunk is one batch over an identity pointIndices prefix
+     * kept from frame to frame. With stored colors the points are grouped per
+     * color (stable) through a color table reused across chunks. Nothing is
+     * allocated once the buffers have grown to the largest chunk.
+     */
+    void buildChunkBatches(const GeometryView &view);
+
+    /**
+     * @brief Ask the kernel to read ahead of visibleChunks[position].
+     *
+     * At position 0 the first few visible chunks are requested, afterwards
+     * one chunk a few places ahead, so reads overlap the drawing of the
+     * chunks before it. Only the prefix drawn at share is requested.
+     */
+    void prefetchAhead(std::size_t position, double share);
+
+    /** Record that chunk was drawn, releasing the least recently drawn chunks over budget. */
+    void finishChunk(std::size_t chunk);
+
+    const PointStreamStats &stats() const { return counters; }
+
+    DrawBatches batches;                       ///< SDL backend batches of the chunk being drawn
+    std::vector<std::uint32_t> visibleChunks;  ///< Frame scratch: chunks inside the view
+
+private:
+    struct Chunk
+    {
+        const char *data;   ///< Start of the chunk in the mapping
+        std::size_t count;  ///< Points
+        std::size_t stride; ///< Bytes from one block to the next (count floats, 64-byte aligned)
+        Aabb bounds;        ///< Object-space bounds of the points
+    };
+
+    void prefetch(std::size_t chunk, std::size_t count);
+    void release(std::size_t chunk);
+
+    MappedFile file;
+    std::vector<Chunk> chunkTable;
+    std::uint64_t totalPoints = 0;
+    std::size_t maxChunkPoints = 0;
+    bool hasColors = false;
+    std::uint32_t uniformColor = 0xFFFFFFFFu;
+    Aabb fileBounds{};
+
+    std::size_t pointBudget = 0;
+    std::size_t residentChunkLimit = 2;
+    std::vector<std::uint32_t> residentRing; ///< Drawn chunks still resident, oldest at ringHead
+    std::size_t ringHead = 0, ringSize = 0;
+    std::vector<std::uint8_t> resident;      ///< Per chunk: in residentRing
+
+    std::vector<std::uint64_t> colorTable;  ///< buildChunkBatches: open-addressing color -> batch table, 0 = empty
+    std::vector<std::uint32_t> pointBatch;  ///< buildChunkBatches: batch of each point of the chunk
+    std::vector<std::size_t> batchFill;     ///< buildChunkBatches: next pointIndices entry of each batch
+
+    std::vector<unsigned char> lastMatrix; ///< matrixKey of the previous frame
+    double fraction = 1.0;
+    bool frameComplete = true;
+    PointStreamStats counters;
+};
+
+/**
+ * @brief Current and peak resident set size of the process in KiB.
+ */
+void residentMemoryKb(long &currentKb, long &peakKb);
@@ -0,0 +1,183 @@
+// frame_pipeline.cpp
+// Worker side of the pipelined loop: apply forwarded events, prepare a frame
+// into the triple buffer's write slot, publish, and wait until it is taken.
+
+#include "frame_pipeline.h"
+#include "../app_state/dirty_tracking.h"
+#include "../input/input.h"
+#include <chrono>
+
+// Longest time the idle worker sleeps before re-checking the state
+constexpr int PIPELINE_IDLE_WAIT_MS = 250;
+
+FramePipeline::FramePipeline(RenderState &state, RendererFrameCallback onFrame, Uint32 wakeEventType)
+    : state(state), onFrame(onFrame), wakeEventType(wakeEventType)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+    stop();
+}
+
+void FramePipeline::start()
+{
+    if (worker.joinable())
+        return;
+    savedFramebuffer = state.framebuffer;
+    stopRequested = false;
+    workerFinished.store(false, std::memory_order_relaxed);
+    queuedEvents.reserve(64);
+    worker = std::thread(&FramePipeline::workerLoop, this);
+}
+
+void FramePipeline::stop()
+{
+    if (!worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    workerWake.notify_one();
+    worker.join();
+    state.framebuffer = savedFramebuffer;
+    state.drawRecording = nullptr;
+}
+
+void FramePipeline::postEvent(const SDL_Event &event, std::uint64_t timestamp)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queuedEvents.push_back({event, timestamp});
+    }
+    workerWake.notify_one();
+}
+
+void FramePipeline::waitForFrame(int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    frameWake.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]()
+                       { return frames.hasFresh() || finished(); });
+}
+
+bool FramePipeline::acquireFrame()
+{
+    if (!frames.acquire())
+        return false;
+    // The lock orders this wake-up after the worker's check of hasFresh()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    workerWake.notify_one();
+    return true;
+}
+
+void FramePipeline::notifyPresenter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    frameWake.notify_all();
+    if (wakeEventType != 0)
+    {
+        SDL_Event wake{};
+        wake.type = wakeEventType;
+        SDL_PushEvent(&wake);
+    }
+}
+
+void FramePipeline::prepareFrame(PipelineFrame &frame)
+{
+    frame.prepareStart = SDL_GetPerformanceCounter();
+    frame.profilerControls = state.profiler;
+    frame.profiling = state.profiler.enabled || state.profiler.overlay;
+    frame.profile = FrameProfileSample{};
+    state.profiler.dumpRequested = false;
+    state.profileSample = frame.profiling ? &frame.profile : nullptr;
+
+    frame.backend = state.backend;
+    if (frame.backend == RenderBackend::Software)
+    {
+        StageTimer timer(state.profileSample, ProfileStage::Rasterize);
+        frame.framebuffer.resize(state.screenWidth, state.screenHeight);
+        frame.framebuffer.clear(packColor(0, 0, 0));
+        state.framebuffer = &frame.framebuffer;
+        state.drawRecording = nullptr;
+    }
+    else
+    {
+        frame.commands.clear();
+        state.framebuffer = nullptr;
+        state.drawRecording = &frame.commands;
+    }
+
+    if (onFrame)
+    {
+        onFrame(nullptr, nullptr, &state);
+    }
+    state.drawRecording = nullptr;
+    state.profileSample = nullptr;
+}
+
+void FramePipeline::workerLoop()
+{
+    std::vector<QueuedEvent> events;
+    events.reserve(64);
+    std::uint64_t pendingInput = 0; // Oldest applied input not yet shown
+    const double ticksToSeconds = 1.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;)
+            {
+                if (stopRequested)
+                    break;
+                // At most one frame ahead: the last published frame must have been taken
+                const bool previousTaken = !frames.hasFresh();
+                if (previousTaken && (everyFrame || !queuedEvents.empty() || frameDirtyFlags(state) != 0))
+                    break;
+                if (!previousTaken)
+                {
+                    workerWake.wait(lock);
+                    continue;
+                }
+
+                // Static image: sleep until an event arrives
+                const Uint64 idleStart = SDL_GetPerformanceCounter();
+                workerWake.wait_for(lock, std::chrono::milliseconds(PIPELINE_IDLE_WAIT_MS));
+                state.pacing.idleSeconds += static_cast<double>(SDL_GetPerformanceCounter() - idleStart) * ticksToSeconds;
+                state.lastPerformanceCounter = 0; // Resume animation from now
+            }
+            if (stopRequested)
+                break;
+            events.swap(queuedEvents);
+        }
+
+        for (const QueuedEvent &queued : events)
+        {
+            if (handleEvent(&state, queued.event) && pendingInput == 0)
+                pendingInput = queued.timestamp;
+        }
+        events.clear();
+        if (sdlRendererRequested.exchange(false, std::memory_order_relaxed))
+            state.backend = RenderBackend::SdlRenderer;
+        if (!state.running)
+            break;
+        if (!everyFrame && frameDirtyFlags(state) == 0)
+            continue;
+
+        PipelineFrame &frame = frames.writeSlot();
+        prepareFrame(frame);
+        frame.inputTimestamp = pendingInput;
+        pendingInput = 0;
+        markFramePresented(state);
+        frames.publish();
+        notifyPresenter();
+    }
+
+    workerFinished.store(true, std::memory_order_release);
+    notifyPresenter();
+}
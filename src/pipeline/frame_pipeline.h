@@ -0,0 +1,129 @@
+/**
+ * @file frame_pipeline.h
+ * @brief Worker thread that prepares frames while the main thread presents.
+ *
+ * In the sequential loop, timing, animation, transform, clipping and drawing
+ * run on the main thread between two presents, so a present that blocks on
+ * VSync also stalls the work for the next frame. In pipelined mode a worker
+ * thread owns the RenderState. It applies the events forwarded by the main
+ * thread, runs the frame callback, and publishes the result through a
+ * TripleBuffer:
+ *  - SDL_Renderer backend: the recorded draw calls (DrawCommandList),
+ *  - software backend: the finished Framebuffer.
+ * The main thread only replays or uploads the newest frame and presents it.
+ * The worker starts frame N+1 as soon as the main thread has taken frame N,
+ * so the two overlap and the worker is never more than one frame ahead.
+ *
+ * While the pipeline runs, no other thread may touch the RenderState.
+ */
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "../2d_renderer/2d_renderer.h"       // RendererFrameCallback
+#include "../app_state/app_state.h"           // RenderState, DrawCommandList
+#include "../diagnostics/frame_profiler.h"    // FrameProfileSample
+#include "../framebuffer/framebuffer.h"       // Framebuffer
+#include "triple_buffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One prepared frame.
+ */
+struct PipelineFrame
+{
+    RenderBackend backend = RenderBackend::SdlRenderer; ///< Selects commands or framebuffer
+    DrawCommandList commands;                           ///< SDL_Renderer backend draw calls
+    Framebuffer framebuffer;                            ///< Software backend image
+    std::uint64_t inputTimestamp = 0;                   ///< Performance counter of the oldest input first shown by this frame; 0 = none
+    std::uint64_t prepareStart = 0;                     ///< Performance counter when the worker started the frame
+    bool profiling = false;                             ///< profile holds this frame's stage times
+    FrameProfileSample profile;                         ///< Worker stages; the presenter adds events and present
+    ProfilerControls profilerControls;                  ///< Profiler switches as of this frame
+};
+
+/**
+ * @brief Runs the frame callback on a worker thread and hands frames to the presenting thread.
+ */
+class FramePipeline
+{
+public:
+    /**
+     * @param state         State owned by the worker between start() and stop().
+     * @param onFrame       Frame callback, called with null window and renderer.
+     * @param wakeEventType SDL event pushed whenever a frame is published or the
+     *                      worker stops, to wake a thread blocked in
+     *                      SDL_WaitEvent; 0 pushes nothing.
+     */
+    FramePipeline(RenderState &state, RendererFrameCallback onFrame, Uint32 wakeEventType);
+    ~FramePipeline();
+
+    FramePipeline(const FramePipeline &) = delete;
+    FramePipeline &operator=(const FramePipeline &) = delete;
+
+    /**
+     * @brief Prepare a frame whenever the previous one was taken, even if it
+     *        would repeat the image (fixed-frame headless runs). Call before start().
+     */
+    void prepareEveryFrame() { everyFrame = true; }
+
+    /** Start the worker thread. */
+    void start();
+
+    /** Stop and join the worker; the state belongs to the caller again. */
+    void stop();
+
+    /**
+     * @brief Queue an event for the worker.
+     * @param event     Event to pass to handleEvent().
+     * @param timestamp Performance counter when the event was received, used
+     *                  for input latency if the event changes the state.
+     */
+    void postEvent(const SDL_Event &event, std::uint64_t timestamp);
+
+    /** Switch the state to the SDL_Renderer backend before the next frame. */
+    void requestSdlRenderer() { sdlRendererRequested.store(true, std::memory_order_relaxed); }
+
+    /** Block until a frame is ready, the worker stopped, or timeoutMs passed. */
+    void waitForFrame(int timeoutMs);
+
+    /** Take the newest published frame; false if there is none since the last call. */
+    bool acquireFrame();
+
+    /** Frame taken by the last successful acquireFrame(); the presenter may update it. */
+    PipelineFrame &frame() { return frames.readSlot(); }
+
+    /** True once the worker left its loop (RenderState::running was cleared). */
+    bool finished() const { return workerFinished.load(std::memory_order_acquire); }
+
+private:
+    struct QueuedEvent
+    {
+        SDL_Event event;
+        std::uint64_t timestamp;
+    };
+
+    void workerLoop();
+    void prepareFrame(PipelineFrame &frame);
+    void notifyPresenter();
+
+    RenderState &state;
+    RendererFrameCallback onFrame;
+    Uint32 wakeEventType;
+    Framebuffer *savedFramebuffer = nullptr;
+    bool everyFrame = false; ///< prepareEveryFrame() was called
+
+    TripleBuffer<PipelineFrame> frames;
+    std::thread worker;
+    std::mutex mutex;                    ///< Guards queuedEvents and stopRequested; only used for sleeping
+    std::condition_variable workerWake;  ///< Event queued, frame taken or stop requested
+    std::condition_variable frameWake;   ///< Frame published or worker finished
+    std::vector<QueuedEvent> queuedEvents;
+    bool stopRequested = false;
+    std::atomic<bool> workerFinished{false};
+    std::atomic<bool> sdlRendererRequested{false};
+};
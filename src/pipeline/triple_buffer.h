@@ -0,0 +1,60 @@
+/**
+ * @file triple_buffer.h
+ * @brief Lock-free single-producer / single-consumer triple buffer.
+ */
+#pragma once
+
+#include <atomic>
+
+/**
+ * @brief Three slots passed between one writer and one reader thread.
+ *
+ * The writer owns one slot and the reader another. The third is parked in an
+ * atomic word together with a "fresh" bit. publish() swaps the written slot
+ * into that word and acquire() swaps the parked slot out, so neither side
+ * waits for the other and the reader always gets the newest published slot.
+ * A slot published twice before the reader acquires it is overwritten.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    /** Slot the writer fills next (writer thread only). */
+    T &writeSlot() { return slots[writeIndex]; }
+
+    /** Hand the write slot to the reader and take over the parked one (writer thread only). */
+    void publish()
+    {
+        const unsigned previous = parked.exchange(writeIndex | FRESH, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    /** True while a published slot waits for acquire() (any thread). */
+    bool hasFresh() const { return (parked.load(std::memory_order_acquire) & FRESH) != 0; }
+
+    /**
+     * @brief Make the newest published slot the read slot (reader thread only).
+     * @return false, leaving the read slot unchanged, if nothing new was published.
+     */
+    bool acquire()
+    {
+        if (!hasFresh())
+            return false;
+        const unsigned previous = parked.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    /** Slot acquired last (reader thread only). */
+    T &readSlot() { return slots[readIndex]; }
+    const T &readSlot() const { return slots[readIndex]; }
+
+private:
+    static constexpr unsigned INDEX_MASK = 3;
+    static constexpr unsigned FRESH = 4;
+
+    T slots[3];
+    unsigned writeIndex = 0;
+    unsigned readIndex = 1;
+    std::atomic<unsigned> parked{2};
+};
@@ -0,0 +1,289 @@
+// input_trace.cpp
+// Binary trace encoding, the recorder's buffered writer and the replay cursor.
+
+#include "input_trace.h"
+#include "../input/input.h"
+#include <cerrno>
+#include <cstring>
+
+constexpr char INPUT_TRACE_MAGIC[8] = {'W', 'F', 'T', 'R', 'A', 'C', 'E', '\0'};
+constexpr std::uint32_t INPUT_TRACE_VERSION = 1;
+
+// Event kinds in the trace
+constexpr unsigned char TRACE_EVENT_QUIT = 1;
+constexpr unsigned char TRACE_EVENT_WINDOW = 2;
+constexpr unsigned char TRACE_EVENT_KEY_DOWN = 3;
+
+// LEB128 of an unsigned value
+static void putVarint(std::vector<unsigned char> &out, std::uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// Signed values are zigzag-mapped so small negatives stay short
+static void putSignedVarint(std::vector<unsigned char> &out, std::int32_t value)
+{
+    putVarint(out, (static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31));
+}
+
+static bool getVarint(const std::vector<unsigned char> &in, std::size_t &cursor, std::uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (cursor >= in.size())
+            return false;
+        const unsigned char byte = in[cursor++];
+        value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool getSignedVarint(const std::vector<unsigned char> &in, std::size_t &cursor, std::int32_t &value)
+{
+    std::uint32_t raw = 0;
+    if (!getVarint(in, cursor, raw))
+        return false;
+    value = static_cast<std::int32_t>((raw >> 1) ^ (0u - (raw & 1u)));
+    return true;
+}
+
+// Vertex and edge counts of the object as set up from the command line
+static void geometryFingerprint(const RenderState &state, std::uint64_t &vertices, std::uint64_t &edges)
+{
+    vertices = state.externalGeometry.x ? state.externalGeometry.vertexCount : state.basePoints3d.size();
+    edges = state.externalGeometry.x ? state.externalGeometry.edgeCount : state.edges3d.size();
+}
+
+InputRecorder::~InputRecorder()
+{
+    std::string error;
+    finish(error);
+}
+
+bool InputRecorder::open(const char *newPath, const RenderState &state, std::string &error)
+{
+    std::string ignored;
+    finish(ignored);
+    file = std::fopen(newPath, "wb");
+    if (!file)
+    {
+        error = std::string("cannot create '") + newPath + "': " + std::strerror(errno);
+        return false;
+    }
+    path = newPath;
+
+    header = InputTraceHeader{};
+    std::memcpy(header.magic, INPUT_TRACE_MAGIC, sizeof(header.magic));
+    header.version = INPUT_TRACE_VERSION;
+    header.backend = static_cast<std::uint32_t>(state.backend);
+    header.screenWidth = state.screenWidth;
+    header.screenHeight = state.screenHeight;
+    header.angles[0] = state.angleX;
+    header.angles[1] = state.angleY;
+    header.angles[2] = state.angleZ;
+    header.rotateSpeeds[0] = state.rotateSpeedX;
+    header.rotateSpeeds[1] = state.rotateSpeedY;
+    header.rotateSpeeds[2] = state.rotateSpeedZ;
+    geometryFingerprint(state, header.vertexCount, header.edgeCount);
+
+    // The frame count is filled in by finish()
+    writeFailed = std::fwrite(&header, sizeof(header), 1, file) != 1;
+    bytesWritten = sizeof(header);
+    pending.clear();
+    pending.reserve(256);
+    pendingEvents = 0;
+    return true;
+}
+
+void InputRecorder::recordEvent(const SDL_Event &event)
+{
+    if (!file)
+        return;
+    switch (event.type)
+    {
+    case SDL_QUIT:
+        pending.push_back(TRACE_EVENT_QUIT);
+        break;
+    case SDL_WINDOWEVENT:
+        pending.push_back(TRACE_EVENT_WINDOW);
+        putVarint(pending, event.window.event);
+        putSignedVarint(pending, event.window.data1);
+        putSignedVarint(pending, event.window.data2);
+        break;
+    case SDL_KEYDOWN:
+        pending.push_back(TRACE_EVENT_KEY_DOWN);
+        putVarint(pending, static_cast<std::uint32_t>(event.key.keysym.sym));
+        break;
+    default:
+        return;
+    }
+    ++pendingEvents;
+}
+
+void InputRecorder::endFrame(float deltaSeconds)
+{
+    if (!file)
+        return;
+    unsigned char count[5];
+    std::size_t countBytes = 0;
+    for (std::uint32_t value = pendingEvents;; value >>= 7)
+    {
+        count[countBytes++] = static_cast<unsigned char>((value & 0x7F) | (value >= 0x80 ? 0x80 : 0));
+        if (value < 0x80)
+            break;
+    }
+    writeFailed |= std::fwrite(count, 1, countBytes, file) != countBytes;
+    if (!pending.empty())
+        writeFailed |= std::fwrite(pending.data(), 1, pending.size(), file) != pending.size();
+    writeFailed |= std::fwrite(&deltaSeconds, sizeof(deltaSeconds), 1, file) != 1;
+    bytesWritten += countBytes + pending.size() + sizeof(deltaSeconds);
+    pending.clear();
+    pendingEvents = 0;
+    ++header.frameCount;
+}
+
+bool InputRecorder::finish(std::string &error)
+{
+    if (!file)
+        return true;
+    bool ok = !writeFailed && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = std::fclose(file) == 0 && ok;
+    file = nullptr;
+    if (!ok)
+        error = "cannot write '" + path + "'";
+    return ok;
+}
+
+bool InputReplay::load(const char *path, std::string &error)
+{
+    std::FILE *file = std::fopen(path, "rb");
+    if (!file)
+    {
+        error = std::string("cannot open '") + path + "': " + std::strerror(errno);
+        return false;
+    }
+    frames.clear();
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1;
+    unsigned char chunk[65536];
+    for (std::size_t read = 0; ok && (read = std::fread(chunk, 1, sizeof(chunk), file)) > 0;)
+        frames.insert(frames.end(), chunk, chunk + read);
+    ok = ok && !std::ferror(file);
+    std::fclose(file);
+    if (!ok)
+    {
+        error = std::string("cannot read '") + path + "'";
+        return false;
+    }
+    if (std::memcmp(header.magic, INPUT_TRACE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        error = "not an input trace";
+        return false;
+    }
+    if (header.version != INPUT_TRACE_VERSION)
+    {
+        error = "unsupported trace version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.backend > static_cast<std::uint32_t>(RenderBackend::Software) || header.screenWidth < 0 || header.screenHeight < 0)
+    {
+        error = "corrupt trace header";
+        return false;
+    }
+
+    // Walk every frame once so playback cannot run off a truncated file
+    std::size_t walk = 0;
+    for (std::uint64_t frame = 0; frame < header.frameCount; ++frame)
+    {
+        std::uint32_t events = 0, unused = 0;
+        std::int32_t unusedSigned = 0;
+        bool valid = getVarint(frames, walk, events);
+        for (std::uint32_t i = 0; valid && i < events; ++i)
+        {
+            const unsigned char kind = walk < frames.size() ? frames[walk++] : 0;
+            if (kind == TRACE_EVENT_WINDOW)
+                valid = getVarint(frames, walk, unused) && getSignedVarint(frames, walk, unusedSigned) && getSignedVarint(frames, walk, unusedSigned);
+            else if (kind == TRACE_EVENT_KEY_DOWN)
+                valid = getVarint(frames, walk, unused);
+            else
+                valid = kind == TRACE_EVENT_QUIT;
+        }
+        walk += sizeof(float);
+        if (!valid || walk > frames.size())
+        {
+            error = "trace truncated at frame " + std::to_string(frame);
+            return false;
+        }
+    }
+    cursor = 0;
+    nextFrame = 0;
+    return true;
+}
+
+bool InputReplay::applyStart(RenderState &state) const
+{
+    state.backend = static_cast<RenderBackend>(header.backend);
+    state.screenWidth = header.screenWidth;
+    state.screenHeight = header.screenHeight;
+    state.angleX = header.angles[0];
+    state.angleY = header.angles[1];
+    state.angleZ = header.angles[2];
+    state.rotateSpeedX = header.rotateSpeeds[0];
+    state.rotateSpeedY = header.rotateSpeeds[1];
+    state.rotateSpeedZ = header.rotateSpeeds[2];
+    std::uint64_t vertices = 0, edges = 0;
+    geometryFingerprint(state, vertices, edges);
+    return vertices == header.vertexCount && edges == header.edgeCount;
+}
+
+bool InputReplay::applyNextFrame(RenderState &state)
+{
+    if (nextFrame >= header.frameCount)
+        return false;
+
+    // load() validated every record, so the reads below cannot fail
+    std::uint32_t events = 0;
+    getVarint(frames, cursor, events);
+    for (std::uint32_t i = 0; i < events; ++i)
+    {
+        SDL_Event event{};
+        const unsigned char kind = frames[cursor++];
+        if (kind == TRACE_EVENT_QUIT)
+        {
+            event.type = SDL_QUIT;
+        }
+        else if (kind == TRACE_EVENT_WINDOW)
+        {
+            std::uint32_t id = 0;
+            event.type = SDL_WINDOWEVENT;
+            getVarint(frames, cursor, id);
+            event.window.event = static_cast<Uint8>(id);
+            getSignedVarint(frames, cursor, event.window.data1);
+            getSignedVarint(frames, cursor, event.window.data2);
+        }
+        else
+        {
+            std::uint32_t sym = 0;
+            event.type = SDL_KEYDOWN;
+            getVarint(frames, cursor, sym);
+            event.key.keysym.sym = static_cast<SDL_Keycode>(sym);
+        }
+        handleEvent(&state, event);
+    }
+    std::memcpy(&state.replayDeltaSeconds, frames.data() + cursor, sizeof(float));
+    cursor += sizeof(float);
+    ++nextFrame;
+    return true;
+}
+
+bool InputReplay::passesLiveEvent(const SDL_Event &event)
+{
+    return event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE);
+}
@@ -0,0 +1,143 @@
+/**
+ * @file input_trace.h
+ * @brief Record the inputs and frame timing of a run and play them back.
+ *
+ * A run is determined by its command line, the SDL events that changed the
+ * state, and the animation step of every drawn frame. InputRecorder writes
+ * the last two to a compact binary trace; InputReplay feeds them back frame
+ * by frame, so two builds started with the same command line and trace see
+ * the same inputs on the same frames. With recorded deltas the angles also
+ * match bit for bit, which makes frame checksums comparable across commits.
+ *
+ * Trace layout (native little-endian):
+ *   header  magic, version, frame count, initial viewport / backend /
+ *           angles / rotation speeds, and the geometry's vertex and edge
+ *           counts as a fingerprint of the command line's mesh
+ *   frames  per drawn frame: varint event count, the events, then the
+ *           float delta in seconds the animation advanced by
+ *
+ * Events are stored by kind with only the fields handleEvent() reads: quit,
+ * window events (id, data1, data2) and key presses (keycode). A frame
+ * without input costs 5 bytes.
+ */
+#pragma once
+
+#include <SDL2/SDL.h>
+#include "../app_state/app_state.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Starting conditions stored at the front of a trace.
+ */
+struct InputTraceHeader
+{
+    char magic[8];             ///< "WFTRACE\0"
+    std::uint32_t version;     ///< INPUT_TRACE_VERSION
+    std::uint32_t backend;     ///< RenderBackend at the first frame
+    std::uint64_t frameCount;  ///< Frames recorded
+    std::int32_t screenWidth;  ///< Viewport at the first frame
+    std::int32_t screenHeight; ///< Viewport at the first frame
+    float angles[3];           ///< Rotation angles at the first frame
+    float rotateSpeeds[3];     ///< Degrees per second
+    std::uint64_t vertexCount; ///< Geometry fingerprint
+    std::uint64_t edgeCount;   ///< Geometry fingerprint
+};
+
+/**
+ * @brief Streams a run's state-changing events and frame deltas to a trace file.
+ *
+ * Call recordEvent() for every event handleEvent() acted on and endFrame()
+ * after every drawn frame. Writes go through a buffered FILE, so recording
+ * does not allocate per frame.
+ */
+class InputRecorder
+{
+public:
+    InputRecorder() = default;
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder &) = delete;
+    InputRecorder &operator=(const InputRecorder &) = delete;
+
+    /**
+     * @brief Create path and capture the starting conditions from state.
+     * @return false (with error set) if the file cannot be created.
+     */
+    bool open(const char *path, const RenderState &state, std::string &error);
+
+    /** Add an event to the current frame (ignored for kinds handleEvent() does not read). */
+    void recordEvent(const SDL_Event &event);
+
+    /** Close the current frame with the animation step it used. */
+    void endFrame(float deltaSeconds);
+
+    /**
+     * @brief Write the frame count into the header and close the file.
+     * @return false (with error set) if any write failed.
+     */
+    bool finish(std::string &error);
+
+    std::uint64_t frames() const { return header.frameCount; }
+    std::uint64_t bytes() const { return bytesWritten; }
+
+private:
+    std::FILE *file = nullptr;
+    std::string path;
+    InputTraceHeader header{};
+    std::vector<unsigned char> pending; ///< Encoded events of the current frame
+    std::uint32_t pendingEvents = 0;
+    std::uint64_t bytesWritten = 0;
+    bool writeFailed = false;
+};
+
+/**
+ * @brief Plays a trace back: starting conditions, then one frame of events and timing at a time.
+ */
+class InputReplay
+{
+public:
+    /**
+     * @brief Read and validate a whole trace file.
+     * @return false (with error set) if it cannot be read or is malformed.
+     */
+    bool load(const char *path, std::string &error);
+
+    const InputTraceHeader &traceHeader() const { return header; }
+
+    /**
+     * @brief Put the recorded starting conditions into state.
+     * @return false if state's geometry differs from the recorded one (the
+     *         command line probably differs); the replay still works.
+     */
+    bool applyStart(RenderState &state) const;
+
+    /**
+     * @brief Apply the next frame's events through handleEvent() and set its delta.
+     *
+     * Sets RenderState::replayDeltaSeconds; frame_callback uses it when
+     * RenderState::useReplayDeltas is set.
+     *
+     * @return false once every frame has been replayed.
+     */
+    bool applyNextFrame(RenderState &state);
+
+    std::uint64_t framesReplayed() const { return nextFrame; }
+
+    /**
+     * @brief Whether a live event may still act during replay.
+     *
+     * Only quitting (window close, Esc) is let through; anything else would
+     * change the state the trace expects.
+     */
+    static bool passesLiveEvent(const SDL_Event &event);
+
+private:
+    InputTraceHeader header{};
+    std::vector<unsigned char> frames; ///< Encoded frame records
+    std::size_t cursor = 0;
+    std::uint64_t nextFrame = 0;
+};
@@ -0,0 +1,317 @@
+// bvh.cpp
+// Median-split BVH over instance world bounds, incremental refit and
+// frustum traversal.
+
+#include "bvh.h"
+#include <algorithm>
+#include <cmath>
+
+// Instances per leaf; small leaves keep the per-instance tests few
+constexpr std::uint32_t LEAF_SIZE = 4;
+
+// Median splits keep the depth near log2(instances / LEAF_SIZE)
+constexpr int MAX_TRAVERSAL_DEPTH = 64;
+
+// Rebuild instead of refitting once refits have doubled the summed node area
+// (the expected number of nodes a traversal visits grows with it)
+constexpr double REBUILD_SURFACE_AREA_RATIO = 2.0;
+
+static void growBounds(Aabb &bounds, const Aabb &other)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        bounds.min[axis] = std::min(bounds.min[axis], other.min[axis]);
+        bounds.max[axis] = std::max(bounds.max[axis], other.max[axis]);
+    }
+}
+
+static double surfaceArea(const Aabb &box)
+{
+    const double dx = static_cast<double>(box.max[0]) - box.min[0], dy = static_cast<double>(box.max[1]) - box.min[1];
+    const double dz = static_cast<double>(box.max[2]) - box.min[2];
+    return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+static bool sameBounds(const Aabb &a, const Aabb &b)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (a.min[axis] != b.min[axis] || a.max[axis] != b.max[axis])
+            return false;
+    }
+    return true;
+}
+
+Frustum makeFrustum(const ProjectionMatrix &matrix, const ClipRegion &region)
+{
+    // Screen x = centerX + X / W lies in [minX, maxX] for W > 0 exactly when
+    // X - (minX - centerX) W >= 0 and (maxX - centerX) W - X >= 0; likewise y.
+    const double left = region.minX - matrix.centerX, right = region.maxX - matrix.centerX;
+    const double top = region.minY - matrix.centerY, bottom = region.maxY - matrix.centerY;
+    Frustum frustum;
+    for (int col = 0; col < 4; ++col)
+    {
+        const double x = matrix.xRow[col], y = matrix.yRow[col], w = matrix.wRow[col];
+        frustum.planes[0][col] = x - left * w;
+        frustum.planes[1][col] = right * w - x;
+        frustum.planes[2][col] = y - top * w;
+        frustum.planes[3][col] = bottom * w - y;
+        frustum.planes[4][col] = w;
+    }
+    frustum.planes[4][3] -= region.nearDepth;
+    return frustum;
+}
+
+FrustumTest testAabb(const Frustum &frustum, const Aabb &box)
+{
+    double center[3], extent[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        center[axis] = 0.5 * (static_cast<double>(box.min[axis]) + box.max[axis]);
+        extent[axis] = 0.5 * (static_cast<double>(box.max[axis]) - box.min[axis]);
+    }
+
+    FrustumTest result = FrustumTest::Inside;
+    for (const auto &plane : frustum.planes)
+    {
+        const double distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+        const double radius = std::fabs(plane[0]) * extent[0] + std::fabs(plane[1]) * extent[1] + std::fabs(plane[2]) * extent[2];
+        if (distance + radius < 0.0)
+            return FrustumTest::Outside;
+        if (distance - radius < 0.0)
+            result = FrustumTest::Intersecting;
+    }
+    return result;
+}
+
+Aabb transformBounds(const Aabb &box, const InstanceTransform &transform)
+{
+    // Center maps through the affine transform; the extent through |M|
+    Aabb result;
+    for (int row = 0; row < 3; ++row)
+    {
+        double center = transform.m[row][3], extent = 0.0;
+        for (int col = 0; col < 3; ++col)
+        {
+            center += transform.m[row][col] * 0.5 * (static_cast<double>(box.min[col]) + box.max[col]);
+            extent += std::fabs(transform.m[row][col]) * 0.5 * (static_cast<double>(box.max[col]) - box.min[col]);
+        }
+        // Round outwards so float bounds still contain every transformed vertex
+        result.min[row] = std::nextafter(static_cast<float>(center - extent), -INFINITY);
+        result.max[row] = std::nextafter(static_cast<float>(center + extent), INFINITY);
+    }
+    return result;
+}
+
+// Bounds of the instances in order[first, first + count)
+static Aabb rangeBounds(const SceneBvh &bvh, std::uint32_t first, std::uint32_t count)
+{
+    Aabb bounds = bvh.instanceBounds[bvh.instanceOrder[first]];
+    for (std::uint32_t i = first + 1; i < first + count; ++i)
+    {
+        growBounds(bounds, bvh.instanceBounds[bvh.instanceOrder[i]]);
+    }
+    return bounds;
+}
+
+static std::uint32_t buildNode(SceneBvh &bvh, std::uint32_t first, std::uint32_t count, std::uint32_t parent)
+{
+    const auto index = static_cast<std::uint32_t>(bvh.nodes.size());
+    bvh.nodes.push_back({rangeBounds(bvh, first, count), first, count, 0, parent});
+    if (count <= LEAF_SIZE)
+    {
+        for (std::uint32_t i = first; i < first + count; ++i)
+        {
+            bvh.leafOfInstance[bvh.instanceOrder[i]] = index;
+        }
+        return index;
+    }
+
+    // Split at the median centroid along the widest axis of the centroids
+    float low[3] = {INFINITY, INFINITY, INFINITY}, high[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (std::uint32_t i = first; i < first + count; ++i)
+    {
+        const Aabb &box = bvh.instanceBounds[bvh.instanceOrder[i]];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float centroid = box.min[axis] + box.max[axis];
+            low[axis] = std::min(low[axis], centroid);
+            high[axis] = std::max(high[axis], centroid);
+        }
+    }
+    int axis = 0;
+    if (high[1] - low[1] > high[axis] - low[axis])
+        axis = 1;
+    if (high[2] - low[2] > high[axis] - low[axis])
+        axis = 2;
+
+    const std::uint32_t half = count / 2;
+    std::uint32_t *order = bvh.instanceOrder.data();
+    std::nth_element(order + first, order + first + half, order + first + count,
+                     [&bvh, axis](std::uint32_t a, std::uint32_t b)
+                     {
+                         const Aabb &boxA = bvh.instanceBounds[a], &boxB = bvh.instanceBounds[b];
+                         return boxA.min[axis] + boxA.max[axis] < boxB.min[axis] + boxB.max[axis];
+                     });
+
+    buildNode(bvh, first, half, index);
+    const std::uint32_t right = buildNode(bvh, first + half, count - half, index);
+    bvh.nodes[index].right = right;
+    return index;
+}
+
+void buildSceneBvh(Scene &scene)
+{
+    SceneBvh &bvh = scene.bvh;
+    const std::size_t count = scene.instances.size();
+    bvh.nodes.clear();
+    bvh.instanceOrder.resize(count);
+    bvh.leafOfInstance.resize(count);
+    bvh.instanceBounds.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const SceneInstance &instance = scene.instances[i];
+        bvh.instanceOrder[i] = static_cast<std::uint32_t>(i);
+        bvh.instanceBounds[i] = transformBounds(scene.meshes[instance.mesh].bounds, instance.transform);
+    }
+    if (count > 0)
+    {
+        bvh.nodes.reserve(2 * (count / LEAF_SIZE + 1));
+        buildNode(bvh, 0, static_cast<std::uint32_t>(count), 0);
+    }
+    bvh.surfaceArea = 0.0;
+    for (const BvhNode &node : bvh.nodes)
+    {
+        bvh.surfaceArea += surfaceArea(node.bounds);
+    }
+    bvh.builtSurfaceArea = bvh.surfaceArea;
+    ++bvh.builds;
+    scene.moved.clear();
+}
+
+// Refit every node in one pass: children follow their parent in the
+// depth-first array, so walking it backwards visits them first
+static void refitAllNodes(SceneBvh &bvh)
+{
+    bvh.surfaceArea = 0.0;
+    for (std::size_t index = bvh.nodes.size(); index-- > 0;)
+    {
+        BvhNode &node = bvh.nodes[index];
+        if (node.right == 0)
+        {
+            node.bounds = rangeBounds(bvh, node.first, node.count);
+        }
+        else
+        {
+            node.bounds = bvh.nodes[index + 1].bounds;
+            growBounds(node.bounds, bvh.nodes[node.right].bounds);
+        }
+        bvh.surfaceArea += surfaceArea(node.bounds);
+    }
+}
+
+void refitSceneBvh(Scene &scene)
+{
+    SceneBvh &bvh = scene.bvh;
+    // Past about one moved instance per leaf, the per-instance walks towards
+    // the root repeat each other's work
+    if (scene.moved.size() * LEAF_SIZE >= scene.instances.size())
+    {
+        for (const std::uint32_t instanceIndex : scene.moved)
+        {
+            const SceneInstance &instance = scene.instances[instanceIndex];
+            bvh.instanceBounds[instanceIndex] = transformBounds(scene.meshes[instance.mesh].bounds, instance.transform);
+        }
+        refitAllNodes(bvh);
+    }
+    else
+    {
+        for (const std::uint32_t instanceIndex : scene.moved)
+        {
+            const SceneInstance &instance = scene.instances[instanceIndex];
+            bvh.instanceBounds[instanceIndex] = transformBounds(scene.meshes[instance.mesh].bounds, instance.transform);
+
+            std::uint32_t index = bvh.leafOfInstance[instanceIndex];
+            for (;;)
+            {
+                BvhNode &node = bvh.nodes[index];
+                Aabb bounds = node.right == 0 ? rangeBounds(bvh, node.first, node.count) : bvh.nodes[index + 1].bounds;
+                if (node.right != 0)
+                    growBounds(bounds, bvh.nodes[node.right].bounds);
+                // Ancestors already enclose unchanged bounds
+                if (sameBounds(bounds, node.bounds))
+                    break;
+                bvh.surfaceArea += surfaceArea(bounds) - surfaceArea(node.bounds);
+                node.bounds = bounds;
+                if (node.parent == index)
+                    break;
+                index = node.parent;
+            }
+        }
+    }
+    scene.moved.clear();
+    ++bvh.refits;
+
+    if (bvh.surfaceArea > REBUILD_SURFACE_AREA_RATIO * bvh.builtSurfaceArea)
+        buildSceneBvh(scene);
+}
+
+void cullSceneInstances(const Scene &scene, const Frustum &frustum, std::vector<std::uint32_t> &visible, CullStats &stats)
+{
+    const SceneBvh &bvh = scene.bvh;
+    visible.clear();
+    if (bvh.nodes.empty())
+        return;
+
+    auto acceptRange = [&](const BvhNode &node)
+    {
+        visible.insert(visible.end(), bvh.instanceOrder.begin() + node.first, bvh.instanceOrder.begin() + node.first + node.count);
+    };
+
+    std::uint32_t stack[MAX_TRAVERSAL_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const std::uint32_t index = stack[--top];
+        const BvhNode &node = bvh.nodes[index];
+        ++stats.nodesVisited;
+
+        switch (testAabb(frustum, node.bounds))
+        {
+        case FrustumTest::Outside:
+            stats.instancesCulled += node.count;
+            break;
+        case FrustumTest::Inside:
+            acceptRange(node);
+            break;
+        case FrustumTest::Intersecting:
+            if (node.right == 0)
+            {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+                {
+                    const std::uint32_t instance = bvh.instanceOrder[i];
+                    if (testAabb(frustum, bvh.instanceBounds[instance]) == FrustumTest::Outside)
+                        ++stats.instancesCulled;
+                    else
+                        visible.push_back(instance);
+                }
+            }
+            else if (top + 2 > MAX_TRAVERSAL_DEPTH)
+            {
+                // Unreachable for a median-split tree; stay conservative anyway
+                acceptRange(node);
+            }
+            else
+            {
+                stack[top++] = node.right;
+                stack[top++] = index + 1;
+            }
+            break;
+        }
+    }
+
+    // Draw in instance order so overlapping instances paint the same way every frame
+    std::sort(visible.begin(), visible.end());
+    stats.instancesDrawn = visible.size();
+}
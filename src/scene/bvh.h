@@ -0,0 +1,86 @@
+/**
+ * @file bvh.h
+ * @brief Instance bounding-volume hierarchy and view-frustum culling.
+ *
+ * Each instance's world AABB (its mesh's object-space AABB pushed through the
+ * instance transform) is a leaf entry of a median-split BVH. Every frame the
+ * hierarchy is walked against the frustum of the frame's projection matrix:
+ * subtrees entirely outside are dropped without touching their instances,
+ * subtrees entirely inside are accepted without further tests, and only
+ * instances in partially visible leaves are tested one by one. Culled
+ * instances cost no vertex transform, clipping or rasterization.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../app_state/app_state.h"          // Aabb, Scene, SceneBvh, CullStats
+#include "../3d_renderer/batch_transform.h" // ProjectionMatrix
+#include "../3d_renderer/clipping.h"        // ClipRegion
+
+/**
+ * @brief The five planes (left, right, top, bottom, near) bounding what a
+ *        projection matrix maps into a clip region.
+ *
+ * Each plane is (a, b, c, d) with a*x + b*y + c*z + d >= 0 on the visible
+ * side, in the space the matrix transforms from. There is no far plane.
+ */
+struct Frustum
+{
+    double planes[5][4];
+};
+
+/**
+ * @brief Where a box lies relative to a frustum.
+ */
+enum class FrustumTest
+{
+    Outside,      ///< Entirely outside one plane; nothing of it can be drawn
+    Intersecting, ///< Crosses at least one plane
+    Inside        ///< Entirely on the visible side of every plane
+};
+
+/**
+ * @brief Frustum of matrix for region.
+ *
+ * Derived from the same matrix and clip region the clipping stage uses, so
+ * the culling is never stricter than clipping (the region's margin applies).
+ */
+Frustum makeFrustum(const ProjectionMatrix &matrix, const ClipRegion &region);
+
+/**
+ * @brief Classify box against frustum (conservative: may report Intersecting
+ *        for a box that is actually outside, never the reverse).
+ */
+FrustumTest testAabb(const Frustum &frustum, const Aabb &box);
+
+/**
+ * @brief Bounds of box after transform.
+ */
+Aabb transformBounds(const Aabb &box, const InstanceTransform &transform);
+
+/**
+ * @brief Rebuild scene.bvh from the current instances and mesh bounds.
+ */
+void buildSceneBvh(Scene &scene);
+
+/**
+ * @brief Refit the BVH for the instances listed in scene.moved, then clear it.
+ *
+ * Each moved instance's world bounds are recomputed and the change is
+ * propagated towards the root, stopping at the first ancestor whose bounds
+ * do not change. The tree shape is kept unless the refits have loosened it
+ * enough to double the summed node surface area, in which case the tree is
+ * rebuilt.
+ */
+void refitSceneBvh(Scene &scene);
+
+/**
+ * @brief Collect the instances that may be visible through frustum.
+ *
+ * @param scene   Scene whose BVH is current.
+ * @param frustum View frustum in world space.
+ * @param visible Receives instance indices in ascending (draw) order.
+ * @param stats   Receives nodes visited and instances culled / drawn.
+ */
+void cullSceneInstances(const Scene &scene, const Frustum &frustum, std::vector<std::uint32_t> &visible, CullStats &stats);
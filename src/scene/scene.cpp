@@ -0,0 +1,247 @@
+// scene.cpp
+// Shared scene meshes, per-instance transforms and the grid demo layout.
+
+#include "scene.h"
+#include "bvh.h"
+#include "../3d_renderer/draw_batches.h"   // buildDrawBatches
+#include "../3d_renderer/geometry_view.h"  // packGeometry, viewOf, computeBounds
+#include "../3d_renderer/lod.h"            // buildMeshLod
+#include "../framebuffer/framebuffer.h"    // packColor
+#include <algorithm>
+#include <cmath>
+
+constexpr double PI = 3.14159265358979323846;
+
+std::uint32_t addSceneMesh(Scene &scene, const std::vector<Point3d> &points, const std::vector<Edge3d> &edges,
+                           const std::vector<std::uint32_t> &triangles)
+{
+    scene.meshes.emplace_back();
+    SceneMesh &mesh = scene.meshes.back();
+    packGeometry(points, edges, triangles, mesh.storage);
+    mesh.geometry = viewOf(mesh.storage);
+    ++scene.revision;
+    return static_cast<std::uint32_t>(scene.meshes.size() - 1);
+}
+
+std::uint32_t addSceneMesh(Scene &scene, const GeometryView &shared)
+{
+    scene.meshes.emplace_back();
+    scene.meshes.back().geometry = shared;
+    ++scene.revision;
+    return static_cast<std::uint32_t>(scene.meshes.size() - 1);
+}
+
+bool addSceneInstance(Scene &scene, const SceneInstance &instance)
+{
+    if (instance.mesh >= scene.meshes.size())
+        return false;
+    scene.instances.push_back(instance);
+    ++scene.revision;
+    return true;
+}
+
+void moveSceneInstance(Scene &scene, std::size_t index, const InstanceTransform &transform)
+{
+    scene.instances[index].transform = transform;
+    scene.moved.push_back(static_cast<std::uint32_t>(index));
+}
+
+void animateSceneInstances(Scene &scene, float deltaSeconds)
+{
+    const float extent = scene.motionExtent;
+    for (std::size_t i = 0; i < scene.motion.size(); ++i)
+    {
+        InstanceMotion &motion = scene.motion[i];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            // Bounce off the faces of the cube
+            float &coordinate = motion.position[axis];
+            coordinate += motion.velocity[axis] * deltaSeconds;
+            if (coordinate > extent || coordinate < -extent)
+            {
+                coordinate = std::max(-extent, std::min(extent, coordinate));
+                motion.velocity[axis] = coordinate > 0.0f ? -std::fabs(motion.velocity[axis]) : std::fabs(motion.velocity[axis]);
+            }
+        }
+        motion.angle = std::fmod(motion.angle + motion.spin * deltaSeconds, 360.0f);
+        moveSceneInstance(scene, i,
+                          makeInstanceTransform(motion.position[0], motion.position[1], motion.position[2], motion.scale, motion.angle));
+    }
+}
+
+void clearScene(Scene &scene)
+{
+    scene.meshes.clear();
+    scene.instances.clear();
+    scene.motion.clear();
+    ++scene.revision;
+}
+
+InstanceTransform makeInstanceTransform(float x, float y, float z, float scale, float angleYDegrees)
+{
+    const double angle = angleYDegrees * PI / 180.0;
+    const float c = static_cast<float>(scale * std::cos(angle)), s = static_cast<float>(scale * std::sin(angle));
+    return {{{c, 0.0f, s, x}, {0.0f, scale, 0.0f, y}, {-s, 0.0f, c, z}}};
+}
+
+ProjectionMatrix instanceProjectionMatrix(const ProjectionMatrix &view, const InstanceTransform &transform)
+{
+    const float *const viewRows[3] = {view.xRow, view.yRow, view.wRow};
+    ProjectionMatrix result = view;
+    float *const resultRows[3] = {result.xRow, result.yRow, result.wRow};
+    for (int row = 0; row < 3; ++row)
+    {
+        const float *v = viewRows[row];
+        for (int col = 0; col < 4; ++col)
+        {
+            double sum = static_cast<double>(v[0]) * transform.m[0][col] + static_cast<double>(v[1]) * transform.m[1][col] +
+                         static_cast<double>(v[2]) * transform.m[2][col];
+            if (col == 3)
+                sum += v[3];
+            resultRows[row][col] = static_cast<float>(sum);
+        }
+    }
+    return result;
+}
+
+void syncScene(RenderState &state)
+{
+    Scene &scene = state.scene;
+    if (scene.preparedRevision != scene.revision)
+    {
+        std::size_t largestVertices = 0, largestBatch = 0, primitives = 0;
+        for (SceneMesh &mesh : scene.meshes)
+        {
+            // Owned views are re-pointed in case the mesh moved with its vector
+            if (!mesh.storage.x.empty())
+                mesh.geometry = viewOf(mesh.storage);
+            buildDrawBatches(mesh.geometry, mesh.drawBatches);
+            mesh.bounds = computeBounds(mesh.geometry);
+            buildMeshLod(mesh.geometry, mesh.bounds, mesh.lod);
+            largestVertices = std::max(largestVertices, mesh.geometry.vertexCount);
+            for (const DrawBatch &batch : mesh.drawBatches.batches)
+            {
+                largestBatch = std::max({largestBatch, batch.pointCount, batch.stripVertexCount});
+            }
+        }
+        for (const SceneInstance &instance : scene.instances)
+        {
+            const GeometryView &geometry = scene.meshes[instance.mesh].geometry;
+            primitives += geometry.vertexCount + geometry.edgeCount;
+        }
+        scene.largestMeshVertices = largestVertices;
+        scene.lodLevels.assign(scene.instances.size(), 0);
+        buildSceneBvh(scene);
+
+        // The software backend rasterizes and empties the segment list whenever
+        // it fills up, so its capacity bounds the scratch rather than the
+        // number of instances.
+        constexpr std::size_t SEGMENT_CHUNK = 1u << 16;
+        FrameScratch &scratch = state.frameScratch;
+        const std::size_t segments = std::min(primitives + state.geometry.vertexCount + state.geometry.edgeCount, SEGMENT_CHUNK);
+        scratch.segments.reserve(segments);
+        scratch.tileBins.segmentIndices.reserve(2 * segments);
+        scratch.submitPoints.reserve(largestBatch);
+        scratch.visibleInstances.reserve(scene.instances.size());
+        scene.preparedRevision = scene.revision;
+    }
+    else if (!scene.moved.empty())
+    {
+        refitSceneBvh(scene);
+    }
+
+    ScreenBuffer &projected = state.projectedPoints;
+    if (projected.x.size() < scene.largestMeshVertices)
+    {
+        projected.x.resize(scene.largestMeshVertices);
+        projected.y.resize(scene.largestMeshVertices);
+        projected.depth.resize(scene.largestMeshVertices);
+    }
+}
+
+// Deterministic value in [0, 1) for the drift of instance index (SplitMix64)
+static double unitHash(std::uint64_t index)
+{
+    std::uint64_t value = index * 0x9E3779B97F4A7C15ULL + 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return static_cast<double>((value ^ (value >> 31)) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+bool instanceCurrentObject(RenderState &state, std::size_t count, bool moving)
+{
+    std::uint32_t mesh;
+    GeometryView geometry;
+    if (state.externalGeometry.x)
+    {
+        geometry = state.externalGeometry;
+        mesh = addSceneMesh(state.scene, geometry);
+    }
+    else
+    {
+        mesh = addSceneMesh(state.scene, state.basePoints3d, state.edges3d, state.triangles3d);
+        geometry = state.scene.meshes[mesh].geometry;
+    }
+    if (geometry.vertexCount == 0 || count == 0)
+    {
+        state.scene.meshes.pop_back();
+        return false;
+    }
+
+    double radiusSquared = 0.0;
+    for (std::size_t i = 0; i < geometry.vertexCount; ++i)
+    {
+        radiusSquared = std::max(radiusSquared, static_cast<double>(geometry.x[i]) * geometry.x[i] +
+                                                    static_cast<double>(geometry.y[i]) * geometry.y[i] +
+                                                    static_cast<double>(geometry.z[i]) * geometry.z[i]);
+    }
+    const double radius = std::sqrt(radiusSquared);
+
+    // side^3 cells inside the cube inscribed in the object's bounding sphere,
+    // so the rotating grid covers about the same screen area as the object
+    int side = 1;
+    while (static_cast<std::size_t>(side) * side * side < count)
+    {
+        ++side;
+    }
+    const double cell = 2.0 * radius / std::sqrt(3.0) / side;
+    const float scale = static_cast<float>(0.4 * cell / radius);
+    const auto channel = [side](int coordinate)
+    { return side > 1 ? 55 + 200 * coordinate / (side - 1) : 255; };
+
+    // Drifting instances cross the grid in about eight seconds per axis
+    const float extent = static_cast<float>(cell * side * 0.5);
+    const float speed = 0.25f * extent;
+    state.scene.motionExtent = extent;
+    state.scene.instances.reserve(state.scene.instances.size() + count);
+    if (moving)
+        state.scene.motion.reserve(state.scene.instances.size() + count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const int ix = static_cast<int>(i % side), iy = static_cast<int>(i / side % side), iz = static_cast<int>(i / side / side);
+        const auto center = [&](int coordinate)
+        { return static_cast<float>((coordinate + 0.5) * cell - cell * side * 0.5); };
+
+        SceneInstance instance;
+        instance.mesh = mesh;
+        const float angle = static_cast<float>(i * 37 % 360);
+        instance.transform = makeInstanceTransform(center(ix), center(iy), center(iz), scale, angle);
+        instance.color = packColor(channel(ix), channel(iy), channel(iz));
+        instance.useMeshColors = false;
+        addSceneInstance(state.scene, instance);
+        if (moving)
+        {
+            const auto velocity = [&](int axis)
+            { return static_cast<float>((2.0 * unitHash(4 * i + axis) - 1.0) * speed); };
+            const float spin = static_cast<float>((unitHash(4 * i + 3) < 0.5 ? -1.0 : 1.0) * (30.0 + 60.0 * unitHash(4 * i + 3)));
+            state.scene.motion.push_back({{center(ix), center(iy), center(iz)}, {velocity(0), velocity(1), velocity(2)}, scale, angle, spin});
+        }
+    }
+
+    state.basePoints3d.clear();
+    state.edges3d.clear();
+    state.triangles3d.clear();
+    state.externalGeometry = GeometryView{};
+    ++state.geometryRevision;
+    return true;
+}
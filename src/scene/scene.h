@@ -0,0 +1,98 @@
+/**
+ * @file scene.h
+ * @brief Instanced scene: shared immutable meshes placed many times.
+ *
+ * Each SceneMesh is stored once. A SceneInstance only records which mesh it
+ * shows, an object-to-world transform and a color, so memory grows with the
+ * unique meshes plus a small constant per instance. Every frame each instance
+ * is drawn by folding its transform into the frame's projection matrix and
+ * running the batch transform over the shared mesh; projected coordinates for
+ * one instance at a time live in RenderState::projectedPoints.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../app_state/app_state.h"          // Scene, SceneMesh, SceneInstance, RenderState
+#include "../3d_renderer/batch_transform.h" // ProjectionMatrix
+
+/**
+ * @brief Add a mesh built from points/edges/triangles (packed into an owned copy).
+ * @return Index of the mesh for SceneInstance::mesh.
+ */
+std::uint32_t addSceneMesh(Scene &scene, const std::vector<Point3d> &points, const std::vector<Edge3d> &edges,
+                           const std::vector<std::uint32_t> &triangles);
+
+/**
+ * @brief Add a mesh that references caller-owned memory (e.g. a mapped cache).
+ *
+ * The memory must outlive every frame that draws the scene.
+ * @return Index of the mesh for SceneInstance::mesh.
+ */
+std::uint32_t addSceneMesh(Scene &scene, const GeometryView &shared);
+
+/**
+ * @brief Append an instance; returns false if its mesh index is out of range.
+ */
+bool addSceneInstance(Scene &scene, const SceneInstance &instance);
+
+/**
+ * @brief Move instance index to transform.
+ *
+ * Cheap: the BVH is refit for moved instances at the next syncScene instead
+ * of being rebuilt.
+ */
+void moveSceneInstance(Scene &scene, std::size_t index, const InstanceTransform &transform);
+
+/**
+ * @brief Advance every drifting instance (Scene::motion) by deltaSeconds.
+ *
+ * Each instance moves along its own velocity, bouncing off the faces of the
+ * cube the grid started in, and spins about its Y axis. The moves go through
+ * moveSceneInstance, so the next syncScene refits the BVH; as neighbours
+ * drift apart the tree loosens until the refit falls back to a rebuild.
+ */
+void animateSceneInstances(Scene &scene, float deltaSeconds);
+
+/**
+ * @brief Remove every mesh and instance.
+ */
+void clearScene(Scene &scene);
+
+/**
+ * @brief Transform that scales uniformly, rotates around Y, then translates.
+ */
+InstanceTransform makeInstanceTransform(float x, float y, float z, float scale, float angleYDegrees);
+
+/**
+ * @brief Projection matrix for one instance: view applied after transform.
+ *
+ * Composed in double precision and rounded once, so the batch transform sees
+ * the same kind of matrix as for the untransformed object.
+ */
+ProjectionMatrix instanceProjectionMatrix(const ProjectionMatrix &view, const InstanceTransform &transform);
+
+/**
+ * @brief Prepare the scene for drawing.
+ *
+ * When meshes or instances were added or removed, rebuilds each mesh's draw
+ * batches, bounds and LOD levels, the instance BVH and the frame scratch; when instances
+ * only moved, refits the BVH. Every frame, makes sure projectedPoints can
+ * hold the largest mesh (the current object may have replaced it since).
+ * Call after syncGeometry and syncDrawBatches.
+ */
+void syncScene(RenderState &state);
+
+/**
+ * @brief Replace the current object with a grid of count scaled-down copies.
+ *
+ * The object becomes scene mesh 0 (mapped external geometry is referenced,
+ * not copied). The instances fill the space the object occupied, each
+ * with its own yaw and a color taken from its grid position. The current
+ * object is left empty. With moving set, each instance also gets a drift
+ * velocity and spin in Scene::motion (see animateSceneInstances).
+ *
+ * @return false if there is no object to instance.
+ */
+bool instanceCurrentObject(RenderState &state, std::size_t count, bool moving);
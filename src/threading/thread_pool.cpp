@@ -0,0 +1,158 @@
+// thread_pool.cpp
+// Work-stealing pool: one contiguous task range per worker, owners pop from
+// the front, idle workers steal from the back of other ranges.
+
+#include "thread_pool.h"
+#include <algorithm>
+
+static std::uint64_t packRange(std::uint32_t begin, std::uint32_t end)
+{
+    return (static_cast<std::uint64_t>(begin) << 32) | end;
+}
+
+static std::uint32_t rangeBegin(std::uint64_t packed) { return static_cast<std::uint32_t>(packed >> 32); }
+static std::uint32_t rangeEnd(std::uint64_t packed) { return static_cast<std::uint32_t>(packed); }
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    workerCount = threadCount;
+    ranges.reset(new TaskRange[workerCount]);
+
+    threads.reserve(workerCount - 1);
+    for (unsigned worker = 1; worker < workerCount; ++worker)
+    {
+        threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::run(std::size_t taskCount, TaskFunction function, void *context)
+{
+    if (taskCount == 0)
+        return;
+
+    // Nothing to share: skip the handoff entirely
+    if (workerCount == 1 || taskCount == 1)
+    {
+        for (std::size_t task = 0; task < taskCount; ++task)
+        {
+            function(context, task, 0);
+        }
+        return;
+    }
+
+    // Split the tasks evenly; stealing evens out any imbalance
+    for (unsigned worker = 0; worker < workerCount; ++worker)
+    {
+        const auto begin = static_cast<std::uint32_t>(taskCount * worker / workerCount);
+        const auto end = static_cast<std::uint32_t>(taskCount * (worker + 1) / workerCount);
+        ranges[worker].packed.store(packRange(begin, end), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobFunction = function;
+        jobContext = context;
+        busyWorkers = workerCount - 1;
+        ++generation;
+    }
+    wakeWorkers.notify_all();
+
+    drain(0);
+
+    // Workers may still be finishing stolen tasks
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [this]()
+                     { return busyWorkers == 0; });
+}
+
+void ThreadPool::workerLoop(unsigned workerIndex)
+{
+    std::uint64_t seenGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorkers.wait(lock, [&]()
+                             { return stopping || generation != seenGeneration; });
+            if (stopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        drain(workerIndex);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+            jobFinished.notify_one();
+    }
+}
+
+void ThreadPool::drain(unsigned workerIndex)
+{
+    std::size_t task;
+    while (popOwn(workerIndex, task))
+    {
+        jobFunction(jobContext, task, workerIndex);
+    }
+
+    // Own range is empty: keep stealing until every range is empty
+    bool stole = true;
+    while (stole)
+    {
+        stole = false;
+        for (unsigned offset = 1; offset < workerCount; ++offset)
+        {
+            if (steal((workerIndex + offset) % workerCount, task))
+            {
+                jobFunction(jobContext, task, workerIndex);
+                stole = true;
+                break;
+            }
+        }
+    }
+}
+
+bool ThreadPool::popOwn(unsigned workerIndex, std::size_t &task)
+{
+    std::atomic<std::uint64_t> &range = ranges[workerIndex].packed;
+    std::uint64_t current = range.load(std::memory_order_acquire);
+    while (rangeBegin(current) < rangeEnd(current))
+    {
+        if (range.compare_exchange_weak(current, packRange(rangeBegin(current) + 1, rangeEnd(current)), std::memory_order_acq_rel))
+        {
+            task = rangeBegin(current);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::steal(unsigned victimIndex, std::size_t &task)
+{
+    std::atomic<std::uint64_t> &range = ranges[victimIndex].packed;
+    std::uint64_t current = range.load(std::memory_order_acquire);
+    while (rangeBegin(current) < rangeEnd(current))
+    {
+        if (range.compare_exchange_weak(current, packRange(rangeBegin(current), rangeEnd(current) - 1), std::memory_order_acq_rel))
+        {
+            task = rangeEnd(current) - 1;
+            return true;
+        }
+    }
+    return false;
+}
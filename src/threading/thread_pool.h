@@ -0,0 +1,92 @@
+/**
+ * @file thread_pool.h
+ * @brief Persistent work-stealing thread pool for data-parallel frame stages.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads that execute indexed tasks.
+ *
+ * parallelFor splits the task indices into one contiguous range per worker.
+ * Each worker consumes its own range from the front; a worker that runs dry
+ * steals single tasks from the back of the other ranges. The calling thread
+ * takes part as worker 0, so a pool of N threads starts N - 1 extra threads
+ * and a pool of 1 runs everything inline.
+ *
+ * Threads are created once and sleep between jobs. parallelFor must only be
+ * called from one thread at a time and does not allocate.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Start the pool.
+     * @param threadCount Total workers including the caller; 0 uses
+     *                    std::thread::hardware_concurrency().
+     */
+    explicit ThreadPool(unsigned threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /** Number of workers, including the calling thread. */
+    unsigned threadCount() const { return workerCount; }
+
+    /**
+     * @brief Run body(taskIndex, workerIndex) for every taskIndex in [0, taskCount).
+     *
+     * Returns once all tasks have finished. workerIndex is in [0, threadCount())
+     * and is stable for the duration of one task, so it can select per-worker
+     * scratch data.
+     */
+    template <typename Body>
+    void parallelFor(std::size_t taskCount, Body &&body)
+    {
+        using BodyType = typename std::remove_reference<Body>::type;
+        run(taskCount, [](void *context, std::size_t task, unsigned worker)
+            { (*static_cast<BodyType *>(context))(task, worker); },
+            const_cast<void *>(static_cast<const void *>(&body)));
+    }
+
+private:
+    using TaskFunction = void (*)(void *context, std::size_t task, unsigned worker);
+
+    // Remaining tasks of one worker as a packed [begin, end) pair, so owner
+    // pops and thief steals are single compare-and-swap operations
+    struct alignas(64) TaskRange
+    {
+        std::atomic<std::uint64_t> packed{0};
+    };
+
+    void run(std::size_t taskCount, TaskFunction function, void *context);
+    void workerLoop(unsigned workerIndex);
+    void drain(unsigned workerIndex);
+    bool popOwn(unsigned workerIndex, std::size_t &task);
+    bool steal(unsigned victimIndex, std::size_t &task);
+
+    unsigned workerCount = 1;
+    std::unique_ptr<TaskRange[]> ranges;
+    std::vector<std::thread> threads;
+
+    // Current job, published under mutex together with a new generation
+    TaskFunction jobFunction = nullptr;
+    void *jobContext = nullptr;
+    std::uint64_t generation = 0;
+    unsigned busyWorkers = 0;
+    bool stopping = false;
+
+    std::mutex mutex;
+    std::condition_variable wakeWorkers;
+    std::condition_variable jobFinished;
+};
@@ -0,0 +1,190 @@
+// shm_frame_consumer.cpp
+// Test consumer of the shared-memory frame ring (--shm=NAME): attaches to
+// the ring, takes frames in place until the producer finishes, and checks
+// that they arrive in order, untorn and with the advertised geometry (on a
+// lossless ring also that none is missing, from frame 1 on). Prints
+// dropped frames, the handoff latency from publication to take, and a
+// checksum of the last frame that matches the producer's --checksum.
+#include "frame_export/shm_frame_ring.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Command-line settings.
+ */
+struct ConsumerOptions
+{
+    const char *name = nullptr; ///< --name=/NAME of the ring
+    double waitSeconds = 10.0;  ///< --wait=S for the ring to appear and between frames
+    double workMs = 0.0;        ///< --work-ms=MS spent on each frame, to simulate a slow consumer
+    bool hashFrames = false;    ///< --hash, read every pixel of every frame (and re-check it afterwards)
+};
+
+static const char *optionValue(const char *arg, const char *name)
+{
+    const std::size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) != 0 || arg[length] != '=')
+        return nullptr;
+    return arg + length + 1;
+}
+
+static bool parseSeconds(const char *text, double &out)
+{
+    char *end = nullptr;
+    const double value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !(value >= 0.0) || value > 86400.0)
+        return false;
+    out = value;
+    return true;
+}
+
+static void printUsage(const char *program)
+{
+    std::printf("Usage: %s --name=/NAME [options]\n"
+                "  --name=/NAME   Ring published by main --shm=/NAME\n"
+                "  --wait=S       Seconds to wait for the ring and for each frame (default 10)\n"
+                "  --work-ms=MS   Busy time per frame, to simulate a slow consumer (default 0)\n"
+                "  --hash         Read every frame's pixels and check the slot was not reused meanwhile\n",
+                program);
+}
+
+// FNV-1a over the visible pixels of each row, as main's --checksum
+static std::uint64_t hashPixels(const void *pixels, std::uint32_t width, std::uint32_t height, std::uint32_t stride)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto *rowBytes = static_cast<const unsigned char *>(pixels);
+    for (std::uint32_t y = 0; y < height; ++y, rowBytes += stride)
+    {
+        for (std::uint32_t i = 0; i < width * 4; ++i)
+        {
+            hash = (hash ^ rowBytes[i]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static double percentile(const std::vector<double> &sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+    const std::size_t rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+int main(int argc, char **argv)
+{
+    ConsumerOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *value = nullptr;
+        if ((value = optionValue(argv[i], "--name")))
+            options.name = value;
+        else if ((value = optionValue(argv[i], "--wait")) && parseSeconds(value, options.waitSeconds))
+            continue;
+        else if ((value = optionValue(argv[i], "--work-ms")) && parseSeconds(value, options.workMs))
+            continue;
+        else if (std::strcmp(argv[i], "--hash") == 0)
+            options.hashFrames = true;
+        else
+        {
+            std::fprintf(stderr, "Unknown or invalid argument '%s'\n", argv[i]);
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (!options.name)
+    {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    // The producer creates the ring when its run starts; poll for it
+    ShmFrameReader reader;
+    std::string error;
+    const auto giveUp = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.waitSeconds);
+    while (!reader.open(options.name, error))
+    {
+        if (std::chrono::steady_clock::now() >= giveUp)
+        {
+            std::fprintf(stderr, "Cannot attach to '%s': %s\n", options.name, error.c_str());
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    const ShmFrameRingHeader &ring = reader.ring();
+    const bool lossless = (ring.flags & SHM_FRAME_RING_LOSSLESS) != 0;
+    std::printf("attached name=%s size=%ux%u stride=%u slots=%u lossless=%d\n", options.name, ring.width, ring.height, ring.stride,
+                ring.slotCount, lossless ? 1 : 0);
+
+    std::uint64_t frames = 0, firstSequence = 0, lastSequence = 0;
+    std::uint64_t dropped = 0, outOfOrder = 0, badGeometry = 0, reused = 0;
+    std::vector<double> latencyUs;
+    latencyUs.reserve(1 << 16);
+    ShmFrame frame;
+    const int timeoutMs = static_cast<int>(options.waitSeconds * 1000.0);
+    while (reader.take(frame, timeoutMs))
+    {
+        latencyUs.push_back(static_cast<double>(shmFrameClockNs() - frame.publishNs) * 1e-3);
+        if (frames == 0)
+        {
+            // Frames published before this consumer attached
+            firstSequence = frame.sequence;
+            dropped += frame.sequence - 1;
+        }
+        else if (frame.sequence <= lastSequence)
+            ++outOfOrder;
+        else
+            dropped += frame.sequence - lastSequence - 1;
+        lastSequence = frame.sequence;
+        ++frames;
+        if (frame.width != ring.width || frame.height != ring.height || frame.stride != ring.stride || frame.format != SHM_FRAME_FORMAT_ARGB8888)
+            ++badGeometry;
+
+        if (options.hashFrames)
+        {
+            volatile std::uint64_t sink = hashPixels(frame.pixels, frame.width, frame.height, frame.stride);
+            (void)sink;
+        }
+        if (options.workMs > 0.0)
+        {
+            const auto until = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(options.workMs);
+            while (std::chrono::steady_clock::now() < until)
+            {
+            }
+        }
+        if (!reader.intact(frame))
+            ++reused;
+    }
+    if (!reader.producerFinished())
+    {
+        std::fprintf(stderr, "No frame for %.1f s and the producer did not finish\n", options.waitSeconds);
+        return 1;
+    }
+
+    // The last frame taken is still held, so it is the producer's final image
+    const std::uint64_t checksum = frames > 0 ? hashPixels(frame.pixels, frame.width, frame.height, frame.stride) : 0;
+    std::sort(latencyUs.begin(), latencyUs.end());
+    double meanUs = 0.0;
+    for (double value : latencyUs)
+        meanUs += value;
+    meanUs = latencyUs.empty() ? 0.0 : meanUs / static_cast<double>(latencyUs.size());
+    std::printf("consumer frames=%llu first=%llu last=%llu dropped=%llu out_of_order=%llu reused=%llu bad_geometry=%llu\n",
+                static_cast<unsigned long long>(frames), static_cast<unsigned long long>(firstSequence), static_cast<unsigned long long>(lastSequence),
+                static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(outOfOrder), static_cast<unsigned long long>(reused),
+                static_cast<unsigned long long>(badGeometry));
+    std::printf("handoff_latency mean=%.1f us p50=%.1f us p95=%.1f us p99=%.1f us max=%.1f us\n", meanUs, percentile(latencyUs, 0.50),
+                percentile(latencyUs, 0.95), percentile(latencyUs, 0.99), latencyUs.empty() ? 0.0 : latencyUs.back());
+    std::printf("checksum=%016llx\n", static_cast<unsigned long long>(checksum));
+
+    // A lossless ring waits for the consumer before frame 1, so every frame from 1 on must arrive
+    const bool ok = outOfOrder == 0 && reused == 0 && badGeometry == 0 && (!lossless || (firstSequence == 1 && dropped == 0));
+    if (!ok)
+        std::fprintf(stderr, "Frame ring check failed\n");
+    return ok ? 0 : 1;
+}